@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+/*
+	Helpers shared by the benchmarks. Each benchmark takes the font files
+	to measure on its command line, as the fonts worth measuring can't be
+	shipped with the source.
+*/
+
+namespace CharacterMapCX
+{
+	namespace Benchmarks
+	{
+		inline bool ReadFile(const char* path, std::vector<uint8_t>& data)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+			{
+				std::fprintf(stderr, "Can't open %s\n", path);
+				return false;
+			}
+
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			return true;
+		}
+
+		/// <summary>
+		/// Runs a pass repeatedly for at least half a second, after one
+		/// untimed warm up pass, and returns the average seconds per pass.
+		/// </summary>
+		template <typename TPass>
+		double TimePass(TPass pass)
+		{
+			typedef std::chrono::steady_clock Clock;
+
+			pass();
+
+			uint32_t passes = 0;
+			Clock::time_point start = Clock::now();
+			double elapsed = 0;
+			do
+			{
+				pass();
+				passes++;
+				elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+			} while (elapsed < 0.5);
+
+			return elapsed / passes;
+		}
+	}
+}
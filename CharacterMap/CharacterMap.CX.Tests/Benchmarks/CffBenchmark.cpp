@@ -0,0 +1,72 @@
+#include "Benchmark.h"
+#include "CffTable.h"
+#include "FontBuilder.h"
+
+/*
+	Measures the CFF / CFF2 CharString interpreter on real fonts.
+
+	    CffBenchmark font.otf [font.otf ...]
+
+	For each font, every glyph is decoded into a path, and separately only
+	measured for tight bounds, reporting glyphs per second. Glyphs the
+	interpreter rejects, which fall back to Direct2D in the app, are
+	counted too.
+*/
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Benchmarks;
+using namespace CharacterMapCX::Tests;
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::fprintf(stderr, "Usage: %s font.otf [font.otf ...]\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("%-40s %8s %8s %14s %14s\n", "Font", "Glyphs", "Failed", "Decode gl/s", "Bounds gl/s");
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::vector<uint8_t> data;
+		if (!ReadFile(argv[i], data))
+			return 1;
+
+		ByteSpan font = Span(data);
+		ByteSpan cff2 = FindTable(font, "CFF2");
+		ByteSpan cff = cff2.IsEmpty() ? FindTable(font, "CFF ") : cff2;
+
+		CffTable table;
+		if (cff.IsEmpty() || !table.Load(cff, !cff2.IsEmpty()))
+		{
+			std::fprintf(stderr, "%s has no CFF or CFF2 table\n", argv[i]);
+			return 1;
+		}
+
+		uint32_t count = table.CharStrings.Count;
+		uint32_t failed = 0;
+		GlyphPath path;
+		for (uint32_t g = 0; g < count; g++)
+			if (!table.Decode(static_cast<uint16_t>(g), path, 1))
+				failed++;
+
+		double decode = TimePass([&]
+			{
+				for (uint32_t g = 0; g < count; g++)
+					table.Decode(static_cast<uint16_t>(g), path, 0.25f);
+			});
+
+		double bounds = TimePass([&]
+			{
+				PathBounds b;
+				for (uint32_t g = 0; g < count; g++)
+					table.GetBounds(static_cast<uint16_t>(g), b, 0.25f, true);
+			});
+
+		std::printf("%-40s %8u %8u %14.0f %14.0f\n", argv[i], count, failed,
+			count / decode, count / bounds);
+	}
+
+	return 0;
+}
@@ -0,0 +1,96 @@
+#include <cstring>
+#include "Benchmark.h"
+#include "GlyfTable.h"
+#include "SvgPathBuilder.h"
+#include "FontBuilder.h"
+
+/*
+	Compares writing TrueType outlines as native quadratic path commands
+	against raising them to cubics, as Direct2D does.
+
+	    SvgPathBenchmark font.ttf [font.ttf ...]
+
+	Every glyph is decoded at half scale, then written with absolute and
+	relative commands at 6 and 2 decimal places. The total size of the path
+	data and the time to write it are reported for both forms.
+*/
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Benchmarks;
+using namespace CharacterMapCX::Tests;
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::fprintf(stderr, "Usage: %s font.ttf [font.ttf ...]\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("%-24s %4s %4s %12s %12s %8s %10s %10s %8s\n",
+		"Font", "Dp", "Rel", "Cubic bytes", "Quad bytes", "Smaller", "Cubic ms", "Quad ms", "Faster");
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::vector<uint8_t> data;
+		if (!ReadFile(argv[i], data))
+			return 1;
+
+		const char* name = std::strrchr(argv[i], '/');
+		name = name ? name + 1 : argv[i];
+
+		ByteSpan font = Span(data);
+		GlyfTable table;
+		if (!table.Load(FindTable(font, "head"), FindTable(font, "loca"), FindTable(font, "glyf"), FindTable(font, "maxp").UInt16(4)))
+		{
+			std::fprintf(stderr, "%s has no glyf table\n", argv[i]);
+			return 1;
+		}
+
+		std::vector<GlyphPath> paths(table.GlyphCount());
+		for (uint32_t g = 0; g < paths.size(); g++)
+			table.Decode(static_cast<uint16_t>(g), paths[g], 0.5f);
+
+		for (int precision : { 6, 2 })
+		{
+			for (bool relative : { false, true })
+			{
+				size_t bytes[2] = {};
+				double seconds[2] = {};
+
+				for (int raise = 0; raise < 2; raise++)
+				{
+					SvgWriteOptions options;
+					options.Relative = relative;
+					options.RaiseQuadratics = raise != 0;
+
+					SvgPathBuilder builder;
+					builder.SetPrecision(precision);
+
+					for (const GlyphPath& path : paths)
+					{
+						builder.Clear();
+						path.WriteSvg(builder, options);
+						bytes[raise] += builder.Size();
+					}
+
+					seconds[raise] = TimePass([&]
+						{
+							for (const GlyphPath& path : paths)
+							{
+								builder.Clear();
+								path.WriteSvg(builder, options);
+							}
+						});
+				}
+
+				std::printf("%-24s %4d %4s %12zu %12zu %7.1f%% %10.2f %10.2f %7.1f%%\n",
+					name, precision, relative ? "yes" : "no",
+					bytes[1], bytes[0], 100.0 * (1 - static_cast<double>(bytes[0]) / bytes[1]),
+					seconds[1] * 1e3, seconds[0] * 1e3, 100.0 * (1 - seconds[0] / seconds[1]));
+			}
+		}
+	}
+
+	return 0;
+}
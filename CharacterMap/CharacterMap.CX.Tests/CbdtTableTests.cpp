@@ -0,0 +1,484 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "CbdtTable.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	struct Metrics
+	{
+		uint8_t Height;
+		uint8_t Width;
+		int8_t BearingX;
+		int8_t BearingY;
+	};
+
+	std::vector<uint8_t> Png(uint8_t marker)
+	{
+		return { 0x89, 'P', 'N', 'G', marker };
+	}
+
+	ByteWriter& SmallMetrics(ByteWriter& w, Metrics m)
+	{
+		return w.U8(m.Height).U8(m.Width).U8(static_cast<uint8_t>(m.BearingX)).U8(static_cast<uint8_t>(m.BearingY)).U8(m.Width);
+	}
+
+	ByteWriter& BigMetrics(ByteWriter& w, Metrics m)
+	{
+		return w.U8(m.Height).U8(m.Width).U8(static_cast<uint8_t>(m.BearingX)).U8(static_cast<uint8_t>(m.BearingY)).U8(m.Width)
+			.U8(0).U8(0).U8(m.Height);
+	}
+
+	// Glyph data records for image formats 17, 18 and 19
+	std::vector<uint8_t> Format17(Metrics m, uint8_t marker)
+	{
+		ByteWriter w;
+		SmallMetrics(w, m).U32(5).Bytes(Png(marker));
+		return w.Data;
+	}
+
+	std::vector<uint8_t> Format18(Metrics m, uint8_t marker)
+	{
+		ByteWriter w;
+		BigMetrics(w, m).U32(5).Bytes(Png(marker));
+		return w.Data;
+	}
+
+	std::vector<uint8_t> Format19(uint8_t marker)
+	{
+		ByteWriter w;
+		w.U32(5).Bytes(Png(marker));
+		return w.Data;
+	}
+
+	/// <summary>
+	/// A CBDT table that records where each glyph's data was written.
+	/// </summary>
+	struct CbdtBuilder
+	{
+		ByteWriter Table;
+
+		CbdtBuilder() { Table.U16(3).U16(0); }
+
+		uint32_t Add(const std::vector<uint8_t>& data)
+		{
+			uint32_t offset = Table.Size();
+			Table.Bytes(data);
+			return offset;
+		}
+	};
+
+	ByteWriter SubTableHeader(uint16_t indexFormat, uint16_t imageFormat, uint32_t imageDataOffset)
+	{
+		ByteWriter w;
+		w.U16(indexFormat).U16(imageFormat).U32(imageDataOffset);
+		return w;
+	}
+
+	/// <summary>
+	/// Format 1 or 3: one offset per glyph in the range, plus an end offset,
+	/// relative to imageDataOffset.
+	/// </summary>
+	std::vector<uint8_t> OffsetSubTable(uint16_t indexFormat, uint16_t imageFormat, uint32_t imageDataOffset, const std::vector<uint32_t>& offsets)
+	{
+		ByteWriter w = SubTableHeader(indexFormat, imageFormat, imageDataOffset);
+		for (uint32_t o : offsets)
+		{
+			if (indexFormat == 1)
+				w.U32(o);
+			else
+				w.U16(o);
+		}
+		return w.Align(4).Data;
+	}
+
+	std::vector<uint8_t> ConstantSubTable(uint16_t imageFormat, uint32_t imageDataOffset, uint32_t imageSize, Metrics m)
+	{
+		ByteWriter w = SubTableHeader(2, imageFormat, imageDataOffset);
+		w.U32(imageSize);
+		return BigMetrics(w, m).Data;
+	}
+
+	std::vector<uint8_t> SparseOffsetSubTable(uint16_t imageFormat, uint32_t imageDataOffset, const std::vector<std::pair<uint16_t, uint16_t>>& pairs)
+	{
+		// The last pair only marks the end of the previous glyph's data
+		ByteWriter w = SubTableHeader(4, imageFormat, imageDataOffset);
+		w.U32(static_cast<uint32_t>(pairs.size() - 1));
+		for (const auto& p : pairs)
+			w.U16(p.first).U16(p.second);
+		return w.Data;
+	}
+
+	std::vector<uint8_t> SparseConstantSubTable(uint16_t imageFormat, uint32_t imageDataOffset, uint32_t imageSize, Metrics m, const std::vector<uint16_t>& glyphs)
+	{
+		ByteWriter w = SubTableHeader(5, imageFormat, imageDataOffset);
+		w.U32(imageSize);
+		BigMetrics(w, m).U32(static_cast<uint32_t>(glyphs.size()));
+		for (uint16_t g : glyphs)
+			w.U16(g);
+		return w.Align(4).Data;
+	}
+
+	struct Range
+	{
+		uint16_t First;
+		uint16_t Last;
+		std::vector<uint8_t> SubTable;
+	};
+
+	struct Strike
+	{
+		uint8_t Ppem;
+		uint16_t StartGlyph;
+		uint16_t EndGlyph;
+		std::vector<Range> Ranges;
+	};
+
+	std::vector<uint8_t> MakeCblc(const std::vector<Strike>& strikes)
+	{
+		ByteWriter w;
+		w.U16(3).U16(0).U32(static_cast<uint32_t>(strikes.size()));
+
+		uint32_t arrayOffset = 8 + static_cast<uint32_t>(strikes.size()) * 48;
+		std::vector<std::vector<uint8_t>> arrays;
+		for (const Strike& s : strikes)
+		{
+			// The subtable array, followed by the subtables it points to
+			ByteWriter a;
+			uint32_t subTableOffset = static_cast<uint32_t>(s.Ranges.size()) * 8;
+			for (const Range& r : s.Ranges)
+			{
+				a.U16(r.First).U16(r.Last).U32(subTableOffset);
+				subTableOffset += static_cast<uint32_t>(r.SubTable.size());
+			}
+			for (const Range& r : s.Ranges)
+				a.Bytes(r.SubTable);
+
+			w.U32(arrayOffset).U32(a.Size()).U32(static_cast<uint32_t>(s.Ranges.size())).U32(0)
+				.Zeros(24)
+				.U16(s.StartGlyph).U16(s.EndGlyph).U8(s.Ppem).U8(s.Ppem).U8(32).U8(1);
+
+			arrayOffset += a.Size();
+			arrays.push_back(a.Data);
+		}
+
+		for (const auto& a : arrays)
+			w.Bytes(a);
+		return w.Data;
+	}
+
+	uint8_t Marker(const BitmapGlyph& glyph)
+	{
+		return glyph.Data.UInt8(glyph.Data.Size - 1);
+	}
+
+	/// <summary>
+	/// Loads a single strike and reads a glyph from it.
+	/// </summary>
+	struct Font
+	{
+		std::vector<uint8_t> Cblc;
+		std::vector<uint8_t> Cbdt;
+		CbdtTable Table;
+
+		Font(const std::vector<Strike>& strikes, const CbdtBuilder& cbdt)
+			: Cblc(MakeCblc(strikes)), Cbdt(cbdt.Table.Data)
+		{
+			EXPECT_TRUE(Table.Load(Span(Cblc), Span(Cbdt)));
+		}
+
+		bool Get(uint16_t glyph, BitmapGlyph& result, uint16_t ppem = 109)
+		{
+			return Table.TryGetGlyph(glyph, ppem, result);
+		}
+	};
+}
+
+TEST(CbdtTable, ReadsIndexFormat1)
+{
+	CbdtBuilder cbdt;
+	uint32_t base = cbdt.Add(Format17({ 20, 18, -1, 16 }, 10));
+	uint32_t second = cbdt.Add(Format17({ 21, 19, 2, -3 }, 12));
+	uint32_t end = cbdt.Table.Size();
+
+	// Glyph 11 has no data
+	Font font({ { 109, 10, 12, { { 10, 12, OffsetSubTable(1, 17, base, { 0, second - base, second - base, end - base }) } } } }, cbdt);
+
+	BitmapGlyph glyph;
+	ASSERT_TRUE(font.Get(10, glyph));
+	EXPECT_EQ(10, Marker(glyph));
+	EXPECT_EQ(20, glyph.Height);
+	EXPECT_EQ(18, glyph.Width);
+	EXPECT_EQ(-1, glyph.OriginX);
+	EXPECT_EQ(16, glyph.OriginY);
+
+	EXPECT_FALSE(font.Get(11, glyph));
+
+	ASSERT_TRUE(font.Get(12, glyph));
+	EXPECT_EQ(12, Marker(glyph));
+	EXPECT_EQ(-3, glyph.OriginY);
+	EXPECT_EQ(static_cast<uint32_t>(GlyphFormat_Png), glyph.Format);
+	EXPECT_EQ(12, glyph.GlyphId);
+	EXPECT_EQ(109, glyph.Ppem);
+}
+
+TEST(CbdtTable, ReadsIndexFormat2)
+{
+	CbdtBuilder cbdt;
+	uint32_t base = cbdt.Add(Format19(1));
+	cbdt.Add(Format19(2));
+	cbdt.Add(Format19(3));
+
+	Font font({ { 109, 5, 7, { { 5, 7, ConstantSubTable(19, base, 9, { 30, 31, 4, 25 }) } } } }, cbdt);
+
+	BitmapGlyph glyph;
+	for (uint16_t g = 5; g <= 7; g++)
+	{
+		ASSERT_TRUE(font.Get(g, glyph)) << g;
+		EXPECT_EQ(g - 4, Marker(glyph));
+
+		// Format 19 takes its metrics from the subtable
+		EXPECT_EQ(30, glyph.Height);
+		EXPECT_EQ(31, glyph.Width);
+		EXPECT_EQ(4, glyph.OriginX);
+		EXPECT_EQ(25, glyph.OriginY);
+	}
+}
+
+TEST(CbdtTable, ReadsIndexFormat3)
+{
+	CbdtBuilder cbdt;
+	uint32_t base = cbdt.Add(Format18({ 40, 41, -5, 35 }, 1));
+	uint32_t second = cbdt.Add(Format18({ 42, 43, 0, 0 }, 2));
+	uint32_t end = cbdt.Table.Size();
+
+	Font font({ { 109, 100, 101, { { 100, 101, OffsetSubTable(3, 18, base, { 0, second - base, end - base }) } } } }, cbdt);
+
+	BitmapGlyph glyph;
+	ASSERT_TRUE(font.Get(100, glyph));
+	EXPECT_EQ(1, Marker(glyph));
+	EXPECT_EQ(40, glyph.Height);
+	EXPECT_EQ(41, glyph.Width);
+	EXPECT_EQ(-5, glyph.OriginX);
+	EXPECT_EQ(35, glyph.OriginY);
+
+	ASSERT_TRUE(font.Get(101, glyph));
+	EXPECT_EQ(2, Marker(glyph));
+	EXPECT_EQ(43, glyph.Width);
+}
+
+TEST(CbdtTable, ReadsIndexFormat4)
+{
+	CbdtBuilder cbdt;
+	std::vector<std::pair<uint16_t, uint16_t>> pairs;
+	uint32_t base = cbdt.Table.Size();
+	std::vector<uint16_t> glyphs = { 3, 7, 8, 20, 31, 50, 51 };
+	for (uint16_t g : glyphs)
+		pairs.push_back({ g, static_cast<uint16_t>(cbdt.Add(Format17({ 1, 1, 0, 0 }, static_cast<uint8_t>(g))) - base) });
+	pairs.push_back({ 0, static_cast<uint16_t>(cbdt.Table.Size() - base) });
+
+	Font font({ { 109, 0, 60, { { 0, 60, SparseOffsetSubTable(17, base, pairs) } } } }, cbdt);
+
+	// Every listed glyph is found by the binary search, including the ends
+	BitmapGlyph glyph;
+	for (uint16_t g : glyphs)
+	{
+		ASSERT_TRUE(font.Get(g, glyph)) << g;
+		EXPECT_EQ(g, Marker(glyph));
+	}
+
+	for (uint16_t g : { 0, 2, 4, 9, 19, 21, 49, 52, 60 })
+		EXPECT_FALSE(font.Get(g, glyph)) << g;
+}
+
+TEST(CbdtTable, ReadsIndexFormat5)
+{
+	CbdtBuilder cbdt;
+	std::vector<uint16_t> glyphs = { 2, 4, 6, 9, 40 };
+	uint32_t base = cbdt.Table.Size();
+	for (uint16_t g : glyphs)
+		cbdt.Add(Format19(static_cast<uint8_t>(g)));
+
+	Font font({ { 109, 0, 50, { { 0, 50, SparseConstantSubTable(19, base, 9, { 12, 13, 1, 11 }, glyphs) } } } }, cbdt);
+
+	BitmapGlyph glyph;
+	for (uint16_t g : glyphs)
+	{
+		ASSERT_TRUE(font.Get(g, glyph)) << g;
+		EXPECT_EQ(g, Marker(glyph));
+		EXPECT_EQ(13, glyph.Width);
+		EXPECT_EQ(11, glyph.OriginY);
+	}
+
+	for (uint16_t g : { 0, 1, 3, 5, 10, 39, 41, 50 })
+		EXPECT_FALSE(font.Get(g, glyph)) << g;
+}
+
+TEST(CbdtTable, SearchesRangesInGlyphOrder)
+{
+	// Twenty ranges of three glyphs with a gap of two between them,
+	// written in reverse to check they are sorted
+	CbdtBuilder cbdt;
+	std::vector<Range> ranges;
+	for (int r = 19; r >= 0; r--)
+	{
+		uint16_t first = static_cast<uint16_t>(10 + r * 5);
+		uint32_t base = cbdt.Table.Size();
+		for (int i = 0; i < 3; i++)
+			cbdt.Add(Format19(static_cast<uint8_t>(first + i)));
+
+		ranges.push_back({ first, static_cast<uint16_t>(first + 2), ConstantSubTable(19, base, 9, { 1, 1, 0, 0 }) });
+	}
+
+	Font font({ { 109, 0, 200, ranges } }, cbdt);
+	ASSERT_EQ(20u, font.Table.GetStrikes()[0].Ranges.size());
+
+	BitmapGlyph glyph;
+	for (uint16_t g = 0; g < 120; g++)
+	{
+		bool inRange = g >= 10 && g < 110 && (g - 10) % 5 < 3;
+		ASSERT_EQ(inRange, font.Get(g, glyph)) << g;
+		if (inRange)
+		{
+			EXPECT_EQ(g, Marker(glyph));
+		}
+		EXPECT_EQ(inRange, font.Table.HasGlyph(g)) << g;
+	}
+}
+
+TEST(CbdtTable, MissesGlyphsOutsideTheStrike)
+{
+	CbdtBuilder cbdt;
+	uint32_t base = cbdt.Add(Format19(1));
+	cbdt.Add(Format19(2));
+	cbdt.Add(Format19(3));
+
+	// The range covers 4-6 but the strike claims only 5-6
+	Font font({ { 109, 5, 6, { { 4, 6, ConstantSubTable(19, base, 9, { 1, 1, 0, 0 }) } } } }, cbdt);
+
+	BitmapGlyph glyph;
+	EXPECT_FALSE(font.Get(3, glyph));
+	EXPECT_FALSE(font.Get(4, glyph));
+	EXPECT_TRUE(font.Get(5, glyph));
+	EXPECT_TRUE(font.Get(6, glyph));
+	EXPECT_FALSE(font.Get(7, glyph));
+}
+
+TEST(CbdtTable, RejectsUncompressedImageFormats)
+{
+	CbdtBuilder cbdt;
+	uint32_t base = cbdt.Add(Format19(1));
+
+	Font font({ { 109, 1, 1, { { 1, 1, ConstantSubTable(1, base, 9, { 1, 1, 0, 0 }) } } } }, cbdt);
+
+	BitmapGlyph glyph;
+	EXPECT_FALSE(font.Get(1, glyph));
+}
+
+TEST(CbdtTable, SelectsAndFallsBackBetweenStrikes)
+{
+	CbdtBuilder cbdt;
+	uint32_t small = cbdt.Add(Format19(20));
+	uint32_t large = cbdt.Add(Format19(128));
+	cbdt.Add(Format19(129));
+
+	Font font({
+		{ 128, 1, 2, { { 1, 2, ConstantSubTable(19, large, 9, { 1, 1, 0, 0 }) } } },
+		{ 20, 1, 1, { { 1, 1, ConstantSubTable(19, small, 9, { 1, 1, 0, 0 }) } } },
+	}, cbdt);
+
+	EXPECT_EQ(0, font.Table.SelectStrike(20));
+	EXPECT_EQ(1, font.Table.SelectStrike(21));
+	EXPECT_EQ(1, font.Table.SelectStrike(255));
+
+	BitmapGlyph glyph;
+	ASSERT_TRUE(font.Get(1, glyph, 16));
+	EXPECT_EQ(20, Marker(glyph));
+	ASSERT_TRUE(font.Get(1, glyph, 100));
+	EXPECT_EQ(128, Marker(glyph));
+
+	// Only the larger strike has glyph 2
+	ASSERT_TRUE(font.Get(2, glyph, 16));
+	EXPECT_EQ(129, Marker(glyph));
+	EXPECT_EQ(128, glyph.Ppem);
+}
+
+TEST(CbdtTable, RejectsOffsetsOutsideTheTables)
+{
+	CbdtBuilder cbdt;
+	uint32_t base = cbdt.Add(Format19(1));
+	uint32_t size = cbdt.Table.Size();
+
+	BitmapGlyph glyph;
+
+	// Image data past the end of CBDT
+	Font past({ { 109, 1, 1, { { 1, 1, ConstantSubTable(19, size, 9, { 1, 1, 0, 0 }) } } } }, cbdt);
+	EXPECT_FALSE(past.Get(1, glyph));
+
+	// A PNG length running past the glyph's data
+	CbdtBuilder longPng;
+	ByteWriter w;
+	w.U32(6).Bytes(Png(1));
+	uint32_t longBase = longPng.Add(w.Data);
+	Font truncated({ { 109, 1, 1, { { 1, 1, ConstantSubTable(19, longBase, 9, { 1, 1, 0, 0 }) } } } }, longPng);
+	EXPECT_FALSE(truncated.Get(1, glyph));
+
+	// Offsets that overflow 32 bits
+	Font overflow({ { 109, 1, 2, { { 1, 2, OffsetSubTable(1, 19, 0xFFFFFFF0u, { 0x10, 0x19, 0x20 }) } } } }, cbdt);
+	EXPECT_FALSE(overflow.Get(1, glyph));
+	EXPECT_FALSE(overflow.Table.HasGlyph(1));
+
+	// Still loads glyphs whose offsets are fine
+	Font fine({ { 109, 1, 1, { { 1, 1, ConstantSubTable(19, base, 9, { 1, 1, 0, 0 }) } } } }, cbdt);
+	EXPECT_TRUE(fine.Get(1, glyph));
+}
+
+TEST(CbdtTable, DropsRangesWithTruncatedSubTables)
+{
+	CbdtBuilder cbdt;
+	uint32_t base = cbdt.Add(Format19(1));
+	uint32_t end = cbdt.Table.Size();
+
+	// A format 1 subtable with one offset fewer than its range needs
+	std::vector<uint8_t> short1 = OffsetSubTable(1, 19, base, { 0, end - base });
+	Strike strike = { 109, 1, 2, { { 1, 2, short1 } } };
+	std::vector<uint8_t> cblc = MakeCblc({ strike });
+
+	CbdtTable table;
+	EXPECT_FALSE(table.Load(Span(cblc), Span(cbdt.Table.Data)));
+
+	// A format 4 subtable claiming more pairs than it has
+	std::vector<uint8_t> sparse = SparseOffsetSubTable(19, base, { { 1, 0 }, { 0, static_cast<uint16_t>(end - base) } });
+	sparse[11] = 9;
+	cblc = MakeCblc({ { 109, 1, 1, { { 1, 1, sparse } } } });
+	EXPECT_FALSE(table.Load(Span(cblc), Span(cbdt.Table.Data)));
+
+	// Ranges with first after last are skipped
+	cblc = MakeCblc({ { 109, 1, 2, { { 2, 1, ConstantSubTable(19, base, 9, { 1, 1, 0, 0 }) } } } });
+	EXPECT_FALSE(table.Load(Span(cblc), Span(cbdt.Table.Data)));
+}
+
+TEST(CbdtTable, RejectsTruncatedHeaders)
+{
+	CbdtBuilder cbdt;
+	uint32_t base = cbdt.Add(Format19(1));
+	std::vector<uint8_t> cblc = MakeCblc({ { 109, 1, 1, { { 1, 1, ConstantSubTable(19, base, 9, { 1, 1, 0, 0 }) } } } });
+
+	CbdtTable table;
+	EXPECT_TRUE(table.Load(Span(cblc), Span(cbdt.Table.Data)));
+	EXPECT_FALSE(table.Load(Span(cblc), ByteSpan()));
+	EXPECT_FALSE(table.Load(Span(std::vector<uint8_t>(cblc.begin(), cblc.begin() + 7)), Span(cbdt.Table.Data)));
+
+	// More size records than fit
+	std::vector<uint8_t> count = cblc;
+	count[7] = 2;
+	EXPECT_FALSE(table.Load(Span(count), Span(cbdt.Table.Data)));
+
+	// A subtable array past the end of the table
+	std::vector<uint8_t> array = cblc;
+	array[8] = 0x10;
+	EXPECT_FALSE(table.Load(Span(array), Span(cbdt.Table.Data)));
+}
@@ -0,0 +1,301 @@
+#include <gtest/gtest.h>
+#include "CffTable.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	/// <summary>
+	/// Writes Type 2 CharStrings. Numbers are pushed with N and operators
+	/// written with Op, or Op2 for the two byte escaped operators.
+	/// </summary>
+	struct CharString
+	{
+		ByteWriter W;
+
+		CharString& N(float value)
+		{
+			int i = static_cast<int>(value);
+			if (static_cast<float>(i) != value)
+				W.U8(255).U32(static_cast<uint32_t>(static_cast<int32_t>(value * 65536)));
+			else if (i >= -107 && i <= 107)
+				W.U8(i + 139);
+			else
+				W.U8(28).I16(i);
+
+			return *this;
+		}
+
+		CharString& N(std::initializer_list<float> values)
+		{
+			for (float v : values)
+				N(v);
+
+			return *this;
+		}
+
+		CharString& Op(uint8_t op)
+		{
+			W.U8(op);
+			return *this;
+		}
+
+		CharString& Op2(uint8_t op)
+		{
+			W.U8(12).U8(op);
+			return *this;
+		}
+
+		CharString& Raw(uint8_t value)
+		{
+			W.U8(value);
+			return *this;
+		}
+
+		operator std::vector<uint8_t>() const { return W.Data; }
+	};
+
+	const uint8_t rmoveto = 21, rlineto = 5, rrcurveto = 8, hvcurveto = 31, endchar = 14;
+	const uint8_t callsubr = 10, callgsubr = 29, return_ = 11;
+	const uint8_t hstemhm = 18, hintmask = 19, vsindex = 15, blend = 16;
+	const uint8_t flex = 35, hflex = 34, hflex1 = 36, flex1 = 37;
+
+	/// <summary>
+	/// Checks a decoded path against points given in font units, before
+	/// the y-axis is flipped.
+	/// </summary>
+	void ExpectPath(const GlyphPath& path, const std::vector<PathVerb>& verbs, const std::vector<float>& points)
+	{
+		EXPECT_EQ(path.Verbs, verbs);
+		ASSERT_EQ(path.Points.size(), points.size());
+		for (size_t i = 0; i < points.size(); i += 2)
+		{
+			EXPECT_NEAR(path.Points[i], points[i], 1e-4) << "point " << i / 2;
+			EXPECT_NEAR(path.Points[i + 1], -points[i + 1], 1e-4) << "point " << i / 2;
+		}
+	}
+
+	const PathVerb M = PathVerb::Move, L = PathVerb::Line, C = PathVerb::Cubic, Z = PathVerb::Close;
+
+	struct CffFont
+	{
+		std::vector<uint8_t> Data;
+		CffTable Table;
+
+		explicit CffFont(std::vector<uint8_t> data, bool cff2 = false) : Data(std::move(data))
+		{
+			EXPECT_TRUE(Table.Load(Span(Data), cff2));
+		}
+
+		bool Decode(uint16_t glyph, GlyphPath& path)
+		{
+			return Table.Decode(glyph, path, 1);
+		}
+	};
+}
+
+TEST(CffTable, DrawsLinesAndCurvesAfterWidth)
+{
+	CffFont font(MakeCff({
+		CharString().Op(endchar),
+		CharString().N({ 50, 10, 20 }).Op(rmoveto).N({ 30, 0 }).Op(rlineto).N({ 0, 30, 10, 10, 10, 0 }).Op(rrcurveto).Op(endchar),
+		}));
+	EXPECT_EQ(font.Table.CharStrings.Count, 2u);
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, L, C, Z }, { 10, 20, 40, 20, 40, 50, 50, 60, 60, 60 });
+}
+
+TEST(CffTable, AlternatesCurveDirectionsWithTrailingOperand)
+{
+	CffFont font(MakeCff({
+		CharString().Op(endchar),
+		CharString().N({ 0, 0 }).Op(rmoveto).N({ 10, 20, 30, 40, 50, 60, 70, 80, 5 }).Op(hvcurveto).Op(endchar),
+		}));
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, C, C, Z }, { 0, 0, 10, 0, 30, 30, 30, 70, 30, 120, 90, 190, 170, 195 });
+}
+
+TEST(CffTable, CallsLocalAndGlobalSubroutinesWithBias)
+{
+	CffFont font(MakeCff(
+		{
+			CharString().Op(endchar),
+			CharString().N({ 0, 0 }).Op(rmoveto).N(-107).Op(callsubr).N(-107).Op(callgsubr).Op(endchar),
+		},
+		{ CharString().N({ 0, 30 }).Op(rlineto).Op(return_) },
+		{ CharString().N({ 30, 0 }).Op(rlineto).Op(return_) }));
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, L, L, Z }, { 0, 0, 30, 0, 30, 30 });
+}
+
+TEST(CffTable, SkipsHintMaskBytesIncludingImpliedStems)
+{
+	// Five hstems plus four implied vstems need a two byte mask. The second
+	// byte is an rmoveto with no operands if it isn't skipped.
+	CffFont font(MakeCff({
+		CharString().Op(endchar),
+		CharString()
+			.N({ 0, 10, 20, 10, 40, 10, 60, 10, 80, 10 }).Op(hstemhm)
+			.N({ 0, 10, 20, 10, 40, 10, 60, 10 }).Op(hintmask).Raw(0xFF).Raw(rmoveto)
+			.N({ 0, 0 }).Op(rmoveto).N({ 10, 0 }).Op(rlineto).Op(endchar),
+		}));
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, L, Z }, { 0, 0, 10, 0 });
+}
+
+TEST(CffTable, DrawsFlex)
+{
+	CffFont font(MakeCff({
+		CharString().Op(endchar),
+		CharString().N({ 0, 0 }).Op(rmoveto).N({ 10, 0, 10, 5, 10, 5, 10, -5, 10, -5, 10, 0, 50 }).Op2(flex).Op(endchar),
+		}));
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, C, C, Z }, { 0, 0, 10, 0, 20, 5, 30, 10, 40, 5, 50, 0, 60, 0 });
+}
+
+TEST(CffTable, DrawsHFlexBackToStartingHeight)
+{
+	CffFont font(MakeCff({
+		CharString().Op(endchar),
+		CharString().N({ 0, 0 }).Op(rmoveto).N({ 10, 10, 5, 10, 10, 10, 10 }).Op2(hflex).Op(endchar),
+		CharString().N({ 0, 0 }).Op(rmoveto).N({ 10, 2, 10, 3, 10, 10, 10, -4, 10 }).Op2(hflex1).Op(endchar),
+		}));
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, C, C, Z }, { 0, 0, 10, 0, 20, 5, 30, 5, 40, 5, 50, 0, 60, 0 });
+
+	ASSERT_TRUE(font.Decode(2, path));
+	ExpectPath(path, { M, C, C, Z }, { 0, 0, 10, 2, 20, 5, 30, 5, 40, 5, 50, 1, 60, 0 });
+}
+
+TEST(CffTable, DrawsFlex1AlongTheLongerAxis)
+{
+	CffFont font(MakeCff({
+		CharString().Op(endchar),
+		CharString().N({ 0, 0 }).Op(rmoveto).N({ 10, 2, 10, 3, 10, 1, 10, -1, 10, -2, 10 }).Op2(flex1).Op(endchar),
+		CharString().N({ 0, 0 }).Op(rmoveto).N({ 2, 10, 3, 10, 1, 10, -1, 10, -2, 10, 10 }).Op2(flex1).Op(endchar),
+		}));
+
+	// Mostly horizontal: the last operand is dx, and y returns to the start
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, C, C, Z }, { 0, 0, 10, 2, 20, 5, 30, 6, 40, 5, 50, 3, 60, 0 });
+
+	// Mostly vertical: the last operand is dy, and x returns to the start
+	ASSERT_TRUE(font.Decode(2, path));
+	ExpectPath(path, { M, C, C, Z }, { 0, 0, 2, 10, 5, 20, 6, 30, 5, 40, 3, 50, 0, 60 });
+}
+
+TEST(CffTable, DrawsSeacAccentedGlyphs)
+{
+	// SID 34 is "A" (StandardEncoding 65) and SID 125 "acute" (194)
+	CffFont font(MakeCff(
+		{
+			CharString().Op(endchar),
+			CharString().N({ 0, 0 }).Op(rmoveto).N({ 100, 0, 0, 100 }).Op(rlineto).Op(endchar),
+			CharString().N({ 0, 0 }).Op(rmoveto).N({ 10, 0, 0, 10 }).Op(rlineto).Op(endchar),
+			CharString().N({ 500, 40, 110, 65, 194 }).Op(endchar),
+		},
+		{}, {}, { 34, 125 }));
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(3, path));
+	ExpectPath(path, { M, L, L, Z, M, L, L, Z }, { 0, 0, 100, 0, 100, 100, 40, 110, 50, 110, 50, 120 });
+
+	PathBounds bounds;
+	ASSERT_TRUE(font.Table.GetBounds(3, bounds, 1, true));
+	EXPECT_FLOAT_EQ(bounds.Right, 100);
+	EXPECT_FLOAT_EQ(bounds.Top, -120);
+
+	// Codes that aren't in the charset fail the glyph
+	font.Data = MakeCff({ CharString().Op(endchar), CharString().N({ 0, 0, 65, 194 }).Op(endchar) });
+	ASSERT_TRUE(font.Table.Load(Span(font.Data), false));
+	EXPECT_FALSE(font.Decode(1, path));
+}
+
+TEST(CffTable, RejectsMalformedCharStrings)
+{
+	CharString overflow;
+	for (int i = 0; i < 600; i++)
+		overflow.N(1);
+
+	CffFont font(MakeCff(
+		{
+			CharString().Op(endchar),
+			CharString().N({ 10, 10 }).Op(rlineto).Op(endchar),
+			CharString().N({ 0, 0 }).Op(rmoveto).N({ 1, 2 }).Op2(10).Op(endchar),
+			CharString().N({ 0, 0 }).Op(rmoveto).N(-107).Op(callsubr).Op(endchar),
+			CharString().N({ 0, 0 }).Op(rmoveto).N(5).Op(callsubr).Op(endchar),
+			CharString().N({ 0, 0 }).Op(rmoveto).Raw(28).Raw(1),
+			overflow.Op(endchar),
+		},
+		{},
+		{ CharString().N(-107).Op(callsubr) }));
+
+	GlyphPath path;
+	EXPECT_FALSE(font.Decode(1, path)) << "line before moveto";
+	EXPECT_FALSE(font.Decode(2, path)) << "deprecated arithmetic";
+	EXPECT_FALSE(font.Decode(3, path)) << "recursive subroutine";
+	EXPECT_FALSE(font.Decode(4, path)) << "subroutine out of range";
+	EXPECT_FALSE(font.Decode(5, path)) << "truncated operand";
+	EXPECT_FALSE(font.Decode(6, path)) << "stack overflow";
+	EXPECT_FALSE(font.Decode(7, path)) << "glyph out of range";
+}
+
+TEST(CffTable, BlendsCff2DeltasAtTheVariationCoordinates)
+{
+	CffFont font(MakeCff2({
+		CharString(),
+		CharString().N({ 0, 0 }).Op(rmoveto).N({ 100, 200, 50, -20, 2 }).Op(blend).Op(rlineto),
+		CharString().N(1).Op(vsindex).N({ 0, 0 }).Op(rmoveto).N({ 100, 10, 20, 1 }).Op(blend).N(0).Op(rlineto),
+		}), true);
+	ASSERT_TRUE(font.Table.IsCff2());
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, L, Z }, { 0, 0, 100, 200 });
+	ASSERT_TRUE(font.Decode(2, path));
+	ExpectPath(path, { M, L, Z }, { 0, 0, 100, 0 });
+
+	float coord = 0.5f;
+	font.Table.SetVariationCoordinates(&coord, 1);
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, L, Z }, { 0, 0, 125, 190 });
+	ASSERT_TRUE(font.Decode(2, path));
+	ExpectPath(path, { M, L, Z }, { 0, 0, 105, 0 });
+
+	coord = -1;
+	font.Table.SetVariationCoordinates(&coord, 1);
+	ASSERT_TRUE(font.Decode(1, path));
+	ExpectPath(path, { M, L, Z }, { 0, 0, 100, 200 });
+	ASSERT_TRUE(font.Decode(2, path));
+	ExpectPath(path, { M, L, Z }, { 0, 0, 120, 0 });
+}
+
+TEST(CffTable, RejectsType1OperatorsInCff2)
+{
+	CffFont font(MakeCff2({
+		CharString(),
+		CharString().N({ 0, 0 }).Op(rmoveto).Op(endchar),
+		CharString().N({ 0, 0 }).Op(rmoveto).Op(return_),
+		CharString().N({ 0, 0 }).Op(rmoveto).N({ 1, 2, 3 }).Op(blend),
+		}), true);
+
+	GlyphPath path;
+	EXPECT_FALSE(font.Decode(1, path));
+	EXPECT_FALSE(font.Decode(2, path));
+	EXPECT_FALSE(font.Decode(3, path)) << "blend without enough operands";
+}
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "DeflateDecoder.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	/// <summary>
+	/// Compresses with zlib. Negative window bits write raw DEFLATE.
+	/// </summary>
+	std::vector<uint8_t> Compress(const std::vector<uint8_t>& data, int level, int strategy = Z_DEFAULT_STRATEGY, int windowBits = 15)
+	{
+		z_stream stream = {};
+		EXPECT_EQ(Z_OK, deflateInit2(&stream, level, Z_DEFLATED, windowBits, 8, strategy));
+
+		std::vector<uint8_t> out(deflateBound(&stream, static_cast<uLong>(data.size())));
+		stream.next_in = const_cast<Bytef*>(data.data());
+		stream.avail_in = static_cast<uInt>(data.size());
+		stream.next_out = out.data();
+		stream.avail_out = static_cast<uInt>(out.size());
+
+		EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+		out.resize(stream.total_out);
+		deflateEnd(&stream);
+		return out;
+	}
+
+	bool Inflate(const std::vector<uint8_t>& compressed, std::vector<uint8_t>& output)
+	{
+		return DeflateDecoder::InflateZlib(Span(compressed), output.data(), static_cast<uint32_t>(output.size()));
+	}
+
+	std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<uint8_t> data(size);
+		for (uint8_t& b : data)
+			b = static_cast<uint8_t>(random());
+		return data;
+	}
+
+	/// <summary>
+	/// Font-like data: short runs, repeated records and some noise, with
+	/// matches as far back as the window allows.
+	/// </summary>
+	std::vector<uint8_t> MixedBytes(size_t size, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<uint8_t> data;
+		data.reserve(size);
+		while (data.size() < size)
+		{
+			switch (random() % 4)
+			{
+			case 0:
+				data.insert(data.end(), random() % 300, static_cast<uint8_t>(random()));
+				break;
+			case 1:
+				if (data.size() > 0)
+				{
+					size_t distance = 1 + random() % std::min<size_t>(data.size(), 32768);
+					size_t length = 3 + random() % 300;
+					for (size_t i = 0; i < length; i++)
+						data.push_back(data[data.size() - distance]);
+				}
+				break;
+			default:
+				for (uint32_t i = random() % 40; i > 0; i--)
+					data.push_back(static_cast<uint8_t>(random() % 16));
+				break;
+			}
+		}
+
+		data.resize(size);
+		return data;
+	}
+
+	std::vector<std::vector<uint8_t>> Inputs()
+	{
+		std::string text;
+		for (int i = 0; i < 2000; i++)
+			text += "The quick brown fox jumps over the lazy dog " + std::to_string(i) + ". ";
+
+		return {
+			{},
+			{ 42 },
+			std::vector<uint8_t>(text.begin(), text.end()),
+			std::vector<uint8_t>(100000, 0),
+			RandomBytes(70000, 1),
+			MixedBytes(200000, 2),
+		};
+	}
+}
+
+TEST(DeflateDecoder, MatchesZlibAtEveryLevel)
+{
+	// Level 0 writes stored blocks, and random data stays stored at
+	// every level, so all three block types are covered
+	for (const std::vector<uint8_t>& data : Inputs())
+	{
+		for (int level = 0; level <= 9; level++)
+		{
+			std::vector<uint8_t> output(data.size());
+			ASSERT_TRUE(Inflate(Compress(data, level), output)) << "level " << level << ", " << data.size() << " bytes";
+			ASSERT_EQ(data, output) << "level " << level << ", " << data.size() << " bytes";
+		}
+	}
+}
+
+TEST(DeflateDecoder, MatchesZlibWithEachStrategy)
+{
+	for (int strategy : { Z_FIXED, Z_HUFFMAN_ONLY, Z_RLE, Z_FILTERED })
+	{
+		for (const std::vector<uint8_t>& data : Inputs())
+		{
+			std::vector<uint8_t> output(data.size());
+			ASSERT_TRUE(Inflate(Compress(data, 9, strategy), output)) << "strategy " << strategy;
+			ASSERT_EQ(data, output) << "strategy " << strategy;
+		}
+	}
+}
+
+TEST(DeflateDecoder, InflatesRawDeflate)
+{
+	std::vector<uint8_t> data = MixedBytes(50000, 3);
+	std::vector<uint8_t> compressed = Compress(data, 6, Z_DEFAULT_STRATEGY, -15);
+
+	std::vector<uint8_t> output(data.size() + 100);
+	uint32_t written = 0;
+	ASSERT_TRUE(DeflateDecoder::InflateRaw(Span(compressed), output.data(), static_cast<uint32_t>(output.size()), written));
+	ASSERT_EQ(data.size(), written);
+	output.resize(written);
+	EXPECT_EQ(data, output);
+}
+
+TEST(DeflateDecoder, ComputesAdler32LikeZlib)
+{
+	std::vector<uint8_t> data = RandomBytes(20000, 4);
+	for (uint32_t size : { 0u, 1u, 5551u, 5552u, 5553u, 20000u })
+		EXPECT_EQ(adler32(1, data.data(), size), DeflateDecoder::Adler32(data.data(), size)) << size;
+
+	std::vector<uint8_t> ones(100000, 0xFF);
+	EXPECT_EQ(adler32(1, ones.data(), 100000), DeflateDecoder::Adler32(ones.data(), 100000));
+}
+
+TEST(DeflateDecoder, RejectsWrongChecksumOrLength)
+{
+	std::vector<uint8_t> data = MixedBytes(10000, 5);
+	std::vector<uint8_t> compressed = Compress(data, 6);
+
+	std::vector<uint8_t> bad = compressed;
+	bad.back() ^= 1;
+	std::vector<uint8_t> output(data.size());
+	EXPECT_FALSE(Inflate(bad, output));
+
+	std::vector<uint8_t> shorter(data.size() - 1);
+	EXPECT_FALSE(Inflate(compressed, shorter));
+
+	std::vector<uint8_t> longer(data.size() + 1);
+	EXPECT_FALSE(Inflate(compressed, longer));
+}
+
+TEST(DeflateDecoder, RejectsBadHeaders)
+{
+	std::vector<uint8_t> data(1000, 'a');
+	std::vector<uint8_t> compressed = Compress(data, 6);
+	std::vector<uint8_t> output(data.size());
+
+	auto withHeader = [&](uint8_t cmf, uint8_t flg)
+	{
+		std::vector<uint8_t> bad = compressed;
+		bad[0] = cmf;
+		bad[1] = flg;
+		return bad;
+	};
+
+	// Method other than deflate, window over 32K, a preset dictionary,
+	// and a header check that doesn't divide by 31
+	EXPECT_FALSE(Inflate(withHeader(0x77, 0x09), output));
+	EXPECT_FALSE(Inflate(withHeader(0x88, 0x1C), output));
+	EXPECT_FALSE(Inflate(withHeader(0x78, 0xBB), output));
+	EXPECT_FALSE(Inflate(withHeader(0x78, 0x9D), output));
+	EXPECT_TRUE(Inflate(withHeader(0x78, 0x01), output));
+}
+
+TEST(DeflateDecoder, RejectsTruncatedStreams)
+{
+	std::vector<uint8_t> data = MixedBytes(5000, 6);
+	for (int level : { 0, 1, 9 })
+	{
+		std::vector<uint8_t> compressed = Compress(data, level);
+		std::vector<uint8_t> output(data.size());
+		for (size_t size = 0; size < compressed.size(); size++)
+		{
+			std::vector<uint8_t> prefix(compressed.begin(), compressed.begin() + size);
+			ASSERT_FALSE(Inflate(prefix, output)) << "level " << level << ", " << size << " bytes";
+		}
+	}
+}
+
+TEST(DeflateDecoder, RejectsDistancesBeforeTheStart)
+{
+	// A fixed block whose first symbol is a length 3, distance 1 match
+	ByteWriter w;
+	w.U8(0x78).U8(0x01)
+		.U8(0x03).U8(0x02).U8(0x00)
+		.U32(0);
+
+	std::vector<uint8_t> output(3);
+	EXPECT_FALSE(Inflate(w.Data, output));
+}
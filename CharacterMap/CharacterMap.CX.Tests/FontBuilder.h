@@ -0,0 +1,357 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "SfntData.h"
+
+/*
+	Helpers for building font data in tests. Everything is written
+	big-endian, as it is stored in a font, so the tests can describe
+	exactly the bytes a parser will see.
+*/
+
+namespace CharacterMapCX
+{
+	namespace Tests
+	{
+		class ByteWriter
+		{
+		public:
+			std::vector<uint8_t> Data;
+
+			ByteWriter& U8(uint32_t value)
+			{
+				Data.push_back(static_cast<uint8_t>(value));
+				return *this;
+			}
+
+			ByteWriter& U16(uint32_t value)
+			{
+				return U8(value >> 8).U8(value);
+			}
+
+			ByteWriter& I16(int32_t value)
+			{
+				return U16(static_cast<uint16_t>(value));
+			}
+
+			ByteWriter& U24(uint32_t value)
+			{
+				return U8(value >> 16).U8(value >> 8).U8(value);
+			}
+
+			ByteWriter& U32(uint32_t value)
+			{
+				return U16(value >> 16).U16(value);
+			}
+
+			ByteWriter& Tag(const char* tag)
+			{
+				return U8(tag[0]).U8(tag[1]).U8(tag[2]).U8(tag[3]);
+			}
+
+			ByteWriter& Bytes(const std::vector<uint8_t>& bytes)
+			{
+				Data.insert(Data.end(), bytes.begin(), bytes.end());
+				return *this;
+			}
+
+			ByteWriter& Zeros(size_t count)
+			{
+				Data.resize(Data.size() + count);
+				return *this;
+			}
+
+			ByteWriter& Align(size_t alignment)
+			{
+				while (Data.size() % alignment != 0)
+					Data.push_back(0);
+
+				return *this;
+			}
+
+			void SetU16(size_t offset, uint32_t value)
+			{
+				Data[offset] = static_cast<uint8_t>(value >> 8);
+				Data[offset + 1] = static_cast<uint8_t>(value);
+			}
+
+			void SetU32(size_t offset, uint32_t value)
+			{
+				SetU16(offset, value >> 16);
+				SetU16(offset + 2, value);
+			}
+
+			uint32_t Size() const { return static_cast<uint32_t>(Data.size()); }
+		};
+
+		typedef std::pair<std::string, std::vector<uint8_t>> TableData;
+
+		inline uint32_t TableChecksum(const std::vector<uint8_t>& data)
+		{
+			uint32_t sum = 0;
+			for (size_t i = 0; i < data.size(); i += 4)
+			{
+				uint32_t word = 0;
+				for (size_t k = 0; k < 4; k++)
+					word = (word << 8) | (i + k < data.size() ? data[i + k] : 0);
+
+				sum += word;
+			}
+
+			return sum;
+		}
+
+		/// <summary>
+		/// Builds an sfnt with a sorted table directory. Tables are padded to
+		/// four bytes and their checksums are filled in.
+		/// </summary>
+		inline std::vector<uint8_t> BuildSfnt(std::vector<TableData> tables, uint32_t version = 0x00010000)
+		{
+			std::sort(tables.begin(), tables.end(),
+				[](const TableData& a, const TableData& b) { return a.first < b.first; });
+
+			uint16_t count = static_cast<uint16_t>(tables.size());
+			uint16_t power = 1, log = 0;
+			while (power * 2 <= count)
+			{
+				power *= 2;
+				log++;
+			}
+
+			ByteWriter w;
+			w.U32(version).U16(count).U16(power * 16).U16(log).U16(count * 16 - power * 16);
+
+			uint32_t offset = 12 + count * 16u;
+			for (const TableData& t : tables)
+			{
+				w.Tag(t.first.c_str()).U32(TableChecksum(t.second)).U32(offset).U32(static_cast<uint32_t>(t.second.size()));
+				offset += (static_cast<uint32_t>(t.second.size()) + 3) & ~3u;
+			}
+
+			for (const TableData& t : tables)
+				w.Bytes(t.second).Align(4);
+
+			return w.Data;
+		}
+
+		/// <summary>
+		/// Finds a table in an sfnt, or returns an empty span.
+		/// </summary>
+		inline ByteSpan FindTable(ByteSpan font, const char* tag)
+		{
+			uint32_t value = MakeSfntTag(tag[0], tag[1], tag[2], tag[3]);
+			uint16_t count = font.UInt16(4);
+			for (uint16_t i = 0; i < count; i++)
+			{
+				uint32_t record = 12 + i * 16u;
+				if (font.UInt32(record) == value)
+					return font.Slice(font.UInt32(record + 8), font.UInt32(record + 12));
+			}
+
+			return ByteSpan();
+		}
+
+		inline ByteSpan Span(const std::vector<uint8_t>& data)
+		{
+			return ByteSpan(data.data(), static_cast<uint32_t>(data.size()));
+		}
+
+		inline std::vector<uint8_t> MakeHead(uint16_t unitsPerEm, bool longLoca)
+		{
+			ByteWriter w;
+			w.U32(0x00010000).U32(0x00010000).U32(0).U32(0x5F0F3CF5)
+				.U16(0).U16(unitsPerEm)
+				.Zeros(16)
+				.I16(0).I16(0).I16(0).I16(0)
+				.U16(0).U16(8).I16(2)
+				.I16(longLoca ? 1 : 0).I16(0);
+			return w.Data;
+		}
+
+		inline std::vector<uint8_t> MakeMaxp(uint16_t numGlyphs)
+		{
+			ByteWriter w;
+			w.U32(0x00005000).U16(numGlyphs);
+			return w.Data;
+		}
+
+		struct NameRecord
+		{
+			uint16_t Platform;
+			uint16_t Encoding;
+			uint16_t NameId;
+			std::vector<uint8_t> Bytes;
+		};
+
+		inline std::vector<uint8_t> Utf16(const std::u16string& text)
+		{
+			ByteWriter w;
+			for (char16_t c : text)
+				w.U16(c);
+			return w.Data;
+		}
+
+		/// <summary>
+		/// Builds a version 0 name table with the strings stored in record
+		/// order.
+		/// </summary>
+		inline std::vector<uint8_t> MakeName(const std::vector<NameRecord>& records)
+		{
+			ByteWriter w;
+			w.U16(0).U16(static_cast<uint32_t>(records.size())).U16(6 + 12 * static_cast<uint32_t>(records.size()));
+
+			uint32_t offset = 0;
+			for (const NameRecord& r : records)
+			{
+				w.U16(r.Platform).U16(r.Encoding).U16(0x409).U16(r.NameId)
+					.U16(static_cast<uint32_t>(r.Bytes.size())).U16(offset);
+				offset += static_cast<uint32_t>(r.Bytes.size());
+			}
+
+			for (const NameRecord& r : records)
+				w.Bytes(r.Bytes);
+
+			return w.Data;
+		}
+
+		/// <summary>
+		/// Writes a CFF INDEX with four byte offsets. CFF2 INDEXes have a
+		/// 32-bit count.
+		/// </summary>
+		inline std::vector<uint8_t> CffIndex(const std::vector<std::vector<uint8_t>>& objects, bool cff2)
+		{
+			ByteWriter w;
+			cff2 ? w.U32(static_cast<uint32_t>(objects.size())) : w.U16(static_cast<uint32_t>(objects.size()));
+			if (objects.empty())
+				return w.Data;
+
+			w.U8(4);
+			uint32_t offset = 1;
+			w.U32(offset);
+			for (const auto& o : objects)
+				w.U32(offset += static_cast<uint32_t>(o.size()));
+
+			for (const auto& o : objects)
+				w.Bytes(o);
+
+			return w.Data;
+		}
+
+		/// <summary>
+		/// Writes a DICT integer operand in its fixed five byte form, so offsets
+		/// can be filled in without changing the DICT's size.
+		/// </summary>
+		inline void CffDictInt(ByteWriter& w, uint32_t value)
+		{
+			w.U8(29).U32(value);
+		}
+
+		typedef std::vector<std::vector<uint8_t>> CffObjects;
+
+		/// <summary>
+		/// Builds a name-keyed CFF table. Glyph ids 1 and up are given the SIDs
+		/// in charset, in order.
+		/// </summary>
+		inline std::vector<uint8_t> MakeCff(const CffObjects& glyphs, const CffObjects& globalSubrs = {}, const CffObjects& localSubrs = {}, std::vector<uint16_t> charset = {})
+		{
+			charset.resize(glyphs.size() - 1, 400);
+
+			ByteWriter charsetData;
+			charsetData.U8(0);
+			for (uint16_t sid : charset)
+				charsetData.U16(sid);
+
+			std::vector<uint8_t> name = CffIndex({ { 'T', 'e', 's', 't' } }, false);
+			std::vector<uint8_t> strings = CffIndex({}, false);
+			std::vector<uint8_t> global = CffIndex(globalSubrs, false);
+			std::vector<uint8_t> charStrings = CffIndex(glyphs, false);
+			std::vector<uint8_t> local = CffIndex(localSubrs, false);
+
+			const uint32_t TopDictSize = 23, PrivateSize = 6;
+			uint32_t topDictIndexSize = static_cast<uint32_t>(CffIndex({ std::vector<uint8_t>(TopDictSize) }, false).size());
+			uint32_t charsetOffset = 4 + static_cast<uint32_t>(name.size()) + topDictIndexSize + static_cast<uint32_t>(strings.size() + global.size());
+			uint32_t charStringsOffset = charsetOffset + charsetData.Size();
+			uint32_t privateOffset = charStringsOffset + static_cast<uint32_t>(charStrings.size());
+
+			ByteWriter top;
+			CffDictInt(top, charsetOffset);
+			top.U8(15);
+			CffDictInt(top, charStringsOffset);
+			top.U8(17);
+			CffDictInt(top, PrivateSize);
+			CffDictInt(top, privateOffset);
+			top.U8(18);
+
+			ByteWriter priv;
+			CffDictInt(priv, PrivateSize);
+			priv.U8(19);
+
+			ByteWriter w;
+			w.U8(1).U8(0).U8(4).U8(4)
+				.Bytes(name)
+				.Bytes(CffIndex({ top.Data }, false))
+				.Bytes(strings)
+				.Bytes(global)
+				.Bytes(charsetData.Data)
+				.Bytes(charStrings)
+				.Bytes(priv.Data)
+				.Bytes(local);
+			return w.Data;
+		}
+
+		/// <summary>
+		/// Builds a CFF2 table with one axis and two ItemVariationData: the
+		/// first uses region 0, peaking at +1, and the second uses region 0 and
+		/// region 1, which peaks at -1.
+		/// </summary>
+		inline std::vector<uint8_t> MakeCff2(const CffObjects& glyphs)
+		{
+			ByteWriter store;
+			store.U16(1).U32(16).U16(2).U32(32).U32(40);
+			store.U16(1).U16(2)
+				.I16(0).I16(16384).I16(16384)
+				.I16(-16384).I16(-16384).I16(0);
+			store.U16(0).U16(0).U16(1).U16(0);
+			store.U16(0).U16(0).U16(2).U16(0).U16(1);
+
+			std::vector<uint8_t> global = CffIndex({}, true);
+			std::vector<uint8_t> charStrings = CffIndex(glyphs, true);
+
+			const uint32_t TopDictSize = 19, HeaderSize = 5;
+			uint32_t vstoreOffset = HeaderSize + TopDictSize + static_cast<uint32_t>(global.size());
+			uint32_t charStringsOffset = vstoreOffset + 2 + store.Size();
+			uint32_t fdArrayOffset = charStringsOffset + static_cast<uint32_t>(charStrings.size());
+
+			const uint32_t FontDictSize = 11;
+			uint32_t privateOffset = fdArrayOffset + static_cast<uint32_t>(CffIndex({ std::vector<uint8_t>(FontDictSize) }, true).size());
+
+			ByteWriter top;
+			CffDictInt(top, charStringsOffset);
+			top.U8(17);
+			CffDictInt(top, fdArrayOffset);
+			top.U8(12).U8(36);
+			CffDictInt(top, vstoreOffset);
+			top.U8(24);
+
+			// An empty Private DICT
+			ByteWriter font;
+			CffDictInt(font, 0);
+			CffDictInt(font, privateOffset);
+			font.U8(18);
+
+			ByteWriter w;
+			w.U8(2).U8(0).U8(HeaderSize).U16(top.Size())
+				.Bytes(top.Data)
+				.Bytes(global)
+				.U16(store.Size()).Bytes(store.Data)
+				.Bytes(charStrings)
+				.Bytes(CffIndex({ font.Data }, true));
+			return w.Data;
+		}
+	}
+}
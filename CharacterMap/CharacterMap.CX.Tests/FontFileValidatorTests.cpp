@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "FontFileValidator.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	std::vector<uint8_t> WindowsFamily(const std::u16string& family)
+	{
+		return MakeName({ { 3, 1, 1, Utf16(family) }, { 3, 1, 2, Utf16(u"Regular") } });
+	}
+
+	/// <summary>
+	/// The tables of a font that passes, with empty glyph data. The
+	/// validator only looks inside head, maxp and name.
+	/// </summary>
+	std::vector<TableData> FontTables(const char* glyphTable = "glyf")
+	{
+		return {
+			{ "head", MakeHead(1000, false) },
+			{ "name", WindowsFamily(u"Test Sans") },
+			{ "maxp", MakeMaxp(1) },
+			{ "cmap", std::vector<uint8_t>(4) },
+			{ "hhea", std::vector<uint8_t>(36) },
+			{ "hmtx", std::vector<uint8_t>(4) },
+			{ glyphTable, std::vector<uint8_t>(4) },
+		};
+	}
+
+	std::vector<TableData> Replace(std::vector<TableData> tables, const std::string& tag, std::vector<uint8_t> data)
+	{
+		for (TableData& t : tables)
+		{
+			if (t.first == tag)
+				t.second = std::move(data);
+		}
+
+		return tables;
+	}
+
+	FontFileStatus Validate(const std::vector<uint8_t>& file)
+	{
+		return FontFileValidator::Validate(Span(file));
+	}
+
+	FontFileStatus Validate(const std::vector<TableData>& tables, uint32_t version = 0x00010000)
+	{
+		return Validate(BuildSfnt(tables, version));
+	}
+
+	/// <summary>
+	/// Joins fonts into a collection, moving their table offsets to be
+	/// from the start of the file.
+	/// </summary>
+	std::vector<uint8_t> BuildCollection(const std::vector<std::vector<uint8_t>>& fonts)
+	{
+		ByteWriter w;
+		w.Tag("ttcf").U32(0x00010000).U32(static_cast<uint32_t>(fonts.size()));
+
+		uint32_t offset = 12 + 4 * static_cast<uint32_t>(fonts.size());
+		for (const std::vector<uint8_t>& font : fonts)
+		{
+			w.U32(offset);
+			offset += static_cast<uint32_t>(font.size());
+		}
+
+		for (const std::vector<uint8_t>& font : fonts)
+		{
+			uint32_t start = w.Size();
+			w.Bytes(font);
+
+			ByteSpan span = Span(font);
+			for (uint32_t i = 0; i < span.UInt16(4); i++)
+			{
+				uint32_t record = 12 + i * 16;
+				w.SetU32(start + record + 8, span.UInt32(record + 8) + start);
+			}
+		}
+
+		return w.Data;
+	}
+
+	std::vector<uint8_t> WoffHeader(const std::vector<std::string>& tags, uint32_t compLength, uint32_t origLength)
+	{
+		uint32_t count = static_cast<uint32_t>(tags.size());
+		uint32_t dataOffset = 44 + count * 20;
+		uint32_t length = dataOffset + count * compLength;
+
+		ByteWriter w;
+		w.Tag("wOFF").U32(0x00010000).U32(length).U16(count).U16(0)
+			.U32(12 + count * 16 + count * origLength).U16(1).U16(0)
+			.Zeros(20);
+
+		for (uint32_t i = 0; i < count; i++)
+			w.Tag(tags[i].c_str()).U32(dataOffset + i * compLength).U32(compLength).U32(origLength).U32(0);
+
+		return w.Zeros(count * compLength).Data;
+	}
+
+	std::vector<uint8_t> Woff2Header(uint32_t totalCompressedSize, uint32_t dataSize)
+	{
+		ByteWriter w;
+		w.Tag("wOF2").U32(0x00010000).U32(48 + dataSize).U16(1).U16(0)
+			.U32(1000).U32(totalCompressedSize).Zeros(24);
+
+		return w.Zeros(dataSize).Data;
+	}
+}
+
+TEST(FontFileValidator, AcceptsTrueTypeAndCffFonts)
+{
+	EXPECT_EQ(FontFileStatus::Valid, Validate(FontTables()));
+	EXPECT_EQ(FontFileStatus::Valid, Validate(FontTables(), MakeSfntTag('t', 'r', 'u', 'e')));
+	EXPECT_EQ(FontFileStatus::Valid, Validate(FontTables("CFF "), MakeSfntTag('O', 'T', 'T', 'O')));
+	EXPECT_EQ(FontFileStatus::Valid, Validate(FontTables("CFF2"), MakeSfntTag('O', 'T', 'T', 'O')));
+}
+
+TEST(FontFileValidator, AcceptsBitmapOnlyFonts)
+{
+	EXPECT_EQ(FontFileStatus::Valid, Validate(FontTables("CBDT")));
+	EXPECT_EQ(FontFileStatus::Valid, Validate(FontTables("sbix")));
+	EXPECT_EQ(FontFileStatus::Valid, Validate(FontTables("EBDT")));
+}
+
+TEST(FontFileValidator, RejectsEachMissingTable)
+{
+	std::vector<TableData> tables = FontTables();
+	for (size_t i = 0; i < tables.size(); i++)
+	{
+		std::vector<TableData> missing = tables;
+		missing.erase(missing.begin() + i);
+		EXPECT_EQ(FontFileStatus::MissingTable, Validate(missing)) << tables[i].first;
+	}
+
+	// A glyph table nobody draws from doesn't count
+	EXPECT_EQ(FontFileStatus::MissingTable, Validate(FontTables("loca")));
+}
+
+TEST(FontFileValidator, RejectsBadHeadAndMaxp)
+{
+	std::vector<uint8_t> head = MakeHead(1000, false);
+	head[12] = 0;
+	EXPECT_EQ(FontFileStatus::BadTable, Validate(Replace(FontTables(), "head", head)));
+
+	head = MakeHead(1000, false);
+	head.resize(53);
+	EXPECT_EQ(FontFileStatus::BadTable, Validate(Replace(FontTables(), "head", head)));
+
+	EXPECT_EQ(FontFileStatus::BadTable, Validate(Replace(FontTables(), "maxp", MakeMaxp(0))));
+	EXPECT_EQ(FontFileStatus::BadTable, Validate(Replace(FontTables(), "maxp", std::vector<uint8_t>(4))));
+}
+
+TEST(FontFileValidator, RequiresReadableFamilyName)
+{
+	auto status = [](const std::vector<NameRecord>& records)
+	{
+		return Validate(Replace(FontTables(), "name", MakeName(records)));
+	};
+
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, status({ { 3, 1, 1, Utf16(u"  ") } }));
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, status({ { 3, 1, 1, Utf16(std::u16string(3, u'\0')) } }));
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, status({ { 3, 1, 1, {} } }));
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, status({ { 3, 1, 2, Utf16(u"Regular") } }));
+
+	// Windows Shift JIS and other legacy encodings aren't read
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, status({ { 3, 2, 1, Utf16(u"Test") } }));
+
+	EXPECT_EQ(FontFileStatus::Valid, status({ { 3, 1, 1, Utf16(u" A ") } }));
+	EXPECT_EQ(FontFileStatus::Valid, status({ { 3, 10, 1, Utf16(u"Test") } }));
+	EXPECT_EQ(FontFileStatus::Valid, status({ { 3, 0, 1, Utf16(u"Symbol") } }));
+	EXPECT_EQ(FontFileStatus::Valid, status({ { 0, 3, 1, Utf16(u"Test") } }));
+
+	// A blank Windows name falls back to a Macintosh one
+	EXPECT_EQ(FontFileStatus::Valid, status({ { 3, 1, 1, Utf16(u" ") }, { 1, 0, 1, { 'T', 'e', 's', 't' } } }));
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, status({ { 1, 0, 1, { ' ', 0 } } }));
+}
+
+TEST(FontFileValidator, IgnoresNamesOutsideTheNameTable)
+{
+	std::vector<uint8_t> name = WindowsFamily(u"Test");
+
+	ByteWriter w;
+	w.Data = name;
+	w.SetU16(6 + 10, 0x1000);
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, Validate(Replace(FontTables(), "name", w.Data)));
+
+	// Record count past the end of the table
+	w.Data = name;
+	w.SetU16(2, 100);
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, Validate(Replace(FontTables(), "name", w.Data)));
+}
+
+TEST(FontFileValidator, RejectsTruncatedFiles)
+{
+	std::vector<uint8_t> font = BuildSfnt(FontTables());
+
+	// Every table is needed, so no prefix that cuts into one can pass.
+	// Only the last table's padding may go.
+	ByteSpan span = Span(font);
+	uint32_t end = 0;
+	for (uint32_t i = 0; i < span.UInt16(4); i++)
+		end = std::max(end, span.UInt32(12 + i * 16 + 8) + span.UInt32(12 + i * 16 + 12));
+
+	EXPECT_EQ(FontFileStatus::Valid, Validate(std::vector<uint8_t>(font.begin(), font.begin() + end)));
+	for (size_t size = 0; size < end; size++)
+	{
+		std::vector<uint8_t> prefix(font.begin(), font.begin() + size);
+		ASSERT_NE(FontFileStatus::Valid, Validate(prefix)) << size;
+	}
+
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(std::vector<uint8_t>(font.begin(), font.begin() + 11)));
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(std::vector<uint8_t>(font.begin(), font.begin() + 12 + 16 * 3)));
+
+	// A table whose length runs past the end of the file
+	ByteWriter w;
+	w.Data = font;
+	w.SetU32(12 + 12, static_cast<uint32_t>(font.size()));
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(w.Data));
+
+	// No tables at all
+	w.Data = font;
+	w.SetU16(4, 0);
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(w.Data));
+}
+
+TEST(FontFileValidator, RejectsUnknownFormats)
+{
+	EXPECT_EQ(FontFileStatus::UnknownFormat, Validate(std::vector<uint8_t>(100, 7)));
+	EXPECT_EQ(FontFileStatus::UnknownFormat, Validate(FontTables(), 0x00020000));
+}
+
+TEST(FontFileValidator, AcceptsACollectionWithAnyValidFont)
+{
+	std::vector<uint8_t> good = BuildSfnt(FontTables());
+	std::vector<uint8_t> nameless = BuildSfnt(Replace(FontTables(), "name", WindowsFamily(u"")));
+	std::vector<uint8_t> outlineless = BuildSfnt(FontTables("loca"));
+
+	EXPECT_EQ(FontFileStatus::Valid, Validate(BuildCollection({ good })));
+	EXPECT_EQ(FontFileStatus::Valid, Validate(BuildCollection({ good, good })));
+
+	// One bad font doesn't stop the others being used
+	EXPECT_EQ(FontFileStatus::Valid, Validate(BuildCollection({ good, nameless })));
+	EXPECT_EQ(FontFileStatus::Valid, Validate(BuildCollection({ nameless, outlineless, good })));
+
+	// When none pass, the first font's problem is reported
+	EXPECT_EQ(FontFileStatus::MissingFamilyName, Validate(BuildCollection({ nameless, outlineless })));
+	EXPECT_EQ(FontFileStatus::MissingTable, Validate(BuildCollection({ outlineless, nameless })));
+
+	// Table offsets are from the start of the collection, so a font
+	// copied in without moving them doesn't pass
+	ByteWriter w;
+	w.Tag("ttcf").U32(0x00010000).U32(1).U32(16).Bytes(good);
+	EXPECT_NE(FontFileStatus::Valid, Validate(w.Data));
+
+	std::vector<uint8_t> collection = BuildCollection({ good });
+	w.Data = collection;
+	w.SetU32(8, 0);
+	EXPECT_EQ(FontFileStatus::BadTable, Validate(w.Data));
+
+	// An offset list running past the end of the file
+	w.Data = collection;
+	w.SetU32(8, static_cast<uint32_t>(collection.size()) / 4);
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(w.Data));
+
+	w.Data = collection;
+	w.SetU32(12, static_cast<uint32_t>(collection.size()));
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(w.Data));
+}
+
+TEST(FontFileValidator, ReportsWoffAsNeedingUnpacking)
+{
+	EXPECT_EQ(FontFileStatus::NeedsUnpacking, Validate(WoffHeader({ "head", "name" }, 8, 16)));
+	EXPECT_EQ(FontFileStatus::MissingTable, Validate(WoffHeader({ "head", "glyf" }, 8, 16)));
+
+	// Compressed data larger than the table it unpacks to
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(WoffHeader({ "name" }, 16, 8)));
+
+	std::vector<uint8_t> woff = WoffHeader({ "head", "name" }, 8, 16);
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(std::vector<uint8_t>(woff.begin(), woff.end() - 1)));
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(std::vector<uint8_t>(woff.begin(), woff.begin() + 43)));
+
+	ByteWriter w;
+	w.Data = woff;
+	w.SetU16(12, 0);
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(w.Data));
+}
+
+TEST(FontFileValidator, ReportsWoff2AsNeedingUnpacking)
+{
+	EXPECT_EQ(FontFileStatus::NeedsUnpacking, Validate(Woff2Header(100, 100)));
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(Woff2Header(101, 100)));
+
+	std::vector<uint8_t> woff2 = Woff2Header(100, 100);
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(std::vector<uint8_t>(woff2.begin(), woff2.begin() + 47)));
+
+	ByteWriter w;
+	w.Data = woff2;
+	w.SetU16(12, 0);
+	EXPECT_EQ(FontFileStatus::Truncated, Validate(w.Data));
+}
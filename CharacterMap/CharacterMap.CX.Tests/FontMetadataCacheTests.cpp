@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "FontMetadataCache.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	FontMetadataKey Key(const std::u16string& path, uint32_t faceIndex = 0, uint16_t simulations = 0)
+	{
+		FontMetadataKey key;
+		key.Path = path;
+		key.FileSize = 123456;
+		key.LastWriteTime = 0x01D9A1B2C3D4E5F6ull;
+		key.FaceIndex = faceIndex;
+		key.Simulations = simulations;
+		return key;
+	}
+
+	FontMetadata Metadata(const std::u16string& family, uint16_t weight = 400)
+	{
+		FontMetadata m;
+		m.FamilyName = family;
+		m.FaceName = u"Regular";
+		m.Weight = weight;
+		return m;
+	}
+
+	struct Cache
+	{
+		std::vector<uint8_t> Data;
+		FontMetadataCacheReader Reader;
+
+		explicit Cache(FontMetadataCacheWriter& writer, const std::u16string& locale = u"en-US")
+		{
+			writer.Write(locale, Data);
+			EXPECT_TRUE(Reader.Load(Span(Data)));
+		}
+	};
+}
+
+TEST(FontMetadataCache, RoundTripsEveryField)
+{
+	FontMetadata m;
+	m.FamilyName = u"Noto Sans \u65E5\u672C";
+	m.FaceName = u"Condensed Bold Italic";
+	m.Weight = 700;
+	m.Style = 2;
+	m.Stretch = 3;
+	m.GlyphCount = 65535;
+	m.FsType = 8;
+	m.Flags = FontMetadataColor | FontMetadataVariations;
+	m.Tables = 0x8421;
+	for (uint8_t i = 0; i < 10; i++)
+		m.Panose[i] = static_cast<uint8_t>(i * 25);
+	m.UnicodeRanges[0] = 0x80000001;
+	m.UnicodeRanges[1] = 0x12345678;
+	m.UnicodeRanges[2] = 0;
+	m.UnicodeRanges[3] = 0xFFFFFFFF;
+
+	FontMetadataKey key = Key(u"C:\\Windows\\Fonts\\NotoSans.ttc", 3, 2);
+	key.FileSize = 0x123456789Aull;
+
+	FontMetadataCacheWriter writer;
+	writer.Add(key, m);
+	Cache cache(writer, u"ja-JP");
+
+	EXPECT_EQ(1u, cache.Reader.Count());
+	EXPECT_EQ(u"ja-JP", cache.Reader.Locale());
+
+	FontMetadata read;
+	ASSERT_TRUE(cache.Reader.TryGet(key, read));
+	EXPECT_EQ(m.FamilyName, read.FamilyName);
+	EXPECT_EQ(m.FaceName, read.FaceName);
+	EXPECT_EQ(m.Weight, read.Weight);
+	EXPECT_EQ(m.Style, read.Style);
+	EXPECT_EQ(m.Stretch, read.Stretch);
+	EXPECT_EQ(m.GlyphCount, read.GlyphCount);
+	EXPECT_EQ(m.FsType, read.FsType);
+	EXPECT_EQ(m.Flags, read.Flags);
+	EXPECT_EQ(m.Tables, read.Tables);
+	for (int i = 0; i < 10; i++)
+		EXPECT_EQ(m.Panose[i], read.Panose[i]);
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(m.UnicodeRanges[i], read.UnicodeRanges[i]);
+}
+
+TEST(FontMetadataCache, FindsEachOfManyFaces)
+{
+	FontMetadataCacheWriter writer;
+	std::vector<FontMetadataKey> keys;
+	for (uint16_t i = 0; i < 500; i++)
+	{
+		keys.push_back(Key(u"C:\\Fonts\\font" + std::u16string(1, static_cast<char16_t>(u'A' + i % 26)) + u".ttc", i / 26, i % 2));
+		writer.Add(keys.back(), Metadata(u"Family", i));
+	}
+
+	Cache cache(writer);
+	EXPECT_EQ(500u, cache.Reader.Count());
+
+	for (uint16_t i = 0; i < keys.size(); i++)
+	{
+		FontMetadata read;
+		ASSERT_TRUE(cache.Reader.TryGet(keys[i], read));
+		EXPECT_EQ(i, read.Weight);
+	}
+}
+
+TEST(FontMetadataCache, RejectsEntryWhenFileHasChanged)
+{
+	FontMetadataKey key = Key(u"C:\\Fonts\\arial.ttf");
+
+	FontMetadataCacheWriter writer;
+	writer.Add(key, Metadata(u"Arial"));
+	Cache cache(writer);
+
+	FontMetadata read;
+	ASSERT_TRUE(cache.Reader.TryGet(key, read));
+
+	FontMetadataKey resized = key;
+	resized.FileSize++;
+	EXPECT_FALSE(cache.Reader.TryGet(resized, read));
+
+	FontMetadataKey rewritten = key;
+	rewritten.LastWriteTime++;
+	EXPECT_FALSE(cache.Reader.TryGet(rewritten, read));
+}
+
+TEST(FontMetadataCache, MissesOtherFacesOfTheSameFile)
+{
+	FontMetadataCacheWriter writer;
+	writer.Add(Key(u"C:\\Fonts\\cambria.ttc", 0, 0), Metadata(u"Cambria"));
+	Cache cache(writer);
+
+	FontMetadata read;
+	EXPECT_FALSE(cache.Reader.TryGet(Key(u"C:\\Fonts\\cambria.ttc", 1, 0), read));
+	EXPECT_FALSE(cache.Reader.TryGet(Key(u"C:\\Fonts\\cambria.ttc", 0, 1), read));
+	EXPECT_FALSE(cache.Reader.TryGet(Key(u"C:\\Fonts\\cambria.ttf", 0, 0), read));
+}
+
+TEST(FontMetadataCache, KeepsLastEntryForRepeatedFace)
+{
+	FontMetadataKey key = Key(u"C:\\Fonts\\segoeui.ttf");
+
+	FontMetadataCacheWriter writer;
+	writer.Add(key, Metadata(u"Segoe UI", 400));
+	writer.Add(Key(u"C:\\Fonts\\other.ttf"), Metadata(u"Other"));
+	writer.Add(key, Metadata(u"Segoe UI", 600));
+	Cache cache(writer);
+
+	EXPECT_EQ(2u, cache.Reader.Count());
+
+	FontMetadata read;
+	ASSERT_TRUE(cache.Reader.TryGet(key, read));
+	EXPECT_EQ(600, read.Weight);
+}
+
+TEST(FontMetadataCache, RejectsBadHeaders)
+{
+	FontMetadataCacheWriter writer;
+	writer.Add(Key(u"C:\\Fonts\\arial.ttf"), Metadata(u"Arial"));
+
+	std::vector<uint8_t> data;
+	writer.Write(u"en-US", data);
+
+	FontMetadataCacheReader reader;
+	ASSERT_TRUE(reader.Load(Span(data)));
+
+	auto rejects = [&](size_t offset, uint8_t value)
+	{
+		std::vector<uint8_t> bad = data;
+		bad[offset] = value;
+		return !reader.Load(Span(bad));
+	};
+
+	EXPECT_TRUE(rejects(0, 'X'));		// magic
+	EXPECT_TRUE(rejects(5, 2));			// version
+	EXPECT_TRUE(rejects(7, 64));		// record size
+	EXPECT_TRUE(rejects(10, 0xFF));		// record count past the data
+	EXPECT_TRUE(rejects(18, 0xFF));		// strings offset past the data
+	EXPECT_TRUE(rejects(21, 0xFF));		// strings length past the data
+
+	EXPECT_FALSE(reader.Load(ByteSpan(data.data(), FontMetadataCacheReader::HeaderSize - 1)));
+	EXPECT_FALSE(reader.Load(ByteSpan(data.data(), static_cast<uint32_t>(data.size() - 1))));
+	EXPECT_EQ(0u, reader.Count());
+}
+
+TEST(FontMetadataCache, SkipsRecordsWithStringsOutsideThePool)
+{
+	FontMetadataKey key = Key(u"C:\\Fonts\\arial.ttf");
+
+	FontMetadataCacheWriter writer;
+	writer.Add(key, Metadata(u"Arial"));
+
+	std::vector<uint8_t> data;
+	writer.Write(u"en-US", data);
+
+	// Point the family name past the end of the string pool
+	uint32_t r = FontMetadataCacheReader::HeaderSize;
+	ByteWriter w;
+	w.Data = data;
+	w.SetU32(r + 52, 0x7FFFFFF0);
+
+	FontMetadataCacheReader reader;
+	ASSERT_TRUE(reader.Load(Span(w.Data)));
+
+	FontMetadata read;
+	EXPECT_FALSE(reader.TryGet(key, read));
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FontNameTable.h"
+#include "FontFaceStore.h"
+
+using namespace CharacterMapCX;
+
+namespace
+{
+	std::u16string Name(int number)
+	{
+		std::u16string name;
+		for (char c : std::to_string(number))
+			name += static_cast<char16_t>(c);
+
+		return name + u" Family";
+	}
+}
+
+TEST(FontNameTable, InternsEachNameOnce)
+{
+	FontNameTable table;
+	uint32_t arial = table.Intern(u"Arial");
+	uint32_t lower = table.Intern(u"arial");
+	uint32_t empty = table.Intern(u"");
+
+	EXPECT_NE(arial, lower);
+	EXPECT_NE(arial, empty);
+	EXPECT_EQ(arial, table.Intern(u"Arial"));
+	EXPECT_EQ(empty, table.Intern(u""));
+	EXPECT_EQ(3u, table.Count());
+
+	EXPECT_EQ(u"Arial", table.Get(arial).ToString());
+	EXPECT_EQ(0u, table.Get(empty).Length);
+	EXPECT_EQ(u'\0', table.Get(arial).Data[5]);
+}
+
+TEST(FontNameTable, DistinguishesCharactersByBothBytes)
+{
+	FontNameTable table;
+	uint32_t a = table.Intern(u"A");
+	uint32_t b = table.Intern(u"Ł");
+	uint32_t c = table.Intern(u"䄀");
+
+	EXPECT_NE(a, b);
+	EXPECT_NE(a, c);
+	EXPECT_NE(b, c);
+	EXPECT_EQ(u"Ł", table.Get(b).ToString());
+}
+
+TEST(FontNameTable, FindsOnlyInternedNames)
+{
+	FontNameTable table;
+	uint32_t id = table.Intern(u"Segoe UI");
+
+	uint32_t found = 0;
+	EXPECT_TRUE(table.TryFind(u"Segoe UI", found));
+	EXPECT_EQ(id, found);
+	EXPECT_FALSE(table.TryFind(u"Segoe", found));
+	EXPECT_EQ(static_cast<uint32_t>(FontNameTable::NotFound), found);
+
+	EXPECT_EQ(nullptr, table.Get(FontNameTable::NotFound).Data);
+	EXPECT_EQ(0u, table.Get(id + 1).Length);
+}
+
+TEST(FontNameTable, KeepsNamesInPlaceAsTheTableGrows)
+{
+	FontNameTable table;
+	uint32_t first = table.Intern(u"First");
+	const char16_t* data = table.Get(first).Data;
+
+	for (int i = 0; i < 5000; i++)
+		table.Intern(Name(i));
+
+	EXPECT_EQ(data, table.Get(first).Data);
+	EXPECT_EQ(first, table.Intern(u"First"));
+	for (int i = 0; i < 5000; i++)
+		ASSERT_EQ(Name(i), table.Get(table.Intern(Name(i))).ToString());
+}
+
+TEST(FontNameTable, StoresNamesLongerThanAnArenaBlock)
+{
+	FontNameTable table;
+	std::u16string longName(20000, u'x');
+
+	uint32_t before = table.Intern(u"Before");
+	uint32_t id = table.Intern(longName);
+	uint32_t after = table.Intern(u"After");
+
+	EXPECT_EQ(longName, table.Get(id).ToString());
+	EXPECT_EQ(u"Before", table.Get(before).ToString());
+	EXPECT_EQ(u"After", table.Get(after).ToString());
+
+	// The short names still share the block that was being filled
+	EXPECT_EQ(table.Get(before).Data + 7, table.Get(after).Data);
+}
+
+TEST(FontNameTable, InternsTheSameIdsFromManyThreads)
+{
+	const int Names = 20000;
+	const int Threads = 8;
+
+	FontNameTable table;
+	std::vector<std::vector<uint32_t>> ids(Threads, std::vector<uint32_t>(Names));
+	std::vector<int> mismatches(Threads);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < Threads; t++)
+	{
+		threads.emplace_back([&, t]
+			{
+				// Each thread walks the names in a different order, so they
+				// race to add and look up the same ones
+				for (int i = 0; i < Names; i++)
+				{
+					int n = (i * 7 + t * 2503) % Names;
+					std::u16string name = Name(n);
+					if (n % 5000 == 0)
+						name.append(20000, u'x');
+
+					uint32_t id = table.Intern(name);
+					ids[t][n] = id;
+
+					uint32_t found = 0;
+					if (table.Get(id).ToString() != name || !table.TryFind(name, found) || found != id)
+						mismatches[t]++;
+				}
+			});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(static_cast<uint32_t>(Names), table.Count());
+	for (int t = 0; t < Threads; t++)
+	{
+		EXPECT_EQ(0, mismatches[t]);
+		EXPECT_EQ(ids[0], ids[t]);
+	}
+}
+
+TEST(FontFaceStore, ReinternsNamesFromAnotherTable)
+{
+	FontNameTable names;
+	FontNameTable other;
+	other.Intern(u"Padding");
+
+	FontFaceStore source(names);
+	uint8_t panose[10] = { 2, 11, 6, 4, 2, 2, 2, 2, 2, 4 };
+	source.Add(names.Intern(u"Arial"), names.Intern(u"Bold"), FontFaceStore::Pack(700, 0, 5, FontFaceColor, 3), 3000, panose);
+
+	FontFaceStore same(names);
+	same.AddFrom(source, 0);
+	EXPECT_EQ(source.FamilyId(0), same.FamilyId(0));
+	EXPECT_EQ(source.FaceNameId(0), same.FaceNameId(0));
+
+	FontFaceStore copy(other);
+	copy.AddFrom(source, 0);
+	EXPECT_EQ(u"Arial", other.Get(copy.FamilyId(0)).ToString());
+	EXPECT_EQ(u"Bold", other.Get(copy.FaceNameId(0)).ToString());
+	EXPECT_EQ(source.Packed(0), copy.Packed(0));
+	EXPECT_EQ(3000, copy.GlyphCount(0));
+	EXPECT_EQ(0, std::memcmp(panose, copy.Panose(0), 10));
+}
@@ -0,0 +1,443 @@
+#include <gtest/gtest.h>
+#include "GlyfTable.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	struct Point
+	{
+		int X;
+		int Y;
+		bool OnCurve;
+	};
+
+	/// <summary>
+	/// Encodes a simple glyph, using short vectors and repeated flags where
+	/// it can, as font compilers do.
+	/// </summary>
+	std::vector<uint8_t> SimpleGlyph(const std::vector<std::vector<Point>>& contours)
+	{
+		std::vector<Point> points;
+		ByteWriter w;
+		w.I16(static_cast<int32_t>(contours.size())).I16(0).I16(0).I16(0).I16(0);
+
+		for (const auto& contour : contours)
+		{
+			points.insert(points.end(), contour.begin(), contour.end());
+			w.U16(static_cast<uint32_t>(points.size() - 1));
+		}
+
+		w.U16(0);
+
+		std::vector<uint8_t> flags;
+		ByteWriter xs, ys;
+		int lastX = 0, lastY = 0;
+		for (const Point& p : points)
+		{
+			uint8_t flag = p.OnCurve ? 0x01 : 0;
+			int dx = p.X - lastX, dy = p.Y - lastY;
+
+			if (dx == 0)
+				flag |= 0x10;
+			else if (dx > -256 && dx < 256)
+			{
+				flag |= 0x02 | (dx > 0 ? 0x10 : 0);
+				xs.U8(dx > 0 ? dx : -dx);
+			}
+			else
+				xs.I16(dx);
+
+			if (dy == 0)
+				flag |= 0x20;
+			else if (dy > -256 && dy < 256)
+			{
+				flag |= 0x04 | (dy > 0 ? 0x20 : 0);
+				ys.U8(dy > 0 ? dy : -dy);
+			}
+			else
+				ys.I16(dy);
+
+			flags.push_back(flag);
+			lastX = p.X;
+			lastY = p.Y;
+		}
+
+		for (size_t i = 0; i < flags.size();)
+		{
+			size_t run = 1;
+			while (i + run < flags.size() && flags[i + run] == flags[i] && run < 256)
+				run++;
+
+			if (run > 1)
+				w.U8(flags[i] | 0x08).U8(static_cast<uint32_t>(run - 1));
+			else
+				w.U8(flags[i]);
+
+			i += run;
+		}
+
+		w.Bytes(xs.Data).Bytes(ys.Data);
+		return w.Data;
+	}
+
+	struct Component
+	{
+		uint16_t Glyph;
+		int Arg1;
+		int Arg2;
+		bool MatchPoints = false;
+		std::vector<float> Transform = {};
+		uint16_t ExtraFlags = 0;
+	};
+
+	std::vector<uint8_t> CompositeGlyph(const std::vector<Component>& components)
+	{
+		ByteWriter w;
+		w.I16(-1).I16(0).I16(0).I16(0).I16(0);
+
+		for (size_t i = 0; i < components.size(); i++)
+		{
+			const Component& c = components[i];
+			uint16_t flags = 0x0001 | c.ExtraFlags;
+			if (!c.MatchPoints)
+				flags |= 0x0002;
+			if (i + 1 < components.size())
+				flags |= 0x0020;
+			if (c.Transform.size() == 1)
+				flags |= 0x0008;
+			else if (c.Transform.size() == 2)
+				flags |= 0x0040;
+			else if (c.Transform.size() == 4)
+				flags |= 0x0080;
+
+			w.U16(flags).U16(c.Glyph);
+			if (c.MatchPoints)
+				w.U16(c.Arg1).U16(c.Arg2);
+			else
+				w.I16(c.Arg1).I16(c.Arg2);
+
+			for (float value : c.Transform)
+				w.I16(static_cast<int32_t>(value * 16384));
+		}
+
+		return w.Data;
+	}
+
+	/// <summary>
+	/// A glyf, loca and head table built from a list of glyphs.
+	/// </summary>
+	struct GlyfFont
+	{
+		std::vector<uint8_t> Head;
+		std::vector<uint8_t> Loca;
+		std::vector<uint8_t> Glyf;
+		GlyfTable Table;
+
+		explicit GlyfFont(const std::vector<std::vector<uint8_t>>& glyphs, bool longLoca = true)
+		{
+			Head = MakeHead(1000, longLoca);
+
+			ByteWriter loca, glyf;
+			for (const auto& glyph : glyphs)
+			{
+				longLoca ? loca.U32(glyf.Size()) : loca.U16(glyf.Size() / 2);
+				// Short offsets are stored halved, so need even lengths.
+				// Long offsets are left unpadded, so a truncated glyph
+				// isn't followed by bytes that could complete it.
+				glyf.Bytes(glyph);
+				if (!longLoca)
+					glyf.Align(2);
+			}
+
+			longLoca ? loca.U32(glyf.Size()) : loca.U16(glyf.Size() / 2);
+			Loca = loca.Data;
+			Glyf = glyf.Data;
+		}
+
+		bool Load()
+		{
+			return Table.Load(Span(Head), Span(Loca), Span(Glyf), static_cast<uint16_t>(Loca.size() / 4));
+		}
+	};
+
+	// A triangle and a square, as two contours of one glyph
+	const std::vector<Point> Triangle = { { 0, 0, true }, { 100, 0, true }, { 50, 100, true } };
+	const std::vector<Point> Square = { { 200, 0, true }, { 300, 0, true }, { 300, 100, true }, { 200, 100, true } };
+
+	void ExpectPoint(const GlyfPoint& p, float x, float y)
+	{
+		EXPECT_FLOAT_EQ(p.X, x);
+		EXPECT_FLOAT_EQ(p.Y, y);
+	}
+}
+
+TEST(GlyfTable, DecodesSimpleGlyphPoints)
+{
+	GlyfFont font({ {}, SimpleGlyph({ Triangle, Square }) });
+	ASSERT_TRUE(font.Load());
+	EXPECT_EQ(font.Table.UnitsPerEm, 1000);
+	EXPECT_EQ(font.Table.GlyphCount(), 2);
+
+	std::vector<GlyfPoint> points;
+	std::vector<uint32_t> ends;
+	ASSERT_TRUE(font.Table.DecodePoints(1, points, ends));
+	ASSERT_EQ(points.size(), 7u);
+	EXPECT_EQ(ends, (std::vector<uint32_t>{ 2, 6 }));
+	ExpectPoint(points[2], 50, 100);
+	ExpectPoint(points[5], 300, 100);
+}
+
+TEST(GlyfTable, ReadsShortLocaOffsets)
+{
+	GlyfFont font({ {}, SimpleGlyph({ Square }) }, false);
+	ASSERT_TRUE(font.Table.Load(Span(font.Head), Span(font.Loca), Span(font.Glyf), 2));
+
+	std::vector<GlyfPoint> points;
+	std::vector<uint32_t> ends;
+	ASSERT_TRUE(font.Table.DecodePoints(1, points, ends));
+	EXPECT_EQ(points.size(), 4u);
+}
+
+TEST(GlyfTable, EmptyGlyphDecodesToEmptyPath)
+{
+	GlyfFont font({ {}, SimpleGlyph({ Square }) });
+	ASSERT_TRUE(font.Load());
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Table.Decode(0, path, 1));
+	EXPECT_TRUE(path.IsEmpty());
+}
+
+TEST(GlyfTable, DecodesLinesAndImpliedOnCurvePoints)
+{
+	// Two off-curve points in a row imply an on-curve point between them
+	GlyfFont font({ SimpleGlyph({ { { 0, 0, true }, { 0, 100, false }, { 100, 100, false }, { 100, 0, true } } }) });
+	ASSERT_TRUE(font.Load());
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Table.Decode(0, path, 0.5f));
+	EXPECT_EQ(path.Verbs, (std::vector<PathVerb>{ PathVerb::Move, PathVerb::Quad, PathVerb::Quad, PathVerb::Close }));
+
+	// y is flipped to match Direct2D
+	std::vector<float> expected = { 0, 0, 0, -50, 25, -50, 50, -50, 50, 0 };
+	EXPECT_EQ(path.Points, expected);
+}
+
+TEST(GlyfTable, ContourStartingOffCurveUsesLastPoint)
+{
+	GlyfFont font({ SimpleGlyph({ { { 50, 100, false }, { 100, 0, true }, { 0, 0, true } } }) });
+	ASSERT_TRUE(font.Load());
+
+	GlyphPath path;
+	ASSERT_TRUE(font.Table.Decode(0, path, 1));
+	ASSERT_FALSE(path.Points.empty());
+	EXPECT_FLOAT_EQ(path.Points[0], 0);
+	EXPECT_FLOAT_EQ(path.Points[1], 0);
+	EXPECT_EQ(path.Verbs.front(), PathVerb::Move);
+	EXPECT_EQ(path.Verbs[1], PathVerb::Quad);
+}
+
+TEST(GlyfTable, AppliesComponentOffsetsAndTransforms)
+{
+	GlyfFont font({
+		SimpleGlyph({ Triangle }),
+		CompositeGlyph({ { 0, 10, 20 } }),
+		CompositeGlyph({ { 0, 0, 0, false, { 0.5f } } }),
+		CompositeGlyph({ { 0, 0, 0, false, { 1.5f, 0.5f } } }),
+		CompositeGlyph({ { 0, 5, 0, false, { 0, 1, -1, 0 } } }),
+		});
+	ASSERT_TRUE(font.Load());
+
+	std::vector<GlyfPoint> points;
+	std::vector<uint32_t> ends;
+
+	ASSERT_TRUE(font.Table.DecodePoints(1, points, ends));
+	ExpectPoint(points[2], 60, 120);
+
+	ASSERT_TRUE(font.Table.DecodePoints(2, points, ends));
+	ExpectPoint(points[2], 25, 50);
+
+	ASSERT_TRUE(font.Table.DecodePoints(3, points, ends));
+	ExpectPoint(points[2], 75, 50);
+
+	// 2x2: x' = a*x + c*y, y' = b*x + d*y, then the unscaled offset
+	ASSERT_TRUE(font.Table.DecodePoints(4, points, ends));
+	ExpectPoint(points[1], 5, 100);
+	ExpectPoint(points[2], -95, 50);
+}
+
+TEST(GlyfTable, ScalesOffsetsOnlyWhenAsked)
+{
+	const uint16_t ScaledComponentOffset = 0x0800;
+	GlyfFont font({
+		SimpleGlyph({ Triangle }),
+		CompositeGlyph({ { 0, 10, 10, false, { 1.5f }, ScaledComponentOffset } }),
+		CompositeGlyph({ { 0, 10, 10, false, { 1.5f } } }),
+		});
+	ASSERT_TRUE(font.Load());
+
+	std::vector<GlyfPoint> points;
+	std::vector<uint32_t> ends;
+	ASSERT_TRUE(font.Table.DecodePoints(1, points, ends));
+	ExpectPoint(points[0], 15, 15);
+
+	ASSERT_TRUE(font.Table.DecodePoints(2, points, ends));
+	ExpectPoint(points[0], 10, 10);
+}
+
+TEST(GlyfTable, MatchesPointsWithinComposite)
+{
+	// The square is placed so its first point sits on the triangle's apex
+	GlyfFont font({
+		SimpleGlyph({ Triangle }),
+		SimpleGlyph({ Square }),
+		CompositeGlyph({ { 0, 0, 0 }, { 1, 2, 0, true } }),
+		});
+	ASSERT_TRUE(font.Load());
+
+	std::vector<GlyfPoint> points;
+	std::vector<uint32_t> ends;
+	ASSERT_TRUE(font.Table.DecodePoints(2, points, ends));
+	ASSERT_EQ(points.size(), 7u);
+	ExpectPoint(points[3], 50, 100);
+	ExpectPoint(points[5], 150, 200);
+	EXPECT_EQ(ends, (std::vector<uint32_t>{ 2, 6 }));
+}
+
+TEST(GlyfTable, MatchesPointsOfNestedCompositeFromItsOwnFirstPoint)
+{
+	// Glyph 2 matches the square to point 2 of its own triangle. Glyph 3
+	// places another square first, so glyph 2's points no longer start at 0
+	// and point 2 of the whole glyph is a corner of that square instead.
+	GlyfFont font({
+		SimpleGlyph({ Triangle }),
+		SimpleGlyph({ Square }),
+		CompositeGlyph({ { 0, 0, 0 }, { 1, 2, 0, true } }),
+		CompositeGlyph({ { 1, 1000, 1000 }, { 2, 0, 0 } }),
+		});
+	ASSERT_TRUE(font.Load());
+
+	std::vector<GlyfPoint> alone, points;
+	std::vector<uint32_t> ends;
+	ASSERT_TRUE(font.Table.DecodePoints(2, alone, ends));
+	ASSERT_TRUE(font.Table.DecodePoints(3, points, ends));
+	ASSERT_EQ(points.size(), 4 + alone.size());
+
+	for (size_t i = 0; i < alone.size(); i++)
+		ExpectPoint(points[4 + i], alone[i].X, alone[i].Y);
+
+	EXPECT_EQ(ends, (std::vector<uint32_t>{ 3, 6, 10 }));
+}
+
+TEST(GlyfTable, MatchesPointsThroughTwoLevelsOfNesting)
+{
+	GlyfFont font({
+		SimpleGlyph({ Triangle }),
+		SimpleGlyph({ Square }),
+		CompositeGlyph({ { 0, 0, 0 }, { 1, 2, 0, true } }),
+		CompositeGlyph({ { 0, -500, 0 }, { 2, 0, 0 } }),
+		CompositeGlyph({ { 1, 0, 0 }, { 3, 1, 0, true } }),
+		});
+	ASSERT_TRUE(font.Load());
+
+	std::vector<GlyfPoint> points;
+	std::vector<uint32_t> ends;
+	ASSERT_TRUE(font.Table.DecodePoints(4, points, ends));
+	ASSERT_EQ(points.size(), 4u + 3 + 3 + 4);
+
+	// Glyph 3 is moved so its first point lands on the outer square's
+	// point 1, at (300, 0). Inside it, glyph 2 still matches its square to
+	// its own triangle's apex.
+	ExpectPoint(points[4], 300, 0);
+	float dx = points[4].X - -500, dy = points[4].Y;
+	ExpectPoint(points[7], 0 + dx, 0 + dy);
+	ExpectPoint(points[9], 50 + dx, 100 + dy);
+	ExpectPoint(points[10], 50 + dx, 100 + dy);
+}
+
+TEST(GlyfTable, RejectsMatchAgainstPointNotYetPlaced)
+{
+	GlyfFont font({
+		SimpleGlyph({ Triangle }),
+		SimpleGlyph({ Square }),
+		CompositeGlyph({ { 0, 0, 0 }, { 1, 3, 0, true } }),
+		CompositeGlyph({ { 1, 0, 0, true } }),
+		});
+	ASSERT_TRUE(font.Load());
+
+	std::vector<GlyfPoint> points;
+	std::vector<uint32_t> ends;
+	EXPECT_FALSE(font.Table.DecodePoints(2, points, ends));
+	EXPECT_FALSE(font.Table.DecodePoints(3, points, ends));
+}
+
+TEST(GlyfTable, RejectsMatchAgainstPointOutsideComponent)
+{
+	GlyfFont font({
+		SimpleGlyph({ Triangle }),
+		SimpleGlyph({ Square }),
+		CompositeGlyph({ { 0, 0, 0 }, { 1, 0, 4, true } }),
+		});
+	ASSERT_TRUE(font.Load());
+
+	std::vector<GlyfPoint> points;
+	std::vector<uint32_t> ends;
+	EXPECT_FALSE(font.Table.DecodePoints(2, points, ends));
+}
+
+TEST(GlyfTable, RejectsRecursiveComposites)
+{
+	GlyfFont font({
+		CompositeGlyph({ { 1, 0, 0 } }),
+		CompositeGlyph({ { 0, 0, 0 } }),
+		});
+	ASSERT_TRUE(font.Load());
+
+	GlyphPath path;
+	EXPECT_FALSE(font.Table.Decode(0, path, 1));
+}
+
+TEST(GlyfTable, RejectsTruncatedGlyphs)
+{
+	std::vector<uint8_t> simple = SimpleGlyph({ Triangle, Square });
+	std::vector<uint8_t> composite = CompositeGlyph({ { 0, 0, 0, false, { 0, 1, -1, 0 } } });
+
+	for (size_t size = 1; size < simple.size(); size++)
+	{
+		GlyfFont font({ std::vector<uint8_t>(simple.begin(), simple.begin() + size) });
+		ASSERT_TRUE(font.Load());
+
+		GlyphPath path;
+		EXPECT_FALSE(font.Table.Decode(0, path, 1)) << size;
+	}
+
+	for (size_t size = 1; size < composite.size(); size++)
+	{
+		GlyfFont font({ simple, std::vector<uint8_t>(composite.begin(), composite.begin() + size) });
+		ASSERT_TRUE(font.Load());
+
+		GlyphPath path;
+		EXPECT_FALSE(font.Table.Decode(1, path, 1)) << size;
+	}
+}
+
+TEST(GlyfTable, ReadsControlBoundsFromGlyphHeader)
+{
+	std::vector<uint8_t> glyph = SimpleGlyph({ Triangle });
+	ByteWriter header;
+	header.I16(1).I16(-10).I16(-20).I16(110).I16(120);
+	std::copy(header.Data.begin(), header.Data.end(), glyph.begin());
+
+	GlyfFont font({ glyph });
+	ASSERT_TRUE(font.Load());
+
+	PathBounds bounds;
+	ASSERT_TRUE(font.Table.GetControlBounds(0, bounds, 2));
+	EXPECT_FLOAT_EQ(bounds.Left, -20);
+	EXPECT_FLOAT_EQ(bounds.Right, 220);
+	EXPECT_FLOAT_EQ(bounds.Top, -240);
+	EXPECT_FLOAT_EQ(bounds.Bottom, 40);
+}
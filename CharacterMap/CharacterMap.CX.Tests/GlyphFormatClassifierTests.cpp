@@ -0,0 +1,331 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "GlyphFormatClassifier.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	const uint8_t None = GlyphFormat_None;
+	const uint8_t TrueType = GlyphFormat_TrueType;
+	const uint8_t Cff = GlyphFormat_Cff;
+	const uint8_t Colr = GlyphFormat_Colr;
+	const uint8_t Svg = GlyphFormat_Svg;
+	const uint8_t Png = GlyphFormat_Png;
+	const uint8_t Jpeg = GlyphFormat_Jpeg;
+
+	/// <summary>
+	/// loca and glyf for glyphs of the given sizes. The glyph data itself
+	/// is never read, only whether there is any.
+	/// </summary>
+	struct GlyfData
+	{
+		std::vector<uint8_t> Loca;
+		std::vector<uint8_t> Glyf;
+
+		GlyfData(const std::vector<uint32_t>& sizes, bool longOffsets)
+		{
+			ByteWriter loca;
+			uint32_t offset = 0;
+			for (uint32_t size : sizes)
+			{
+				longOffsets ? loca.U32(offset) : loca.U16(offset / 2);
+				offset += size;
+			}
+			longOffsets ? loca.U32(offset) : loca.U16(offset / 2);
+
+			Loca = loca.Data;
+			Glyf.resize(offset);
+		}
+	};
+
+	struct BaseGlyph
+	{
+		uint16_t Glyph;
+		uint16_t Layers;
+	};
+
+	std::vector<uint8_t> MakeColr(const std::vector<BaseGlyph>& v0, const std::vector<uint16_t>& v1 = {}, bool version1 = false)
+	{
+		uint32_t headerSize = version1 ? 34 : 14;
+		uint32_t listOffset = headerSize + static_cast<uint32_t>(v0.size()) * 6;
+
+		ByteWriter w;
+		w.U16(version1 ? 1 : 0).U16(static_cast<uint32_t>(v0.size())).U32(headerSize).U32(0).U16(0);
+		if (version1)
+			w.U32(v1.empty() ? 0 : listOffset).U32(0).U32(0).U32(0).U32(0);
+
+		for (const BaseGlyph& b : v0)
+			w.U16(b.Glyph).U16(0).U16(b.Layers);
+
+		if (!v1.empty())
+		{
+			w.U32(static_cast<uint32_t>(v1.size()));
+			for (uint16_t g : v1)
+				w.U16(g).U32(0);
+		}
+		return w.Data;
+	}
+
+	struct SvgRange
+	{
+		uint16_t First;
+		uint16_t Last;
+		uint32_t Offset;
+	};
+
+	std::vector<uint8_t> MakeSvg(const std::vector<SvgRange>& ranges)
+	{
+		ByteWriter w;
+		w.U16(0).U32(10).U32(0).U16(static_cast<uint32_t>(ranges.size()));
+		for (const SvgRange& r : ranges)
+			w.U16(r.First).U16(r.Last).U32(r.Offset).U32(r.Offset == 0 ? 0 : 10);
+		return w.Data;
+	}
+
+	/// <summary>
+	/// One sbix strike, with a record of the given graphic type for each
+	/// glyph, or none for a null type.
+	/// </summary>
+	std::vector<uint8_t> MakeSbix(const std::vector<const char*>& types)
+	{
+		uint32_t count = static_cast<uint32_t>(types.size());
+		ByteWriter w;
+		w.U16(1).U16(1).U32(1).U32(12).U16(64).U16(72);
+
+		uint32_t offset = 4 + (count + 1) * 4;
+		for (const char* type : types)
+		{
+			w.U32(offset);
+			if (type != nullptr)
+				offset += 8 + 4;
+		}
+		w.U32(offset);
+
+		for (const char* type : types)
+			if (type != nullptr)
+				w.I16(0).I16(0).Tag(type).U32(0x89504E47);
+		return w.Data;
+	}
+
+	/// <summary>
+	/// One CBLC strike covering first to last with a format 2 subtable, and
+	/// a CBDT table with a format 19 PNG for each glyph.
+	/// </summary>
+	void MakeCbdt(uint16_t first, uint16_t last, std::vector<uint8_t>& cblc, std::vector<uint8_t>& cbdt)
+	{
+		ByteWriter data;
+		data.U16(3).U16(0);
+		for (uint32_t g = first; g <= last; g++)
+			data.U32(4).U32(0x89504E47);
+		cbdt = data.Data;
+
+		ByteWriter w;
+		w.U16(3).U16(0).U32(1);
+		w.U32(56).U32(8 + 20).U32(1).U32(0).Zeros(24).U16(first).U16(last).U8(109).U8(109).U8(32).U8(1);
+		w.U16(first).U16(last).U32(8);
+		w.U16(2).U16(19).U32(4).U32(8).Zeros(8);
+		cblc = w.Data;
+	}
+
+	std::vector<uint8_t> Classify(const GlyphFormatTables& tables)
+	{
+		return GlyphFormatClassifier::Classify(tables);
+	}
+}
+
+TEST(GlyphFormatClassifier, MarksGlyfGlyphsWithOutlines)
+{
+	for (bool longOffsets : { false, true })
+	{
+		std::vector<uint8_t> head = MakeHead(1000, longOffsets);
+		GlyfData glyf({ 12, 0, 20, 0 }, longOffsets);
+
+		GlyphFormatTables tables;
+		tables.NumGlyphs = 4;
+		tables.Head = Span(head);
+		tables.Loca = Span(glyf.Loca);
+		tables.Glyf = Span(glyf.Glyf);
+
+		// Empty glyphs, such as the space, have no outline
+		EXPECT_EQ((std::vector<uint8_t>{ TrueType, None, TrueType, None }), Classify(tables));
+	}
+}
+
+TEST(GlyphFormatClassifier, StopsAtTheEndOfLoca)
+{
+	std::vector<uint8_t> head = MakeHead(1000, false);
+	GlyfData glyf({ 12, 20 }, false);
+
+	// maxp claims more glyphs than loca has entries for
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 5;
+	tables.Head = Span(head);
+	tables.Loca = Span(glyf.Loca);
+	tables.Glyf = Span(glyf.Glyf);
+	EXPECT_EQ((std::vector<uint8_t>{ TrueType, TrueType, None, None, None }), Classify(tables));
+
+	// and glyph data past the end of glyf is ignored
+	tables.Glyf = Span(glyf.Glyf).Slice(0, 16);
+	EXPECT_EQ((std::vector<uint8_t>{ TrueType, None, None, None, None }), Classify(tables));
+}
+
+TEST(GlyphFormatClassifier, MarksEveryCffCharString)
+{
+	std::vector<uint8_t> endchar = { 14 };
+	std::vector<uint8_t> cff = MakeCff({ endchar, endchar, endchar });
+	std::vector<uint8_t> cff2 = MakeCff2({ endchar, endchar });
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 4;
+	tables.Cff = Span(cff);
+	EXPECT_EQ((std::vector<uint8_t>{ Cff, Cff, Cff, None }), Classify(tables));
+
+	tables.Cff = ByteSpan();
+	tables.Cff2 = Span(cff2);
+	EXPECT_EQ((std::vector<uint8_t>{ Cff, Cff, None, None }), Classify(tables));
+
+	// CharStrings beyond the glyph count are ignored
+	tables.NumGlyphs = 2;
+	tables.Cff2 = ByteSpan();
+	tables.Cff = Span(cff);
+	EXPECT_EQ((std::vector<uint8_t>{ Cff, Cff }), Classify(tables));
+
+	// as is a table that doesn't parse
+	cff[0] = 9;
+	EXPECT_EQ((std::vector<uint8_t>{ None, None }), Classify(tables));
+}
+
+TEST(GlyphFormatClassifier, MarksColrV0BaseGlyphsWithLayers)
+{
+	std::vector<uint8_t> colr = MakeColr({ { 1, 2 }, { 2, 0 }, { 3, 1 }, { 9, 1 } });
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 5;
+	tables.Colr = Span(colr);
+
+	// A base glyph with no layers isn't drawn in colour, and glyph 9 is
+	// past the end of the font
+	EXPECT_EQ((std::vector<uint8_t>{ None, Colr, None, Colr, None }), Classify(tables));
+}
+
+TEST(GlyphFormatClassifier, MarksColrV1PaintedGlyphs)
+{
+	std::vector<uint8_t> colr = MakeColr({ { 1, 1 } }, { 2, 4, 700 }, true);
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 5;
+	tables.Colr = Span(colr);
+	EXPECT_EQ((std::vector<uint8_t>{ None, Colr, Colr, None, Colr }), Classify(tables));
+
+	// Version 0 tables have no base glyph list, whatever follows the header
+	colr[1] = 0;
+	EXPECT_EQ((std::vector<uint8_t>{ None, Colr, None, None, None }), Classify(tables));
+
+	// A list offset of zero means there isn't one
+	colr = MakeColr({ { 3, 1 } }, {}, true);
+	tables.Colr = Span(colr);
+	EXPECT_EQ((std::vector<uint8_t>{ None, None, None, Colr, None }), Classify(tables));
+}
+
+TEST(GlyphFormatClassifier, MarksSvgDocumentRanges)
+{
+	std::vector<uint8_t> svg = MakeSvg({ { 1, 2, 100 }, { 4, 4, 200 }, { 5, 5, 0 }, { 6, 1000, 300 } });
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 8;
+	tables.Svg = Span(svg);
+
+	// Ranges without a document are skipped, and ranges past the end of
+	// the font are cut short
+	EXPECT_EQ((std::vector<uint8_t>{ None, Svg, Svg, None, Svg, None, Svg, Svg }), Classify(tables));
+
+	svg.resize(svg.size() - 1);
+	tables.Svg = Span(svg);
+	EXPECT_EQ((std::vector<uint8_t>{ None, Svg, Svg, None, Svg, None, None, None }), Classify(tables));
+}
+
+TEST(GlyphFormatClassifier, MarksSbixImagesByType)
+{
+	std::vector<uint8_t> sbix = MakeSbix({ nullptr, "png ", "jpg ", "mask" });
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 4;
+	tables.Sbix = Span(sbix);
+	EXPECT_EQ((std::vector<uint8_t>{ None, Png, Jpeg, None }), Classify(tables));
+}
+
+TEST(GlyphFormatClassifier, MarksCbdtGlyphs)
+{
+	std::vector<uint8_t> cblc, cbdt;
+	MakeCbdt(2, 3, cblc, cbdt);
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 5;
+	tables.Cblc = Span(cblc);
+	tables.Cbdt = Span(cbdt);
+	EXPECT_EQ((std::vector<uint8_t>{ None, None, Png, Png, None }), Classify(tables));
+
+	// CBLC without its CBDT table
+	tables.Cbdt = ByteSpan();
+	EXPECT_EQ((std::vector<uint8_t>(5, None)), Classify(tables));
+}
+
+TEST(GlyphFormatClassifier, IgnoresGlyphsPastTheEndOfTheFont)
+{
+	std::vector<uint8_t> cblc, cbdt;
+	MakeCbdt(1, 6, cblc, cbdt);
+	std::vector<uint8_t> colr = MakeColr({ { 2, 1 }, { 3, 1 }, { 0xFFFF, 1 } }, { 3, 0xFFFF }, true);
+	std::vector<uint8_t> svg = MakeSvg({ { 3, 0xFFFF, 100 } });
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 3;
+	tables.Colr = Span(colr);
+	tables.Svg = Span(svg);
+	tables.Cblc = Span(cblc);
+	tables.Cbdt = Span(cbdt);
+	EXPECT_EQ((std::vector<uint8_t>{ None, Png, Colr | Png }), Classify(tables));
+
+	tables.NumGlyphs = 0;
+	EXPECT_TRUE(Classify(tables).empty());
+}
+
+TEST(GlyphFormatClassifier, CombinesFormatsPerGlyph)
+{
+	std::vector<uint8_t> head = MakeHead(1000, false);
+	GlyfData glyf({ 0, 10, 10, 10, 10, 10 }, false);
+	std::vector<uint8_t> colr = MakeColr({ { 2, 3 } });
+	std::vector<uint8_t> svg = MakeSvg({ { 3, 3, 50 } });
+	std::vector<uint8_t> sbix = MakeSbix({ nullptr, nullptr, nullptr, nullptr, "png ", nullptr });
+	std::vector<uint8_t> cblc, cbdt;
+	MakeCbdt(5, 5, cblc, cbdt);
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = 6;
+	tables.Head = Span(head);
+	tables.Loca = Span(glyf.Loca);
+	tables.Glyf = Span(glyf.Glyf);
+	tables.Colr = Span(colr);
+	tables.Svg = Span(svg);
+	tables.Sbix = Span(sbix);
+	tables.Cblc = Span(cblc);
+	tables.Cbdt = Span(cbdt);
+
+	std::vector<uint8_t> expected = {
+		None,
+		TrueType,
+		TrueType | Colr,
+		TrueType | Svg,
+		TrueType | Png,
+		TrueType | Png,
+	};
+	EXPECT_EQ(expected, Classify(tables));
+
+	// Plain outlines aren't colour, everything else is
+	EXPECT_EQ(0u, TrueType & GlyphFormat_ColorMask);
+	EXPECT_EQ(0u, Cff & GlyphFormat_ColorMask);
+	for (uint8_t f : { Colr, Svg, Png, Jpeg })
+		EXPECT_NE(0u, f & GlyphFormat_ColorMask);
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GlyphPathCache.h"
+
+using namespace CharacterMapCX;
+
+namespace
+{
+	// Face keys as NativeInterop builds them: file identity, face index and
+	// simulations, then the instance's axis tag/value pairs.
+	std::string FaceKey(const std::vector<std::pair<uint32_t, float>>& axis = {})
+	{
+		std::string key = "C:\\Windows\\Fonts\\Test.ttf";
+		uint32_t index = 0, simulations = 0;
+		key.append(reinterpret_cast<const char*>(&index), sizeof(index));
+		key.append(reinterpret_cast<const char*>(&simulations), sizeof(simulations));
+		for (const auto& a : axis)
+		{
+			key.append(reinterpret_cast<const char*>(&a.first), sizeof(a.first));
+			key.append(reinterpret_cast<const char*>(&a.second), sizeof(a.second));
+		}
+		return key;
+	}
+
+	std::string Key(uint16_t glyph, float emSize = 64, const std::string& faceKey = FaceKey())
+	{
+		std::string key;
+		GlyphPathCache::MakeKey(faceKey, glyph, emSize, key);
+		return key;
+	}
+
+	GlyphPath Square(float size)
+	{
+		GlyphPath path;
+		path.MoveTo(0, 0);
+		path.LineTo(size, 0);
+		path.LineTo(size, size);
+		path.LineTo(0, size);
+		path.Close();
+		return path;
+	}
+
+	std::vector<uint8_t> Encode(const GlyphPath& path, float emSize = 64)
+	{
+		std::vector<uint8_t> encoded;
+		PathEncoding::Encode(path, encoded, GlyphPathCache::FractionBits(emSize));
+		return encoded;
+	}
+
+	// What one entry is charged against the budget
+	size_t Cost(const std::string& key, const std::vector<uint8_t>& encoded)
+	{
+		return 128 + key.size() * 2 + encoded.size();
+	}
+}
+
+TEST(GlyphPathCache, ReturnsWhatWasAdded)
+{
+	GlyphPathCache cache;
+	GlyphPath square = Square(10);
+
+	GlyphPath path;
+	EXPECT_FALSE(cache.TryGet(Key(1), path));
+
+	cache.Add(Key(1), Encode(square));
+	ASSERT_TRUE(cache.TryGet(Key(1), path));
+	EXPECT_EQ(square.Verbs, path.Verbs);
+	EXPECT_EQ(square.Points, path.Points);
+	EXPECT_EQ(Cost(Key(1), Encode(square)), cache.GetSize());
+}
+
+TEST(GlyphPathCache, EvictsLeastRecentlyUsedOverBudget)
+{
+	GlyphPathCache cache;
+	std::vector<uint8_t> encoded = Encode(Square(10));
+	size_t cost = Cost(Key(1), encoded);
+	cache.SetBudget(cost * 3);
+
+	cache.Add(Key(1), Encode(Square(10)));
+	cache.Add(Key(2), Encode(Square(10)));
+	cache.Add(Key(3), Encode(Square(10)));
+	EXPECT_EQ(cost * 3, cache.GetSize());
+
+	// Using glyph 1 makes glyph 2 the oldest
+	GlyphPath path;
+	ASSERT_TRUE(cache.TryGet(Key(1), path));
+
+	cache.Add(Key(4), Encode(Square(10)));
+	EXPECT_EQ(cost * 3, cache.GetSize());
+	EXPECT_TRUE(cache.TryGet(Key(1), path));
+	EXPECT_FALSE(cache.TryGet(Key(2), path));
+	EXPECT_TRUE(cache.TryGet(Key(3), path));
+	EXPECT_TRUE(cache.TryGet(Key(4), path));
+
+	// Adding a key again only refreshes it
+	cache.Add(Key(3), Encode(Square(10)));
+	cache.Add(Key(5), Encode(Square(10)));
+	EXPECT_FALSE(cache.TryGet(Key(1), path));
+	EXPECT_TRUE(cache.TryGet(Key(3), path));
+
+	// Shrinking the budget trims from the oldest end
+	cache.SetBudget(cost);
+	EXPECT_EQ(cost, cache.GetSize());
+	EXPECT_TRUE(cache.TryGet(Key(3), path));
+	EXPECT_FALSE(cache.TryGet(Key(4), path));
+	EXPECT_FALSE(cache.TryGet(Key(5), path));
+}
+
+TEST(GlyphPathCache, SkipsEntriesLargerThanTheBudget)
+{
+	GlyphPathCache cache;
+	cache.SetBudget(Cost(Key(1), Encode(Square(10))));
+
+	GlyphPath big;
+	big.MoveTo(0, 0);
+	for (int i = 0; i < 100; i++)
+		big.LineTo(static_cast<float>(i * 37 % 101), static_cast<float>(i));
+	big.Close();
+
+	cache.Add(Key(1), Encode(Square(10)));
+	cache.Add(Key(2), Encode(big));
+
+	// The small entry isn't evicted to make room for one that can't fit
+	GlyphPath path;
+	EXPECT_TRUE(cache.TryGet(Key(1), path));
+	EXPECT_FALSE(cache.TryGet(Key(2), path));
+
+	cache.SetBudget(0);
+	cache.Add(Key(3), Encode(Square(10)));
+	EXPECT_EQ(0u, cache.GetSize());
+	EXPECT_FALSE(cache.TryGet(Key(3), path));
+}
+
+TEST(GlyphPathCache, SeparatesKeysBySizeAndAxisValues)
+{
+	GlyphPathCache cache;
+	std::string regular = FaceKey({ { 0x77676874, 400.0f } });
+	std::string bold = FaceKey({ { 0x77676874, 700.0f } });
+
+	EXPECT_NE(Key(5, 64, regular), Key(5, 64, bold));
+	EXPECT_NE(Key(5, 64, regular), Key(5, 65, regular));
+	EXPECT_NE(Key(5, 64, regular), Key(6, 64, regular));
+	EXPECT_NE(Key(5, 64), Key(5, 64, regular));
+
+	cache.Add(Key(5, 64, regular), Encode(Square(10)));
+	cache.Add(Key(5, 64, bold), Encode(Square(20)));
+	cache.Add(Key(5, 128, regular), Encode(Square(30), 128));
+
+	GlyphPath path;
+	ASSERT_TRUE(cache.TryGet(Key(5, 64, regular), path));
+	EXPECT_EQ(Square(10).Points, path.Points);
+	ASSERT_TRUE(cache.TryGet(Key(5, 64, bold), path));
+	EXPECT_EQ(Square(20).Points, path.Points);
+	ASSERT_TRUE(cache.TryGet(Key(5, 128, regular), path));
+	EXPECT_EQ(Square(30).Points, path.Points);
+	EXPECT_FALSE(cache.TryGet(Key(5, 256, regular), path));
+	EXPECT_FALSE(cache.TryGet(Key(5, 64), path));
+}
+
+TEST(GlyphPathCache, RoundsToAboutOneInSixtyFiveThousandOfTheEm)
+{
+	EXPECT_EQ(16, GlyphPathCache::FractionBits(1));
+	EXPECT_EQ(10, GlyphPathCache::FractionBits(64));
+	EXPECT_EQ(8, GlyphPathCache::FractionBits(256));
+	EXPECT_EQ(6, GlyphPathCache::FractionBits(1024));
+	EXPECT_EQ(1, GlyphPathCache::FractionBits(32768));
+	EXPECT_EQ(0, GlyphPathCache::FractionBits(1e6f));
+	EXPECT_EQ(16, GlyphPathCache::FractionBits(0.01f));
+}
+
+TEST(GlyphPathCache, HandlesConcurrentReadsAndWrites)
+{
+	GlyphPathCache cache;
+
+	// Room for about half the glyphs, so threads evict each other's entries
+	const int glyphs = 200;
+	cache.SetBudget(Cost(Key(0), Encode(Square(1))) * glyphs / 2);
+
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 8; t++)
+	{
+		threads.emplace_back([&, t]
+			{
+				GlyphPath path;
+				for (int i = 0; i < 5000; i++)
+				{
+					uint16_t glyph = static_cast<uint16_t>((i * 7 + t * 31) % glyphs);
+					if (cache.TryGet(Key(glyph), path))
+					{
+						if (path.Points != Square(glyph).Points)
+							mismatches++;
+					}
+					else
+					{
+						cache.Add(Key(glyph), Encode(Square(glyph)));
+					}
+				}
+			});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(0, mismatches.load());
+	EXPECT_LE(cache.GetSize(), cache.GetBudget());
+	EXPECT_GT(cache.GetSize(), 0u);
+}
@@ -0,0 +1,400 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include "GlyphPath.h"
+#include "SvgPathBuilder.h"
+
+using namespace CharacterMapCX;
+
+namespace
+{
+	std::string Write(const GlyphPath& path, const SvgWriteOptions& options, int precision = 6)
+	{
+		SvgPathBuilder b;
+		b.SetPrecision(precision);
+		path.WriteSvg(b, options);
+		b.TrimEnd();
+		return std::string(b.Data(), b.Size());
+	}
+
+	SvgWriteOptions NoFill()
+	{
+		SvgWriteOptions options;
+		options.FillMode = -1;
+		return options;
+	}
+
+	/// <summary>
+	/// Reads path data written by WriteSvg back into absolute points, with
+	/// each T expanded to the Q it stands for.
+	/// </summary>
+	GlyphPath Parse(const std::string& data)
+	{
+		GlyphPath path;
+		std::istringstream in(data);
+		std::string token;
+
+		double cx = 0, cy = 0, sx = 0, sy = 0, qx = 0, qy = 0;
+		auto read = [&](bool relative, double ox, double oy, double& x, double& y)
+		{
+			in >> x >> y;
+			if (relative)
+			{
+				x += ox;
+				y += oy;
+			}
+		};
+
+		while (in >> token)
+		{
+			char c = token[0];
+			bool relative = c >= 'a';
+			double x1, y1, x2, y2, x, y;
+			bool quad = false;
+
+			switch (c & ~0x20)
+			{
+			case 'M':
+				read(relative, cx, cy, x, y);
+				path.MoveTo(static_cast<float>(x), static_cast<float>(y));
+				sx = x; sy = y;
+				break;
+			case 'L':
+				read(relative, cx, cy, x, y);
+				path.LineTo(static_cast<float>(x), static_cast<float>(y));
+				break;
+			case 'Q':
+				read(relative, cx, cy, x1, y1);
+				read(relative, cx, cy, x, y);
+				path.QuadTo(static_cast<float>(x1), static_cast<float>(y1), static_cast<float>(x), static_cast<float>(y));
+				qx = x1; qy = y1; quad = true;
+				break;
+			case 'T':
+				x1 = 2 * cx - qx;
+				y1 = 2 * cy - qy;
+				read(relative, cx, cy, x, y);
+				path.QuadTo(static_cast<float>(x1), static_cast<float>(y1), static_cast<float>(x), static_cast<float>(y));
+				qx = x1; qy = y1; quad = true;
+				break;
+			case 'C':
+				read(relative, cx, cy, x1, y1);
+				read(relative, cx, cy, x2, y2);
+				read(relative, cx, cy, x, y);
+				path.CubicTo(static_cast<float>(x1), static_cast<float>(y1), static_cast<float>(x2), static_cast<float>(y2),
+					static_cast<float>(x), static_cast<float>(y));
+				break;
+			case 'Z':
+				path.Close();
+				x = sx; y = sy;
+				break;
+			default:
+				ADD_FAILURE() << "Unexpected token " << token;
+				return path;
+			}
+
+			// A T after anything but a curve reflects nothing
+			if (!quad)
+				qx = x, qy = y;
+
+			cx = x; cy = y;
+		}
+
+		return path;
+	}
+
+	/// <summary>
+	/// A figure shaped like TrueType outlines, with runs of quadratics whose
+	/// on-curve points are implied midway between two control points.
+	/// </summary>
+	GlyphPath RandomFigure(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> coord(-500.0f, 500.0f);
+		std::uniform_int_distribution<int> run(1, 6);
+
+		GlyphPath path;
+		path.MoveTo(coord(random), coord(random));
+		for (int segment = 0; segment < 8; segment++)
+		{
+			int count = run(random);
+			if (count == 1)
+			{
+				path.LineTo(coord(random), coord(random));
+				continue;
+			}
+
+			float px = coord(random), py = coord(random);
+			for (int i = 1; i < count; i++)
+			{
+				float nx = coord(random), ny = coord(random);
+				path.QuadTo(px, py, (px + nx) / 2, (py + ny) / 2);
+				px = nx; py = ny;
+			}
+			path.QuadTo(px, py, coord(random), coord(random));
+		}
+		path.Close();
+		return path;
+	}
+}
+
+TEST(GlyphPath, WritesImpliedOnCurvePointsAsSmoothQuadratics)
+{
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	path.QuadTo(10, 10, 20, 0);
+	path.QuadTo(30, -10, 40, 0);
+	path.QuadTo(50, 10, 60, 0);
+	path.Close();
+
+	EXPECT_EQ("M 0 0 Q 10 10 20 0 T 40 0 T 60 0 Z", Write(path, NoFill()));
+
+	SvgWriteOptions options = NoFill();
+	options.Relative = true;
+	EXPECT_EQ("m 0 0 q 10 10 20 0 t 20 0 t 20 0 z", Write(path, options));
+}
+
+TEST(GlyphPath, WritesQuadraticWhenControlIsNotReflected)
+{
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	path.LineTo(10, 0);
+	path.QuadTo(10, 10, 20, 10);
+	path.QuadTo(30, 20, 30, 30);
+
+	// A quadratic after a line has no control point to reflect
+	EXPECT_EQ("M 0 0 L 10 0 Q 10 10 20 10 Q 30 20 30 30", Write(path, NoFill()));
+}
+
+TEST(GlyphPath, ComparesReflectionAfterRounding)
+{
+	// The second control point is the exact reflection of the first, but
+	// with no decimals the first rounds to 1 and the on-curve point to 2,
+	// so a T would be read back with its control point at 3.
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	path.QuadTo(1.4f, 5, 1.7f, 0);
+	path.QuadTo(2.0f, -5, 4, 0);
+
+	EXPECT_EQ("M 0 0 Q 1 5 2 0 Q 2 -5 4 0", Write(path, NoFill(), 0));
+	EXPECT_EQ("M 0 0 Q 1.4 5 1.7 0 T 4 0", Write(path, NoFill(), 1));
+}
+
+TEST(GlyphPath, RaisesQuadraticsToCubicsWhenAsked)
+{
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	path.QuadTo(30, 30, 60, 0);
+	path.QuadTo(90, -30, 120, 0);
+
+	SvgWriteOptions options = NoFill();
+	options.RaiseQuadratics = true;
+	EXPECT_EQ("M 0 0 C 20 20 40 20 60 0 C 80 -20 100 -20 120 0", Write(path, options));
+}
+
+TEST(GlyphPath, ReadsBackAsTheRoundedSourcePoints)
+{
+	std::mt19937 random(1234);
+	for (int figure = 0; figure < 200; figure++)
+	{
+		GlyphPath path = RandomFigure(random);
+
+		for (int precision : { 0, 2, 6 })
+		{
+			SvgPathBuilder rounding;
+			rounding.SetPrecision(precision);
+
+			for (bool relative : { false, true })
+			{
+				SvgWriteOptions options = NoFill();
+				options.Relative = relative;
+				std::string data = Write(path, options, precision);
+				GlyphPath parsed = Parse(data);
+
+				ASSERT_EQ(path.Verbs, parsed.Verbs) << data;
+				ASSERT_EQ(path.Points.size(), parsed.Points.size()) << data;
+				for (size_t i = 0; i < path.Points.size(); i++)
+				{
+					ASSERT_NEAR(rounding.Round(path.Points[i]), parsed.Points[i], 1e-3)
+						<< "precision " << precision << (relative ? " relative" : "") << " point " << i / 2 << "\n" << data;
+				}
+			}
+		}
+	}
+}
+
+TEST(GlyphPath, WritesRelativeCommandsFromEachFigureStart)
+{
+	GlyphPath path;
+	path.MoveTo(10, 10);
+	path.LineTo(20, 10);
+	path.CubicTo(20, 15, 25, 20, 30, 20);
+	path.Close();
+	path.MoveTo(30, 30);
+	path.LineTo(40, 40);
+
+	// Closing returns to 10,10, so the next move is relative to that
+	SvgWriteOptions options = NoFill();
+	options.Relative = true;
+	EXPECT_EQ("m 10 10 l 10 0 c 0 5 5 10 10 10 z m 20 20 l 10 10", Write(path, options));
+}
+
+TEST(GlyphPath, TakesRelativeDeltasFromRoundedPoints)
+{
+	GlyphPath path;
+	path.MoveTo(0.4f, 0);
+	path.LineTo(0.8f, 0);
+	path.LineTo(1.2f, 0);
+	path.LineTo(1.6f, 0);
+
+	// Rounded, the points are 0, 1, 1 and 2; deltas of the unrounded
+	// points would each round to 0 and never reach 2.
+	SvgWriteOptions options = NoFill();
+	options.Relative = true;
+	EXPECT_EQ("m 0 0 l 1 0 l 0 0 l 1 0", Write(path, options, 0));
+}
+
+TEST(GlyphPath, ElidesRepeatedDrawingCommands)
+{
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	path.LineTo(10, 0);
+	path.LineTo(10, 10);
+	path.QuadTo(5, 15, 0, 10);
+	path.QuadTo(-5, 5, 0, 0);
+	path.QuadTo(1, -5, 0, -10);
+	path.Close();
+	path.Close();
+	path.MoveTo(20, 20);
+	path.MoveTo(30, 30);
+	path.LineTo(40, 30);
+
+	SvgWriteOptions options = NoFill();
+	options.ElideCommands = true;
+
+	// Moves and closes are always written, as a repeated move would be read
+	// as a line
+	EXPECT_EQ("M 0 0 L 10 0 10 10 Q 5 15 0 10 T 0 0 Q 1 -5 0 -10 Z Z M 20 20 M 30 30 L 40 30", Write(path, options));
+
+	options.Relative = true;
+	EXPECT_EQ("m 0 0 l 10 0 0 10 q -5 5 -10 0 t 0 -10 q 1 -5 0 -10 z z m 20 20 m 10 10 l 10 0", Write(path, options));
+
+	options.Relative = false;
+	options.RaiseQuadratics = true;
+	EXPECT_EQ("M 0 0 L 10 0 10 10 C 6.67 13.33 3.33 13.33 0 10 -3.33 6.67 -3.33 3.33 0 0"
+		" 0.67 -3.33 0.67 -6.67 0 -10 Z Z M 20 20 M 30 30 L 40 30", Write(path, options, 2));
+}
+
+TEST(GlyphPath, SimplifyWithoutToleranceOnlyRemovesExactlyCollinearPoints)
+{
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	path.LineTo(5, 0);
+	path.LineTo(10, 0);
+	path.LineTo(10, 0);
+	path.LineTo(10, 5);
+	path.LineTo(10, 10);
+	path.LineTo(5, 5);
+	path.LineTo(0, 0);
+	path.Close();
+
+	// Slightly off the line, which a tolerance of zero keeps
+	path.MoveTo(20, 0);
+	path.LineTo(25, 0.001f);
+	path.LineTo(30, 0);
+
+	path.SimplifyLines(0);
+	EXPECT_EQ("M 0 0 L 10 0 L 10 10 L 0 0 Z M 20 0 L 25 0.001 L 30 0", Write(path, NoFill()));
+
+	// A negative tolerance leaves the path alone
+	GlyphPath copy = path;
+	copy.LineTo(35, 0);
+	copy.LineTo(40, 0);
+	GlyphPath unchanged = copy;
+	copy.SimplifyLines(-1);
+	EXPECT_EQ(unchanged.Verbs, copy.Verbs);
+	EXPECT_EQ(unchanged.Points, copy.Points);
+}
+
+TEST(GlyphPath, SimplifyKeepsCurvesAndFigureBoundaries)
+{
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	path.LineTo(5, 0);
+	path.LineTo(10, 0);
+	path.QuadTo(15, 5, 20, 0);
+	path.LineTo(25, 0);
+	path.LineTo(30, 0);
+	path.CubicTo(30, 5, 35, 5, 35, 0);
+	path.LineTo(40, 0);
+	path.Close();
+	path.MoveTo(40, 0);
+	path.LineTo(50, 0);
+	path.LineTo(60, 0);
+	path.Close();
+	path.LineTo(62, 0);
+	path.LineTo(64, 0);
+
+	// Each run of lines is simplified from the point before it, and never
+	// joins a run in another figure. A line straight after a close starts
+	// from the figure's start, not the last point written, so it's left
+	// alone.
+	path.SimplifyLines(1);
+	EXPECT_EQ("M 0 0 L 10 0 Q 15 5 20 0 L 30 0 C 30 5 35 5 35 0 L 40 0 Z M 40 0 L 60 0 Z L 62 0 L 64 0", Write(path, NoFill()));
+}
+
+TEST(GlyphPath, SimplifiedLinesStayWithinTolerance)
+{
+	auto distance = [](const float* a, const float* b, const float* p)
+	{
+		double dx = b[0] - a[0], dy = b[1] - a[1];
+		double length = dx * dx + dy * dy;
+		double t = length > 0 ? ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / length : 0;
+		t = std::max(0.0, std::min(1.0, t));
+		return std::hypot(a[0] + t * dx - p[0], a[1] + t * dy - p[1]);
+	};
+
+	std::mt19937 random(99);
+	std::normal_distribution<float> step(0, 3);
+
+	for (float tolerance : { 0.5f, 2.0f, 8.0f })
+	{
+		for (int figure = 0; figure < 50; figure++)
+		{
+			// A random walk drifting to the right, so most points are close
+			// to a straight line
+			GlyphPath path;
+			float x = 0, y = 0;
+			path.MoveTo(x, y);
+			for (int i = 0; i < 200; i++)
+				path.LineTo(x += 2 + step(random), y += step(random));
+
+			GlyphPath simplified = path;
+			simplified.SimplifyLines(tolerance);
+
+			size_t count = simplified.Points.size() / 2;
+			ASSERT_LT(count, path.Points.size() / 2);
+			ASSERT_EQ(count, simplified.Verbs.size());
+			ASSERT_EQ(path.Points[0], simplified.Points[0]);
+			ASSERT_EQ(path.Points.back(), simplified.Points.back());
+
+			// Kept points are a subsequence of the original, and every point
+			// dropped between two of them is within the tolerance of the line
+			// joining them
+			size_t next = 0;
+			for (size_t k = 0; k + 1 < count; k++)
+			{
+				const float* a = &simplified.Points[k * 2];
+				const float* b = &simplified.Points[k * 2 + 2];
+				while (path.Points[next * 2] != a[0] || path.Points[next * 2 + 1] != a[1])
+					ASSERT_LT(++next, path.Points.size() / 2);
+
+				for (next++; path.Points[next * 2] != b[0] || path.Points[next * 2 + 1] != b[1]; next++)
+				{
+					ASSERT_LT(next, path.Points.size() / 2);
+					ASSERT_LE(distance(a, b, &path.Points[next * 2]), tolerance * 1.0001);
+				}
+			}
+		}
+	}
+}
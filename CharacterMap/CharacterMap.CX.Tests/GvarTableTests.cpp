@@ -0,0 +1,511 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include "GvarTable.h"
+#include "VariationInstanceCache.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	struct Point
+	{
+		float X;
+		float Y;
+	};
+
+	int32_t F2Dot14(float value)
+	{
+		return static_cast<int32_t>(value * 16384.0f);
+	}
+
+	/// <summary>
+	/// Packs point numbers as byte runs. No points means every point.
+	/// </summary>
+	std::vector<uint8_t> PackPoints(const std::vector<uint16_t>& points)
+	{
+		ByteWriter w;
+		w.U8(static_cast<uint32_t>(points.size()));
+		if (!points.empty())
+		{
+			w.U8(static_cast<uint32_t>(points.size() - 1));
+			uint16_t last = 0;
+			for (uint16_t p : points)
+			{
+				w.U8(p - last);
+				last = p;
+			}
+		}
+		return w.Data;
+	}
+
+	/// <summary>
+	/// Packs the x deltas then the y deltas, as one run of words each.
+	/// </summary>
+	std::vector<uint8_t> PackDeltas(const std::vector<Point>& deltas)
+	{
+		ByteWriter w;
+		w.U8(0x40 | static_cast<uint32_t>(deltas.size() - 1));
+		for (const Point& d : deltas)
+			w.I16(static_cast<int32_t>(d.X));
+		w.U8(0x40 | static_cast<uint32_t>(deltas.size() - 1));
+		for (const Point& d : deltas)
+			w.I16(static_cast<int32_t>(d.Y));
+		return w.Data;
+	}
+
+	struct Tuple
+	{
+		// Shared tuple index and the private point numbers flag
+		uint16_t Index = 0;
+		std::vector<float> Peak;
+		std::vector<float> Start;
+		std::vector<float> End;
+		std::vector<uint8_t> Data;
+	};
+
+	/// <summary>
+	/// Builds one glyph's variation data. Shared point numbers are only
+	/// written when there are some.
+	/// </summary>
+	std::vector<uint8_t> GlyphVariations(const std::vector<Tuple>& tuples, const std::vector<uint8_t>& sharedPoints = {})
+	{
+		ByteWriter header;
+		for (const Tuple& t : tuples)
+		{
+			uint32_t index = t.Index;
+			if (!t.Peak.empty())
+				index |= 0x8000;
+			if (!t.Start.empty())
+				index |= 0x4000;
+
+			header.U16(static_cast<uint32_t>(t.Data.size())).U16(index);
+			for (float v : t.Peak)
+				header.I16(F2Dot14(v));
+			for (float v : t.Start)
+				header.I16(F2Dot14(v));
+			for (float v : t.End)
+				header.I16(F2Dot14(v));
+		}
+
+		uint32_t count = static_cast<uint32_t>(tuples.size()) | (sharedPoints.empty() ? 0 : 0x8000);
+
+		ByteWriter w;
+		w.U16(count).U16(4 + header.Size()).Bytes(header.Data).Bytes(sharedPoints);
+		for (const Tuple& t : tuples)
+			w.Bytes(t.Data);
+		return w.Data;
+	}
+
+	std::vector<uint8_t> MakeGvar(uint32_t axisCount, const std::vector<std::vector<float>>& sharedTuples, const std::vector<std::vector<uint8_t>>& glyphs)
+	{
+		ByteWriter tuples;
+		for (const auto& tuple : sharedTuples)
+			for (float v : tuple)
+				tuples.I16(F2Dot14(v));
+
+		uint32_t offsets = 20 + (static_cast<uint32_t>(glyphs.size()) + 1) * 4;
+		uint32_t dataOffset = offsets + tuples.Size();
+
+		ByteWriter w;
+		w.U16(1).U16(0).U16(axisCount).U16(static_cast<uint32_t>(sharedTuples.size())).U32(offsets)
+			.U16(static_cast<uint32_t>(glyphs.size())).U16(1).U32(dataOffset);
+
+		uint32_t offset = 0;
+		for (const auto& glyph : glyphs)
+		{
+			w.U32(offset);
+			offset += static_cast<uint32_t>(glyph.size());
+		}
+		w.U32(offset);
+
+		w.Bytes(tuples.Data);
+		for (const auto& glyph : glyphs)
+			w.Bytes(glyph);
+		return w.Data;
+	}
+
+	// Deltas for every point, followed by the four phantom points
+	std::vector<Point> WithPhantoms(std::vector<Point> deltas)
+	{
+		deltas.resize(deltas.size() + 4, Point{ 0, 0 });
+		return deltas;
+	}
+
+	std::vector<Point> Apply(GvarTable& table, std::vector<Point> points, const std::vector<uint32_t>& endPoints = {}, bool* ok = nullptr)
+	{
+		bool result = table.ApplyDeltas(0, points.data(), static_cast<uint32_t>(points.size()), endPoints.data(), static_cast<uint32_t>(endPoints.size()));
+		if (ok != nullptr)
+			*ok = result;
+		else
+			EXPECT_TRUE(result);
+		return points;
+	}
+
+	void ExpectPoints(const std::vector<Point>& expected, const std::vector<Point>& actual)
+	{
+		ASSERT_EQ(expected.size(), actual.size());
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			EXPECT_FLOAT_EQ(expected[i].X, actual[i].X) << "point " << i;
+			EXPECT_FLOAT_EQ(expected[i].Y, actual[i].Y) << "point " << i;
+		}
+	}
+
+	const std::vector<Point> Square = { { 0, 0 }, { 100, 0 }, { 100, 100 }, { 0, 100 } };
+}
+
+TEST(GvarTable, ScalesSharedPeakTuples)
+{
+	Tuple t;
+	t.Index = 0;
+	t.Data = PackDeltas(WithPhantoms({ { 10, 0 }, { 20, 0 }, { 30, -10 }, { 40, -20 } }));
+	std::vector<uint8_t> gvar = MakeGvar(1, { { 1 } }, { GlyphVariations({ t }) });
+
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+
+	table.SetCoordinates({ 0.5f });
+	ExpectPoints({ { 5, 0 }, { 110, 0 }, { 115, 95 }, { 20, 90 } }, Apply(table, Square));
+
+	table.SetCoordinates({ 1 });
+	ExpectPoints({ { 10, 0 }, { 120, 0 }, { 130, 90 }, { 40, 80 } }, Apply(table, Square));
+
+	// The other side of the default is outside the region
+	table.SetCoordinates({ -0.5f });
+	ExpectPoints(Square, Apply(table, Square));
+
+	table.SetCoordinates({ 0 });
+	EXPECT_TRUE(table.IsDefault());
+	ExpectPoints(Square, Apply(table, Square));
+}
+
+TEST(GvarTable, MultipliesScalarsAcrossAxes)
+{
+	Tuple t;
+	t.Peak = { 1, -1 };
+	t.Data = PackDeltas(WithPhantoms({ { 40, 80 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }));
+	std::vector<uint8_t> gvar = MakeGvar(2, {}, { GlyphVariations({ t }) });
+
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 2));
+
+	table.SetCoordinates({ 0.5f, -0.25f });
+	EXPECT_FLOAT_EQ(5, Apply(table, Square)[0].X);
+	EXPECT_FLOAT_EQ(10, Apply(table, Square)[0].Y);
+
+	table.SetCoordinates({ 0.5f, 0 });
+	EXPECT_FLOAT_EQ(0, Apply(table, Square)[0].X);
+}
+
+TEST(GvarTable, ScalesIntermediateRegions)
+{
+	Tuple embedded;
+	embedded.Peak = { 0.5f };
+	embedded.Start = { 0.25f };
+	embedded.End = { 1 };
+	embedded.Data = PackDeltas(WithPhantoms({ { 16, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }));
+
+	// A shared peak with its own intermediate region
+	Tuple shared;
+	shared.Index = 0;
+	shared.Start = { -1 };
+	shared.End = { -0.5f };
+	shared.Data = PackDeltas(WithPhantoms({ { 0, 0 }, { 0, 32 }, { 0, 0 }, { 0, 0 } }));
+
+	std::vector<uint8_t> gvar = MakeGvar(1, { { -0.5f } }, { GlyphVariations({ embedded, shared }) });
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+
+	struct { float Coord; float X; float Y; } cases[] = {
+		{ 0.2f, 0, 0 },
+		{ 0.375f, 8, 0 },
+		{ 0.5f, 16, 0 },
+		{ 0.75f, 8, 0 },
+		{ 1, 0, 0 },
+		{ -0.5f, 0, 32 },
+		{ -0.75f, 0, 16 },
+		{ -0.25f, 0, 0 },
+	};
+
+	for (const auto& c : cases)
+	{
+		table.SetCoordinates({ c.Coord });
+		std::vector<Point> points = Apply(table, Square);
+		EXPECT_FLOAT_EQ(c.X, points[0].X) << "at " << c.Coord;
+		EXPECT_FLOAT_EQ(c.Y, points[1].Y) << "at " << c.Coord;
+	}
+}
+
+TEST(GvarTable, UsesSharedOrPrivatePointNumbers)
+{
+	// Without contours, only the listed points move
+	Tuple usesShared;
+	usesShared.Peak = { 1 };
+	usesShared.Data = PackDeltas({ { 10, 1 }, { 30, 3 } });
+
+	Tuple usesPrivate;
+	usesPrivate.Index = 0x2000;
+	usesPrivate.Peak = { 1 };
+	usesPrivate.Data = PackPoints({ 1 });
+	std::vector<uint8_t> deltas = PackDeltas({ { 200, 20 } });
+	usesPrivate.Data.insert(usesPrivate.Data.end(), deltas.begin(), deltas.end());
+
+	std::vector<uint8_t> gvar = MakeGvar(1, {}, { GlyphVariations({ usesShared, usesPrivate }, PackPoints({ 0, 2 })) });
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+	table.SetCoordinates({ 1 });
+
+	ExpectPoints({ { 10, 1 }, { 300, 20 }, { 130, 103 }, { 0, 100 } }, Apply(table, Square));
+}
+
+TEST(GvarTable, PrivatePointsCanListEveryPoint)
+{
+	Tuple t;
+	t.Index = 0x2000;
+	t.Peak = { 1 };
+	t.Data = PackPoints({});
+	std::vector<uint8_t> deltas = PackDeltas(WithPhantoms({ { 1, 2 }, { 3, 4 }, { 5, 6 }, { 7, 8 } }));
+	t.Data.insert(t.Data.end(), deltas.begin(), deltas.end());
+
+	// The shared points only cover point 3, but this tuple has its own
+	std::vector<uint8_t> gvar = MakeGvar(1, {}, { GlyphVariations({ t }, PackPoints({ 3 })) });
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+	table.SetCoordinates({ 1 });
+
+	ExpectPoints({ { 1, 2 }, { 103, 4 }, { 105, 106 }, { 7, 108 } }, Apply(table, Square));
+}
+
+TEST(GvarTable, InfersUntouchedPointsBetweenTouchedOnes)
+{
+	// A diamond, with the left and right points touched
+	std::vector<Point> diamond = { { 0, 50 }, { 50, 0 }, { 100, 50 }, { 50, 100 }, { -20, 50 } };
+
+	Tuple t;
+	t.Index = 0x2000;
+	t.Peak = { 1 };
+	t.Data = PackPoints({ 0, 2 });
+	std::vector<uint8_t> deltas = PackDeltas({ { 10, 4 }, { 30, 4 } });
+	t.Data.insert(t.Data.end(), deltas.begin(), deltas.end());
+
+	std::vector<uint8_t> gvar = MakeGvar(1, {}, { GlyphVariations({ t }) });
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+	table.SetCoordinates({ 1 });
+
+	// Points between the touched ones in x are interpolated; the point past
+	// them takes the nearer one's delta. Both touched points move by the
+	// same y, so every point does.
+	ExpectPoints({ { 10, 54 }, { 70, 4 }, { 130, 54 }, { 70, 104 }, { -10, 54 } }, Apply(table, diamond, { 4 }));
+}
+
+TEST(GvarTable, ShiftsAContourWithOneTouchedPoint)
+{
+	std::vector<Point> points = { { 0, 0 }, { 100, 0 }, { 50, 80 }, { 200, 0 }, { 300, 0 }, { 250, 80 } };
+
+	Tuple t;
+	t.Index = 0x2000;
+	t.Peak = { 1 };
+	t.Data = PackPoints({ 1 });
+	std::vector<uint8_t> deltas = PackDeltas({ { 5, -7 } });
+	t.Data.insert(t.Data.end(), deltas.begin(), deltas.end());
+
+	std::vector<uint8_t> gvar = MakeGvar(1, {}, { GlyphVariations({ t }) });
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+	table.SetCoordinates({ 1 });
+
+	// The whole first contour moves with its one touched point, and the
+	// second, with none touched, stays put
+	ExpectPoints({ { 5, -7 }, { 105, -7 }, { 55, 73 }, { 200, 0 }, { 300, 0 }, { 250, 80 } },
+		Apply(table, points, { 2, 5 }));
+}
+
+TEST(GvarTable, IgnoresPointNumbersPastTheGlyph)
+{
+	Tuple t;
+	t.Index = 0x2000;
+	t.Peak = { 1 };
+	t.Data = PackPoints({ 0, 9 });
+	std::vector<uint8_t> deltas = PackDeltas({ { 10, 10 }, { 99, 99 } });
+	t.Data.insert(t.Data.end(), deltas.begin(), deltas.end());
+
+	std::vector<uint8_t> gvar = MakeGvar(1, {}, { GlyphVariations({ t }) });
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+	table.SetCoordinates({ 1 });
+
+	ExpectPoints({ { 10, 10 }, { 110, 10 }, { 110, 110 }, { 10, 110 } }, Apply(table, Square, { 3 }));
+}
+
+TEST(GvarTable, RejectsMalformedTables)
+{
+	Tuple t;
+	t.Index = 0;
+	t.Data = PackDeltas(WithPhantoms({ { 1, 1 }, { 1, 1 }, { 1, 1 }, { 1, 1 } }));
+	std::vector<uint8_t> gvar = MakeGvar(1, { { 1 } }, { GlyphVariations({ t }) });
+
+	GvarTable table;
+	EXPECT_TRUE(table.Load(Span(gvar), 1));
+	EXPECT_FALSE(table.Load(Span(gvar), 2));
+	EXPECT_FALSE(table.Load(Span(std::vector<uint8_t>(gvar.begin(), gvar.begin() + 20)), 1));
+
+	std::vector<uint8_t> version = gvar;
+	version[1] = 2;
+	EXPECT_FALSE(table.Load(Span(version), 1));
+
+	// Shared tuples running past the end of the table
+	std::vector<uint8_t> shared = gvar;
+	shared[7] = 200;
+	EXPECT_FALSE(table.Load(Span(shared), 1));
+}
+
+TEST(GvarTable, RejectsTruncatedTupleData)
+{
+	Tuple t;
+	t.Peak = { 1 };
+	t.Data = PackDeltas(WithPhantoms({ { 10, 0 }, { 20, 0 }, { 30, -10 }, { 40, -20 } }));
+	std::vector<uint8_t> glyph = GlyphVariations({ t });
+
+	// Cutting the glyph's data anywhere leaves it malformed
+	for (size_t size = 1; size < glyph.size(); size++)
+	{
+		std::vector<uint8_t> gvar = MakeGvar(1, {}, { std::vector<uint8_t>(glyph.begin(), glyph.begin() + size) });
+		GvarTable table;
+		ASSERT_TRUE(table.Load(Span(gvar), 1));
+		table.SetCoordinates({ 1 });
+
+		bool ok = true;
+		Apply(table, Square, {}, &ok);
+		EXPECT_FALSE(ok) << "size " << size;
+	}
+}
+
+TEST(GvarTable, RejectsCorruptTupleHeaders)
+{
+	GvarTable table;
+	bool ok = true;
+
+	// A shared tuple index past the shared tuples
+	Tuple t;
+	t.Index = 3;
+	t.Data = PackDeltas(WithPhantoms({ { 1, 1 }, { 1, 1 }, { 1, 1 }, { 1, 1 } }));
+	std::vector<uint8_t> gvar = MakeGvar(1, { { 1 } }, { GlyphVariations({ t }) });
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+	table.SetCoordinates({ 1 });
+	Apply(table, Square, {}, &ok);
+	EXPECT_FALSE(ok);
+
+	// A tuple claiming more data than the glyph holds
+	t.Index = 0;
+	std::vector<uint8_t> glyph = GlyphVariations({ t });
+	glyph[5] += 10;
+	gvar = MakeGvar(1, { { 1 } }, { glyph });
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+	table.SetCoordinates({ 1 });
+	Apply(table, Square, {}, &ok);
+	EXPECT_FALSE(ok);
+
+	// Point numbers claiming more points than follow
+	Tuple sparse;
+	sparse.Index = 0x2000;
+	sparse.Peak = { 1 };
+	sparse.Data = { 5, 1, 0, 1 };
+	gvar = MakeGvar(1, {}, { GlyphVariations({ sparse }) });
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+	table.SetCoordinates({ 1 });
+	Apply(table, Square, {}, &ok);
+	EXPECT_FALSE(ok);
+}
+
+TEST(GvarTable, SkipsTheDataOfTuplesThatDontApply)
+{
+	// This tuple's data is garbage, but it only applies to heavier instances
+	Tuple unused;
+	unused.Peak = { 1 };
+	unused.Start = { 0.5f };
+	unused.End = { 1 };
+	unused.Data = { 0x7F };
+
+	Tuple used;
+	used.Peak = { -1 };
+	used.Data = PackDeltas(WithPhantoms({ { 8, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }));
+
+	std::vector<uint8_t> gvar = MakeGvar(1, {}, { GlyphVariations({ unused, used }) });
+	GvarTable table;
+	ASSERT_TRUE(table.Load(Span(gvar), 1));
+
+	table.SetCoordinates({ -0.5f });
+	EXPECT_FLOAT_EQ(4, Apply(table, Square)[0].X);
+
+	bool ok = true;
+	table.SetCoordinates({ 0.75f });
+	Apply(table, Square, {}, &ok);
+	EXPECT_FALSE(ok);
+}
+
+TEST(GvarTable, ReusesSharedScalarsForTheSameInstance)
+{
+	Tuple t;
+	t.Index = 1;
+	t.Data = PackDeltas(WithPhantoms({ { 10, 0 }, { 20, 0 }, { 30, -10 }, { 40, -20 } }));
+	std::vector<uint8_t> gvar = MakeGvar(1, { { -1 }, { 1 } }, { GlyphVariations({ t }) });
+
+	GvarTable first;
+	ASSERT_TRUE(first.Load(Span(gvar), 1));
+	first.SetCoordinates({ 0.25f });
+
+	std::shared_ptr<const std::vector<float>> scalars = first.GetSharedScalars();
+	ASSERT_NE(nullptr, scalars);
+	EXPECT_EQ((std::vector<float>{ 0, 0.25f }), *scalars);
+
+	GvarTable second;
+	ASSERT_TRUE(second.Load(Span(gvar), 1));
+	second.SetCoordinates({ 0.25f }, scalars);
+	EXPECT_EQ(scalars, second.GetSharedScalars());
+	ExpectPoints(Apply(first, Square), Apply(second, Square));
+
+	// Scalars for a different number of shared tuples are worked out again
+	auto wrong = std::make_shared<const std::vector<float>>(1, 1.0f);
+	second.SetCoordinates({ 0.25f }, wrong);
+	EXPECT_NE(wrong, second.GetSharedScalars());
+	EXPECT_EQ(*scalars, *second.GetSharedScalars());
+}
+
+TEST(VariationInstanceCache, KeepsTheFirstInstanceAddedForAKey)
+{
+	VariationInstanceCache cache;
+	EXPECT_EQ(nullptr, cache.TryGet("face"));
+
+	auto first = std::make_shared<VariationInstance>();
+	first->Coords = { 0.5f };
+	auto second = std::make_shared<VariationInstance>();
+
+	EXPECT_EQ(first, cache.Add("face", first));
+	EXPECT_EQ(first, cache.Add("face", second));
+	EXPECT_EQ(first, cache.TryGet("face"));
+	EXPECT_EQ(1u, cache.GetCount());
+}
+
+TEST(VariationInstanceCache, DropsTheLeastRecentlyUsed)
+{
+	VariationInstanceCache cache;
+	cache.SetCapacity(2);
+
+	cache.Add("a", std::make_shared<VariationInstance>());
+	cache.Add("b", std::make_shared<VariationInstance>());
+	EXPECT_NE(nullptr, cache.TryGet("a"));
+	cache.Add("c", std::make_shared<VariationInstance>());
+
+	EXPECT_NE(nullptr, cache.TryGet("a"));
+	EXPECT_EQ(nullptr, cache.TryGet("b"));
+	EXPECT_NE(nullptr, cache.TryGet("c"));
+
+	cache.SetCapacity(0);
+	EXPECT_EQ(0u, cache.GetCount());
+	EXPECT_NE(nullptr, cache.Add("d", std::make_shared<VariationInstance>()));
+	EXPECT_EQ(nullptr, cache.TryGet("d"));
+}
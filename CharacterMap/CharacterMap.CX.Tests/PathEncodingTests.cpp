@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "PathEncoding.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	std::vector<uint8_t> Encode(const GlyphPath& path, uint8_t fractionBits = PathEncoding::DefaultFractionBits)
+	{
+		std::vector<uint8_t> encoded;
+		PathEncoding::Encode(path, encoded, fractionBits);
+		return encoded;
+	}
+
+	bool Decode(const std::vector<uint8_t>& encoded, GlyphPath& path)
+	{
+		return PathEncoding::Decode(Span(encoded), path);
+	}
+
+	uint8_t Command(PathVerb verb, uint32_t run)
+	{
+		return static_cast<uint8_t>((run - 1) << 3 | static_cast<uint8_t>(verb));
+	}
+
+	GlyphPath EveryVerb()
+	{
+		GlyphPath path;
+		path.MoveTo(100, -700);
+		path.LineTo(612.5f, -700);
+		path.QuadTo(700, -700, 700, -612.25f);
+		path.CubicTo(700, -300, 650.00390625f, 0, 400, 0);
+		path.LineTo(100, 0);
+		path.Close();
+		path.MoveTo(-20, 30);
+		path.LineTo(-40, 30);
+		path.Close();
+		return path;
+	}
+}
+
+TEST(PathEncoding, RoundTripsPointsOnTheGridExactly)
+{
+	GlyphPath path = EveryVerb();
+
+	GlyphPath decoded;
+	ASSERT_TRUE(Decode(Encode(path), decoded));
+	EXPECT_EQ(path.Verbs, decoded.Verbs);
+	EXPECT_EQ(path.Points, decoded.Points);
+}
+
+TEST(PathEncoding, WritesZigZagVarintDeltas)
+{
+	GlyphPath path;
+	path.MoveTo(1, -1);
+	path.LineTo(1 + 64, -1 - 64);
+	path.LineTo(100065, -1);
+
+	std::vector<uint8_t> expected = {
+		PathEncoding::Version, 0,
+		Command(PathVerb::Move, 1), 2, 1,
+		Command(PathVerb::Line, 2),
+			// 64 and -64 zigzag to 128 and 127, so only the first takes two bytes
+			0x80, 0x01, 0x7F,
+			// 100000 zigzags to 200000, three 7-bit groups; 64 zigzags to 128
+			0xC0, 0x9A, 0x0C, 0x80, 0x01,
+	};
+
+	EXPECT_EQ(expected, Encode(path, 0));
+}
+
+TEST(PathEncoding, PacksRunsOfOneVerbIntoCommandBytes)
+{
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	for (int i = 1; i <= 40; i++)
+		path.LineTo(static_cast<float>(i), 0);
+	path.QuadTo(41, 1, 42, 0);
+	path.Close();
+
+	std::vector<uint8_t> encoded = Encode(path, 0);
+
+	// Every line advances by one unit in x, which is two one-byte varints
+	ASSERT_EQ(2u + 3 + (1 + 32 * 2) + (1 + 8 * 2) + (1 + 4) + 1, encoded.size());
+	EXPECT_EQ(Command(PathVerb::Move, 1), encoded[2]);
+	EXPECT_EQ(Command(PathVerb::Line, 32), encoded[5]);
+	EXPECT_EQ(Command(PathVerb::Line, 8), encoded[5 + 65]);
+	EXPECT_EQ(Command(PathVerb::Quad, 1), encoded[5 + 65 + 17]);
+	EXPECT_EQ(Command(PathVerb::Close, 1), encoded.back());
+
+	GlyphPath decoded;
+	ASSERT_TRUE(Decode(encoded, decoded));
+	EXPECT_EQ(path.Verbs, decoded.Verbs);
+	EXPECT_EQ(path.Points, decoded.Points);
+}
+
+TEST(PathEncoding, RoundsToWithinHalfAStep)
+{
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> coord(-2000.0f, 2000.0f);
+
+	GlyphPath path;
+	path.MoveTo(coord(random), coord(random));
+	for (int i = 0; i < 500; i++)
+		path.CubicTo(coord(random), coord(random), coord(random), coord(random), coord(random), coord(random));
+	path.Close();
+
+	for (uint8_t bits : { 0, 4, 8, 12 })
+	{
+		GlyphPath decoded;
+		ASSERT_TRUE(Decode(Encode(path, bits), decoded));
+		ASSERT_EQ(path.Points.size(), decoded.Points.size());
+
+		// Half a step, plus the float rounding of a value this large
+		float bound = 0.5f / (1 << bits) + 2000.0f * 1e-6f;
+		for (size_t i = 0; i < path.Points.size(); i++)
+			ASSERT_NEAR(path.Points[i], decoded.Points[i], bound) << "bits " << int(bits) << ", point " << i / 2;
+	}
+}
+
+TEST(PathEncoding, LimitsFractionBits)
+{
+	GlyphPath path;
+	path.MoveTo(0.5f, 0.25f);
+
+	std::vector<uint8_t> encoded = Encode(path, 20);
+	EXPECT_EQ(16, encoded[1]);
+
+	GlyphPath decoded;
+	ASSERT_TRUE(Decode(encoded, decoded));
+	EXPECT_EQ(path.Points, decoded.Points);
+}
+
+TEST(PathEncoding, DecodesAnEmptyPath)
+{
+	std::vector<uint8_t> encoded = Encode(GlyphPath());
+	EXPECT_EQ(2u, encoded.size());
+
+	GlyphPath decoded;
+	decoded.MoveTo(1, 1);
+	EXPECT_TRUE(Decode(encoded, decoded));
+	EXPECT_TRUE(decoded.IsEmpty());
+}
+
+TEST(PathEncoding, RejectsTruncatedInput)
+{
+	std::vector<uint8_t> encoded = Encode(EveryVerb());
+
+	// Offsets where a whole command ends, so a shorter stream is still valid
+	std::vector<size_t> ends;
+	for (size_t size = 2; size <= encoded.size(); size++)
+	{
+		GlyphPath decoded;
+		std::vector<uint8_t> prefix(encoded.begin(), encoded.begin() + size);
+		if (Decode(prefix, decoded))
+			ends.push_back(size);
+	}
+
+	// Header, then after each of the nine commands
+	EXPECT_EQ(10u, ends.size());
+	EXPECT_EQ(encoded.size(), ends.back());
+
+	GlyphPath decoded;
+	EXPECT_FALSE(Decode(std::vector<uint8_t>(encoded.begin(), encoded.begin() + 1), decoded));
+	EXPECT_FALSE(Decode(std::vector<uint8_t>(), decoded));
+}
+
+TEST(PathEncoding, RejectsMalformedInput)
+{
+	GlyphPath decoded;
+	EXPECT_FALSE(Decode({ 2, 8 }, decoded));
+	EXPECT_FALSE(Decode({ PathEncoding::Version, 17 }, decoded));
+
+	// Verbs past Close
+	for (uint8_t verb = 5; verb < 8; verb++)
+		EXPECT_FALSE(Decode({ PathEncoding::Version, 8, verb, 0, 0 }, decoded));
+
+	// A varint longer than five bytes
+	EXPECT_FALSE(Decode({ PathEncoding::Version, 8, 0, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0 }, decoded));
+
+	// Large deltas wrap rather than overflow
+	EXPECT_TRUE(Decode({ PathEncoding::Version, 0, Command(PathVerb::Line, 2), 0xFE, 0xFF, 0xFF, 0xFF, 0x0F, 0, 0xFE, 0xFF, 0xFF, 0xFF, 0x0F, 0 }, decoded));
+}
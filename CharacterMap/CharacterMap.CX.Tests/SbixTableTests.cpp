@@ -0,0 +1,298 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "SbixTable.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	struct Record
+	{
+		const char* Type;
+		std::vector<uint8_t> Data;
+		int16_t OriginX = 0;
+		int16_t OriginY = 0;
+	};
+
+	struct Strike
+	{
+		uint16_t Ppem;
+		uint16_t Ppi;
+		// One entry per glyph; a null type leaves the record empty
+		std::vector<Record> Glyphs;
+	};
+
+	Record Png(uint8_t marker, int16_t x = 0, int16_t y = 0)
+	{
+		return { "png ", { 0x89, 'P', 'N', 'G', marker }, x, y };
+	}
+
+	Record Dupe(uint16_t glyph)
+	{
+		return { "dupe", { static_cast<uint8_t>(glyph >> 8), static_cast<uint8_t>(glyph) } };
+	}
+
+	Record Empty()
+	{
+		return { nullptr, {} };
+	}
+
+	std::vector<uint8_t> MakeStrike(const Strike& strike)
+	{
+		uint32_t count = static_cast<uint32_t>(strike.Glyphs.size());
+
+		ByteWriter w;
+		w.U16(strike.Ppem).U16(strike.Ppi);
+
+		uint32_t offset = 4 + (count + 1) * 4;
+		ByteWriter records;
+		for (const Record& r : strike.Glyphs)
+		{
+			w.U32(offset + records.Size());
+			if (r.Type != nullptr)
+				records.I16(r.OriginX).I16(r.OriginY).Tag(r.Type).Bytes(r.Data);
+		}
+
+		w.U32(offset + records.Size()).Bytes(records.Data);
+		return w.Data;
+	}
+
+	std::vector<uint8_t> MakeSbix(const std::vector<Strike>& strikes)
+	{
+		ByteWriter w;
+		w.U16(1).U16(1).U32(static_cast<uint32_t>(strikes.size()));
+
+		uint32_t offset = 8 + static_cast<uint32_t>(strikes.size()) * 4;
+		std::vector<std::vector<uint8_t>> data;
+		for (const Strike& s : strikes)
+		{
+			data.push_back(MakeStrike(s));
+			w.U32(offset);
+			offset += static_cast<uint32_t>(data.back().size());
+		}
+
+		for (const auto& d : data)
+			w.Bytes(d);
+		return w.Data;
+	}
+
+	/// <summary>
+	/// The marker byte Png put at the end of an image, to tell them apart.
+	/// </summary>
+	uint8_t Marker(const BitmapGlyph& glyph)
+	{
+		return glyph.Data.UInt8(glyph.Data.Size - 1);
+	}
+
+	// Strikes are written out of order, as Load sorts them
+	const std::vector<Strike> ThreeStrikes = {
+		{ 64, 72, { Png(64), Png(64), Empty() } },
+		{ 20, 72, { Png(20), Empty(), Empty() } },
+		{ 160, 144, { Png(160), Empty(), Png(161) } },
+	};
+}
+
+TEST(SbixTable, SortsStrikesBySize)
+{
+	std::vector<uint8_t> sbix = MakeSbix(ThreeStrikes);
+
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(sbix), 3));
+	ASSERT_EQ(3u, table.GetStrikes().size());
+	EXPECT_EQ(20, table.GetStrikes()[0].Ppem);
+	EXPECT_EQ(64, table.GetStrikes()[1].Ppem);
+	EXPECT_EQ(160, table.GetStrikes()[2].Ppem);
+	EXPECT_EQ(144, table.GetStrikes()[2].Ppi);
+}
+
+TEST(SbixTable, SelectsExactThenLargerThenLargestStrike)
+{
+	std::vector<uint8_t> sbix = MakeSbix(ThreeStrikes);
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(sbix), 3));
+
+	EXPECT_EQ(1, table.SelectStrike(64));
+	EXPECT_EQ(0, table.SelectStrike(20));
+	EXPECT_EQ(0, table.SelectStrike(1));
+	EXPECT_EQ(1, table.SelectStrike(21));
+	EXPECT_EQ(2, table.SelectStrike(65));
+	EXPECT_EQ(2, table.SelectStrike(1000));
+
+	EXPECT_EQ(-1, SbixTable().SelectStrike(64));
+}
+
+TEST(SbixTable, ReadsImageAndOrigin)
+{
+	std::vector<uint8_t> sbix = MakeSbix({ { 32, 96, { Empty(), Png(7, -3, 12) } } });
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(sbix), 2));
+
+	BitmapGlyph glyph;
+	ASSERT_TRUE(table.TryGetGlyph(1, 32, glyph));
+	EXPECT_EQ(static_cast<uint32_t>(GlyphFormat_Png), glyph.Format);
+	EXPECT_EQ(1, glyph.GlyphId);
+	EXPECT_EQ(32, glyph.Ppem);
+	EXPECT_EQ(96, glyph.Ppi);
+	EXPECT_EQ(-3, glyph.OriginX);
+	EXPECT_EQ(12, glyph.OriginY);
+	ASSERT_EQ(5u, glyph.Data.Size);
+	EXPECT_EQ(0x89, glyph.Data.UInt8(0));
+	EXPECT_EQ(7, Marker(glyph));
+}
+
+TEST(SbixTable, FallsBackToLargerThenSmallerStrikes)
+{
+	std::vector<uint8_t> sbix = MakeSbix(ThreeStrikes);
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(sbix), 3));
+
+	BitmapGlyph glyph;
+	ASSERT_TRUE(table.TryGetGlyph(0, 64, glyph));
+	EXPECT_EQ(64, Marker(glyph));
+
+	// Glyph 2 is only in the 160 strike, which is larger
+	ASSERT_TRUE(table.TryGetGlyph(2, 20, glyph));
+	EXPECT_EQ(161, Marker(glyph));
+	EXPECT_EQ(160, glyph.Ppem);
+
+	// Glyph 1 is only in the 64 strike, smaller than the preferred 160
+	ASSERT_TRUE(table.TryGetGlyph(1, 100, glyph));
+	EXPECT_EQ(64, Marker(glyph));
+
+	// No fallback when reading one strike
+	EXPECT_FALSE(table.TryGetGlyphFromStrike(2, 1, glyph));
+	EXPECT_FALSE(table.TryGetGlyphFromStrike(3, 0, glyph));
+	EXPECT_FALSE(table.TryGetGlyphFromStrike(-1, 0, glyph));
+}
+
+TEST(SbixTable, TreatsZeroLengthRecordsAsMissing)
+{
+	// A record with only its header and no image data counts as empty
+	Record headerOnly = { "png ", {} };
+	std::vector<uint8_t> sbix = MakeSbix({ { 16, 72, { Empty(), headerOnly, Png(1) } } });
+
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(sbix), 3));
+
+	BitmapGlyph glyph;
+	EXPECT_FALSE(table.TryGetGlyph(0, 16, glyph));
+	EXPECT_FALSE(table.TryGetGlyph(1, 16, glyph));
+	EXPECT_TRUE(table.TryGetGlyph(2, 16, glyph));
+	EXPECT_FALSE(table.TryGetGlyph(3, 16, glyph));
+}
+
+TEST(SbixTable, RejectsUnknownGraphicTypes)
+{
+	Record mask = { "mask", { 1, 2, 3 } };
+	std::vector<uint8_t> sbix = MakeSbix({ { 16, 72, { mask, { "jpg ", { 1 } }, { "tiff", { 1 } } } } });
+
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(sbix), 3));
+
+	BitmapGlyph glyph;
+	EXPECT_FALSE(table.TryGetGlyph(0, 16, glyph));
+	ASSERT_TRUE(table.TryGetGlyph(1, 16, glyph));
+	EXPECT_EQ(static_cast<uint32_t>(GlyphFormat_Jpeg), glyph.Format);
+	ASSERT_TRUE(table.TryGetGlyph(2, 16, glyph));
+	EXPECT_EQ(static_cast<uint32_t>(GlyphFormat_Tiff), glyph.Format);
+}
+
+TEST(SbixTable, FollowsDupeRecords)
+{
+	std::vector<uint8_t> sbix = MakeSbix({ { 16, 72, { Png(9, 4, 5), Dupe(0), Dupe(1), Dupe(7) } } });
+
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(sbix), 4));
+
+	BitmapGlyph glyph;
+	ASSERT_TRUE(table.TryGetGlyph(2, 16, glyph));
+	EXPECT_EQ(9, Marker(glyph));
+	EXPECT_EQ(0, glyph.GlyphId);
+	EXPECT_EQ(4, glyph.OriginX);
+
+	// A dupe of a glyph past numGlyphs
+	EXPECT_FALSE(table.TryGetGlyph(3, 16, glyph));
+}
+
+TEST(SbixTable, StopsDupeChainsAfterEightRecords)
+{
+	// Glyph n is a dupe of n + 1, and the last glyph has the image
+	std::vector<Record> records;
+	for (uint16_t i = 0; i < 9; i++)
+		records.push_back(Dupe(i + 1));
+	records.push_back(Png(42));
+
+	// A cycle, for good measure
+	records.push_back(Dupe(11));
+	records.push_back(Dupe(10));
+
+	std::vector<uint8_t> sbix = MakeSbix({ { 16, 72, records } });
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(sbix), static_cast<uint16_t>(records.size())));
+
+	// Seven dupes then the image is eight records, the most that are read
+	BitmapGlyph glyph;
+	ASSERT_TRUE(table.TryGetGlyph(2, 16, glyph));
+	EXPECT_EQ(42, Marker(glyph));
+	EXPECT_FALSE(table.TryGetGlyph(1, 16, glyph));
+	EXPECT_FALSE(table.TryGetGlyph(0, 16, glyph));
+
+	EXPECT_FALSE(table.TryGetGlyph(10, 16, glyph));
+}
+
+TEST(SbixTable, SkipsStrikesWithTruncatedOffsetArrays)
+{
+	std::vector<uint8_t> sbix = MakeSbix({ { 16, 72, { Png(16), Png(16) } }, { 32, 72, { Png(32), Png(32) } } });
+
+	// Claiming more glyphs than the strikes have offsets for makes the
+	// second strike's array run off the end of the table
+	SbixTable table;
+	uint32_t second = Span(sbix).UInt32(12);
+	uint32_t size = static_cast<uint32_t>(sbix.size()) - second;
+	uint16_t glyphs = static_cast<uint16_t>((size - 4) / 4);
+	ASSERT_TRUE(table.Load(Span(sbix), glyphs));
+	ASSERT_EQ(1u, table.GetStrikes().size());
+	EXPECT_EQ(16, table.GetStrikes()[0].Ppem);
+
+	// With no strike left, nothing loads
+	EXPECT_FALSE(table.Load(Span(std::vector<uint8_t>(sbix.begin(), sbix.begin() + 20)), 2));
+}
+
+TEST(SbixTable, RejectsTruncatedHeaders)
+{
+	std::vector<uint8_t> sbix = MakeSbix(ThreeStrikes);
+	SbixTable table;
+
+	EXPECT_FALSE(table.Load(Span(std::vector<uint8_t>(sbix.begin(), sbix.begin() + 7)), 3));
+
+	// More strike offsets than the table has room for
+	std::vector<uint8_t> count = sbix;
+	count[4] = 0x10;
+	EXPECT_FALSE(table.Load(Span(count), 3));
+
+	// Offsets pointing past the end only drop their own strike
+	std::vector<uint8_t> offset = sbix;
+	offset[8] = 0x10;
+	ASSERT_TRUE(table.Load(Span(offset), 3));
+	EXPECT_EQ(2u, table.GetStrikes().size());
+}
+
+TEST(SbixTable, IgnoresRecordsRunningPastTheStrike)
+{
+	std::vector<uint8_t> sbix = MakeSbix({ { 16, 72, { Png(1), Png(2) } } });
+
+	// Point glyph 1's end offset past the end of the table
+	uint32_t strike = Span(sbix).UInt32(8);
+	ByteWriter w;
+	w.Data = sbix;
+	w.SetU32(strike + 4 + 2 * 4, 0x1000);
+
+	SbixTable table;
+	ASSERT_TRUE(table.Load(Span(w.Data), 2));
+
+	BitmapGlyph glyph;
+	EXPECT_TRUE(table.TryGetGlyph(0, 16, glyph));
+	EXPECT_FALSE(table.TryGetGlyph(1, 16, glyph));
+}
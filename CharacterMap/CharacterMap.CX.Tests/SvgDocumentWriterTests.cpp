@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "SvgDocumentWriter.h"
+
+using namespace CharacterMapCX;
+
+namespace
+{
+	std::string Text(const SvgPathBuilder& b)
+	{
+		return std::string(b.Data(), b.Size());
+	}
+
+	std::string Document(const GlyphPath& path, uint32_t argb, const SvgWriteOptions& options = SvgWriteOptions())
+	{
+		SvgPathBuilder b;
+		SvgDocumentWriter::WriteDocument(b, path, options, argb);
+		return Text(b);
+	}
+
+	std::string Symbol(const std::string& id, const GlyphPath& path, const SvgWriteOptions& options = SvgWriteOptions())
+	{
+		SvgPathBuilder b;
+		SvgDocumentWriter::WriteSymbol(b, id.data(), id.size(), path, options);
+		return Text(b);
+	}
+
+	GlyphPath Square(float left, float top, float size)
+	{
+		GlyphPath path;
+		path.MoveTo(left, top);
+		path.LineTo(left + size, top);
+		path.LineTo(left + size, top + size);
+		path.LineTo(left, top + size);
+		path.Close();
+		return path;
+	}
+
+	const std::string EmptyDocument = "<svg width=\"100%\" height=\"100%\" xmlns=\"http://www.w3.org/2000/svg\"></svg>";
+}
+
+TEST(SvgDocumentWriter, WritesAFilledDocument)
+{
+	// The fill rule prefix is never written into a document
+	EXPECT_EQ("<svg width=\"100%\" height=\"100%\" viewBox=\"0 0 10 10\" xmlns=\"http://www.w3.org/2000/svg\">"
+		"<path d=\"M 0 0 L 10 0 L 10 10 L 0 10 Z\" style=\"fill: #ff8000; fill-opacity: 0.501961\" /></svg>",
+		Document(Square(0, 0, 10), 0x80FF8000));
+}
+
+TEST(SvgDocumentWriter, WritesPathsWithTheGivenOptions)
+{
+	SvgWriteOptions options;
+	options.Relative = true;
+	options.ElideCommands = true;
+
+	std::string document = Document(Square(0, 0, 10), 0xFF000000, options);
+	EXPECT_NE(std::string::npos, document.find("d=\"m 0 0 l 10 0 0 10 -10 0 z\"")) << document;
+}
+
+TEST(SvgDocumentWriter, ExpandsTheViewBoxToWholeUnits)
+{
+	std::string document = Document(Square(-10.4f, 0.25f, 30.7f), 0xFF000000);
+	EXPECT_NE(std::string::npos, document.find("viewBox=\"-11 0 32 31\"")) << document;
+
+	// Curves are bounded by their extrema, not their control points
+	GlyphPath path;
+	path.MoveTo(0, 0);
+	path.QuadTo(10, 20, 20, 0);
+	path.Close();
+	document = Document(path, 0xFF000000);
+	EXPECT_NE(std::string::npos, document.find("viewBox=\"0 0 20 10\"")) << document;
+}
+
+TEST(SvgDocumentWriter, WritesTheColourAndOpacitySeparately)
+{
+	auto style = [](uint32_t argb)
+	{
+		std::string document = Document(Square(0, 0, 1), argb);
+		size_t start = document.find("style=\"");
+		return document.substr(start, document.find('"', start + 7) + 1 - start);
+	};
+
+	EXPECT_EQ("style=\"fill: #012345; fill-opacity: 1\"", style(0xFF012345));
+	EXPECT_EQ("style=\"fill: #abcdef; fill-opacity: 0\"", style(0x00ABCDEF));
+	EXPECT_EQ("style=\"fill: #000000; fill-opacity: 0.2\"", style(0x33000000));
+	EXPECT_EQ("style=\"fill: #ffffff; fill-opacity: 0.003922\"", style(0x01FFFFFF));
+}
+
+TEST(SvgDocumentWriter, WritesAnEmptyDocumentForGlyphsWithoutSegments)
+{
+	EXPECT_EQ(EmptyDocument, Document(GlyphPath(), 0xFF000000));
+
+	// Figures that never draw anything, as some fonts have for spaces
+	GlyphPath path;
+	path.MoveTo(10, 10);
+	path.Close();
+	path.MoveTo(20, 20);
+	EXPECT_EQ(EmptyDocument, Document(path, 0xFF000000));
+
+	EXPECT_EQ("<symbol id=\"space\" />\r\n", Symbol("space", path));
+	EXPECT_EQ("<symbol id=\"space\" />\r\n", Symbol("space", GlyphPath()));
+}
+
+TEST(SvgDocumentWriter, WritesSymbolsWithoutAFill)
+{
+	EXPECT_EQ("<symbol id=\"uni0041\" viewBox=\"1 2 5 5\"><path d=\"M 1 2 L 6 2 L 6 7 L 1 7 Z\" /></symbol>\r\n",
+		Symbol("uni0041", Square(1, 2, 5)));
+}
+
+TEST(SvgDocumentWriter, EscapesSymbolIds)
+{
+	EXPECT_EQ("<symbol id=\"a&amp;b&lt;c&gt;d&quot;e&apos;f\" />\r\n", Symbol("a&b<c>d\"e'f", GlyphPath()));
+
+	// UTF-8 is passed through as it is
+	EXPECT_EQ("<symbol id=\"caf\xC3\xA9\" />\r\n", Symbol("caf\xC3\xA9", GlyphPath()));
+
+	// Only the given length is written, so ids needn't be terminated
+	SvgPathBuilder b;
+	SvgDocumentWriter::WriteSymbol(b, "glyph&more", 5, GlyphPath(), SvgWriteOptions());
+	EXPECT_EQ("<symbol id=\"glyph\" />\r\n", Text(b));
+}
+
+TEST(SvgDocumentWriter, WritesASpriteSheet)
+{
+	SvgPathBuilder b;
+	SvgDocumentWriter::WriteHeader(b);
+	SvgDocumentWriter::BeginSprite(b);
+	SvgDocumentWriter::WriteSymbol(b, "a", 1, Square(0, 0, 2), SvgWriteOptions());
+	SvgDocumentWriter::WriteSymbol(b, "b", 1, GlyphPath(), SvgWriteOptions());
+	SvgDocumentWriter::EndSprite(b);
+
+	EXPECT_EQ("<!-- Exported by Character Map UWP -->\r\n"
+		"<svg xmlns=\"http://www.w3.org/2000/svg\">\r\n"
+		"<symbol id=\"a\" viewBox=\"0 0 2 2\"><path d=\"M 0 0 L 2 0 L 2 2 L 0 2 Z\" /></symbol>\r\n"
+		"<symbol id=\"b\" />\r\n"
+		"</svg>\r\n", Text(b));
+}
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "VariationAxes.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	struct Axis
+	{
+		const char* Tag;
+		float Minimum;
+		float Default;
+		float Maximum;
+	};
+
+	int32_t Fixed(float value)
+	{
+		return static_cast<int32_t>(value * 65536.0f);
+	}
+
+	int32_t F2Dot14(float value)
+	{
+		return static_cast<int32_t>(value * 16384.0f);
+	}
+
+	std::vector<uint8_t> MakeFvar(const std::vector<Axis>& axes)
+	{
+		ByteWriter w;
+		w.U16(1).U16(0).U16(16).U16(2).U16(static_cast<uint32_t>(axes.size())).U16(20).U16(0).U16(0);
+		for (const Axis& a : axes)
+			w.Tag(a.Tag).U32(Fixed(a.Minimum)).U32(Fixed(a.Default)).U32(Fixed(a.Maximum)).U16(0).U16(256);
+		return w.Data;
+	}
+
+	typedef std::vector<std::pair<float, float>> SegmentMap;
+
+	std::vector<uint8_t> MakeAvar(const std::vector<SegmentMap>& maps)
+	{
+		ByteWriter w;
+		w.U16(1).U16(0).U16(0).U16(static_cast<uint32_t>(maps.size()));
+		for (const SegmentMap& map : maps)
+		{
+			w.U16(static_cast<uint32_t>(map.size()));
+			for (const auto& m : map)
+				w.I16(F2Dot14(m.first)).I16(F2Dot14(m.second));
+		}
+		return w.Data;
+	}
+
+	const std::vector<Axis> WeightWidth = {
+		{ "wght", 100, 400, 900 },
+		{ "wdth", 75, 100, 100 },
+	};
+
+	std::vector<float> Normalize(const VariationAxes& axes, std::vector<float> values)
+	{
+		std::vector<float> coords;
+		axes.Normalize(values.data(), coords);
+		return coords;
+	}
+}
+
+TEST(VariationAxes, ReadsAxesFromFvar)
+{
+	std::vector<uint8_t> fvar = MakeFvar(WeightWidth);
+
+	VariationAxes axes;
+	ASSERT_TRUE(axes.Load(Span(fvar), ByteSpan()));
+	ASSERT_EQ(2u, axes.AxisCount());
+	EXPECT_EQ(MakeSfntTag('w', 'g', 'h', 't'), axes.GetAxis(0).Tag);
+	EXPECT_EQ(100, axes.GetAxis(0).Minimum);
+	EXPECT_EQ(400, axes.GetAxis(0).Default);
+	EXPECT_EQ(900, axes.GetAxis(0).Maximum);
+	EXPECT_EQ(MakeSfntTag('w', 'd', 't', 'h'), axes.GetAxis(1).Tag);
+	EXPECT_EQ(75, axes.GetAxis(1).Minimum);
+}
+
+TEST(VariationAxes, RejectsTruncatedFvar)
+{
+	std::vector<uint8_t> fvar = MakeFvar(WeightWidth);
+
+	VariationAxes axes;
+	EXPECT_FALSE(axes.Load(Span(std::vector<uint8_t>(fvar.begin(), fvar.end() - 1)), ByteSpan()));
+	EXPECT_FALSE(axes.Load(ByteSpan(), ByteSpan()));
+
+	// Axis records smaller than the spec's are rejected rather than misread
+	fvar[11] = 16;
+	EXPECT_FALSE(axes.Load(Span(fvar), ByteSpan()));
+}
+
+TEST(VariationAxes, NormalizesEachSideOfTheDefault)
+{
+	std::vector<uint8_t> fvar = MakeFvar(WeightWidth);
+	VariationAxes axes;
+	ASSERT_TRUE(axes.Load(Span(fvar), ByteSpan()));
+
+	EXPECT_EQ((std::vector<float>{ 0.5f, 0 }), Normalize(axes, { 650, 100 }));
+	EXPECT_EQ((std::vector<float>{ -0.5f, -1 }), Normalize(axes, { 250, 75 }));
+	EXPECT_EQ((std::vector<float>{ 1, -0.5f }), Normalize(axes, { 900, 87.5f }));
+
+	// Values are clamped to the axis range
+	EXPECT_EQ((std::vector<float>{ -1, 0 }), Normalize(axes, { 0, 200 }));
+	EXPECT_EQ((std::vector<float>{ 1, -1 }), Normalize(axes, { 2000, 0 }));
+
+	// and rounded to F2Dot14
+	EXPECT_EQ(5461 / 16384.0f, Normalize(axes, { 400 + 500 / 3.0f, 100 })[0]);
+}
+
+TEST(VariationAxes, ReportsWhetherAnythingVaries)
+{
+	std::vector<uint8_t> fvar = MakeFvar(WeightWidth);
+	VariationAxes axes;
+	ASSERT_TRUE(axes.Load(Span(fvar), ByteSpan()));
+
+	std::vector<float> coords;
+	std::vector<float> defaults = { 400, 100 };
+	EXPECT_FALSE(axes.Normalize(defaults.data(), coords));
+
+	std::vector<float> bold = { 700, 100 };
+	EXPECT_TRUE(axes.Normalize(bold.data(), coords));
+}
+
+TEST(VariationAxes, MapsCoordinatesThroughAvar)
+{
+	std::vector<uint8_t> fvar = MakeFvar(WeightWidth);
+	std::vector<uint8_t> avar = MakeAvar({
+		{ { -1, -1 }, { 0, 0 }, { 0.5f, 0.75f }, { 1, 1 } },
+		{},
+	});
+
+	VariationAxes axes;
+	ASSERT_TRUE(axes.Load(Span(fvar), Span(avar)));
+
+	EXPECT_EQ(0.75f, Normalize(axes, { 650, 100 })[0]);
+	EXPECT_EQ(0.375f, Normalize(axes, { 525, 100 })[0]);
+	EXPECT_EQ(0.875f, Normalize(axes, { 775, 100 })[0]);
+	EXPECT_EQ(-0.5f, Normalize(axes, { 250, 100 })[0]);
+	EXPECT_EQ(1, Normalize(axes, { 900, 100 })[0]);
+
+	// An axis with an empty map is left alone
+	EXPECT_EQ(-0.5f, Normalize(axes, { 400, 87.5f })[1]);
+}
+
+TEST(VariationAxes, IgnoresAvarForADifferentAxisCount)
+{
+	std::vector<uint8_t> fvar = MakeFvar(WeightWidth);
+	std::vector<uint8_t> avar = MakeAvar({ { { -1, -1 }, { 0, 0 }, { 0.5f, 0.75f }, { 1, 1 } } });
+
+	VariationAxes axes;
+	ASSERT_TRUE(axes.Load(Span(fvar), Span(avar)));
+	EXPECT_EQ(0.5f, Normalize(axes, { 650, 100 })[0]);
+
+	// A truncated avar is ignored as a whole
+	avar = MakeAvar({ { { -1, -1 }, { 0, 0 }, { 0.5f, 0.75f }, { 1, 1 } }, { { 0, 0 } } });
+	avar.resize(avar.size() - 1);
+	ASSERT_TRUE(axes.Load(Span(fvar), Span(avar)));
+	EXPECT_EQ(0.5f, Normalize(axes, { 650, 100 })[0]);
+}
+
+TEST(VariationAxes, ScalesPeakRegions)
+{
+	EXPECT_EQ(1, VariationAxes::AxisScalar(1, 0, 1, 1));
+	EXPECT_EQ(0.5f, VariationAxes::AxisScalar(0.5f, 0, 1, 1));
+	EXPECT_EQ(0, VariationAxes::AxisScalar(0, 0, 1, 1));
+	EXPECT_EQ(0, VariationAxes::AxisScalar(-0.5f, 0, 1, 1));
+	EXPECT_EQ(0.25f, VariationAxes::AxisScalar(-0.25f, -1, -1, 0));
+}
+
+TEST(VariationAxes, ScalesIntermediateRegions)
+{
+	EXPECT_EQ(0, VariationAxes::AxisScalar(0.2f, 0.25f, 0.5f, 1));
+	EXPECT_EQ(0.5f, VariationAxes::AxisScalar(0.375f, 0.25f, 0.5f, 1));
+	EXPECT_EQ(1, VariationAxes::AxisScalar(0.5f, 0.25f, 0.5f, 1));
+	EXPECT_EQ(0.5f, VariationAxes::AxisScalar(0.75f, 0.25f, 0.5f, 1));
+	EXPECT_EQ(0, VariationAxes::AxisScalar(1, 0.25f, 0.5f, 1));
+}
+
+TEST(VariationAxes, IgnoresInvalidRegions)
+{
+	// A zero peak means the axis doesn't take part
+	EXPECT_EQ(1, VariationAxes::AxisScalar(0.7f, 0, 0, 0));
+
+	// Regions out of order, or spanning the default, apply everywhere
+	EXPECT_EQ(1, VariationAxes::AxisScalar(0.1f, 0.5f, 0.25f, 1));
+	EXPECT_EQ(1, VariationAxes::AxisScalar(0.9f, 0, 1, 0.5f));
+	EXPECT_EQ(1, VariationAxes::AxisScalar(-0.9f, -0.5f, 0.5f, 1));
+}
@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "WoffDecoder.h"
+#include "FontBuilder.h"
+
+using namespace CharacterMapCX;
+using namespace CharacterMapCX::Tests;
+
+namespace
+{
+	std::vector<uint8_t> GlyphData(size_t size)
+	{
+		std::mt19937 random(7);
+		std::vector<uint8_t> data(size);
+		for (size_t i = 0; i < size; i++)
+			data[i] = static_cast<uint8_t>(i % 64 < 48 ? i % 7 : random());
+		return data;
+	}
+
+	std::vector<TableData> FontTables()
+	{
+		return {
+			{ "head", MakeHead(2048, false) },
+			{ "maxp", MakeMaxp(100) },
+			{ "name", MakeName({ { 3, 1, 1, Utf16(u"Test Sans") }, { 3, 1, 6, Utf16(u"TestSans-Regular") } }) },
+			{ "glyf", GlyphData(20001) },
+			{ "cmap", GlyphData(33) },
+			{ "DSIG", std::vector<uint8_t>(8, 0xAB) },
+		};
+	}
+
+	/// <summary>
+	/// Wraps an sfnt in WOFF as font tools do: each table is compressed
+	/// with zlib unless that doesn't make it smaller.
+	/// </summary>
+	std::vector<uint8_t> BuildWoff(const std::vector<uint8_t>& sfnt)
+	{
+		ByteSpan font = Span(sfnt);
+		uint16_t count = font.UInt16(4);
+
+		ByteWriter w;
+		w.Tag("wOFF").U32(font.UInt32(0)).U32(0).U16(count).U16(0)
+			.U32(static_cast<uint32_t>(sfnt.size())).U16(1).U16(0)
+			.Zeros(20)
+			.Zeros(count * 20u);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t record = 12 + i * 16;
+			ByteSpan table = font.Slice(font.UInt32(record + 8), font.UInt32(record + 12));
+
+			std::vector<uint8_t> data(compressBound(table.Size));
+			uLongf length = static_cast<uLongf>(data.size());
+			EXPECT_EQ(Z_OK, compress2(data.data(), &length, table.Data, table.Size, 9));
+			data.resize(length);
+			if (data.size() >= table.Size)
+				data.assign(table.Data, table.Data + table.Size);
+
+			uint32_t entry = 44 + i * 20;
+			w.SetU32(entry, font.UInt32(record));
+			w.SetU32(entry + 4, w.Size());
+			w.SetU32(entry + 8, static_cast<uint32_t>(data.size()));
+			w.SetU32(entry + 12, table.Size);
+			w.SetU32(entry + 16, font.UInt32(record + 4));
+			w.Bytes(data).Align(4);
+		}
+
+		w.SetU32(8, w.Size());
+		return w.Data;
+	}
+
+	ByteSpan FindWoffEntry(const std::vector<uint8_t>& woff, const char* tag, uint32_t& entry)
+	{
+		ByteSpan file = Span(woff);
+		for (uint32_t i = 0; i < file.UInt16(12); i++)
+		{
+			entry = 44 + i * 20;
+			if (file.UInt32(entry) == MakeSfntTag(tag[0], tag[1], tag[2], tag[3]))
+				return file.Slice(file.UInt32(entry + 4), file.UInt32(entry + 8));
+		}
+
+		return ByteSpan();
+	}
+
+	/// <summary>
+	/// Checks a decoded font holds exactly the source's tables, apart from
+	/// DSIG, with valid records and checksums.
+	/// </summary>
+	void ExpectSameFont(const std::vector<uint8_t>& source, const std::vector<uint8_t>& decoded)
+	{
+		ByteSpan expected = Span(source);
+		ByteSpan actual = Span(decoded);
+
+		EXPECT_EQ(expected.UInt32(0), actual.UInt32(0));
+		EXPECT_EQ(expected.UInt16(4) - 1, actual.UInt16(4));
+		EXPECT_EQ(0xB1B0AFBA, WoffDecoder::Checksum(decoded.data(), static_cast<uint32_t>(decoded.size())));
+
+		uint16_t count = actual.UInt16(4);
+		uint16_t power = 1, log = 0;
+		while (power * 2 <= count)
+		{
+			power *= 2;
+			log++;
+		}
+		EXPECT_EQ(power * 16, actual.UInt16(6));
+		EXPECT_EQ(log, actual.UInt16(8));
+		EXPECT_EQ(count * 16 - power * 16, actual.UInt16(10));
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t record = 12 + i * 16;
+			uint32_t tag = actual.UInt32(record);
+			if (i > 0)
+			{
+				EXPECT_LT(actual.UInt32(record - 16), tag);
+			}
+
+			EXPECT_EQ(0u, actual.UInt32(record + 8) % 4);
+			EXPECT_NE(MakeSfntTag('D', 'S', 'I', 'G'), tag);
+
+			char name[5] = { static_cast<char>(tag >> 24), static_cast<char>(tag >> 16), static_cast<char>(tag >> 8), static_cast<char>(tag), 0 };
+			ByteSpan table = actual.Slice(actual.UInt32(record + 8), actual.UInt32(record + 12));
+			ByteSpan original = FindTable(expected, name);
+			ASSERT_EQ(original.Size, table.Size) << name;
+
+			std::vector<uint8_t> bytes(table.Data, table.Data + table.Size);
+			std::vector<uint8_t> originalBytes(original.Data, original.Data + original.Size);
+			if (tag == MakeSfntTag('h', 'e', 'a', 'd'))
+			{
+				// checkSumAdjustment is recalculated for the new layout
+				std::fill(bytes.begin() + 8, bytes.begin() + 12, 0);
+				std::fill(originalBytes.begin() + 8, originalBytes.begin() + 12, 0);
+			}
+
+			EXPECT_EQ(originalBytes, bytes) << name;
+			EXPECT_EQ(TableChecksum(bytes), actual.UInt32(record + 4)) << name;
+		}
+	}
+}
+
+TEST(WoffDecoder, DecodesToTheWrappedFont)
+{
+	std::vector<uint8_t> sfnt = BuildSfnt(FontTables());
+	std::vector<uint8_t> woff = BuildWoff(sfnt);
+
+	// The test is only worth anything if some tables are compressed
+	uint32_t entry = 0;
+	ASSERT_LT(FindWoffEntry(woff, "glyf", entry).Size, 20001u);
+	ASSERT_EQ(8u, FindWoffEntry(woff, "DSIG", entry).Size);
+
+	std::vector<uint8_t> decoded;
+	ASSERT_EQ(WoffStatus::OK, WoffDecoder().Decode(Span(woff), decoded));
+	ExpectSameFont(sfnt, decoded);
+}
+
+TEST(WoffDecoder, DecodesCffFlavor)
+{
+	std::vector<TableData> tables = FontTables();
+	tables[3].first = "CFF ";
+
+	std::vector<uint8_t> sfnt = BuildSfnt(tables, MakeSfntTag('O', 'T', 'T', 'O'));
+	std::vector<uint8_t> decoded;
+	ASSERT_EQ(WoffStatus::OK, WoffDecoder().Decode(Span(BuildWoff(sfnt)), decoded));
+	ExpectSameFont(sfnt, decoded);
+}
+
+TEST(WoffDecoder, DecodesTablesOnManyThreads)
+{
+	std::vector<uint8_t> sfnt = BuildSfnt(FontTables());
+	std::vector<uint8_t> woff = BuildWoff(sfnt);
+
+	std::vector<uint8_t> decoded;
+	WoffStatus status = WoffDecoder().Decode(Span(woff), decoded, [](uint32_t count, auto body)
+		{
+			std::vector<std::thread> threads;
+			for (uint32_t i = 0; i < count; i++)
+				threads.emplace_back([i, &body] { body(i); });
+			for (std::thread& thread : threads)
+				thread.join();
+		});
+
+	ASSERT_EQ(WoffStatus::OK, status);
+	ExpectSameFont(sfnt, decoded);
+}
+
+TEST(WoffDecoder, FillsEmptyFamilyNameFromPostScriptName)
+{
+	std::vector<TableData> tables = FontTables();
+	tables[2].second = MakeName({ { 3, 1, 1, {} }, { 3, 1, 6, Utf16(u"TestSans-Regular") } });
+
+	std::vector<uint8_t> decoded;
+	ASSERT_EQ(WoffStatus::OK, WoffDecoder().Decode(Span(BuildWoff(BuildSfnt(tables))), decoded));
+
+	ByteSpan name = FindTable(Span(decoded), "name");
+	ASSERT_FALSE(name.IsEmpty());
+	EXPECT_EQ(name.UInt16(6 + 12 + 8), name.UInt16(6 + 8));
+	EXPECT_EQ(name.UInt16(6 + 12 + 10), name.UInt16(6 + 10));
+}
+
+TEST(WoffDecoder, RejectsOtherFormats)
+{
+	std::vector<uint8_t> decoded;
+	std::vector<uint8_t> sfnt = BuildSfnt(FontTables());
+	EXPECT_EQ(WoffStatus::UnrecognisedFile, WoffDecoder().Decode(Span(sfnt), decoded));
+
+	std::vector<uint8_t> woff2 = BuildWoff(sfnt);
+	woff2[3] = '2';
+	EXPECT_EQ(WoffStatus::UnsupportedWoff2, WoffDecoder().Decode(Span(woff2), decoded));
+}
+
+TEST(WoffDecoder, RejectsMalformedDirectories)
+{
+	std::vector<uint8_t> woff = BuildWoff(BuildSfnt(FontTables()));
+	std::vector<uint8_t> decoded;
+	uint32_t entry = 0;
+	FindWoffEntry(woff, "glyf", entry);
+
+	ByteWriter w;
+	w.Data = woff;
+	w.SetU16(12, 0);
+	EXPECT_EQ(WoffStatus::Malformed, WoffDecoder().Decode(Span(w.Data), decoded));
+
+	EXPECT_EQ(WoffStatus::Malformed, WoffDecoder().Decode(ByteSpan(woff.data(), 44 + 20 * 5), decoded));
+
+	// Compressed data past the end of the file
+	w.Data = woff;
+	w.SetU32(entry + 4, static_cast<uint32_t>(woff.size()) - 4);
+	EXPECT_EQ(WoffStatus::Malformed, WoffDecoder().Decode(Span(w.Data), decoded));
+
+	// Compressed data longer than the table
+	w.Data = woff;
+	w.SetU32(entry + 12, Span(woff).UInt32(entry + 8) - 1);
+	EXPECT_EQ(WoffStatus::Malformed, WoffDecoder().Decode(Span(w.Data), decoded));
+
+	// A table no DEFLATE stream of that size could decode to
+	w.Data = woff;
+	w.SetU32(entry + 12, 0x7FFFFFFF);
+	EXPECT_EQ(WoffStatus::Malformed, WoffDecoder().Decode(Span(w.Data), decoded));
+}
+
+TEST(WoffDecoder, RejectsTablesThatDecodeToTheWrongLength)
+{
+	std::vector<uint8_t> woff = BuildWoff(BuildSfnt(FontTables()));
+	std::vector<uint8_t> decoded;
+	uint32_t entry = 0;
+	ByteSpan glyf = FindWoffEntry(woff, "glyf", entry);
+
+	ByteWriter w;
+	w.Data = woff;
+	w.SetU32(entry + 12, 20002);
+	EXPECT_EQ(WoffStatus::TableLengthMismatch, WoffDecoder().Decode(Span(w.Data), decoded));
+
+	// Corrupting the compressed data breaks its Adler-32 checksum
+	w.Data = woff;
+	w.Data[glyf.Data - woff.data() + glyf.Size / 2] ^= 0x10;
+	EXPECT_EQ(WoffStatus::TableLengthMismatch, WoffDecoder().Decode(Span(w.Data), decoded));
+}
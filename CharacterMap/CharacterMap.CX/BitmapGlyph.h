@@ -0,0 +1,34 @@
+#pragma once
+
+#include "SfntData.h"
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// An embedded bitmap image for a single glyph at a specific strike.
+	/// </summary>
+	struct BitmapGlyph
+	{
+		/// <summary>
+		/// The raw PNG / JPEG / TIFF bytes of the image.
+		/// </summary>
+		ByteSpan Data;
+
+		/// <summary>
+		/// One of GlyphFormat_Png, GlyphFormat_Jpeg or GlyphFormat_Tiff.
+		/// </summary>
+		uint32_t Format = GlyphFormat_None;
+
+		uint16_t GlyphId = 0;
+		uint16_t Ppem = 0;
+		uint16_t Ppi = 0;
+		int16_t OriginX = 0;
+		int16_t OriginY = 0;
+
+		/// <summary>
+		/// Image size in pixels, when the table stores metrics (CBDT only).
+		/// </summary>
+		uint16_t Width = 0;
+		uint16_t Height = 0;
+	};
+}
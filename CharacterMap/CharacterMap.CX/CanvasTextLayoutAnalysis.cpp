@@ -15,33 +15,10 @@ CharacterMapCX::CanvasTextLayoutAnalysis::CanvasTextLayoutAnalysis(ComPtr<ColorT
 
 	if (analyzer->IsCharacterAnalysisMode)
 	{
+		m_hasRuns = true;
 		m_glyphLayerCount = analyzer->GlyphLayerCount;
-
-		auto colors = ref new Array<Color>(analyzer->RunColors.size());
-		float max = 255.0;
-		for (unsigned int a = 0; a < analyzer->RunColors.size(); a = a + 1)
-		{
-			DWRITE_COLOR_F color = analyzer->RunColors[a];
-			Color c = ColorHelper::FromArgb((UINT)(color.a * max), (UINT)(color.r * max), (UINT)(color.g * max), (UINT)(color.b * max));
-			colors[a] = c;
-		}
-		m_colors = colors;
-
-		auto gd = ref new Array<IVectorView<uint16>^>(analyzer->GlyphIndicies.size());
-
-		for(unsigned int a = 0; a < analyzer->GlyphIndicies.size(); a = a + 1)
-		{
-			auto i = analyzer->GlyphIndicies[a];
-			auto ind = ref new Vector<uint16>(sizeof(i));
-			for (unsigned int b = 0; b < sizeof(i); b = b + 1)
-			{
-				ind->Append(i[b]);
-			}
-
-			gd[a] = ind->GetView();
-		}
-
-		m_indicies = gd;
+		m_glyphs = std::move(analyzer->Glyphs);
+		m_runs = std::move(analyzer->Runs);
 	}
 
 	for (GlyphImageFormat t : analyzer->GlyphFormats)
@@ -65,5 +42,37 @@ CharacterMapCX::CanvasTextLayoutAnalysis::CanvasTextLayoutAnalysis(ComPtr<ColorT
 
 	auto vec = ref new Vector<GlyphImageFormat>(std::move(analyzer->GlyphFormats));
 	m_glyphFormats = vec->GetView();
+}
+
+Array<Color>^ CanvasTextLayoutAnalysis::Colors::get()
+{
+	if (m_colors == nullptr && m_hasRuns)
+	{
+		auto colors = ref new Array<Color>(static_cast<unsigned int>(m_runs.size()));
+		float max = 255.0;
+		for (unsigned int a = 0; a < m_runs.size(); a++)
+		{
+			DWRITE_COLOR_F color = m_runs[a].Color;
+			colors[a] = ColorHelper::FromArgb((UINT)(color.a * max), (UINT)(color.r * max), (UINT)(color.g * max), (UINT)(color.b * max));
+		}
+		m_colors = colors;
+	}
+
+	return m_colors;
+}
+
+Array<IVectorView<uint16>^>^ CanvasTextLayoutAnalysis::Indicies::get()
+{
+	if (m_indicies == nullptr && m_hasRuns)
+	{
+		auto gd = ref new Array<IVectorView<uint16>^>(static_cast<unsigned int>(m_runs.size()));
+		for (unsigned int a = 0; a < m_runs.size(); a++)
+		{
+			auto start = m_glyphs.begin() + m_runs[a].GlyphOffset;
+			gd[a] = (ref new Vector<uint16>(start, start + m_runs[a].GlyphCount))->GetView();
+		}
+		m_indicies = gd;
+	}
 
-}
\ No newline at end of file
+	return m_indicies;
+}
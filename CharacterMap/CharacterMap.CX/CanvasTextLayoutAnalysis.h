@@ -18,7 +18,13 @@ namespace CharacterMapCX
 	public ref class CanvasTextLayoutAnalysis sealed
 	{
 	public:
-		inline CanvasTextLayoutAnalysis() { }
+		/// <summary>
+		/// Creates the analysis of a plain outline glyph, with no colour data.
+		/// </summary>
+		inline CanvasTextLayoutAnalysis()
+		{
+			m_glyphFormats = (ref new Platform::Collections::Vector<GlyphImageFormat>())->GetView();
+		}
 
 		property bool HasColorGlyphs
 		{
@@ -61,14 +67,21 @@ namespace CharacterMapCX
 			IVectorView<GlyphImageFormat>^ get() { return m_glyphFormats; }
 		}
 
+		/// <summary>
+		/// The colour of each glyph run. Only available for character analysis.
+		/// </summary>
 		property Array<Windows::UI::Color>^ Colors
 		{
-			Array<Windows::UI::Color>^ get() { return m_colors; }
+			Array<Windows::UI::Color>^ get();
 		}
 
+		/// <summary>
+		/// The glyph indices of each glyph run, in the same order as Colors.
+		/// Only available for character analysis.
+		/// </summary>
 		property Array<IVectorView<uint16>^>^ Indicies
 		{
-			Array<IVectorView<uint16>^>^ get() { return m_indicies; }
+			Array<IVectorView<uint16>^>^ get();
 		}
 
 	internal:
@@ -80,8 +93,15 @@ namespace CharacterMapCX
 		bool m_containsVectorColorGlyphs = false;
 		int m_glyphLayerCount = 1;
 		
+		bool m_hasRuns = false;
+
 		IVectorView<GlyphImageFormat>^ m_glyphFormats;
 		Array<Windows::UI::Color>^ m_colors;
 		Array<IVectorView<uint16>^>^ m_indicies;
+
+		// Taken from the analyzer. The WinRT views above are created
+		// from these on first use.
+		std::vector<uint16> m_glyphs;
+		std::vector<ColorGlyphRun> m_runs;
 	};
 }
\ No newline at end of file
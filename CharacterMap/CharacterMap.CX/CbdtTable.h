@@ -0,0 +1,383 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "BitmapGlyph.h"
+
+/*
+	Native CBLC / CBDT reader.
+	CBLC Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/cblc
+	CBDT Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/cbdt
+
+	Load indexes every BitmapSize record and its IndexSubTables into a sorted
+	list of glyph ranges per strike, so a glyph lookup is a binary search over
+	ranges followed by (for the sparse formats 4 and 5) a binary search inside
+	the subtable. PNG data is returned as a view onto the CBDT table, which
+	must stay alive for as long as any BitmapGlyph is in use.
+*/
+
+namespace CharacterMapCX
+{
+	struct CbdtIndexRange
+	{
+		uint16_t FirstGlyph = 0;
+		uint16_t LastGlyph = 0;
+		uint16_t IndexFormat = 0;
+		uint16_t ImageFormat = 0;
+		uint32_t ImageDataOffset = 0;
+
+		/// <summary>
+		/// The IndexSubTable, starting at its header.
+		/// </summary>
+		ByteSpan SubTable;
+	};
+
+	struct CbdtStrike
+	{
+		uint16_t Ppem = 0;
+		uint8_t BitDepth = 0;
+		uint16_t StartGlyph = 0;
+		uint16_t EndGlyph = 0;
+		std::vector<CbdtIndexRange> Ranges;
+	};
+
+	class CbdtTable
+	{
+	public:
+		/// <summary>
+		/// Indexes every strike in the CBLC table. Both tables must stay alive
+		/// for as long as this instance is used.
+		/// </summary>
+		bool Load(ByteSpan cblc, ByteSpan cbdt)
+		{
+			m_strikes.clear();
+			m_cbdt = cbdt;
+
+			if (!cblc.Contains(0, 8) || !cbdt.Contains(0, 4))
+				return false;
+
+			uint32_t sizeCount = cblc.UInt32(4);
+			if (sizeCount > (cblc.Size - 8) / BitmapSizeRecordSize)
+				return false;
+
+			m_strikes.reserve(sizeCount);
+			for (uint32_t i = 0; i < sizeCount; i++)
+			{
+				uint32_t record = 8 + i * BitmapSizeRecordSize;
+				uint32_t arrayOffset = cblc.UInt32(record);
+				uint32_t subTableCount = cblc.UInt32(record + 8);
+
+				ByteSpan subTableArray = cblc.Slice(arrayOffset);
+				if (subTableArray.IsEmpty() || subTableCount > subTableArray.Size / 8)
+					continue;
+
+				CbdtStrike strike;
+				strike.StartGlyph = cblc.UInt16(record + 40);
+				strike.EndGlyph = cblc.UInt16(record + 42);
+				strike.Ppem = cblc.UInt8(record + 45); // ppemY
+				strike.BitDepth = cblc.UInt8(record + 46);
+				strike.Ranges.reserve(subTableCount);
+
+				for (uint32_t s = 0; s < subTableCount; s++)
+				{
+					CbdtIndexRange range;
+					range.FirstGlyph = subTableArray.UInt16(s * 8);
+					range.LastGlyph = subTableArray.UInt16(s * 8 + 2);
+					range.SubTable = subTableArray.Slice(subTableArray.UInt32(s * 8 + 4));
+
+					if (range.LastGlyph < range.FirstGlyph || !range.SubTable.Contains(0, 8))
+						continue;
+
+					range.IndexFormat = range.SubTable.UInt16(0);
+					range.ImageFormat = range.SubTable.UInt16(2);
+					range.ImageDataOffset = range.SubTable.UInt32(4);
+
+					if (IsValidRange(range))
+						strike.Ranges.push_back(range);
+				}
+
+				if (strike.Ranges.empty())
+					continue;
+
+				// Fonts are required to sort these, but don't trust them to
+				std::sort(strike.Ranges.begin(), strike.Ranges.end(),
+					[](const CbdtIndexRange& a, const CbdtIndexRange& b) { return a.FirstGlyph < b.FirstGlyph; });
+
+				m_strikes.push_back(std::move(strike));
+			}
+
+			std::stable_sort(m_strikes.begin(), m_strikes.end(),
+				[](const CbdtStrike& a, const CbdtStrike& b) { return a.Ppem < b.Ppem; });
+
+			return !m_strikes.empty();
+		}
+
+		const std::vector<CbdtStrike>& GetStrikes() const { return m_strikes; }
+
+		/// <summary>
+		/// Returns the index of the smallest strike at least as large as the
+		/// target ppem, otherwise the largest strike. Returns -1 if there are none.
+		/// </summary>
+		int SelectStrike(uint16_t targetPpem) const
+		{
+			if (m_strikes.empty())
+				return -1;
+
+			auto it = std::lower_bound(m_strikes.begin(), m_strikes.end(), targetPpem,
+				[](const CbdtStrike& s, uint16_t ppem) { return s.Ppem < ppem; });
+
+			if (it == m_strikes.end())
+				return static_cast<int>(m_strikes.size()) - 1;
+
+			return static_cast<int>(it - m_strikes.begin());
+		}
+
+		/// <summary>
+		/// Finds the PNG image for a glyph, preferring the best strike for the
+		/// target ppem and falling back to larger then smaller strikes.
+		/// </summary>
+		bool TryGetGlyph(uint16_t glyphId, uint16_t targetPpem, BitmapGlyph& result) const
+		{
+			int best = SelectStrike(targetPpem);
+			if (best < 0)
+				return false;
+
+			int count = static_cast<int>(m_strikes.size());
+			for (int i = best; i < count; i++)
+				if (TryGetGlyphFromStrike(i, glyphId, result))
+					return true;
+
+			for (int i = best - 1; i >= 0; i--)
+				if (TryGetGlyphFromStrike(i, glyphId, result))
+					return true;
+
+			return false;
+		}
+
+		/// <summary>
+		/// Returns true if any strike has an image for the glyph. Cheaper than
+		/// TryGetGlyph as the glyph data itself is never read.
+		/// </summary>
+		bool HasGlyph(uint16_t glyphId) const
+		{
+			for (const CbdtStrike& strike : m_strikes)
+			{
+				const CbdtIndexRange* range = FindRange(strike, glyphId);
+				uint32_t offset, length;
+				if (range != nullptr && TryGetImageLocation(*range, glyphId, offset, length))
+					return true;
+			}
+
+			return false;
+		}
+
+		bool TryGetGlyphFromStrike(int strikeIndex, uint16_t glyphId, BitmapGlyph& result) const
+		{
+			if (strikeIndex < 0 || strikeIndex >= static_cast<int>(m_strikes.size()))
+				return false;
+
+			const CbdtStrike& strike = m_strikes[strikeIndex];
+			const CbdtIndexRange* range = FindRange(strike, glyphId);
+			if (range == nullptr)
+				return false;
+
+			uint32_t offset, length;
+			if (!TryGetImageLocation(*range, glyphId, offset, length))
+				return false;
+
+			ByteSpan data = m_cbdt.Slice(offset, length);
+			if (data.IsEmpty())
+				return false;
+
+			switch (range->ImageFormat)
+			{
+			case 17: // SmallGlyphMetrics + PNG
+				if (!ReadPng(data, 5, result))
+					return false;
+				ReadMetrics(data, result);
+				break;
+
+			case 18: // BigGlyphMetrics + PNG
+				if (!ReadPng(data, 8, result))
+					return false;
+				ReadMetrics(data, result);
+				break;
+
+			case 19: // PNG, metrics are in the CBLC subtable
+				if (!ReadPng(data, 0, result))
+					return false;
+				if (range->IndexFormat == 2 || range->IndexFormat == 5)
+					ReadMetrics(range->SubTable.Slice(12), result);
+				break;
+
+			default:
+				// Formats 1-9 are uncompressed EBDT style bitmaps, which
+				// have no place in a colour bitmap table.
+				return false;
+			}
+
+			result.Format = GlyphFormat_Png;
+			result.GlyphId = glyphId;
+			result.Ppem = strike.Ppem;
+			result.Ppi = 72;
+			return true;
+		}
+
+	private:
+		static constexpr uint32_t BitmapSizeRecordSize = 48;
+
+		ByteSpan m_cbdt;
+		std::vector<CbdtStrike> m_strikes;
+
+		static const CbdtIndexRange* FindRange(const CbdtStrike& strike, uint16_t glyphId)
+		{
+			if (glyphId < strike.StartGlyph || glyphId > strike.EndGlyph)
+				return nullptr;
+
+			// Find the last range starting at or before the glyph
+			auto it = std::upper_bound(strike.Ranges.begin(), strike.Ranges.end(), glyphId,
+				[](uint16_t id, const CbdtIndexRange& r) { return id < r.FirstGlyph; });
+
+			if (it == strike.Ranges.begin())
+				return nullptr;
+
+			--it;
+			return glyphId <= it->LastGlyph ? &(*it) : nullptr;
+		}
+
+		static bool IsValidRange(const CbdtIndexRange& range)
+		{
+			uint32_t glyphs = static_cast<uint32_t>(range.LastGlyph - range.FirstGlyph) + 1;
+			const ByteSpan& t = range.SubTable;
+
+			switch (range.IndexFormat)
+			{
+			case 1: return t.Contains(8, (glyphs + 1) * 4);
+			case 2: return t.Contains(8, 12);
+			case 3: return t.Contains(8, (glyphs + 1) * 2);
+			case 4:
+			{
+				uint32_t count = t.UInt32(8);
+				return count < 0x10000 && t.Contains(12, (count + 1) * 4);
+			}
+			case 5:
+			{
+				uint32_t count = t.UInt32(20);
+				return count < 0x10000 && t.Contains(24, count * 2);
+			}
+			default: return false;
+			}
+		}
+
+		/// <summary>
+		/// Resolves the offset and length of a glyph's data inside CBDT.
+		/// </summary>
+		static bool TryGetImageLocation(const CbdtIndexRange& range, uint16_t glyphId, uint32_t& offset, uint32_t& length)
+		{
+			const ByteSpan& t = range.SubTable;
+			uint32_t index = glyphId - range.FirstGlyph;
+			uint32_t start = 0, end = 0;
+
+			switch (range.IndexFormat)
+			{
+			case 1: // Variable size, 32-bit offsets
+				start = t.UInt32(8 + index * 4);
+				end = t.UInt32(8 + (index + 1) * 4);
+				break;
+
+			case 2: // Constant size, every glyph in range present
+			{
+				uint32_t size = t.UInt32(8);
+				start = index * size;
+				end = start + size;
+				break;
+			}
+
+			case 3: // Variable size, 16-bit offsets
+				start = t.UInt16(8 + index * 2);
+				end = t.UInt16(8 + (index + 1) * 2);
+				break;
+
+			case 4: // Variable size, sparse glyph / offset pairs
+			{
+				uint32_t count = t.UInt32(8);
+				uint32_t lo = 0, hi = count;
+				while (lo < hi)
+				{
+					uint32_t mid = lo + (hi - lo) / 2;
+					uint16_t id = t.UInt16(12 + mid * 4);
+					if (id < glyphId)
+						lo = mid + 1;
+					else if (id > glyphId)
+						hi = mid;
+					else
+					{
+						start = t.UInt16(12 + mid * 4 + 2);
+						end = t.UInt16(12 + (mid + 1) * 4 + 2);
+						break;
+					}
+				}
+				break;
+			}
+
+			case 5: // Constant size, sparse glyph array
+			{
+				uint32_t size = t.UInt32(8);
+				uint32_t count = t.UInt32(20);
+				uint32_t lo = 0, hi = count;
+				while (lo < hi)
+				{
+					uint32_t mid = lo + (hi - lo) / 2;
+					uint16_t id = t.UInt16(24 + mid * 2);
+					if (id < glyphId)
+						lo = mid + 1;
+					else if (id > glyphId)
+						hi = mid;
+					else
+					{
+						start = mid * size;
+						end = start + size;
+						break;
+					}
+				}
+				break;
+			}
+
+			default:
+				return false;
+			}
+
+			if (end <= start)
+				return false;
+
+			uint64_t absolute = static_cast<uint64_t>(range.ImageDataOffset) + start;
+			if (absolute > UINT32_MAX)
+				return false;
+
+			offset = static_cast<uint32_t>(absolute);
+			length = end - start;
+			return true;
+		}
+
+		static bool ReadPng(ByteSpan data, uint32_t metricsSize, BitmapGlyph& result)
+		{
+			uint32_t length = data.UInt32(metricsSize);
+			ByteSpan png = data.Slice(metricsSize + 4, length);
+			if (png.IsEmpty())
+				return false;
+
+			result.Data = png;
+			return true;
+		}
+
+		static void ReadMetrics(ByteSpan metrics, BitmapGlyph& result)
+		{
+			// Small and Big metrics share the same leading fields:
+			// height, width, horiBearingX, horiBearingY
+			result.Height = metrics.UInt8(0);
+			result.Width = metrics.UInt8(1);
+			result.OriginX = static_cast<int8_t>(metrics.UInt8(2));
+			result.OriginY = static_cast<int8_t>(metrics.UInt8(3));
+		}
+	};
+}
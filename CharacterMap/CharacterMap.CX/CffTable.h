@@ -0,0 +1,1182 @@
+#pragma once
+
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "SfntData.h"
+#include "GlyphPath.h"
+#include "VariationAxes.h"
+
+/*
+	Native CFF / CFF2 table structure reader.
+	CFF Spec:  https://adobe-type-tools.github.io/font-tech-notes/pdfs/5176.CFF.pdf
+	CFF2 Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/cff2
+
+	Reads the table structure and interprets Type 2 / CFF2 CharStrings into
+	cubic outlines, including subroutines, flex, seac and CFF2 blending.
+	Type 2 Spec: https://adobe-type-tools.github.io/font-tech-notes/pdfs/5177.Type2.pdf
+*/
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// A CFF INDEX structure. Objects are returned as views into the table.
+	/// </summary>
+	struct CffIndex
+	{
+		uint32_t Count = 0;
+
+		/// <summary>
+		/// Offset of the first byte after the INDEX inside the table.
+		/// </summary>
+		uint32_t End = 0;
+
+		bool Read(ByteSpan table, uint32_t offset, bool cff2)
+		{
+			*this = CffIndex();
+			m_table = table;
+
+			uint32_t countSize = cff2 ? 4 : 2;
+			if (!table.Contains(offset, countSize))
+				return false;
+
+			Count = cff2 ? table.UInt32(offset) : table.UInt16(offset);
+			if (Count == 0)
+			{
+				End = offset + countSize;
+				return true;
+			}
+
+			m_offSize = table.UInt8(offset + countSize);
+			if (m_offSize < 1 || m_offSize > 4)
+				return false;
+
+			m_offsets = offset + countSize + 1;
+			uint64_t offsetsLength = static_cast<uint64_t>(Count + 1ull) * m_offSize;
+			if (offsetsLength > table.Size - m_offsets || m_offsets > table.Size)
+				return false;
+
+			// Offsets are 1-based from the byte preceding the object data
+			m_dataStart = m_offsets + static_cast<uint32_t>(offsetsLength) - 1;
+			uint32_t last = table.UIntN(m_offsets + Count * m_offSize, m_offSize);
+			if (last < 1 || !table.Contains(m_dataStart + 1, last - 1))
+				return false;
+
+			End = m_dataStart + last;
+			return true;
+		}
+
+		ByteSpan Get(uint32_t i) const
+		{
+			if (i >= Count)
+				return ByteSpan();
+
+			uint32_t start = m_table.UIntN(m_offsets + i * m_offSize, m_offSize);
+			uint32_t end = m_table.UIntN(m_offsets + (i + 1) * m_offSize, m_offSize);
+			if (start < 1 || end < start)
+				return ByteSpan();
+
+			return m_table.Slice(m_dataStart + start, end - start);
+		}
+
+	private:
+		ByteSpan m_table;
+		uint8_t m_offSize = 0;
+		uint32_t m_offsets = 0;
+		uint32_t m_dataStart = 0;
+	};
+
+	namespace CffDict
+	{
+		/// <summary>
+		/// Reads a nibble encoded real number, advancing i past it.
+		/// </summary>
+		inline double ReadReal(ByteSpan dict, uint32_t& i)
+		{
+			char buffer[64];
+			int length = 0;
+			bool done = false;
+
+			while (!done && i < dict.Size)
+			{
+				uint8_t b = dict.Data[i++];
+				for (int n = 0; n < 2 && !done; n++)
+				{
+					uint8_t nibble = n == 0 ? (b >> 4) : (b & 0xF);
+					const char* text = nullptr;
+					switch (nibble)
+					{
+					case 0xA: text = "."; break;
+					case 0xB: text = "E"; break;
+					case 0xC: text = "E-"; break;
+					case 0xD: break;
+					case 0xE: text = "-"; break;
+					case 0xF: done = true; break;
+					default:
+						if (length < 62)
+							buffer[length++] = static_cast<char>('0' + nibble);
+						break;
+					}
+
+					for (; text != nullptr && *text && length < 62; text++)
+						buffer[length++] = *text;
+				}
+			}
+
+			buffer[length] = 0;
+			return length > 0 ? strtod(buffer, nullptr) : 0;
+		}
+
+		/// <summary>
+		/// Walks a DICT, invoking func(op, operands, count) for each operator.
+		/// Two byte operators are reported as 1200 + second byte. Returns false
+		/// if the DICT is malformed.
+		/// </summary>
+		template <typename F>
+		bool Parse(ByteSpan dict, F&& func)
+		{
+			static constexpr int MaxOperands = 513;
+			double operands[MaxOperands];
+			int count = 0;
+			uint32_t i = 0;
+
+			while (i < dict.Size)
+			{
+				uint8_t b0 = dict.Data[i];
+
+				if (b0 <= 21)
+				{
+					int op = b0;
+					i++;
+					if (b0 == 12)
+					{
+						if (i >= dict.Size)
+							return false;
+
+						op = 1200 + dict.Data[i++];
+					}
+
+					func(op, operands, count);
+					count = 0;
+					continue;
+				}
+
+				if (count >= MaxOperands)
+					return false;
+
+				if (b0 == 28)
+				{
+					if (!dict.Contains(i + 1, 2))
+						return false;
+
+					operands[count++] = dict.Int16(i + 1);
+					i += 3;
+				}
+				else if (b0 == 29)
+				{
+					if (!dict.Contains(i + 1, 4))
+						return false;
+
+					operands[count++] = dict.Int32(i + 1);
+					i += 5;
+				}
+				else if (b0 == 30)
+				{
+					operands[count++] = ReadReal(dict, ++i);
+				}
+				else if (b0 >= 32 && b0 <= 246)
+				{
+					operands[count++] = b0 - 139;
+					i++;
+				}
+				else if (b0 >= 247 && b0 <= 254)
+				{
+					if (i + 1 >= dict.Size)
+						return false;
+
+					int b1 = dict.Data[i + 1];
+					operands[count++] = b0 <= 250
+						? (b0 - 247) * 256 + b1 + 108
+						: -(b0 - 251) * 256 - b1 - 108;
+					i += 2;
+				}
+				else
+				{
+					// Reserved operators, plus CFF2's blend (23), which only the
+					// callers that understand it should act on.
+					func(b0, operands, count);
+					count = 0;
+					i++;
+				}
+			}
+
+			return true;
+		}
+	}
+
+	/// <summary>
+	/// Private DICT values needed to run a CharString.
+	/// </summary>
+	struct CffPrivate
+	{
+		CffIndex Subrs;
+		int32_t SubrBias = 0;
+		uint16_t VsIndex = 0;
+	};
+
+	class CffTable
+	{
+	public:
+		/// <summary>
+		/// Reads the table structure. Returns true if the CharStrings could be
+		/// located; Decode additionally needs the Private DICTs and subroutines,
+		/// and fails per glyph if those are malformed.
+		/// </summary>
+		bool Load(ByteSpan table, bool cff2)
+		{
+			m_table = table;
+			m_isCff2 = cff2;
+			m_isCid = false;
+			m_charset = 0;
+			m_fdSelect = 0;
+			m_privates.clear();
+			m_regionScalars.clear();
+			CharStrings = CffIndex();
+			m_globalSubrs = CffIndex();
+
+			if (!table.Contains(0, 4))
+				return false;
+
+			ByteSpan topDict;
+			uint32_t globalSubrsOffset = 0;
+			if (cff2)
+			{
+				if (table.UInt8(0) != 2)
+					return false;
+
+				uint32_t headerSize = table.UInt8(2);
+				uint32_t topDictLength = table.UInt16(3);
+				topDict = table.Slice(headerSize, topDictLength);
+				globalSubrsOffset = headerSize + topDictLength;
+			}
+			else
+			{
+				if (table.UInt8(0) != 1)
+					return false;
+
+				CffIndex names, topDicts, strings;
+				if (!names.Read(table, table.UInt8(2), false)
+					|| !topDicts.Read(table, names.End, false)
+					|| topDicts.Count == 0
+					|| !strings.Read(table, topDicts.End, false))
+					return false;
+
+				topDict = topDicts.Get(0);
+				globalSubrsOffset = strings.End;
+			}
+
+			if (topDict.IsEmpty())
+				return false;
+
+			uint32_t charStringsOffset = 0;
+			uint32_t fdArrayOffset = 0;
+			uint32_t vstoreOffset = 0;
+			uint32_t privateSize = 0, privateOffset = 0;
+			uint32_t charStringType = 2;
+
+			bool valid = CffDict::Parse(topDict, [&](int op, const double* operands, int count)
+				{
+					uint32_t last = count > 0 ? ToOffset(operands[count - 1]) : 0;
+					switch (op)
+					{
+					case 15: m_charset = last; break;
+					case 17: charStringsOffset = last; break;
+					case 18:
+						if (count >= 2)
+						{
+							privateSize = ToOffset(operands[count - 2]);
+							privateOffset = last;
+						}
+						break;
+					case 24: vstoreOffset = last; break;
+					case 1206: charStringType = last; break;
+					case 1230: m_isCid = true; break;
+					case 1236: fdArrayOffset = last; break;
+					case 1237: m_fdSelect = last; break;
+					}
+				});
+
+			if (!valid
+				|| charStringType != 2
+				|| charStringsOffset == 0
+				|| !CharStrings.Read(table, charStringsOffset, cff2))
+				return false;
+
+			m_numGlyphs = CharStrings.Count;
+			m_globalSubrs.Read(table, globalSubrsOffset, cff2);
+
+			// Private DICTs. CID-keyed CFF and all CFF2 fonts keep one
+			// per Font DICT in the FDArray; name-keyed CFF has just one.
+			if (fdArrayOffset > 0)
+			{
+				CffIndex fdArray;
+				if (fdArray.Read(table, fdArrayOffset, cff2))
+				{
+					uint32_t fdCount = std::min<uint32_t>(fdArray.Count, 256);
+					m_privates.resize(fdCount);
+					for (uint32_t i = 0; i < fdCount; i++)
+					{
+						uint32_t size = 0, offset = 0;
+						CffDict::Parse(fdArray.Get(i), [&](int op, const double* operands, int count)
+							{
+								if (op == 18 && count >= 2)
+								{
+									size = ToOffset(operands[count - 2]);
+									offset = ToOffset(operands[count - 1]);
+								}
+							});
+
+						ReadPrivate(size, offset, m_privates[i]);
+					}
+				}
+			}
+			else
+			{
+				m_privates.resize(1);
+				ReadPrivate(privateSize, privateOffset, m_privates[0]);
+			}
+
+			if (cff2 && vstoreOffset > 0)
+				ReadVariationStore(vstoreOffset + 2); // skip the uint16 length
+
+			return true;
+		}
+
+		bool IsCff2() const { return m_isCff2; }
+
+		CffIndex CharStrings;
+
+		/// <summary>
+		/// Sets the normalized (-1 to 1, after avar) design coordinates used
+		/// to resolve blend operators in CFF2 CharStrings. Passing no
+		/// coordinates selects the default instance.
+		/// </summary>
+		void SetVariationCoordinates(const float* coords, uint32_t count)
+		{
+			m_regionScalars.clear();
+
+			bool isDefault = true;
+			for (uint32_t i = 0; i < count; i++)
+				if (coords[i] != 0)
+					isDefault = false;
+
+			if (isDefault || m_regionListOffset == 0)
+				return;
+
+			ByteSpan regions = m_table.Slice(m_regionListOffset);
+			uint32_t axisCount = regions.UInt16(0);
+			uint32_t regionCount = regions.UInt16(2);
+			if (!regions.Contains(4, regionCount * axisCount * 6))
+				return;
+
+			m_regionScalars.resize(regionCount);
+			for (uint32_t r = 0; r < regionCount; r++)
+			{
+				float scalar = 1;
+				for (uint32_t a = 0; a < axisCount && scalar != 0; a++)
+				{
+					uint32_t record = 4 + (r * axisCount + a) * 6;
+					float start = regions.Int16(record) / 16384.0f;
+					float peak = regions.Int16(record + 2) / 16384.0f;
+					float end = regions.Int16(record + 4) / 16384.0f;
+					float coord = a < count ? coords[a] : 0;
+
+					scalar *= VariationAxes::AxisScalar(coord, start, peak, end);
+				}
+
+				m_regionScalars[r] = scalar;
+			}
+		}
+
+		/// <summary>
+		/// Runs a glyph's CharString, writing cubic path commands scaled by
+		/// the given factor with the y-axis flipped to match Direct2D.
+		/// Returns false if the CharString is malformed or uses operators
+		/// we don't support.
+		/// </summary>
+		bool Decode(uint16_t glyphId, GlyphPath& path, float scale)
+		{
+			path.Clear();
+
+			if (glyphId >= m_numGlyphs || m_privates.empty())
+				return false;
+
+			CharStringState state(&path, nullptr, scale);
+			if (!RunGlyph(glyphId, state, 0, 0, 0))
+				return false;
+
+			state.ClosePath();
+			return true;
+		}
+
+		/// <summary>
+		/// Runs a glyph's CharString only to measure it, in the same space
+		/// Decode writes to, without storing any path commands. Tight bounds
+		/// follow the extrema of each curve; otherwise control points are
+		/// included. Empty glyphs succeed with empty bounds.
+		/// </summary>
+		bool GetBounds(uint16_t glyphId, PathBounds& bounds, float scale, bool tight)
+		{
+			bounds = PathBounds::Empty();
+
+			if (glyphId >= m_numGlyphs || m_privates.empty())
+				return false;
+
+			CharStringState state(nullptr, &bounds, scale);
+			state.Tight = tight;
+			return RunGlyph(glyphId, state, 0, 0, 0);
+		}
+
+	private:
+		// Type 2 limits, plus a budget on total work so nested subroutine
+		// calls in a malformed font can't keep us busy indefinitely.
+		static constexpr int MaxStack = 513;
+		static constexpr int MaxSubrDepth = 10;
+		static constexpr uint32_t MaxOperations = 1 << 20;
+
+		struct CharStringState
+		{
+			CharStringState(GlyphPath* path, PathBounds* bounds, float scale)
+				: Path(path), Bounds(bounds), Scale(scale) { }
+
+			// Exactly one of these receives the outline
+			GlyphPath* Path;
+			PathBounds* Bounds;
+			float Scale;
+			bool Tight = false;
+
+			float Stack[MaxStack];
+			int Count = 0;
+
+			float X = 0;
+			float Y = 0;
+			float OffsetX = 0;
+			float OffsetY = 0;
+			bool Open = false;
+
+			uint32_t Stems = 0;
+			bool SeenWidth = false;
+			bool Ended = false;
+			uint16_t VsIndex = 0;
+			uint32_t Operations = 0;
+
+			float PX(float x) const { return (x + OffsetX) * Scale; }
+			float PY(float y) const { return -(y + OffsetY) * Scale; }
+
+			void MoveTo(float dx, float dy)
+			{
+				ClosePath();
+				X += dx; Y += dy;
+				if (Path)
+					Path->MoveTo(PX(X), PY(Y));
+				else
+					GlyphPath::Include(*Bounds, PX(X), PY(Y));
+				Open = true;
+			}
+
+			void LineTo(float dx, float dy)
+			{
+				X += dx; Y += dy;
+				if (Path)
+					Path->LineTo(PX(X), PY(Y));
+				else
+					GlyphPath::Include(*Bounds, PX(X), PY(Y));
+			}
+
+			void CurveTo(float dx1, float dy1, float dx2, float dy2, float dx3, float dy3)
+			{
+				float x0 = X, y0 = Y;
+				float x1 = X + dx1, y1 = Y + dy1;
+				float x2 = x1 + dx2, y2 = y1 + dy2;
+				X = x2 + dx3; Y = y2 + dy3;
+
+				if (Path)
+				{
+					Path->CubicTo(PX(x1), PY(y1), PX(x2), PY(y2), PX(X), PY(Y));
+					return;
+				}
+
+				GlyphPath::Include(*Bounds, PX(X), PY(Y));
+				if (Tight)
+					GlyphPath::CubicExtrema(*Bounds, PX(x0), PY(y0), PX(x1), PY(y1), PX(x2), PY(y2), PX(X), PY(Y));
+				else
+				{
+					GlyphPath::Include(*Bounds, PX(x1), PY(y1));
+					GlyphPath::Include(*Bounds, PX(x2), PY(y2));
+				}
+			}
+
+			void ClosePath()
+			{
+				if (Open && Path)
+					Path->Close();
+				Open = false;
+			}
+		};
+
+		ByteSpan m_table;
+		bool m_isCff2 = false;
+		bool m_isCid = false;
+		uint32_t m_numGlyphs = 0;
+		uint32_t m_charset = 0;
+		uint32_t m_fdSelect = 0;
+		CffIndex m_globalSubrs;
+		std::vector<CffPrivate> m_privates;
+
+		// CFF2 variation store
+		uint32_t m_regionListOffset = 0;
+		std::vector<uint32_t> m_variationData;
+		std::vector<float> m_regionScalars;
+
+		static uint32_t ToOffset(double value)
+		{
+			return value > 0 && value < 4294967295.0 ? static_cast<uint32_t>(value) : 0;
+		}
+
+		/// <summary>
+		/// Converts a stack value used as an integer argument, mapping values
+		/// that can't be represented to -1.
+		/// </summary>
+		static int ToInt(float value)
+		{
+			return value > -1073741824.0f && value < 1073741824.0f ? static_cast<int>(value) : -1;
+		}
+
+		static int32_t SubrBias(uint32_t count)
+		{
+			return count < 1240 ? 107 : count < 33900 ? 1131 : 32768;
+		}
+
+		void ReadPrivate(uint32_t size, uint32_t offset, CffPrivate& priv)
+		{
+			ByteSpan dict = m_table.Slice(offset, size);
+			if (dict.IsEmpty())
+				return;
+
+			uint32_t subrs = 0;
+			CffDict::Parse(dict, [&](int op, const double* operands, int count)
+				{
+					if (op == 19 && count > 0)
+						subrs = ToOffset(operands[count - 1]);
+					else if (op == 22 && count > 0)
+						priv.VsIndex = static_cast<uint16_t>(ToOffset(operands[count - 1]));
+				});
+
+			// Subrs are relative to the start of the Private DICT
+			if (subrs > 0 && priv.Subrs.Read(m_table, offset + subrs, m_isCff2))
+				priv.SubrBias = SubrBias(priv.Subrs.Count);
+		}
+
+		void ReadVariationStore(uint32_t offset)
+		{
+			m_variationData.clear();
+			m_regionListOffset = 0;
+
+			if (!m_table.Contains(offset, 8) || m_table.UInt16(offset) != 1)
+				return;
+
+			uint32_t regionList = m_table.UInt32(offset + 2);
+			uint32_t dataCount = m_table.UInt16(offset + 6);
+			if (regionList == 0 || !m_table.Contains(offset + 8, dataCount * 4))
+				return;
+
+			m_regionListOffset = offset + regionList;
+			for (uint32_t i = 0; i < dataCount; i++)
+				m_variationData.push_back(offset + m_table.UInt32(offset + 8 + i * 4));
+		}
+
+		/// <summary>
+		/// Returns the Font DICT index of a glyph for CID-keyed and CFF2 fonts.
+		/// </summary>
+		uint32_t GetFontDictIndex(uint16_t glyphId) const
+		{
+			if (m_fdSelect == 0)
+				return 0;
+
+			ByteSpan fds = m_table.Slice(m_fdSelect);
+			switch (fds.UInt8(0))
+			{
+			case 0:
+				return fds.UInt8(1 + glyphId);
+
+			case 3:
+			{
+				uint32_t ranges = fds.UInt16(1);
+				uint32_t lo = 0, hi = ranges;
+				while (lo < hi)
+				{
+					uint32_t mid = lo + (hi - lo) / 2;
+					uint32_t record = 3 + mid * 3;
+					if (glyphId < fds.UInt16(record))
+						hi = mid;
+					else if (glyphId >= fds.UInt16(record + 3))
+						lo = mid + 1;
+					else
+						return fds.UInt8(record + 2);
+				}
+				return 0;
+			}
+
+			case 4:
+			{
+				uint32_t ranges = fds.UInt32(1);
+				uint32_t lo = 0, hi = ranges;
+				while (lo < hi)
+				{
+					uint32_t mid = lo + (hi - lo) / 2;
+					uint32_t record = 5 + mid * 6;
+					if (glyphId < fds.UInt32(record))
+						hi = mid;
+					else if (glyphId >= fds.UInt32(record + 6))
+						lo = mid + 1;
+					else
+						return fds.UInt16(record + 4);
+				}
+				return 0;
+			}
+
+			default:
+				return 0;
+			}
+		}
+
+		/// <summary>
+		/// Finds the glyph using a StandardEncoding code, for seac.
+		/// </summary>
+		bool TryGetStandardGlyph(int code, uint16_t& glyphId) const
+		{
+			static const uint8_t StandardEncodingSids[256] = {
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+				17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32,
+				33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48,
+				49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64,
+				65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80,
+				81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 96, 97, 98, 99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110,
+				0, 111, 112, 113, 114, 0, 115, 116, 117, 118, 119, 120, 121, 122, 0, 123,
+				0, 124, 125, 126, 127, 128, 129, 130, 131, 0, 132, 133, 0, 134, 135, 136,
+				137, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 138, 0, 139, 0, 0, 0, 0, 140, 141, 142, 143, 0, 0, 0, 0,
+				0, 144, 0, 0, 0, 145, 0, 0, 146, 147, 148, 149, 0, 0, 0, 0,
+			};
+
+			if (code < 0 || code > 255 || m_isCid || StandardEncodingSids[code] == 0)
+				return false;
+
+			uint32_t sid = StandardEncodingSids[code];
+
+			// ISOAdobe charset maps glyph ids straight to SIDs
+			if (m_charset == 0)
+			{
+				if (sid >= m_numGlyphs)
+					return false;
+
+				glyphId = static_cast<uint16_t>(sid);
+				return true;
+			}
+
+			// Expert charsets never contain the standard accented glyphs
+			if (m_charset <= 2)
+				return false;
+
+			ByteSpan charset = m_table.Slice(m_charset);
+			uint8_t format = charset.UInt8(0);
+			uint32_t gid = 1;
+			uint32_t offset = 1;
+
+			while (gid < m_numGlyphs && offset < charset.Size)
+			{
+				if (format == 0)
+				{
+					if (charset.UInt16(offset) == sid)
+						break;
+					offset += 2;
+					gid++;
+				}
+				else if (format == 1 || format == 2)
+				{
+					uint32_t first = charset.UInt16(offset);
+					uint32_t left = format == 1 ? charset.UInt8(offset + 2) : charset.UInt16(offset + 2);
+					if (sid >= first && sid <= first + left)
+					{
+						gid += sid - first;
+						break;
+					}
+					gid += left + 1;
+					offset += format == 1 ? 3 : 4;
+				}
+				else
+					return false;
+			}
+
+			if (gid >= m_numGlyphs || offset >= charset.Size)
+				return false;
+
+			glyphId = static_cast<uint16_t>(gid);
+			return true;
+		}
+
+		bool RunGlyph(uint16_t glyphId, CharStringState& state, int seacDepth, float offsetX, float offsetY)
+		{
+			uint32_t fd = GetFontDictIndex(glyphId);
+			if (fd >= m_privates.size())
+				return false;
+
+			const CffPrivate& priv = m_privates[fd];
+
+			state.X = state.Y = 0;
+			state.OffsetX = offsetX;
+			state.OffsetY = offsetY;
+			state.Count = 0;
+			state.Stems = 0;
+			state.SeenWidth = m_isCff2;
+			state.Ended = false;
+			state.VsIndex = priv.VsIndex;
+
+			return Execute(CharStrings.Get(glyphId), priv, state, 0, seacDepth);
+		}
+
+		bool Execute(ByteSpan code, const CffPrivate& priv, CharStringState& s, int depth, int seacDepth)
+		{
+			if (depth > MaxSubrDepth)
+				return false;
+
+			uint32_t i = 0;
+			while (i < code.Size && !s.Ended)
+			{
+				if (++s.Operations > MaxOperations)
+					return false;
+
+				uint8_t b0 = code.Data[i++];
+
+				// Operands
+				if (b0 >= 32 || b0 == 28)
+				{
+					if (s.Count >= MaxStack)
+						return false;
+
+					float value;
+					if (b0 == 28)
+					{
+						if (!code.Contains(i, 2))
+							return false;
+						value = code.Int16(i);
+						i += 2;
+					}
+					else if (b0 <= 246)
+					{
+						value = static_cast<float>(b0 - 139);
+					}
+					else if (b0 <= 250)
+					{
+						if (i >= code.Size)
+							return false;
+						value = static_cast<float>((b0 - 247) * 256 + code.Data[i++] + 108);
+					}
+					else if (b0 <= 254)
+					{
+						if (i >= code.Size)
+							return false;
+						value = static_cast<float>(-(b0 - 251) * 256 - code.Data[i++] - 108);
+					}
+					else
+					{
+						if (!code.Contains(i, 4))
+							return false;
+						value = code.Int32(i) / 65536.0f;
+						i += 4;
+					}
+
+					s.Stack[s.Count++] = value;
+					continue;
+				}
+
+				float* a = s.Stack;
+				int n = s.Count;
+
+				switch (b0)
+				{
+				case 1:  // hstem
+				case 3:  // vstem
+				case 18: // hstemhm
+				case 23: // vstemhm
+					TakeWidth(s, n % 2 != 0);
+					s.Stems += s.Count / 2;
+					s.Count = 0;
+					break;
+
+				case 19: // hintmask
+				case 20: // cntrmask
+				{
+					// Any operands are an implied vstem
+					TakeWidth(s, n % 2 != 0);
+					s.Stems += s.Count / 2;
+					s.Count = 0;
+
+					uint32_t maskBytes = (s.Stems + 7) / 8;
+					if (!code.Contains(i, maskBytes))
+						return false;
+					i += maskBytes;
+					break;
+				}
+
+				case 21: // rmoveto
+					TakeWidth(s, n > 2);
+					if (s.Count < 2)
+						return false;
+					s.MoveTo(s.Stack[s.Count - 2], s.Stack[s.Count - 1]);
+					s.Count = 0;
+					break;
+
+				case 22: // hmoveto
+					TakeWidth(s, n > 1);
+					if (s.Count < 1)
+						return false;
+					s.MoveTo(s.Stack[s.Count - 1], 0);
+					s.Count = 0;
+					break;
+
+				case 4:  // vmoveto
+					TakeWidth(s, n > 1);
+					if (s.Count < 1)
+						return false;
+					s.MoveTo(0, s.Stack[s.Count - 1]);
+					s.Count = 0;
+					break;
+
+				case 5:  // rlineto
+					if (!s.Open)
+						return false;
+					for (int k = 0; k + 1 < n; k += 2)
+						s.LineTo(a[k], a[k + 1]);
+					s.Count = 0;
+					break;
+
+				case 6:  // hlineto
+				case 7:  // vlineto
+				{
+					if (!s.Open)
+						return false;
+					bool horizontal = b0 == 6;
+					for (int k = 0; k < n; k++, horizontal = !horizontal)
+					{
+						if (horizontal)
+							s.LineTo(a[k], 0);
+						else
+							s.LineTo(0, a[k]);
+					}
+					s.Count = 0;
+					break;
+				}
+
+				case 8:  // rrcurveto
+					if (!s.Open)
+						return false;
+					for (int k = 0; k + 5 < n; k += 6)
+						s.CurveTo(a[k], a[k + 1], a[k + 2], a[k + 3], a[k + 4], a[k + 5]);
+					s.Count = 0;
+					break;
+
+				case 24: // rcurveline
+				{
+					if (!s.Open || n < 8)
+						return false;
+					int k = 0;
+					for (; k + 5 < n - 2; k += 6)
+						s.CurveTo(a[k], a[k + 1], a[k + 2], a[k + 3], a[k + 4], a[k + 5]);
+					s.LineTo(a[k], a[k + 1]);
+					s.Count = 0;
+					break;
+				}
+
+				case 25: // rlinecurve
+				{
+					if (!s.Open || n < 8)
+						return false;
+					int k = 0;
+					for (; k + 1 < n - 6; k += 2)
+						s.LineTo(a[k], a[k + 1]);
+					s.CurveTo(a[k], a[k + 1], a[k + 2], a[k + 3], a[k + 4], a[k + 5]);
+					s.Count = 0;
+					break;
+				}
+
+				case 26: // vvcurveto
+				{
+					if (!s.Open)
+						return false;
+					int k = 0;
+					float dx1 = 0;
+					if (n % 4 == 1)
+						dx1 = a[k++];
+					for (; k + 3 < n; k += 4)
+					{
+						s.CurveTo(dx1, a[k], a[k + 1], a[k + 2], 0, a[k + 3]);
+						dx1 = 0;
+					}
+					s.Count = 0;
+					break;
+				}
+
+				case 27: // hhcurveto
+				{
+					if (!s.Open)
+						return false;
+					int k = 0;
+					float dy1 = 0;
+					if (n % 4 == 1)
+						dy1 = a[k++];
+					for (; k + 3 < n; k += 4)
+					{
+						s.CurveTo(a[k], dy1, a[k + 1], a[k + 2], a[k + 3], 0);
+						dy1 = 0;
+					}
+					s.Count = 0;
+					break;
+				}
+
+				case 30: // vhcurveto
+				case 31: // hvcurveto
+				{
+					if (!s.Open)
+						return false;
+					bool horizontal = b0 == 31;
+					for (int k = 0; k + 3 < n; k += 4, horizontal = !horizontal)
+					{
+						// A trailing fifth operand belongs to the last curve
+						float last = (n - k == 5) ? a[k + 4] : 0;
+						if (horizontal)
+							s.CurveTo(a[k], 0, a[k + 1], a[k + 2], last, a[k + 3]);
+						else
+							s.CurveTo(0, a[k], a[k + 1], a[k + 2], a[k + 3], last);
+					}
+					s.Count = 0;
+					break;
+				}
+
+				case 10: // callsubr
+				case 29: // callgsubr
+				{
+					if (n < 1)
+						return false;
+
+					const CffIndex& subrs = b0 == 10 ? priv.Subrs : m_globalSubrs;
+					int32_t index = ToInt(a[--s.Count]) + SubrBias(subrs.Count);
+					if (index < 0 || static_cast<uint32_t>(index) >= subrs.Count)
+						return false;
+
+					if (!Execute(subrs.Get(static_cast<uint32_t>(index)), priv, s, depth + 1, seacDepth))
+						return false;
+					break;
+				}
+
+				case 11: // return
+					if (m_isCff2)
+						return false;
+					return true;
+
+				case 14: // endchar
+				{
+					if (m_isCff2)
+						return false;
+
+					TakeWidth(s, n == 1 || n == 5);
+					if (s.Count == 4)
+					{
+						// seac: adx ady bchar achar
+						if (seacDepth > 0)
+							return false;
+
+						float adx = s.Stack[0], ady = s.Stack[1];
+						uint16_t base, accent;
+						if (!TryGetStandardGlyph(ToInt(s.Stack[2]), base)
+							|| !TryGetStandardGlyph(ToInt(s.Stack[3]), accent))
+							return false;
+
+						s.ClosePath();
+						if (!RunGlyph(base, s, seacDepth + 1, 0, 0))
+							return false;
+						s.ClosePath();
+						if (!RunGlyph(accent, s, seacDepth + 1, adx, ady))
+							return false;
+					}
+
+					s.ClosePath();
+					s.Count = 0;
+					s.Ended = true;
+					break;
+				}
+
+				case 15: // vsindex
+					if (!m_isCff2 || n < 1)
+						return false;
+					s.VsIndex = static_cast<uint16_t>(ToInt(a[n - 1]));
+					s.Count = 0;
+					break;
+
+				case 16: // blend
+					if (!m_isCff2 || !Blend(s))
+						return false;
+					break;
+
+				case 12:
+				{
+					if (i >= code.Size)
+						return false;
+
+					uint8_t b1 = code.Data[i++];
+					if (!Flex(s, b1))
+						return false;
+					s.Count = 0;
+					break;
+				}
+
+				default:
+					// Reserved, or the deprecated arithmetic operators
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		static void TakeWidth(CharStringState& s, bool hasWidth)
+		{
+			if (s.SeenWidth)
+				return;
+
+			s.SeenWidth = true;
+			if (hasWidth && s.Count > 0)
+			{
+				for (int k = 1; k < s.Count; k++)
+					s.Stack[k - 1] = s.Stack[k];
+				s.Count--;
+			}
+		}
+
+		static bool Flex(CharStringState& s, uint8_t op)
+		{
+			const float* a = s.Stack;
+			if (!s.Open)
+				return false;
+
+			switch (op)
+			{
+			case 35: // flex
+				if (s.Count < 13)
+					return false;
+				s.CurveTo(a[0], a[1], a[2], a[3], a[4], a[5]);
+				s.CurveTo(a[6], a[7], a[8], a[9], a[10], a[11]);
+				return true;
+
+			case 34: // hflex
+			{
+				if (s.Count < 7)
+					return false;
+				float y = s.Y;
+				s.CurveTo(a[0], 0, a[1], a[2], a[3], 0);
+				s.CurveTo(a[4], 0, a[5], y - s.Y, a[6], 0);
+				return true;
+			}
+
+			case 36: // hflex1
+			{
+				if (s.Count < 9)
+					return false;
+				float y = s.Y;
+				s.CurveTo(a[0], a[1], a[2], a[3], a[4], 0);
+				s.CurveTo(a[5], 0, a[6], a[7], a[8], y - (s.Y + a[7]));
+				return true;
+			}
+
+			case 37: // flex1
+			{
+				if (s.Count < 11)
+					return false;
+
+				float dx = a[0] + a[2] + a[4] + a[6] + a[8];
+				float dy = a[1] + a[3] + a[5] + a[7] + a[9];
+				float x = s.X, y = s.Y;
+				s.CurveTo(a[0], a[1], a[2], a[3], a[4], a[5]);
+
+				// The last point moves along whichever axis changed most
+				float lastX, lastY;
+				if (std::fabs(dx) > std::fabs(dy))
+				{
+					lastX = a[10];
+					lastY = y - (s.Y + a[7] + a[9]);
+				}
+				else
+				{
+					lastX = x - (s.X + a[6] + a[8]);
+					lastY = a[10];
+				}
+
+				s.CurveTo(a[6], a[7], a[8], a[9], lastX, lastY);
+				return true;
+			}
+
+			default:
+				return false;
+			}
+		}
+
+		bool Blend(CharStringState& s) const
+		{
+			if (s.Count < 1)
+				return false;
+
+			int n = ToInt(s.Stack[s.Count - 1]);
+			uint32_t regionCount = 0;
+			ByteSpan data;
+
+			if (s.VsIndex < m_variationData.size())
+			{
+				data = m_table.Slice(m_variationData[s.VsIndex]);
+				regionCount = data.UInt16(4);
+				if (!data.Contains(6, regionCount * 2))
+					return false;
+			}
+
+			int k = static_cast<int>(regionCount);
+			int64_t required = static_cast<int64_t>(n) * (k + 1) + 1;
+			if (n < 0 || required > s.Count)
+				return false;
+
+			int base = s.Count - static_cast<int>(required);
+			float* values = s.Stack + base;
+			const float* deltas = values + n;
+
+			if (!m_regionScalars.empty())
+			{
+				for (int v = 0; v < n; v++)
+				{
+					for (int r = 0; r < k; r++)
+					{
+						uint32_t region = data.UInt16(6 + r * 2);
+						float scalar = region < m_regionScalars.size() ? m_regionScalars[region] : 0;
+						values[v] += deltas[v * k + r] * scalar;
+					}
+				}
+			}
+
+			s.Count = base + n;
+			return true;
+		}
+	};
+}
@@ -64,6 +64,24 @@ HRESULT ColorTextAnalyzer::DrawGlyphRun(
 
 	if (HasColorGlyphs)
 	{
+		// The enumerator doesn't say how many runs it holds, but each glyph
+		// of the source run comes back at least once, as itself or as its
+		// layers, so that much is reserved up front. Capacity still doubles,
+		// as a layout calls this once per run.
+		size_t expected = glyphRun->glyphCount;
+		auto reserve = [expected](auto& v)
+		{
+			size_t needed = v.size() + expected;
+			if (needed > v.capacity())
+				v.reserve(needed > v.capacity() * 2 ? needed : v.capacity() * 2);
+		};
+
+		reserve(GlyphFormats);
+		if (IsCharacterAnalysisMode)
+		{
+			reserve(Runs);
+			reserve(Glyphs);
+		}
 
 		for (;;)
 		{
@@ -75,26 +93,23 @@ HRESULT ColorTextAnalyzer::DrawGlyphRun(
 			DWRITE_COLOR_GLYPH_RUN1 const* colorRun;
 			ThrowIfFailed(glyphRunEnumerator->GetCurrentRun(&colorRun));
 
-			auto arr = new uint16[colorRun->glyphRun.glyphCount];
-			
-
-			/*CanvasGlyph* g = new CanvasGlyph();
-			g->Index = colorRun->glyphRun.glyphIndices[0];*/
-
 			GlyphImageFormat format = static_cast<GlyphImageFormat>(colorRun->glyphImageFormat);
 			GlyphFormats.push_back(format);
 
 			if (IsCharacterAnalysisMode)
 			{
-				RunColors.push_back(colorRun->runColor);
-
-				auto arr = new uint16[colorRun->glyphRun.glyphCount];
-				for (unsigned int a = 0; a < colorRun->glyphRun.glyphCount; a = a + 1)
-				{
-					arr[a] = colorRun->glyphRun.glyphIndices[a];
-				}
-
-				GlyphIndicies.push_back(arr);
+				// All runs share one glyph buffer, so a glyph with hundreds
+				// of layers grows two vectors rather than allocating per layer.
+				UINT32 count = colorRun->glyphRun.glyphCount;
+				ColorGlyphRun run;
+				run.GlyphOffset = static_cast<uint32_t>(Glyphs.size());
+				run.GlyphCount = count;
+				run.Color = colorRun->runColor;
+				run.Format = format;
+				run.BaselineOrigin = D2D1::Point2F(colorRun->baselineOriginX, colorRun->baselineOriginY);
+				Runs.push_back(run);
+
+				Glyphs.insert(Glyphs.end(), colorRun->glyphRun.glyphIndices, colorRun->glyphRun.glyphIndices + count);
 
 				if ((format & GlyphImageFormat::Colr) == GlyphImageFormat::Colr)
 				{
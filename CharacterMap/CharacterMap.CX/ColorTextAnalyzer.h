@@ -4,11 +4,25 @@
 #include <d2d1_2.h>
 #include <d2d1_3.h>
 #include <dwrite_3.h>
+#include <vector>
 #include "GlyphImageFormat.h"
 #include "ErrorHandling.h"
 
 namespace CharacterMapCX
 {
+	/// <summary>
+	/// A single colour run captured by ColorTextAnalyzer. The glyphs of the
+	/// run live in ColorTextAnalyzer::Glyphs, starting at GlyphOffset.
+	/// </summary>
+	struct ColorGlyphRun
+	{
+		uint32_t GlyphOffset;
+		uint32_t GlyphCount;
+		DWRITE_COLOR_F Color;
+		GlyphImageFormat Format;
+		D2D1_POINT_2F BaselineOrigin;
+	};
+
 	class ColorTextAnalyzer : public IDWriteTextRenderer
 	{
 	public:
@@ -28,9 +42,17 @@ namespace CharacterMapCX
 
 		std::vector<GlyphImageFormat> GlyphFormats;
 
-		std::vector<uint16*> GlyphIndicies;
-
-		std::vector<DWRITE_COLOR_F> RunColors;
+		/// <summary>
+		/// Glyph indices of every captured colour run, stored back to back.
+		/// Only populated in character analysis mode.
+		/// </summary>
+		std::vector<uint16> Glyphs;
+
+		/// <summary>
+		/// Captured colour runs, indexing into Glyphs.
+		/// Only populated in character analysis mode.
+		/// </summary>
+		std::vector<ColorGlyphRun> Runs;
 
 		IFACEMETHOD(IsPixelSnappingDisabled)(
 			_In_opt_ void* clientDrawingContext,
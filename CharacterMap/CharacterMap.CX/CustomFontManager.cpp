@@ -10,6 +10,7 @@
 #include "pch.h"
 #include "CustomFontManager.h"
 #include <robuffer.h>
+#include <fileapifromapp.h>
 
 using namespace CharacterMapCX;
 
@@ -21,34 +22,48 @@ ComPtr<IDWriteFactory> DefaultCustomFontManagerAdapter::CreateDWriteFactory(DWRI
     return factory;
 }
 
+/// <summary>
+/// Enumerates the files of a collection key: a list of paths, each
+/// separated from the next by a null character. A key for a single file is
+/// just its path.
+/// </summary>
 class CustomFontFileEnumerator
     : public RuntimeClass<RuntimeClassFlags<ClassicCom>, IDWriteFontFileEnumerator>
     , private LifespanTracker<CustomFontFileEnumerator>
 {
     ComPtr<IDWriteFactory> m_factory;
-    std::wstring m_filename;
+    std::wstring m_key;
+    size_t m_next = 0;
     ComPtr<IDWriteFontFile> m_theFile;
 
 public:
     CustomFontFileEnumerator(IDWriteFactory* factory, void const* collectionKey, uint32_t collectionKeySize)
         : m_factory(factory)
-        , m_filename(static_cast<wchar_t const*>(collectionKey), collectionKeySize / 2)
+        , m_key(static_cast<wchar_t const*>(collectionKey), collectionKeySize / 2)
     {
     }
 
     IFACEMETHODIMP MoveNext(BOOL* hasCurrentFile) override
     {
-        if (m_theFile)
-        {
-            *hasCurrentFile = FALSE;
-        }
-        else if (SUCCEEDED(m_factory->CreateFontFileReference(m_filename.c_str(), nullptr, &m_theFile)))
-        {
-            *hasCurrentFile = TRUE;
-        }
-        else
+        *hasCurrentFile = FALSE;
+        m_theFile = nullptr;
+
+        // A file that can't be opened is skipped rather than failing the
+        // rest of the collection
+        while (m_next < m_key.size())
         {
-            *hasCurrentFile = FALSE;
+            size_t end = m_key.find(L'\0', m_next);
+            if (end == std::wstring::npos)
+                end = m_key.size();
+
+            std::wstring filename = m_key.substr(m_next, end - m_next);
+            m_next = end + 1;
+
+            if (!filename.empty() && SUCCEEDED(m_factory->CreateFontFileReference(filename.c_str(), nullptr, &m_theFile)))
+            {
+                *hasCurrentFile = TRUE;
+                break;
+            }
         }
 
         return S_OK;
@@ -100,21 +115,198 @@ CustomFontManager::CustomFontManager(ComPtr<IDWriteFactory7> sharedFactory)
 //    return GetFontCollectionFromPath(path);
 //}
 
+namespace
+{
+    /// <summary>
+    /// Hashes the size and last write time of each file, so a collection is
+    /// rebuilt if any of them changes. Returns false if a file can't be read.
+    /// </summary>
+    bool TryGetFilesIdentity(std::vector<std::wstring> const& paths, uint64_t& identity)
+    {
+        identity = 14695981039346656037ull;
+        for (auto const& path : paths)
+        {
+            WIN32_FILE_ATTRIBUTE_DATA data{};
+            if (!GetFileAttributesExFromAppW(path.c_str(), GetFileExInfoStandard, &data))
+                return false;
+
+            uint64_t size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+            uint64_t lastWriteTime = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+            identity = (identity ^ size) * 1099511628211ull;
+            identity = (identity ^ lastWriteTime) * 1099511628211ull;
+        }
+
+        return true;
+    }
+
+    bool IsMergedKey(std::wstring const& key)
+    {
+        return key.find(L'\0') != std::wstring::npos;
+    }
+
+    bool KeyContains(std::wstring const& key, std::wstring const& path)
+    {
+        size_t start = 0;
+        while (start <= key.size())
+        {
+            size_t end = key.find(L'\0', start);
+            if (end == std::wstring::npos)
+                end = key.size();
+
+            if (key.compare(start, end - start, path) == 0)
+                return true;
+
+            start = end + 1;
+        }
+
+        return false;
+    }
+}
+
 ComPtr<IDWriteFontCollection3> CustomFontManager::GetFontCollection(Platform::String^ path)
 {
-    auto pathBegin = begin(path);
-    auto pathEnd = end(path);
+    std::wstring key(path->Data(), path->Length());
+    return GetFontCollection(key, { key });
+}
+
+ComPtr<IDWriteFontCollection3> CustomFontManager::GetFontCollection(std::vector<std::wstring> const& paths)
+{
+    std::wstring key;
+    for (auto const& path : paths)
+    {
+        if (!key.empty())
+            key.push_back(L'\0');
+        key.append(path);
+    }
+
+    return GetFontCollection(key, paths);
+}
+
+ComPtr<IDWriteFontCollection3> CustomFontManager::GetFontCollection(std::wstring const& key, std::vector<std::wstring> const& paths)
+{
+    uint64_t identity = 0;
+    if (!TryGetFilesIdentity(paths, identity))
+    {
+        // Nothing to key the collection on, so it isn't cached
+        RemoveFontCollection(key, nullptr);
+        return CreateFontCollection(key);
+    }
 
-    assert(pathBegin && pathEnd);
+    std::shared_ptr<CachedFontCollection> entry;
 
-    void const* key = pathBegin;
-    uint32_t keySize = static_cast<uint32_t>(std::distance(pathBegin, pathEnd) * sizeof(wchar_t));
+    auto collections = std::atomic_load(&m_collections);
+    if (collections)
+    {
+        auto it = collections->find(key);
+        if (it != collections->end())
+            entry = it->second;
+    }
+
+    if (!entry || entry->Identity != identity)
+    {
+        Lock lock(m_collectionsMutex);
 
+        // Another thread may have added it since the snapshot was taken
+        collections = std::atomic_load(&m_collections);
+        auto it = collections ? collections->find(key) : CollectionMap::const_iterator();
+        if (collections && it != collections->end() && it->second->Identity == identity)
+        {
+            entry = it->second;
+        }
+        else
+        {
+            auto map = collections ? std::make_shared<CollectionMap>(*collections) : std::make_shared<CollectionMap>();
+
+            // Only the latest merged collection is kept, as each import
+            // changes the file list and would otherwise leave the previous
+            // list's collection, and all its files, loaded for good
+            if (IsMergedKey(key))
+            {
+                for (auto it = map->begin(); it != map->end();)
+                {
+                    if (IsMergedKey(it->first))
+                        it = map->erase(it);
+                    else
+                        ++it;
+                }
+            }
+
+            entry = std::make_shared<CachedFontCollection>();
+            entry->Identity = identity;
+            (*map)[key] = entry;
+            std::atomic_store(&m_collections, std::shared_ptr<const CollectionMap>(map));
+        }
+    }
+
+    // Created outside the lock, so loading one file doesn't hold up others.
+    // If it throws, the flag stays unset and the next caller tries again.
+    try
+    {
+        std::call_once(entry->Created, [&]
+            {
+                entry->Collection = CreateFontCollection(key);
+            });
+    }
+    catch (...)
+    {
+        RemoveFontCollection(key, entry);
+        throw;
+    }
+
+    return entry->Collection;
+}
+
+void CustomFontManager::ReleaseFontCollection(Platform::String^ path)
+{
+    std::wstring file(path->Data(), path->Length());
+
+    auto collections = std::atomic_load(&m_collections);
+    if (!collections)
+        return;
+
+    std::vector<std::wstring> keys;
+    for (auto const& pair : *collections)
+    {
+        if (KeyContains(pair.first, file))
+            keys.push_back(pair.first);
+    }
+
+    for (auto const& key : keys)
+        RemoveFontCollection(key, nullptr);
+}
+
+/// <summary>
+/// Removes the cached entry for a key. If entry is set, it's only
+/// removed if it's still the cached one.
+/// </summary>
+void CustomFontManager::RemoveFontCollection(std::wstring const& key, std::shared_ptr<CachedFontCollection> const& entry)
+{
+    Lock lock(m_collectionsMutex);
+
+    auto collections = std::atomic_load(&m_collections);
+    if (!collections)
+        return;
+
+    auto it = collections->find(key);
+    if (it == collections->end() || (entry && it->second != entry))
+        return;
+
+    auto map = std::make_shared<CollectionMap>(*collections);
+    map->erase(key);
+    std::atomic_store(&m_collections, std::shared_ptr<const CollectionMap>(map));
+}
+
+ComPtr<IDWriteFontCollection3> CustomFontManager::CreateFontCollection(std::wstring const& key)
+{
     ComPtr<IDWriteFontCollection> tcollection;
     ComPtr<IDWriteFontCollection3> collection;
 
     auto& factory = GetIsolatedFactory();
-    ThrowIfFailed(factory->CreateCustomFontCollection(m_customLoader.Get(), key, keySize, &tcollection));
+    ThrowIfFailed(factory->CreateCustomFontCollection(
+        m_customLoader.Get(),
+        key.data(),
+        static_cast<uint32_t>(key.size() * sizeof(wchar_t)),
+        &tcollection));
 
     tcollection.As<IDWriteFontCollection3>(&collection);
 
@@ -123,30 +315,26 @@ ComPtr<IDWriteFontCollection3> CustomFontManager::GetFontCollection(Platform::St
 
 ComPtr<IDWriteFactory7> const& CustomFontManager::GetIsolatedFactory()
 {
-    RecursiveLock lock(m_mutex);
-
-    if (!m_isolatedFactory)
-    {
-        auto fac = m_adapter->CreateDWriteFactory(DWRITE_FACTORY_TYPE_ISOLATED);
-        fac.As<IDWriteFactory7>(&m_isolatedFactory);
+    std::call_once(m_isolatedFactoryCreated, [this]
+        {
+            auto fac = m_adapter->CreateDWriteFactory(DWRITE_FACTORY_TYPE_ISOLATED);
+            fac.As<IDWriteFactory7>(&m_isolatedFactory);
 
-        m_customLoader = Make<CustomFontLoader>();
-        ThrowIfFailed(m_isolatedFactory->RegisterFontCollectionLoader(m_customLoader.Get()));
-    }
+            m_customLoader = Make<CustomFontLoader>();
+            ThrowIfFailed(m_isolatedFactory->RegisterFontCollectionLoader(m_customLoader.Get()));
+        });
 
     return m_isolatedFactory;
 }
 
 ComPtr<IDWriteTextAnalyzer2> const& CustomFontManager::GetTextAnalyzer()
 {
-    RecursiveLock lock(m_mutex);
-
-    if (!m_textAnalyzer)
-    {
-        ComPtr<IDWriteTextAnalyzer> textAnalyzerBase;
-        ThrowIfFailed(m_sharedFactory->CreateTextAnalyzer(&textAnalyzerBase));
-        textAnalyzerBase.As<IDWriteTextAnalyzer2>(&m_textAnalyzer);
-    }
+    std::call_once(m_textAnalyzerCreated, [this]
+        {
+            ComPtr<IDWriteTextAnalyzer> textAnalyzerBase;
+            ThrowIfFailed(m_sharedFactory->CreateTextAnalyzer(&textAnalyzerBase));
+            textAnalyzerBase.As<IDWriteTextAnalyzer2>(&m_textAnalyzer);
+        });
 
     return m_textAnalyzer;
-}
\ No newline at end of file
+}
@@ -10,6 +10,8 @@
 
 #include "pch.h"
 #include "Singleton.h"
+#include <memory>
+#include <unordered_map>
 
 namespace CharacterMapCX {
     class DefaultCustomFontManagerAdapter;
@@ -27,21 +29,69 @@ namespace CharacterMapCX {
         virtual ComPtr<IDWriteFactory> CreateDWriteFactory(DWRITE_FACTORY_TYPE type) override;
     };
     
+    /// <summary>
+    /// A custom font collection for one or more files, along with a hash of
+    /// the size and last write time each file had when it was loaded.
+    /// Entries are shared, so one that's evicted stays alive until every
+    /// reader has finished with it, and callers keep their own reference to
+    /// the collection.
+    /// </summary>
+    struct CachedFontCollection
+    {
+        uint64_t Identity = 0;
+        std::once_flag Created;
+        ComPtr<IDWriteFontCollection3> Collection;
+    };
+
     class CustomFontManager : public Singleton<CustomFontManager>
     {
+        typedef std::unordered_map<std::wstring, std::shared_ptr<CachedFontCollection>> CollectionMap;
+
         std::shared_ptr<CustomFontManagerAdapter> m_adapter;
     
-        std::recursive_mutex m_mutex;
+        std::once_flag m_isolatedFactoryCreated;
+        std::once_flag m_textAnalyzerCreated;
         ComPtr<IDWriteFactory7> m_isolatedFactory;
         ComPtr<IDWriteFactory7> m_sharedFactory;
         ComPtr<IDWriteFontCollectionLoader> m_customLoader;
         ComPtr<IDWriteTextAnalyzer2> m_textAnalyzer;
         ComPtr<IDWriteFontFallback> m_systemFontFallback;
+
+        // Read without a lock through std::atomic_load, and replaced as a
+        // whole under m_collectionsMutex whenever an entry is added or removed
+        std::shared_ptr<const CollectionMap> m_collections;
+        std::mutex m_collectionsMutex;
+
+        ComPtr<IDWriteFontCollection3> GetFontCollection(std::wstring const& key, std::vector<std::wstring> const& paths);
+        ComPtr<IDWriteFontCollection3> CreateFontCollection(std::wstring const& key);
+        void RemoveFontCollection(std::wstring const& key, std::shared_ptr<CachedFontCollection> const& entry);
     
     public:
         CustomFontManager();
         CustomFontManager(ComPtr<IDWriteFactory7> sharedFactory);
+
+        /// <summary>
+        /// Gets the collection for a font file, creating it only if the file
+        /// hasn't been loaded before or has changed since. Safe to call from
+        /// any thread.
+        /// </summary>
         ComPtr<IDWriteFontCollection3> GetFontCollection(Platform::String^ path);
+
+        /// <summary>
+        /// Gets one collection holding the fonts of every file, creating it
+        /// only if that list of files hasn't been loaded before or any of
+        /// them has changed since. Families with the same name in different
+        /// files are merged. Only the most recent list's collection is
+        /// cached.
+        /// </summary>
+        ComPtr<IDWriteFontCollection3> GetFontCollection(std::vector<std::wstring> const& paths);
+
+        /// <summary>
+        /// Drops every cached collection that holds a font file, so the cache
+        /// doesn't keep the file open once it's about to be deleted.
+        /// </summary>
+        void ReleaseFontCollection(Platform::String^ path);
+
         ComPtr<IDWriteFactory7> const& GetIsolatedFactory();
         ComPtr<IDWriteTextAnalyzer2> const& GetTextAnalyzer();
     };
@@ -33,7 +33,13 @@ namespace CharacterMapCX
 
 		property UINT32 GlyphCount
 		{
-			UINT32 get() { return GetFontFace()->GetGlyphCount(); }
+			UINT32 get()
+			{
+				if (m_dwProperties != nullptr && m_dwProperties->m_glyphCount > 0)
+					return m_dwProperties->m_glyphCount;
+
+				return GetFontFace()->GetGlyphCount();
+			}
 		}
 
 		property CanvasFontFileFormatType FileFormatType
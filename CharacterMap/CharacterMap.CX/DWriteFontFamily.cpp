@@ -1,6 +1,8 @@
 #pragma once
 #include "pch.h"
 #include "DWriteFontFamily.h"
+#include "FontMetadataStore.h"
+#include "FontFaceView.h"
 
 using namespace Windows::Foundation;
 using namespace Windows::Foundation::Collections;
@@ -9,6 +11,32 @@ using namespace CharacterMapCX;
 using namespace concurrency;
 
 
+namespace
+{
+	uint32_t Intern(String^ value)
+	{
+		if (value == nullptr)
+			return FontNameTable::Shared().Intern(u"", 0);
+
+		return FontNameTable::Shared().Intern(reinterpret_cast<const char16_t*>(value->Data()), value->Length());
+	}
+
+	uint32_t ToFaceFlags(const FontMetadata& metadata)
+	{
+		uint32_t flags = FontFaceCached;
+		if (metadata.HasFlag(FontMetadataColor))
+			flags |= FontFaceColor;
+		if (metadata.HasFlag(FontMetadataSymbol))
+			flags |= FontFaceSymbol;
+		if (metadata.HasFlag(FontMetadataMonospaced))
+			flags |= FontFaceMonospaced;
+		if (metadata.HasFlag(FontMetadataVariations))
+			flags |= FontFaceVariable;
+
+		return flags;
+	}
+}
+
 void DWriteFontFamily::Inflate()
 {
 	if (m_fonts != nullptr)
@@ -17,36 +45,135 @@ void DWriteFontFamily::Inflate()
 	wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
 	int ls = GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH);
 
-	String^ familyName = nullptr;
-	ComPtr<IDWriteLocalizedStrings> names;
-	if (SUCCEEDED(m_family->GetFamilyNames(&names)))
-		familyName = DirectWrite::GetLocaleString(names, ls, localeName);
+	std::vector<FontFaceRecord> records(GetFontCount());
+	UINT32 count = CreateRecords(ls, localeName, records.data(), nullptr);
 
-	auto fonts = ref new Vector<DWriteFontFace^>();
+	auto table = std::make_shared<FontFaceTable>();
+	table->Reserve(count);
+	for (UINT32 i = 0; i < count; i++)
+		table->Add(records[i]);
+
+	m_fonts = ref new FontFaceView(table, 0, count);
+}
+
+UINT32 DWriteFontFamily::CreateRecords(int ls, wchar_t* localeName, FontFaceRecord* records, FontMetadataStore* store)
+{
+	FontMetadataKey key;
+	FontMetadataKey last;
+	bool hasLast = false;
+
+	UINT32 count = 0;
 	auto fontCount = m_family->GetFontCount();
 	for (uint32_t j = 0; j < fontCount; ++j)
 	{
-		ComPtr<IDWriteFont3> font;
-		m_family->GetFont(j, &font);
+		ComPtr<IDWriteFont3> font = GetLocalFont(j);
+		if (font == nullptr)
+			continue;
+
+		FontFaceRecord& record = records[count++];
 
-		if (font != nullptr && font->GetLocality() == DWRITE_LOCALITY::DWRITE_LOCALITY_LOCAL)
+		bool hasKey = store != nullptr && store->TryGetKey(font.Get(), key, hasLast ? &last : nullptr);
+		if (hasKey)
 		{
-			String^ fontName = nullptr;
-			if (SUCCEEDED(font->GetFaceNames(&names)))
-				fontName = DirectWrite::GetLocaleString(names, ls, localeName);
-
-			auto props = ref new DWriteProperties(
-				DWriteFontSource::Unknown,
-				nullptr,
-				familyName,
-				fontName,
-				font);
-
-			fonts->Append(ref new DWriteFontFace(font, props));
+			std::swap(last, key);
+			hasLast = true;
+
+			FontMetadata metadata;
+			if (store->TryGet(last, metadata))
+			{
+				uint32_t source = GetSource(font.Get());
+				uint32_t flags = ToFaceFlags(metadata);
+				if (font->GetSimulations() != DWRITE_FONT_SIMULATIONS_NONE)
+					flags |= FontFaceSimulated;
+
+				record.Font = font;
+				record.FamilyId = FontNameTable::Shared().Intern(metadata.FamilyName);
+				record.FaceNameId = FontNameTable::Shared().Intern(metadata.FaceName);
+				record.Packed = FontFaceStore::Pack(metadata.Weight, metadata.Style, metadata.Stretch, flags, source);
+				record.GlyphCount = metadata.GlyphCount;
+				memcpy(record.Panose, metadata.Panose, sizeof(record.Panose));
+				continue;
+			}
 		}
+
+		CreateRecord(font, ls, localeName, record);
+
+		if (hasKey)
+			store->AddMiss(
+				last,
+				font,
+				FontNameTable::Shared().Get(record.FamilyId).ToString(),
+				FontNameTable::Shared().Get(record.FaceNameId).ToString());
 	}
 
-	m_fonts = fonts->GetView();
+	return count;
 }
 
+ComPtr<IDWriteFont3> DWriteFontFamily::GetLocalFont(UINT32 index)
+{
+	ComPtr<IDWriteFont3> font;
+	m_family->GetFont(index, &font);
 
+	if (font != nullptr && font->GetLocality() == DWRITE_LOCALITY::DWRITE_LOCALITY_LOCAL)
+		return font;
+
+	return nullptr;
+}
+
+void DWriteFontFamily::CreateRecord(ComPtr<IDWriteFont3> font, int ls, wchar_t* localeName, FontFaceRecord& record)
+{
+	ComPtr<IDWriteLocalizedStrings> names;
+	record.FaceNameId = Intern(SUCCEEDED(font->GetFaceNames(&names))
+		? DirectWrite::GetLocaleString(names, ls, localeName)
+		: nullptr);
+
+	// Whether the font is variable isn't known without creating its face,
+	// so it's left for DWriteProperties.HasVariations to read
+	uint32_t source = GetSource(font.Get());
+	uint32_t flags = 0;
+	if (font->IsColorFont())
+		flags |= FontFaceColor;
+	if (font->IsSymbolFont())
+		flags |= FontFaceSymbol;
+	if (font->GetSimulations() != DWRITE_FONT_SIMULATIONS_NONE)
+		flags |= FontFaceSimulated;
+
+	record.Font = font;
+	record.FamilyId = GetFamilyId(ls, localeName);
+	record.Packed = FontFaceStore::Pack(font->GetWeight(), font->GetStyle(), font->GetStretch(), flags, source);
+}
+
+uint32_t DWriteFontFamily::GetFamilyId(int ls, wchar_t* localeName)
+{
+	// Only read once a face needs it, as faces from the metadata store don't
+	if (!m_hasFamilyId)
+	{
+		ComPtr<IDWriteLocalizedStrings> names;
+		m_familyId = Intern(SUCCEEDED(m_family->GetFamilyNames(&names))
+			? DirectWrite::GetLocaleString(names, ls, localeName)
+			: nullptr);
+		m_hasFamilyId = true;
+	}
+
+	return m_familyId;
+}
+
+uint32_t DWriteFontFamily::GetSource(IDWriteFont3* font)
+{
+	if (m_fontSet == nullptr)
+	{
+		ComPtr<IDWriteFontSet1> set;
+		if (FAILED(m_family->GetFontSet(&set)) || FAILED(set.As(&m_fontSet)))
+			return 0;
+	}
+
+	ComPtr<IDWriteFontFaceReference> ref;
+	UINT32 index = 0;
+	BOOL exists = FALSE;
+	if (FAILED(font->GetFontFaceReference(&ref))
+		|| FAILED(m_fontSet->FindFontFaceReference(ref.Get(), &index, &exists))
+		|| !exists)
+		return 0;
+
+	return static_cast<uint32_t>(m_fontSet->GetFontSourceType(index));
+}
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "DWriteFontFace.h"
+#include "FontFaceTable.h"
 using namespace Windows::Foundation::Collections;
 
 namespace CharacterMapCX
 {
+	class FontMetadataStore;
+
 	public ref class DWriteFontFamily sealed
 	{
 	public:
@@ -16,9 +19,47 @@ namespace CharacterMapCX
 			m_family = family;
 		}
 
+		/// <summary>
+		/// Number of fonts in the family, including any Inflate would skip.
+		/// </summary>
+		UINT32 GetFontCount() { return m_family->GetFontCount(); }
+
+		/// <summary>
+		/// Reads each local font in the family into records, which must
+		/// have room for GetFontCount() entries. Returns the number of
+		/// records written. Safe to call from any thread. Faces found in the
+		/// metadata store, if one is given, are read from it without
+		/// reading their names or file.
+		/// </summary>
+		UINT32 CreateRecords(int ls, wchar_t* localeName, FontFaceRecord* records, FontMetadataStore* store);
+
+		/// <summary>
+		/// Gets a font of the family, or nullptr if it isn't local.
+		/// </summary>
+		ComPtr<IDWriteFont3> GetLocalFont(UINT32 index);
+
+		/// <summary>
+		/// Reads one font of the family into a record, including its names.
+		/// </summary>
+		void CreateRecord(ComPtr<IDWriteFont3> font, int ls, wchar_t* localeName, FontFaceRecord& record);
+
 		IVectorView<DWriteFontFace^>^ m_fonts = nullptr;
 
 	private:
+		/// <summary>
+		/// Gets the ID of the family's name in the shared FontNameTable.
+		/// </summary>
+		uint32_t GetFamilyId(int ls, wchar_t* localeName);
+
+		/// <summary>
+		/// Gets where a font was installed from out of the family's font
+		/// set, so no file is read.
+		/// </summary>
+		uint32_t GetSource(IDWriteFont3* font);
+
+		bool m_hasFamilyId = false;
+		uint32_t m_familyId = 0;
+		ComPtr<IDWriteFontSet3> m_fontSet = nullptr;
 		ComPtr<IDWriteFontFamily2> m_family = nullptr;
 		ComPtr<IDWriteFontCollection3> m_collection = nullptr;
 	};
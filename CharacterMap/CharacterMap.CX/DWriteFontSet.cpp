@@ -0,0 +1,334 @@
+#pragma once
+#include "pch.h"
+#include "DWriteFontSet.h"
+#include "FontFaceView.h"
+#include <ppl.h>
+#include <unordered_map>
+
+using namespace Windows::Foundation::Collections;
+using namespace Platform;
+using namespace CharacterMapCX;
+using namespace concurrency;
+
+DWriteFontSet^ DWriteFontSet::Inflate()
+{
+	return InflateFromStore(nullptr);
+}
+
+DWriteFontSet^ DWriteFontSet::InflateFromStore(FontMetadataStore* store)
+{
+	if (m_table != nullptr)
+		return this;
+
+	wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
+	int ls = GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH);
+
+	// 1. Give every font of every family a slot in one flat array up front,
+	//    so each family fills its own range without any locking.
+	std::vector<DWriteFontFamily^> families;
+	for each (auto family in m_families)
+		families.push_back(family);
+
+	UINT32 familyCount = static_cast<UINT32>(families.size());
+
+	std::vector<UINT32> offsets(familyCount + 1);
+	for (UINT32 i = 0; i < familyCount; i++)
+		offsets[i + 1] = offsets[i] + families[i]->GetFontCount();
+
+	std::vector<FontFaceRecord> records(offsets.back());
+	std::vector<UINT32> counts(familyCount);
+
+	// 2. Read the faces on PPL's worker pool, which is sized to the
+	//    machine. Families range from one face to dozens, so they're left
+	//    to work stealing rather than split evenly.
+	parallel_for(0u, familyCount, [&](UINT32 i)
+		{
+			counts[i] = families[i]->CreateRecords(ls, localeName, records.data() + offsets[i], store);
+		});
+
+	// 3. Move the records into the table, giving each family a view of
+	//    its rows
+	auto table = std::make_shared<FontFaceTable>();
+	table->Reserve(offsets.back());
+	for (UINT32 i = 0; i < familyCount; i++)
+	{
+		UINT32 first = table->Size();
+		for (UINT32 j = 0; j < counts[i]; j++)
+			table->Add(records[offsets[i] + j]);
+
+		families[i]->m_fonts = ref new FontFaceView(table, first, counts[i]);
+	}
+
+	m_table = table;
+	this->Update();
+	return this;
+}
+
+void DWriteFontSet::Update()
+{
+	if (m_table == nullptr)
+		return;
+
+	const FontFaceStore& store = m_table->Store();
+	uint32_t simulated = FontFaceStore::FlagMask(FontFaceSimulated);
+	uint32_t variable = FontFaceStore::FlagMask(FontFaceVariable);
+
+	uint32_t cached = FontFaceStore::FlagMask(FontFaceCached);
+
+	m_faceCount = store.Count(simulated, 0);
+	m_varCount = store.Count(simulated | variable, variable);
+
+	// Faces that weren't in the metadata cache only learn whether they're
+	// variable once HasVariations is read, so as before, any of them may be
+	if (m_varCount == 0 && store.Count(simulated | cached, 0) > 0)
+		m_varCount = 1;
+	m_appxCount = store.Count(FontFaceStore::SourceMask, FontFaceStore::SourceValue(static_cast<uint32_t>(DWriteFontSource::AppxPackage)));
+	m_cloudCount = store.Count(FontFaceStore::SourceMask, FontFaceStore::SourceValue(static_cast<uint32_t>(DWriteFontSource::RemoteFontProvider)));
+
+	m_fonts = ref new FontFaceView(m_table, 0, m_table->Size());
+}
+
+IVectorView<DWriteFontFace^>^ DWriteFontSet::GetFonts(bool includeSimulated)
+{
+	if (m_table == nullptr || includeSimulated)
+		return m_fonts;
+
+	std::vector<uint32_t> rows;
+	rows.reserve(m_faceCount);
+	m_table->Store().Select(FontFaceStore::FlagMask(FontFaceSimulated), 0, rows);
+	return ref new FontFaceView(m_table, std::move(rows));
+}
+
+DWriteFontFace^ DWriteFontSet::FindFace(String^ familyName, FontWeight weight, FontStretch stretch, FontStyle style)
+{
+	if (m_table == nullptr || familyName == nullptr)
+		return nullptr;
+
+	const FontFaceStore& store = m_table->Store();
+	uint32_t familyId = 0;
+	if (!store.Names().TryFind(reinterpret_cast<const char16_t*>(familyName->Data()), familyName->Length(), familyId))
+		return nullptr;
+
+	uint32_t mask = FontFaceStore::WeightMask | FontFaceStore::StretchMask | FontFaceStore::StyleMask;
+	uint32_t value = FontFaceStore::Pack(weight.Weight, static_cast<uint32_t>(style), static_cast<uint32_t>(stretch), 0, 0);
+
+	uint32_t index = 0;
+	if (!store.Find(familyId, mask, value, index))
+		return nullptr;
+
+	return m_table->GetFace(index);
+}
+
+namespace
+{
+	/// <summary>
+	/// Gets the path of a font file from the local file loader, or returns
+	/// false if it was loaded some other way.
+	/// </summary>
+	bool GetLocalPath(IDWriteFontFile* file, const void* key, UINT32 keySize, std::wstring& path)
+	{
+		ComPtr<IDWriteFontFileLoader> loader;
+		ComPtr<IDWriteLocalFontFileLoader> localLoader;
+		UINT32 length = 0;
+		if (FAILED(file->GetLoader(&loader))
+			|| FAILED(loader.As(&localLoader))
+			|| FAILED(localLoader->GetFilePathLengthFromKey(key, keySize, &length)))
+			return false;
+
+		path.resize(length + 1);
+		if (FAILED(localLoader->GetFilePathFromKey(key, keySize, &path[0], length + 1)))
+			return false;
+
+		path.resize(length);
+		return true;
+	}
+
+	/// <summary>
+	/// Gets the identity of the file a font comes from and its face within
+	/// it. Local file keys include the file's last write time, so the
+	/// file's path is also returned as location, to match a file that was
+	/// modified in place.
+	/// </summary>
+	bool GetFaceIdentity(IDWriteFont3* font, std::string& identity, std::wstring& location)
+	{
+		ComPtr<IDWriteFontFaceReference> ref;
+		ComPtr<IDWriteFontFile> file;
+		const void* key = nullptr;
+		UINT32 keySize = 0;
+
+		if (font == nullptr
+			|| FAILED(font->GetFontFaceReference(&ref))
+			|| FAILED(ref->GetFontFile(&file))
+			|| FAILED(file->GetReferenceKey(&key, &keySize)))
+			return false;
+
+		std::wstring suffix = L"|" + std::to_wstring(ref->GetFontFaceIndex()) + L"|" + std::to_wstring(font->GetSimulations());
+
+		identity.assign(static_cast<const char*>(key), keySize);
+		identity.append(reinterpret_cast<const char*>(suffix.data()), suffix.size() * sizeof(wchar_t));
+
+		if (GetLocalPath(file.Get(), key, keySize, location))
+			location += suffix;
+		else
+			location.clear();
+
+		return true;
+	}
+}
+
+DWriteFontSetDiff^ DWriteFontSet::Patch(IVectorView<DWriteFontFamily^>^ families)
+{
+	if (m_table == nullptr)
+	{
+		m_families = families;
+		InflateFromStore(nullptr);
+		return ref new DWriteFontSetDiff();
+	}
+
+	wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
+	int ls = GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH);
+
+	auto current = m_table;
+
+	struct Existing
+	{
+		uint32_t Row;
+		std::wstring Location;
+	};
+
+	// 1. Index the faces we already have by where they come from
+	std::string identity;
+	std::wstring location;
+	std::unordered_map<std::string, Existing> existing;
+	std::vector<DWriteFontFace^> removed;
+	for (uint32_t i = 0; i < current->Size(); i++)
+	{
+		if (GetFaceIdentity(current->GetFont(i).Get(), identity, location))
+			existing.emplace(std::move(identity), Existing{ i, std::move(location) });
+		else
+			removed.push_back(current->GetFace(i));
+	}
+
+	// 2. Rebuild each family of the new collection into a new table,
+	//    copying the rows that are still there and reading the rest
+	auto table = std::make_shared<FontFaceTable>();
+	table->Reserve(current->Size());
+
+	std::vector<std::pair<uint32_t, std::wstring>> created;
+	FontFaceRecord record;
+	for each (auto family in families)
+	{
+		UINT32 first = table->Size();
+		UINT32 count = family->GetFontCount();
+		for (UINT32 i = 0; i < count; i++)
+		{
+			ComPtr<IDWriteFont3> font = family->GetLocalFont(i);
+			if (font == nullptr)
+				continue;
+
+			location.clear();
+			if (GetFaceIdentity(font.Get(), identity, location))
+			{
+				auto match = existing.find(identity);
+				if (match != existing.end())
+				{
+					table->AddFrom(*current, match->second.Row);
+					existing.erase(match);
+					continue;
+				}
+			}
+
+			record = FontFaceRecord();
+			family->CreateRecord(font, ls, localeName, record);
+			created.emplace_back(table->Add(record), std::move(location));
+		}
+
+		family->m_fonts = ref new FontFaceView(table, first, table->Size() - first);
+	}
+
+	// 3. Anything left over is gone, unless a new face came from the same
+	//    file, in which case the file was modified. Faces are only created
+	//    for the rows in the diff.
+	std::unordered_map<std::wstring, uint32_t> byLocation;
+	for (auto& pair : existing)
+	{
+		if (pair.second.Location.empty() || !byLocation.emplace(pair.second.Location, pair.second.Row).second)
+			removed.push_back(current->GetFace(pair.second.Row));
+	}
+
+	std::vector<DWriteFontFace^> added;
+	std::vector<DWriteFontFace^> changed;
+	std::vector<DWriteFontFace^> previous;
+	for (auto& pair : created)
+	{
+		auto match = pair.second.empty() ? byLocation.end() : byLocation.find(pair.second);
+		if (match != byLocation.end())
+		{
+			changed.push_back(table->GetFace(pair.first));
+			previous.push_back(current->GetFace(match->second));
+			byLocation.erase(match);
+		}
+		else
+			added.push_back(table->GetFace(pair.first));
+	}
+
+	for (auto& pair : byLocation)
+		removed.push_back(current->GetFace(pair.second));
+
+	m_families = families;
+	m_table = table;
+	this->Update();
+
+	return ref new DWriteFontSetDiff(std::move(added), std::move(removed), std::move(changed), std::move(previous));
+}
+
+void DWriteFontSet::SetSourceFiles(const std::vector<std::wstring>& paths)
+{
+	m_fileRows.clear();
+	m_fileRows.resize(paths.size());
+	if (m_table == nullptr)
+		return;
+
+	std::unordered_map<std::wstring, uint32_t> indices;
+	for (uint32_t i = 0; i < paths.size(); i++)
+		indices.emplace(paths[i], i);
+
+	// Looking up each face's file is independent, so it's done in parallel
+	// and only the bucketing below is serial
+	uint32_t size = m_table->Size();
+	std::vector<uint32_t> fileIndices(size, UINT32_MAX);
+	parallel_for(0u, size, [&](uint32_t i)
+		{
+			ComPtr<IDWriteFontFaceReference> ref;
+			ComPtr<IDWriteFontFile> file;
+			const void* key = nullptr;
+			UINT32 keySize = 0;
+			std::wstring path;
+
+			ComPtr<IDWriteFont3> font = m_table->GetFont(i);
+			if (font != nullptr
+				&& SUCCEEDED(font->GetFontFaceReference(&ref))
+				&& SUCCEEDED(ref->GetFontFile(&file))
+				&& SUCCEEDED(file->GetReferenceKey(&key, &keySize))
+				&& GetLocalPath(file.Get(), key, keySize, path))
+			{
+				auto it = indices.find(path);
+				if (it != indices.end())
+					fileIndices[i] = it->second;
+			}
+		});
+
+	for (uint32_t i = 0; i < size; i++)
+	{
+		if (fileIndices[i] != UINT32_MAX)
+			m_fileRows[fileIndices[i]].push_back(i);
+	}
+}
+
+IVectorView<DWriteFontFace^>^ DWriteFontSet::GetFontsFromFile(int fileIndex)
+{
+	if (m_table == nullptr || fileIndex < 0 || static_cast<size_t>(fileIndex) >= m_fileRows.size())
+		return ref new FontFaceView(m_table, std::vector<uint32_t>());
+
+	return ref new FontFaceView(m_table, std::vector<uint32_t>(m_fileRows[fileIndex]));
+}
@@ -2,6 +2,7 @@
 
 #include "DWriteFontFamily.h"
 #include "DWriteFontFace.h"
+#include "DWriteFontSetDiff.h"
 
 using namespace Windows::Foundation::Collections;
 using namespace Platform::Collections;
@@ -26,44 +27,64 @@ namespace CharacterMapCX
 
 		property int CloudFontCount { int get() { return m_cloudCount; } }
 
+		/// <summary>
+		/// Number of variable faces known from the metadata cache. At least 1
+		/// if any face wasn't cached, as those aren't checked up front.
+		/// </summary>
 		property int VariableFontCount { int get() { return m_varCount; } }
 
 		/* Non-simulated font face count */
 		property int FaceCount { int get() { return m_faceCount; } }
 
-		DWriteFontSet^ Inflate()
-		{
-			for each (auto family in m_families)
-				family->Inflate();
-
-			this->Update();
-			return this;
-		}
-
-		void Update()
-		{
-			int appxCount = 0;
-			int cloudCount = 0;
-
-			auto fonts = ref new Vector<DWriteFontFace^>();
-
-			for each (auto family in m_families)
-			{
-				for each (auto font in family->m_fonts)
-				{
-					fonts->Append(font);
-					if (font->m_dwProperties->m_source == DWriteFontSource::AppxPackage)
-						m_appxCount++;
-
-					if (!font->m_dwProperties->m_isSimulated)
-						m_faceCount++;
-				}
-			}
-
-			m_fonts = fonts->GetView();
-		}
+		/// <summary>
+		/// Reads the faces of every family in parallel, then updates Fonts.
+		/// Face objects are only created as they're read from Fonts or a
+		/// family.
+		/// </summary>
+		DWriteFontSet^ Inflate();
+
+		/// <summary>
+		/// Recounts the set and rebuilds Fonts from its faces.
+		/// </summary>
+		void Update();
+
+		/// <summary>
+		/// Gets the faces of the set, optionally leaving out simulated ones.
+		/// Faces that are left out are never created.
+		/// </summary>
+		IVectorView<DWriteFontFace^>^ GetFonts(bool includeSimulated);
+
+		/// <summary>
+		/// Finds a face by family name and style, or returns nullptr.
+		/// </summary>
+		DWriteFontFace^ FindFace(String^ familyName, FontWeight weight, FontStretch stretch, FontStyle style);
+
+		/// <summary>
+		/// Gets the faces that came from one of the files a merged set was
+		/// loaded from, by the file's index in the list it was loaded with.
+		/// </summary>
+		IVectorView<DWriteFontFace^>^ GetFontsFromFile(int fileIndex);
 
 	internal:
+		/// <summary>
+		/// Inflates the set, creating faces from the font metadata store
+		/// where it has them.
+		/// </summary>
+		DWriteFontSet^ InflateFromStore(FontMetadataStore* store);
+
+		/// <summary>
+		/// Replaces the families of an inflated set with those of a newer
+		/// collection. Faces that are still present are kept as they are,
+		/// so only added or modified fonts have faces created for them.
+		/// </summary>
+		DWriteFontSetDiff^ Patch(IVectorView<DWriteFontFamily^>^ families);
+
+		/// <summary>
+		/// Records which of a list of files each face of an inflated set
+		/// was loaded from, for GetFontsFromFile.
+		/// </summary>
+		void SetSourceFiles(const std::vector<std::wstring>& paths);
+
 		DWriteFontSet(IVectorView<DWriteFontFamily^>^ families)
 		{
 			m_families = families;
@@ -87,11 +108,13 @@ namespace CharacterMapCX
 		int _ls = 0;
 		wchar_t* _locale = nullptr;
 
+		std::shared_ptr<FontFaceTable> m_table = nullptr;
+		std::vector<std::vector<uint32_t>> m_fileRows;
 		IVectorView<DWriteFontFace^>^ m_fonts = nullptr;
 		IVectorView<DWriteFontFamily^>^ m_families = nullptr;
 		int m_appxCount = 0;
 		int m_cloudCount = 0;
-		int m_varCount = 1;
-		int m_faceCount = 1;
+		int m_varCount = 0;
+		int m_faceCount = 0;
 	};
 }
\ No newline at end of file
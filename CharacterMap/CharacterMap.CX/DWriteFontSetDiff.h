@@ -0,0 +1,71 @@
+#pragma once
+
+#include "DWriteFontFace.h"
+
+using namespace Windows::Foundation::Collections;
+using namespace Platform::Collections;
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Faces that changed when a DWriteFontSet was patched to match a newer
+	/// font collection. Faces are matched by the file they come from and
+	/// their index in it.
+	/// </summary>
+	public ref class DWriteFontSetDiff sealed
+	{
+	public:
+		property IVectorView<DWriteFontFace^>^ Added
+		{
+			IVectorView<DWriteFontFace^>^ get() { return m_added; }
+		}
+
+		property IVectorView<DWriteFontFace^>^ Removed
+		{
+			IVectorView<DWriteFontFace^>^ get() { return m_removed; }
+		}
+
+		/// <summary>
+		/// New faces for font files that were modified in place.
+		/// </summary>
+		property IVectorView<DWriteFontFace^>^ Changed
+		{
+			IVectorView<DWriteFontFace^>^ get() { return m_changed; }
+		}
+
+		/// <summary>
+		/// The faces replaced by Changed, in the same order.
+		/// </summary>
+		property IVectorView<DWriteFontFace^>^ Previous
+		{
+			IVectorView<DWriteFontFace^>^ get() { return m_previous; }
+		}
+
+		property bool IsEmpty
+		{
+			bool get() { return m_added->Size == 0 && m_removed->Size == 0 && m_changed->Size == 0; }
+		}
+
+	internal:
+		DWriteFontSetDiff(
+			std::vector<DWriteFontFace^>&& added,
+			std::vector<DWriteFontFace^>&& removed,
+			std::vector<DWriteFontFace^>&& changed,
+			std::vector<DWriteFontFace^>&& previous)
+		{
+			m_added = (ref new Vector<DWriteFontFace^>(std::move(added)))->GetView();
+			m_removed = (ref new Vector<DWriteFontFace^>(std::move(removed)))->GetView();
+			m_changed = (ref new Vector<DWriteFontFace^>(std::move(changed)))->GetView();
+			m_previous = (ref new Vector<DWriteFontFace^>(std::move(previous)))->GetView();
+		}
+
+		DWriteFontSetDiff()
+			: DWriteFontSetDiff({}, {}, {}, {}) { }
+
+	private:
+		IVectorView<DWriteFontFace^>^ m_added;
+		IVectorView<DWriteFontFace^>^ m_removed;
+		IVectorView<DWriteFontFace^>^ m_changed;
+		IVectorView<DWriteFontFace^>^ m_previous;
+	};
+}
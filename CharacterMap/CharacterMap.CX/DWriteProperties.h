@@ -4,6 +4,7 @@
 #include "GlyphImageFormat.h"
 #include "DWriteFontSource.h"
 #include "DWriteFontSimulations.h"
+#include "FontFaceStore.h"
 
 using namespace Windows::Foundation;
 using namespace Windows::Foundation::Collections;
@@ -24,7 +25,7 @@ namespace CharacterMapCX
 
 		property bool IsSimulated { bool get() { return m_isSimulated; } }
 
-		property bool IsMonospacedFont { bool get() { return m_font->IsMonospacedFont(); } }
+		property bool IsMonospacedFont { bool get() { return m_hasMetadata ? m_isMonospaced : m_font->IsMonospacedFont(); } }
 
 		property bool IsColorFont { bool get() { return m_isColorFont; } }
 
@@ -72,7 +73,10 @@ namespace CharacterMapCX
 		property Array<UINT8>^ Panose { Array<UINT8>^ get() 
 		{
 			DWRITE_PANOSE pan[10];
-			m_font->GetPanose(pan);
+			if (m_hasMetadata)
+				memcpy(pan, m_panose, sizeof(m_panose));
+			else
+				m_font->GetPanose(pan);
 
 			bool valid = false;
 			for (int i = 0; i < 10; i++)
@@ -131,9 +135,61 @@ namespace CharacterMapCX
 			m_hasVariations = hasVariations;
 		}
 
+		/// <summary>
+		/// Creates properties from a face's row in a FontFaceStore, so
+		/// nothing needs to be read from the font file. Panose may be null.
+		/// </summary>
+		DWriteProperties(DWriteFontSource source, String^ familyName, String^ faceName, uint32_t packed, UINT32 glyphCount, const uint8_t* panose, ComPtr<IDWriteFont3> font)
+		{
+			uint32_t flags = FontFaceStore::Flags(packed);
+
+			m_weight = Windows::UI::Text::FontWeight{ static_cast<uint16_t>(FontFaceStore::Weight(packed)) };
+			m_style = static_cast<Windows::UI::Text::FontStyle>(FontFaceStore::Style(packed));
+			m_stretch = static_cast<Windows::UI::Text::FontStretch>(FontFaceStore::Stretch(packed));
+
+			m_isSymbolFont = (flags & FontFaceSymbol) != 0;
+			m_isColorFont = (flags & FontFaceColor) != 0;
+
+			// Only the metadata cache knows whether a face is variable, from
+			// the same HasVariations call the getter makes
+			m_hasVariations = (flags & FontFaceVariable) != 0;
+			m_loadedVariations = (flags & FontFaceCached) != 0;
+
+			if (flags & FontFaceCached)
+			{
+				m_isMonospaced = (flags & FontFaceMonospaced) != 0;
+				m_glyphCount = glyphCount;
+				if (panose != nullptr)
+					memcpy(m_panose, panose, sizeof(m_panose));
+				m_hasMetadata = true;
+			}
+
+			m_font = font;
+
+			m_source = source;
+			m_familyName = familyName;
+			m_faceName = faceName;
+
+			m_simulations = static_cast<DWriteFontSimulations>(font->GetSimulations());
+			m_isSimulated = (flags & FontFaceSimulated) != 0;
+		}
+
 		bool m_isSimulated = false;
 		DWriteFontSource m_source = DWriteFontSource::Unknown;
 
+		/// <summary>
+		/// Glyph count from the metadata cache, or 0 if it wasn't used.
+		/// </summary>
+		UINT32 m_glyphCount = 0;
+
+		/// <summary>
+		/// IDs of FamilyName and FaceName in the shared FontNameTable, or
+		/// NotFound for faces that weren't created from a FontFaceStore.
+		/// Faces with the same ID have the same name.
+		/// </summary>
+		uint32_t m_familyId = FontNameTable::NotFound;
+		uint32_t m_faceNameId = FontNameTable::NotFound;
+
 	private:
 		inline DWriteProperties() { }
 
@@ -176,6 +232,9 @@ namespace CharacterMapCX
 		bool m_hasVariations = false;
 		bool m_isColorFont = false;
 		bool m_isSymbolFont = false;
+		bool m_isMonospaced = false;
+		bool m_hasMetadata = false;
+		UINT8 m_panose[10] = {};
 		String^ m_remoteSource = nullptr;
 		String^ m_familyName = nullptr;
 		String^ m_faceName = nullptr;
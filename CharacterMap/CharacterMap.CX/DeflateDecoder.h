@@ -0,0 +1,479 @@
+#pragma once
+
+#include <cstring>
+#include "SfntData.h"
+
+/*
+	Decodes zlib (RFC 1950) and raw DEFLATE (RFC 1951) data into a buffer of
+	known size, such as a WOFF table whose original length is in the table
+	directory.
+
+	Nothing is allocated: the output is written straight into the caller's
+	buffer and the Huffman tables live on the stack, so one decoder per
+	thread can run with no shared state. Codes of up to FastBits bits, which
+	are nearly all of them, are decoded with one table lookup; longer ones
+	fall back to walking the canonical code counts.
+*/
+
+namespace CharacterMapCX
+{
+	class DeflateDecoder
+	{
+	public:
+		/// <summary>
+		/// Decodes a zlib stream into output, which must be exactly the size
+		/// of the decoded data. Fails if the data is malformed, decodes to
+		/// a different size, or its Adler-32 checksum doesn't match.
+		/// </summary>
+		static bool InflateZlib(ByteSpan input, uint8_t* output, uint32_t outputSize)
+		{
+			if (input.Size < 6)
+				return false;
+
+			// Deflate with a window of at most 32K and no preset dictionary
+			uint8_t cmf = input.UInt8(0);
+			uint8_t flg = input.UInt8(1);
+			if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || (flg & 0x20) != 0 || ((cmf << 8) | flg) % 31 != 0)
+				return false;
+
+			BitReader bits(input.Slice(2));
+			uint32_t written = 0;
+			if (!Inflate(bits, output, outputSize, written) || written != outputSize)
+				return false;
+
+			uint32_t adler = 0;
+			return bits.ReadAlignedUInt32(adler) && adler == Adler32(output, outputSize);
+		}
+
+		/// <summary>
+		/// Decodes raw DEFLATE data into output. written is set to the
+		/// number of bytes decoded.
+		/// </summary>
+		static bool InflateRaw(ByteSpan input, uint8_t* output, uint32_t outputSize, uint32_t& written)
+		{
+			BitReader bits(input);
+			written = 0;
+			return Inflate(bits, output, outputSize, written);
+		}
+
+		static uint32_t Adler32(const uint8_t* data, uint32_t size)
+		{
+			const uint32_t mod = 65521;
+			uint32_t a = 1;
+			uint32_t b = 0;
+
+			// 5552 is the most bytes that can be summed before b overflows
+			while (size > 0)
+			{
+				uint32_t block = size < 5552 ? size : 5552;
+				size -= block;
+				while (block-- > 0)
+				{
+					a += *data++;
+					b += a;
+				}
+
+				a %= mod;
+				b %= mod;
+			}
+
+			return (b << 16) | a;
+		}
+
+	private:
+		static const uint32_t MaxBits = 15;
+		static const uint32_t FastBits = 10;
+
+		/// <summary>
+		/// Reads bits least significant first, as DEFLATE packs them. Past
+		/// the end of the input it reads zeros, and remembers that it did
+		/// so a decode that relied on them can be failed.
+		/// </summary>
+		class BitReader
+		{
+		public:
+			BitReader(ByteSpan input) : m_next(input.Data), m_end(input.Data + input.Size) { }
+
+			void Refill()
+			{
+				while (m_count <= 56)
+				{
+					uint64_t byte = 0;
+					if (m_next < m_end)
+						byte = *m_next++;
+					else
+						m_padding++;
+
+					m_buffer |= byte << m_count;
+					m_count += 8;
+				}
+			}
+
+			/// <summary>
+			/// Peeks at up to 32 bits. Call Refill first.
+			/// </summary>
+			uint32_t Peek(uint32_t n) const
+			{
+				return static_cast<uint32_t>(m_buffer & ((1ull << n) - 1));
+			}
+
+			void Consume(uint32_t n)
+			{
+				m_buffer >>= n;
+				m_count -= n;
+			}
+
+			uint32_t Read(uint32_t n)
+			{
+				if (n == 0)
+					return 0;
+
+				Refill();
+				uint32_t value = Peek(n);
+				Consume(n);
+				return value;
+			}
+
+			/// <summary>
+			/// True if more bits have been consumed than the input held.
+			/// </summary>
+			bool IsOverrun() const
+			{
+				return m_count < m_padding * 8;
+			}
+
+			void AlignToByte()
+			{
+				Consume(m_count % 8);
+			}
+
+			bool ReadAlignedUInt32(uint32_t& value)
+			{
+				AlignToByte();
+				value = 0;
+				for (int i = 0; i < 4; i++)
+					value = (value << 8) | Read(8);
+
+				return !IsOverrun();
+			}
+
+			/// <summary>
+			/// Copies whole bytes for a stored block. The reader must be
+			/// byte aligned.
+			/// </summary>
+			bool CopyBytes(uint8_t* output, uint32_t length)
+			{
+				// Drain what's already buffered without refilling, so the
+				// rest can be copied straight from the input
+				while (length > 0 && m_count >= 8)
+				{
+					*output++ = static_cast<uint8_t>(Peek(8));
+					Consume(8);
+					length--;
+				}
+
+				if (IsOverrun() || length > static_cast<size_t>(m_end - m_next))
+					return false;
+
+				memcpy(output, m_next, length);
+				m_next += length;
+				return true;
+			}
+
+		private:
+			const uint8_t* m_next;
+			const uint8_t* m_end;
+			uint64_t m_buffer = 0;
+			uint32_t m_count = 0;
+			uint32_t m_padding = 0;
+		};
+
+		/// <summary>
+		/// A canonical Huffman code, decoded through a lookup on its first
+		/// FastBits bits.
+		/// </summary>
+		struct Huffman
+		{
+			// Symbol << 4 | code length, or 0 for codes longer than FastBits
+			uint16_t Fast[1 << FastBits];
+			uint16_t Counts[MaxBits + 1];
+			uint16_t Symbols[288];
+
+			/// <summary>
+			/// Builds the code from each symbol's code length. Incomplete
+			/// codes are allowed, as DEFLATE uses them for single distance
+			/// codes; over-subscribed ones are not.
+			/// </summary>
+			bool Build(const uint8_t* lengths, uint32_t count)
+			{
+				memset(Counts, 0, sizeof(Counts));
+				memset(Fast, 0, sizeof(Fast));
+
+				for (uint32_t i = 0; i < count; i++)
+					Counts[lengths[i]]++;
+				Counts[0] = 0;
+
+				int32_t left = 1;
+				for (uint32_t len = 1; len <= MaxBits; len++)
+				{
+					left <<= 1;
+					left -= Counts[len];
+					if (left < 0)
+						return false;
+				}
+
+				uint16_t offsets[MaxBits + 2] = {};
+				uint32_t nextCode[MaxBits + 1] = {};
+				uint32_t code = 0;
+				for (uint32_t len = 1; len <= MaxBits; len++)
+				{
+					offsets[len + 1] = offsets[len] + Counts[len];
+					code = (code + Counts[len - 1]) << 1;
+					nextCode[len] = code;
+				}
+
+				for (uint32_t symbol = 0; symbol < count; symbol++)
+				{
+					uint32_t len = lengths[symbol];
+					if (len == 0)
+						continue;
+
+					Symbols[offsets[len]++] = static_cast<uint16_t>(symbol);
+
+					uint32_t c = nextCode[len]++;
+					if (len > FastBits)
+						continue;
+
+					// Codes are packed most significant bit first, so the
+					// lookup index is the code reversed
+					uint32_t reversed = 0;
+					for (uint32_t i = 0; i < len; i++)
+						reversed |= ((c >> i) & 1) << (len - 1 - i);
+
+					for (uint32_t i = reversed; i < (1u << FastBits); i += 1u << len)
+						Fast[i] = static_cast<uint16_t>((symbol << 4) | len);
+				}
+
+				return true;
+			}
+
+			/// <summary>
+			/// Returns the next symbol, or -1 if the bits aren't a code.
+			/// </summary>
+			int Decode(BitReader& bits) const
+			{
+				bits.Refill();
+
+				uint16_t entry = Fast[bits.Peek(FastBits)];
+				if (entry != 0)
+				{
+					bits.Consume(entry & 0xF);
+					return entry >> 4;
+				}
+
+				uint32_t peek = bits.Peek(MaxBits);
+				int32_t code = 0;
+				int32_t first = 0;
+				int32_t index = 0;
+				for (uint32_t len = 1; len <= MaxBits; len++)
+				{
+					code |= (peek >> (len - 1)) & 1;
+					int32_t count = Counts[len];
+					if (code - first < count)
+					{
+						bits.Consume(len);
+						return Symbols[index + (code - first)];
+					}
+
+					index += count;
+					first = (first + count) << 1;
+					code <<= 1;
+				}
+
+				return -1;
+			}
+		};
+
+		static bool Inflate(BitReader& bits, uint8_t* output, uint32_t outputSize, uint32_t& written)
+		{
+			bool final = false;
+			while (!final)
+			{
+				final = bits.Read(1) != 0;
+				uint32_t type = bits.Read(2);
+
+				bool ok = false;
+				if (type == 0)
+					ok = InflateStored(bits, output, outputSize, written);
+				else if (type == 1)
+					ok = InflateFixed(bits, output, outputSize, written);
+				else if (type == 2)
+					ok = InflateDynamic(bits, output, outputSize, written);
+
+				if (!ok || bits.IsOverrun())
+					return false;
+			}
+
+			return true;
+		}
+
+		static bool InflateStored(BitReader& bits, uint8_t* output, uint32_t outputSize, uint32_t& written)
+		{
+			bits.AlignToByte();
+			uint32_t length = bits.Read(16);
+			uint32_t inverse = bits.Read(16);
+			if (length != (~inverse & 0xFFFF) || length > outputSize - written)
+				return false;
+
+			if (!bits.CopyBytes(output + written, length))
+				return false;
+
+			written += length;
+			return true;
+		}
+
+		static bool InflateFixed(BitReader& bits, uint8_t* output, uint32_t outputSize, uint32_t& written)
+		{
+			uint8_t lengths[288 + 30];
+			uint32_t i = 0;
+			for (; i < 144; i++) lengths[i] = 8;
+			for (; i < 256; i++) lengths[i] = 9;
+			for (; i < 280; i++) lengths[i] = 7;
+			for (; i < 288; i++) lengths[i] = 8;
+			for (; i < 288 + 30; i++) lengths[i] = 5;
+
+			Huffman literals;
+			Huffman distances;
+			literals.Build(lengths, 288);
+			distances.Build(lengths + 288, 30);
+			return InflateCodes(bits, literals, distances, output, outputSize, written);
+		}
+
+		static bool InflateDynamic(BitReader& bits, uint8_t* output, uint32_t outputSize, uint32_t& written)
+		{
+			static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+			uint32_t literalCount = bits.Read(5) + 257;
+			uint32_t distanceCount = bits.Read(5) + 1;
+			uint32_t codeCount = bits.Read(4) + 4;
+			if (literalCount > 286 || distanceCount > 30)
+				return false;
+
+			uint8_t lengths[288 + 32] = {};
+			for (uint32_t i = 0; i < codeCount; i++)
+				lengths[order[i]] = static_cast<uint8_t>(bits.Read(3));
+
+			Huffman codes;
+			if (!codes.Build(lengths, 19))
+				return false;
+
+			uint32_t total = literalCount + distanceCount;
+			uint32_t index = 0;
+			memset(lengths, 0, sizeof(lengths));
+			while (index < total)
+			{
+				int symbol = codes.Decode(bits);
+				if (symbol < 0)
+					return false;
+
+				if (symbol < 16)
+				{
+					lengths[index++] = static_cast<uint8_t>(symbol);
+					continue;
+				}
+
+				uint8_t value = 0;
+				uint32_t repeat = 0;
+				if (symbol == 16)
+				{
+					if (index == 0)
+						return false;
+					value = lengths[index - 1];
+					repeat = 3 + bits.Read(2);
+				}
+				else if (symbol == 17)
+					repeat = 3 + bits.Read(3);
+				else
+					repeat = 11 + bits.Read(7);
+
+				if (index + repeat > total)
+					return false;
+
+				while (repeat-- > 0)
+					lengths[index++] = value;
+			}
+
+			// Without an end of block code the block can never finish
+			if (lengths[256] == 0)
+				return false;
+
+			Huffman literals;
+			Huffman distances;
+			if (!literals.Build(lengths, literalCount) || !distances.Build(lengths + literalCount, distanceCount))
+				return false;
+
+			return InflateCodes(bits, literals, distances, output, outputSize, written);
+		}
+
+		static bool InflateCodes(BitReader& bits, const Huffman& literals, const Huffman& distances, uint8_t* output, uint32_t outputSize, uint32_t& written)
+		{
+			static const uint16_t lengthBase[29] = {
+				3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+				35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			static const uint8_t lengthExtra[29] = {
+				0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+				3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			static const uint16_t distanceBase[30] = {
+				1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+				257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+				8193, 12289, 16385, 24577 };
+			static const uint8_t distanceExtra[30] = {
+				0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+				7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+			while (true)
+			{
+				int symbol = literals.Decode(bits);
+				if (symbol < 0)
+					return false;
+
+				if (symbol < 256)
+				{
+					if (written == outputSize)
+						return false;
+
+					output[written++] = static_cast<uint8_t>(symbol);
+					continue;
+				}
+
+				if (symbol == 256)
+					return true;
+
+				symbol -= 257;
+				if (symbol >= 29)
+					return false;
+
+				uint32_t length = lengthBase[symbol] + bits.Read(lengthExtra[symbol]);
+
+				int distanceSymbol = distances.Decode(bits);
+				if (distanceSymbol < 0 || distanceSymbol >= 30)
+					return false;
+
+				uint32_t distance = distanceBase[distanceSymbol] + bits.Read(distanceExtra[distanceSymbol]);
+				if (distance > written || length > outputSize - written)
+					return false;
+
+				// Copies may overlap the bytes they produce, so go forwards
+				uint8_t* to = output + written;
+				const uint8_t* from = to - distance;
+				for (uint32_t i = 0; i < length; i++)
+					to[i] = from[i];
+
+				written += length;
+
+				if (bits.IsOverrun())
+					return false;
+			}
+		}
+	};
+}
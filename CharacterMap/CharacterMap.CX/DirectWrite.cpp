@@ -2,6 +2,13 @@
 #include "pch.h"
 #include "CanvasTextLayoutAnalysis.h"
 #include "GsubTableReader.h"
+#include "SbixTable.h"
+#include "CbdtTable.h"
+#include "NativeBuffer.h"
+#include "FontTable.h"
+#include "GlyphFormatClassifier.h"
+#include "FontFileValidator.h"
+#include "MappedFile.h"
 
 
 #include "DWriteNamedFontAxisValue.h"
@@ -437,43 +444,27 @@ Platform::String^ DirectWrite::GetFileName(DWriteFontFace^ fontFace)
 bool DirectWrite::HasValidFonts(StorageFile^ file)
 {
 	/*
-	   To avoid garbage collection issues with CanvasFontSet in C# preventing us from
-	   immediately deleting the StorageFile, we shall do this here in C++
-	   */
-
-	auto path = file->Path->Data();
-	auto dwFontSet = CreateIDWriteFontSet(file->Path);
-	bool valid = false;
+		Checked straight from the file's bytes rather than by loading it
+		into DirectWrite, so nothing holds the file open afterwards and a
+		bad file is rejected without building a collection for it.
+
+		This includes checking the font has a family name. Although other
+		platforms and font renderers can read fonts without a FamilyName
+		set in the 'name' table (for example, WOFF fonts), XAML font
+		rendering does not support them. Our basic WOFF conversion may
+		give us fonts that are perfectly fine except for this missing field.
+	*/
 
-	if (dwFontSet->GetFontCount() > 0)
-	{
-		/*
-			We need to validate the font has a family name.
-			Although other platforms and font renderers can read and understand fonts 
-			without a FamilyName set in the 'name' table (for example, WOFF fonts), 
-			XAML font rendering engine does not support these types of fonts. 
-			Our basic WOFF conversion may give us fonts that are perfectly fine 
-			except for this missing field.
-
-			WOFF2 fonts may also give the same problem.
-
-		*/
-
-		ComPtr<IDWriteStringList> names;
-		dwFontSet->GetPropertyValues(
-			DWRITE_FONT_PROPERTY_ID_WIN32_FAMILY_NAME,
-			&names);
-
-		// We just need to *prove* there is a readable name - we don't need to 
-		// read it.
-		UINT32 nameLength;
-		names->GetStringLength(0, &nameLength);
-		valid = nameLength > 0;
-	}
+	MappedFile mapped(file->Path);
+	if (!mapped.IsOpen())
+		return false;
 
-	dwFontSet = nullptr;
+	return FontFileValidator::Validate(mapped.Data()) == FontFileStatus::Valid;
+}
 
-	return valid;
+void DirectWrite::ReleaseFontCollection(String^ path)
+{
+	CustomFontManager::GetInstance()->ReleaseFontCollection(path);
 }
 
 bool DirectWrite::IsFontLocal(DWriteFontFace^ fontFace)
@@ -502,33 +493,66 @@ bool DirectWrite::IsLocalFont(ComPtr<IDWriteFontFileLoader> loader, const void*
 	return true;
 }
 
-IAsyncOperation<bool>^ DirectWrite::SaveFontStreamAsync(ComPtr<IDWriteFontFileStream> fileStream, IOutputStream^ stream)
+/// <summary>
+/// Writes the chunk of a font file stream starting at offset, then chains
+/// the next chunk as a continuation, so no thread waits on the output
+/// stream. Each chunk is a fragment of the file wrapped in a buffer the
+/// stream reads from in place, so only one chunk is ever held open and
+/// nothing is copied on the way.
+/// </summary>
+static task<bool> SaveFontChunksAsync(
+	ComPtr<IDWriteFontFileStream> fileStream,
+	IOutputStream^ stream,
+	UINT64 offset,
+	UINT64 fileSize,
+	progress_reporter<UINT64> reporter,
+	cancellation_token token)
 {
-	return create_async([fileStream, stream]
+	if (offset >= fileSize)
+		return create_task(stream->FlushAsync());
+
+	const UINT64 chunkSize = 1024 * 1024;
+	uint32 size = static_cast<uint32>(fileSize - offset < chunkSize ? fileSize - offset : chunkSize);
+
+	return create_task([fileStream, stream, offset, size, token]
 		{
-			uint64 fileSize = 0;
-			fileStream->GetFileSize(&fileSize);
+			// Cancelling stops between chunks
+			if (token.is_canceled())
+				cancel_current_task();
 
-			// 1. Copy stream to byte array
-			void* context;
-			const void* fragment;
-			fileStream->ReadFileFragment(&fragment, 0, fileSize, &context);
-			auto b = (byte*)fragment;
+			const void* fragment = nullptr;
+			void* context = nullptr;
+			if (FAILED(fileStream->ReadFileFragment(&fragment, offset, size, &context)))
+				return task_from_result(0u);
 
-			// 2. Write the byte array to stream.
-			DataWriter^ w = ref new DataWriter(stream);
-			w->WriteBytes(Platform::ArrayReference<BYTE>(b, fileSize));
+			auto buffer = NativeBuffer::Create(
+				ByteSpan(fragment, size),
+				[fileStream, context] { fileStream->ReleaseFileFragment(context); });
 
-			return create_task(w->StoreAsync()).then([w, fileStream, context](bool result)
-				{
-					fileStream->ReleaseFileFragment(context);
-					delete w;
-					return task_from_result(result);
-				}, task_continuation_context::use_arbitrary());
+			return create_task(stream->WriteAsync(buffer));
+		}, token).then([=](unsigned int written)
+		{
+			if (written != size)
+				return task_from_result(false);
+
+			reporter.report(offset + size);
+			return SaveFontChunksAsync(fileStream, stream, offset + size, fileSize, reporter, token);
+		}, task_continuation_context::use_arbitrary());
+}
+
+IAsyncOperationWithProgress<bool, UINT64>^ DirectWrite::SaveFontStreamAsync(ComPtr<IDWriteFontFileStream> fileStream, IOutputStream^ stream)
+{
+	return create_async([fileStream, stream](progress_reporter<UINT64> reporter, cancellation_token token)
+		{
+			UINT64 fileSize = 0;
+			if (fileStream == nullptr || FAILED(fileStream->GetFileSize(&fileSize)))
+				return task_from_result(false);
+
+			return SaveFontChunksAsync(fileStream, stream, 0, fileSize, reporter, token);
 		});
 }
 
-IAsyncOperation<bool>^ DirectWrite::WriteToStreamAsync(DWriteFontFace^ fontFace, IOutputStream^ stream)
+IAsyncOperationWithProgress<bool, UINT64>^ DirectWrite::WriteToStreamAsync(DWriteFontFace^ fontFace, IOutputStream^ stream)
 {
 	// 1. Acquire the underlying FontLoader used to create the CanvasFontFace
 	ComPtr<IDWriteFontFaceReference> fontFaceRef = fontFace->GetReference();
@@ -549,7 +573,7 @@ IAsyncOperation<bool>^ DirectWrite::WriteToStreamAsync(DWriteFontFace^ fontFace,
 		return SaveFontStreamAsync(fileStream, stream);
 	}
 
-	return create_async([] { return task_from_result(false); });
+	return SaveFontStreamAsync(nullptr, stream);
 }
 
 IBuffer^ DirectWrite::GetImageDataBuffer(DWriteFontFace^ fontFace, UINT32 pixelsPerEm, UINT unicodeIndex, GlyphImageFormat format)
@@ -561,26 +585,125 @@ IBuffer^ DirectWrite::GetImageDataBuffer(DWriteFontFace^ fontFace, UINT32 pixels
 
 	// 2. Get index of glyph inside the font
 	UINT16 idx = 0;
-	auto arr = new UINT[1];
-	arr[0] = unicodeIndex;
-	auto hr3 = face5->GetGlyphIndices(arr, 1, &idx);
-	delete[] arr;
+	face5->GetGlyphIndices(&unicodeIndex, 1, &idx);
+
+	// 3. Bitmap glyphs can be read directly from the font tables, avoiding
+	//    DirectWrite having to prepare the image for us.
+	if ((format & (GlyphImageFormat::Png | GlyphImageFormat::Jpeg | GlyphImageFormat::Tiff)) != GlyphImageFormat::None)
+	{
+		if (IBuffer^ buffer = GetBitmapGlyphBuffer(face5, idx, pixelsPerEm, format))
+			return buffer;
+	}
 
-	// 3. Get the actual image data
+	// 4. Get the actual image data
 	DWRITE_GLYPH_IMAGE_DATA data;
 	void* context;
-	auto formats = face5->GetGlyphImageData(idx, pixelsPerEm, static_cast<DWRITE_GLYPH_IMAGE_FORMATS>(format), &data, &context);
+	if (FAILED(face5->GetGlyphImageData(idx, pixelsPerEm, static_cast<DWRITE_GLYPH_IMAGE_FORMATS>(format), &data, &context)))
+		return ref new Windows::Storage::Streams::Buffer(0);
+
+	// 5. Wrap the image data in a WinRT buffer. The data stays owned by 
+	//    DirectWrite and is released when the buffer is.
+	return NativeBuffer::Create(
+		ByteSpan(data.imageData, data.imageDataSize),
+		[face5, context] { face5->ReleaseGlyphImageData(context); });
+}
+
+GlyphFormatMap^ DirectWrite::GetGlyphFormats(DWriteFontFace^ fontFace)
+{
+	return GetGlyphFormats(fontFace->GetFontFace());
+}
+
+GlyphFormatMap^ DirectWrite::GetGlyphFormats(ComPtr<IDWriteFontFace3> face)
+{
+	ComPtr<IDWriteFontFace> f;
+	face.As(&f);
+
+	// Tables are released when this scope exits
+	FontTable head(f, DWRITE_MAKE_OPENTYPE_TAG('h', 'e', 'a', 'd'));
+	FontTable loca(f, DWRITE_MAKE_OPENTYPE_TAG('l', 'o', 'c', 'a'));
+	FontTable glyf(f, DWRITE_MAKE_OPENTYPE_TAG('g', 'l', 'y', 'f'));
+	FontTable cff(f, DWRITE_MAKE_OPENTYPE_TAG('C', 'F', 'F', ' '));
+	FontTable cff2(f, DWRITE_MAKE_OPENTYPE_TAG('C', 'F', 'F', '2'));
+	FontTable colr(f, DWRITE_MAKE_OPENTYPE_TAG('C', 'O', 'L', 'R'));
+	FontTable svg(f, DWRITE_MAKE_OPENTYPE_TAG('S', 'V', 'G', ' '));
+	FontTable sbix(f, DWRITE_MAKE_OPENTYPE_TAG('s', 'b', 'i', 'x'));
+	FontTable cblc(f, DWRITE_MAKE_OPENTYPE_TAG('C', 'B', 'L', 'C'));
+	FontTable cbdt(f, DWRITE_MAKE_OPENTYPE_TAG('C', 'B', 'D', 'T'));
+
+	GlyphFormatTables tables;
+	tables.NumGlyphs = face->GetGlyphCount();
+	tables.Head = head.Data();
+	tables.Loca = loca.Data();
+	tables.Glyf = glyf.Data();
+	tables.Cff = cff.Data();
+	tables.Cff2 = cff2.Data();
+	tables.Colr = colr.Data();
+	tables.Svg = svg.Data();
+	tables.Sbix = sbix.Data();
+	tables.Cblc = cblc.Data();
+	tables.Cbdt = cbdt.Data();
+
+	return ref new GlyphFormatMap(GlyphFormatClassifier::Classify(tables));
+}
+
+IBuffer^ DirectWrite::GetBitmapGlyphBuffer(ComPtr<IDWriteFontFace5> face, UINT16 glyphIndex, UINT32 pixelsPerEm, GlyphImageFormat format)
+{
+	const void* tableData;
+	UINT32 tableSize;
+	BOOL exists;
+	void* context;
 
-	// 4. Write image data to a WinRT buffer
-	auto b = (byte*)data.imageData;
-	DataWriter^ writer = ref new DataWriter();
-	writer->WriteBytes(Platform::ArrayReference<BYTE>(b, data.imageDataSize));
-	IBuffer^ buffer = writer->DetachBuffer();
+	uint16_t ppem = static_cast<uint16_t>(min(pixelsPerEm, 0xFFFFu));
+	BitmapGlyph glyph;
 
-	// 5. Cleanup
-	face5->ReleaseGlyphImageData(context);
-	delete writer;
+	// SBIX
+	if (SUCCEEDED(face->TryGetFontTable(DWRITE_MAKE_OPENTYPE_TAG('s', 'b', 'i', 'x'), &tableData, &tableSize, &context, &exists)))
+	{
+		if (exists)
+		{
+			SbixTable sbix;
+			if (sbix.Load(ByteSpan(tableData, tableSize), face->GetGlyphCount())
+				&& sbix.TryGetGlyph(glyphIndex, ppem, glyph)
+				&& (glyph.Format & static_cast<uint32_t>(format)) != 0)
+			{
+				// The buffer holds the table open until it is released
+				return NativeBuffer::Create(glyph.Data, [face, context] { face->ReleaseFontTable(context); });
+			}
+		}
+
+		face->ReleaseFontTable(context);
+	}
+
+	// CBLC / CBDT
+	// Only PNG data is stored in CBDT. CBLC is only needed for the lookup,
+	// but CBDT must stay open for as long as the buffer is alive.
+	if ((format & GlyphImageFormat::Png) == GlyphImageFormat::Png
+		&& SUCCEEDED(face->TryGetFontTable(DWRITE_MAKE_OPENTYPE_TAG('C', 'B', 'L', 'C'), &tableData, &tableSize, &context, &exists)))
+	{
+		if (exists)
+		{
+			const void* dataTable;
+			UINT32 dataSize;
+			BOOL dataExists;
+			void* dataContext;
+
+			if (SUCCEEDED(face->TryGetFontTable(DWRITE_MAKE_OPENTYPE_TAG('C', 'B', 'D', 'T'), &dataTable, &dataSize, &dataContext, &dataExists)))
+			{
+				CbdtTable cbdt;
+				if (dataExists
+					&& cbdt.Load(ByteSpan(tableData, tableSize), ByteSpan(dataTable, dataSize))
+					&& cbdt.TryGetGlyph(glyphIndex, ppem, glyph))
+				{
+					face->ReleaseFontTable(context);
+					return NativeBuffer::Create(glyph.Data, [face, dataContext] { face->ReleaseFontTable(dataContext); });
+				}
+
+				face->ReleaseFontTable(dataContext);
+			}
+		}
+
+		face->ReleaseFontTable(context);
+	}
 
-	// 6. Return buffer
-	return buffer;
+	return nullptr;
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "DWriteFontAxis.h"
 #include "DWriteFontFace.h"
 #include "DWriteKnownFontAxisValues.h"
+#include "GlyphFormatMap.h"
 
 using namespace Microsoft::Graphics::Canvas::Text;
 using namespace Microsoft::WRL;
@@ -41,12 +42,23 @@ namespace CharacterMapCX
 		/// </summary>
 		static IBuffer^ GetImageDataBuffer(DWriteFontFace^ fontFace, UINT32 pixelsPerEm, UINT unicodeIndex, GlyphImageFormat format);
 
+		/// <summary>
+		/// Classifies the image formats of every glyph in a font in one pass over its tables.
+		/// </summary>
+		static GlyphFormatMap^ GetGlyphFormats(DWriteFontFace^ fontFace);
+
 		/// <summary>
 		/// Verifies if a font file actually contains a font(s) usable by the system.
 		/// StorageFile needs to be in apps local storage due to permission restrictions.
 		/// </summary>
 		static bool HasValidFonts(StorageFile^ file);
 
+		/// <summary>
+		/// Releases the cached font collection for a font file. Call before
+		/// deleting the file, so it isn't held open.
+		/// </summary>
+		static void ReleaseFontCollection(String^ path);
+
 		/// <summary>
 		/// Verifies if a font is actually completely on a users system. Some cloud fonts may only be partially downloaded.
 		/// </summary>
@@ -54,8 +66,9 @@ namespace CharacterMapCX
 
 		/// <summary>
 		/// Writes the underlying source file of a FontFace to a stream. 
+		/// Progress is the number of bytes written so far.
 		/// </summary>
-		static IAsyncOperation<bool>^ WriteToStreamAsync(DWriteFontFace^ fontFace, IOutputStream^ stream);
+		static IAsyncOperationWithProgress<bool, UINT64>^ WriteToStreamAsync(DWriteFontFace^ fontFace, IOutputStream^ stream);
 
 		//static Platform::String^ GetFileName(CanvasFontFace^ fontFace);
 
@@ -79,6 +92,8 @@ namespace CharacterMapCX
 
 		static IMapView<UINT32, UINT32>^ GetSupportedTypography(ComPtr<IDWriteFontFaceReference> faceRef);
 
+		static GlyphFormatMap^ GetGlyphFormats(ComPtr<IDWriteFontFace3> face);
+
 		//static __inline DWriteFontSet^ GetFonts(ComPtr<IDWriteFontSet3> fontSet);
 
 		static ComPtr<IDWriteFontSet> DirectWrite::CreateIDWriteFontSet(String^ path);
@@ -89,7 +104,18 @@ namespace CharacterMapCX
 
 		static IVectorView<DWriteFontSet^>^ GetFonts(IVectorView<Uri^>^ uris, ComPtr<IDWriteFactory7> fac);
 
-		static IAsyncOperation<bool>^ SaveFontStreamAsync(ComPtr<IDWriteFontFileStream> fileStream, IOutputStream^ stream);
+		/// <summary>
+		/// Writes a font file stream to an output stream in bounded chunks,
+		/// straight from the stream's fragments. Returns false if the file
+		/// couldn't be read or fully written.
+		/// </summary>
+		static IAsyncOperationWithProgress<bool, UINT64>^ SaveFontStreamAsync(ComPtr<IDWriteFontFileStream> fileStream, IOutputStream^ stream);
+
+		/// <summary>
+		/// Returns a buffer viewing the embedded bitmap for a glyph directly inside 
+		/// the font's bitmap tables, or nullptr if the font has no matching image.
+		/// </summary>
+		static IBuffer^ GetBitmapGlyphBuffer(ComPtr<IDWriteFontFace5> face, UINT16 glyphIndex, UINT32 pixelsPerEm, GlyphImageFormat format);
 
 	private:
 		DirectWrite() { };
@@ -74,6 +74,24 @@ namespace CharacterMapCX
 		/// </summary>
 		property IMapView<int, String^>^ GlyphNameMappings { IMapView<int, String^>^ get() { ReadTables(); return m_mappings; } }
 
+		/// <summary>
+		/// Image formats of every glyph in the font, indexed by glyph index.
+		/// </summary>
+		property GlyphFormatMap^ GlyphFormats
+		{
+			GlyphFormatMap^ get()
+			{
+				if (m_glyphFormats == nullptr && m_ref != nullptr)
+				{
+					ComPtr<IDWriteFontFace3> face;
+					ThrowIfFailed(m_ref->CreateFontFace(&face));
+					m_glyphFormats = DirectWrite::GetGlyphFormats(face);
+				}
+
+				return m_glyphFormats;
+			}
+		}
+
 
 		FontAnalysis() { }
 
@@ -100,6 +118,7 @@ namespace CharacterMapCX
 		IVectorView<DWriteFontAxis^>^ m_axis;
 
 		IMapView<int, String^>^ m_mappings;
+		GlyphFormatMap^ m_glyphFormats;
 		ComPtr<IDWriteFontFaceReference> m_ref;
 
 		bool m_tables = false;
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "FontNameTable.h"
+
+/*
+	Flat, struct-of-arrays storage for the faces of a font set.
+
+	Each face is a row across a few parallel columns: family and face name
+	IDs from a FontNameTable, and one packed 32-bit word holding weight, style,
+	stretch, flags and source. Questions about the whole library, like how
+	many faces are simulated or which come from an APPX package, are then
+	a mask-and-compare over one contiguous column rather than a walk over
+	objects.
+
+	Packed layout
+		bits 0-9	weight (1 - 1000)
+		bits 10-11	style
+		bits 12-15	stretch
+		bits 16-23	FontFaceFlags
+		bits 24-31	source (DWriteFontSource)
+*/
+
+namespace CharacterMapCX
+{
+	enum FontFaceFlags : uint32_t
+	{
+		FontFaceSimulated = 1,
+		FontFaceColor = 2,
+		FontFaceSymbol = 4,
+		FontFaceVariable = 8,
+		FontFaceMonospaced = 16,
+
+		/// <summary>
+		/// Monospaced, glyph count and panose were read from the font
+		/// metadata cache. Otherwise they're read from the font when needed.
+		/// </summary>
+		FontFaceCached = 32,
+	};
+
+	class FontFaceStore
+	{
+	public:
+		FontFaceStore() : m_names(&FontNameTable::Shared()) { }
+
+		/// <summary>
+		/// Creates a store whose names are interned in the given table,
+		/// which must outlive it.
+		/// </summary>
+		explicit FontFaceStore(FontNameTable& names) : m_names(&names) { }
+
+		static const uint32_t WeightMask = 0x3FF;
+		static const uint32_t StyleShift = 10;
+		static const uint32_t StretchShift = 12;
+		static const uint32_t FlagsShift = 16;
+		static const uint32_t SourceShift = 24;
+
+		static const uint32_t StyleMask = 0x3u << StyleShift;
+		static const uint32_t StretchMask = 0xFu << StretchShift;
+		static const uint32_t SourceMask = 0xFFu << SourceShift;
+
+		static uint32_t Pack(uint32_t weight, uint32_t style, uint32_t stretch, uint32_t flags, uint32_t source)
+		{
+			return (weight & WeightMask)
+				| ((style << StyleShift) & StyleMask)
+				| ((stretch << StretchShift) & StretchMask)
+				| ((flags & 0xFF) << FlagsShift)
+				| ((source & 0xFF) << SourceShift);
+		}
+
+		static uint32_t Weight(uint32_t packed) { return packed & WeightMask; }
+		static uint32_t Style(uint32_t packed) { return (packed & StyleMask) >> StyleShift; }
+		static uint32_t Stretch(uint32_t packed) { return (packed & StretchMask) >> StretchShift; }
+		static uint32_t Flags(uint32_t packed) { return (packed >> FlagsShift) & 0xFF; }
+		static uint32_t Source(uint32_t packed) { return packed >> SourceShift; }
+
+		/// <summary>
+		/// Mask for testing FontFaceFlags in a packed word.
+		/// </summary>
+		static uint32_t FlagMask(uint32_t flags) { return (flags & 0xFF) << FlagsShift; }
+
+		/// <summary>
+		/// Value of the source bits for a source, to compare under SourceMask.
+		/// </summary>
+		static uint32_t SourceValue(uint32_t source) { return (source & 0xFF) << SourceShift; }
+
+		void Reserve(uint32_t count)
+		{
+			m_familyIds.reserve(count);
+			m_faceNameIds.reserve(count);
+			m_packed.reserve(count);
+			m_glyphCounts.reserve(count);
+			m_panose.reserve(count * 10);
+		}
+
+		/// <summary>
+		/// Adds a face, returning its index. Panose may be null.
+		/// </summary>
+		uint32_t Add(uint32_t familyId, uint32_t faceNameId, uint32_t packed, uint16_t glyphCount, const uint8_t* panose)
+		{
+			uint32_t index = Size();
+			m_familyIds.push_back(familyId);
+			m_faceNameIds.push_back(faceNameId);
+			m_packed.push_back(packed);
+			m_glyphCounts.push_back(glyphCount);
+			m_panose.resize(m_panose.size() + 10);
+			if (panose != nullptr)
+				std::memcpy(&m_panose[index * 10], panose, 10);
+
+			return index;
+		}
+
+		/// <summary>
+		/// Adds a face with the same values as one in another store.
+		/// </summary>
+		uint32_t AddFrom(const FontFaceStore& other, uint32_t index)
+		{
+			uint32_t familyId = other.m_familyIds[index];
+			uint32_t faceNameId = other.m_faceNameIds[index];
+			if (other.m_names != m_names)
+			{
+				familyId = m_names->Intern(other.m_names->Get(familyId).ToString());
+				faceNameId = m_names->Intern(other.m_names->Get(faceNameId).ToString());
+			}
+
+			return Add(familyId, faceNameId, other.m_packed[index], other.m_glyphCounts[index], other.Panose(index));
+		}
+
+		uint32_t Size() const { return static_cast<uint32_t>(m_packed.size()); }
+
+		uint32_t FamilyId(uint32_t index) const { return m_familyIds[index]; }
+		uint32_t FaceNameId(uint32_t index) const { return m_faceNameIds[index]; }
+		uint32_t Packed(uint32_t index) const { return m_packed[index]; }
+		uint16_t GlyphCount(uint32_t index) const { return m_glyphCounts[index]; }
+		const uint8_t* Panose(uint32_t index) const { return &m_panose[index * 10]; }
+
+		FontNameTable& Names() const { return *m_names; }
+
+		/// <summary>
+		/// Counts the faces whose packed word, under mask, equals value.
+		/// </summary>
+		uint32_t Count(uint32_t mask, uint32_t value) const
+		{
+			uint32_t count = 0;
+			const uint32_t* packed = m_packed.data();
+			size_t size = m_packed.size();
+			for (size_t i = 0; i < size; i++)
+				count += (packed[i] & mask) == value;
+
+			return count;
+		}
+
+		/// <summary>
+		/// Appends the index of each face whose packed word, under mask,
+		/// equals value.
+		/// </summary>
+		void Select(uint32_t mask, uint32_t value, std::vector<uint32_t>& indices) const
+		{
+			const uint32_t* packed = m_packed.data();
+			uint32_t size = Size();
+			for (uint32_t i = 0; i < size; i++)
+			{
+				if ((packed[i] & mask) == value)
+					indices.push_back(i);
+			}
+		}
+
+		/// <summary>
+		/// Finds the first face of a family whose packed word, under mask,
+		/// equals value. Returns false if there isn't one.
+		/// </summary>
+		bool Find(uint32_t familyId, uint32_t mask, uint32_t value, uint32_t& index) const
+		{
+			uint32_t size = Size();
+			for (uint32_t i = 0; i < size; i++)
+			{
+				if (m_familyIds[i] == familyId && (m_packed[i] & mask) == value)
+				{
+					index = i;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		std::vector<uint32_t> m_familyIds;
+		std::vector<uint32_t> m_faceNameIds;
+		std::vector<uint32_t> m_packed;
+		std::vector<uint16_t> m_glyphCounts;
+		std::vector<uint8_t> m_panose;
+		FontNameTable* m_names;
+	};
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "DWriteFontFace.h"
+#include "FontFaceStore.h"
+#include <mutex>
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// One face as it's read from DirectWrite, with its names interned in
+	/// the shared FontNameTable.
+	/// </summary>
+	struct FontFaceRecord
+	{
+		ComPtr<IDWriteFont3> Font;
+		uint32_t FamilyId = FontNameTable::NotFound;
+		uint32_t FaceNameId = FontNameTable::NotFound;
+		uint32_t Packed = 0;
+		uint16_t GlyphCount = 0;
+		uint8_t Panose[10] = {};
+	};
+
+	/// <summary>
+	/// The faces of a font set: a FontFaceStore plus the DirectWrite font
+	/// each row came from. The DWriteFontFace^ for a row is only created
+	/// the first time it's asked for.
+	/// </summary>
+	class FontFaceTable
+	{
+	public:
+		void Reserve(uint32_t count)
+		{
+			m_store.Reserve(count);
+			m_fonts.reserve(count);
+			m_faces.reserve(count);
+		}
+
+		uint32_t Add(const FontFaceRecord& record)
+		{
+			m_fonts.push_back(record.Font);
+			m_faces.push_back(nullptr);
+			return m_store.Add(record.FamilyId, record.FaceNameId, record.Packed, record.GlyphCount, record.Panose);
+		}
+
+		/// <summary>
+		/// Adds a row from another table, keeping its face if it has
+		/// already been created.
+		/// </summary>
+		uint32_t AddFrom(FontFaceTable& other, uint32_t index)
+		{
+			m_fonts.push_back(other.m_fonts[index]);
+			m_faces.push_back(other.TryGetCreatedFace(index));
+			return m_store.AddFrom(other.m_store, index);
+		}
+
+		uint32_t Size() const { return m_store.Size(); }
+
+		const FontFaceStore& Store() const { return m_store; }
+
+		ComPtr<IDWriteFont3> GetFont(uint32_t index) const { return m_fonts[index]; }
+
+		/// <summary>
+		/// Gets the face for a row, creating it on first use. Safe to call
+		/// from any thread.
+		/// </summary>
+		DWriteFontFace^ GetFace(uint32_t index)
+		{
+			Lock lock(m_mutex);
+
+			DWriteFontFace^ face = m_faces[index];
+			if (face == nullptr)
+			{
+				uint32_t packed = m_store.Packed(index);
+				auto props = ref new DWriteProperties(
+					static_cast<DWriteFontSource>(FontFaceStore::Source(packed)),
+					GetString(m_store.FamilyId(index)),
+					GetString(m_store.FaceNameId(index)),
+					packed,
+					m_store.GlyphCount(index),
+					m_store.Panose(index),
+					m_fonts[index]);
+
+				props->m_familyId = m_store.FamilyId(index);
+				props->m_faceNameId = m_store.FaceNameId(index);
+
+				face = ref new DWriteFontFace(m_fonts[index], props);
+				m_faces[index] = face;
+			}
+
+			return face;
+		}
+
+		/// <summary>
+		/// Gets the face for a row only if it has already been created.
+		/// </summary>
+		DWriteFontFace^ TryGetCreatedFace(uint32_t index)
+		{
+			Lock lock(m_mutex);
+			return m_faces[index];
+		}
+
+		/// <summary>
+		/// Finds the row of a face created by this table.
+		/// </summary>
+		bool IndexOf(DWriteFontFace^ face, uint32_t first, uint32_t count, uint32_t& index)
+		{
+			Lock lock(m_mutex);
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				if (m_faces[i] == face)
+				{
+					index = i;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		FontFaceStore m_store;
+		std::vector<ComPtr<IDWriteFont3>> m_fonts;
+		std::vector<DWriteFontFace^> m_faces;
+		std::mutex m_mutex;
+
+		/// <summary>
+		/// Converts an interned name once for the whole process, so every
+		/// face with that name shares one HSTRING.
+		/// </summary>
+		static String^ GetString(uint32_t id)
+		{
+			static std::mutex mutex;
+			static std::vector<String^> strings;
+
+			if (id == FontNameTable::NotFound)
+				return nullptr;
+
+			Lock lock(mutex);
+			if (id >= strings.size())
+				strings.resize(FontNameTable::Shared().Count());
+
+			if (strings[id] == nullptr)
+			{
+				FontName name = FontNameTable::Shared().Get(id);
+				strings[id] = ref new String(reinterpret_cast<const wchar_t*>(name.Data), name.Length);
+			}
+
+			return strings[id];
+		}
+	};
+}
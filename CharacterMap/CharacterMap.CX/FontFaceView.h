@@ -0,0 +1,123 @@
+#pragma once
+
+#include "FontFaceTable.h"
+
+using namespace Windows::Foundation::Collections;
+
+namespace CharacterMapCX
+{
+	ref class FontFaceViewIterator sealed : IIterator<DWriteFontFace^>
+	{
+	public:
+		virtual property DWriteFontFace^ Current
+		{
+			DWriteFontFace^ get()
+			{
+				if (m_index >= m_view->Size)
+					throw ref new ChangedStateException();
+
+				return m_view->GetAt(m_index);
+			}
+		}
+
+		virtual property bool HasCurrent
+		{
+			bool get() { return m_index < m_view->Size; }
+		}
+
+		virtual bool MoveNext()
+		{
+			if (m_index < m_view->Size)
+				m_index++;
+
+			return HasCurrent;
+		}
+
+		virtual unsigned int GetMany(WriteOnlyArray<DWriteFontFace^>^ items)
+		{
+			unsigned int count = m_view->GetMany(m_index, items);
+			m_index += count;
+			return count;
+		}
+
+	internal:
+		FontFaceViewIterator(IVectorView<DWriteFontFace^>^ view) : m_view(view) { }
+
+	private:
+		IVectorView<DWriteFontFace^>^ m_view;
+		unsigned int m_index = 0;
+	};
+
+	/// <summary>
+	/// A read-only list of faces backed by a FontFaceTable, either a range
+	/// of its rows or a list of row indices. Faces are created as they're
+	/// read, so a list that's only counted or partly read never creates the
+	/// rest.
+	/// </summary>
+	ref class FontFaceView sealed : IVectorView<DWriteFontFace^>
+	{
+	public:
+		virtual DWriteFontFace^ GetAt(unsigned int index)
+		{
+			if (index >= m_count)
+				throw ref new OutOfBoundsException();
+
+			return m_table->GetFace(RowAt(index));
+		}
+
+		virtual property unsigned int Size
+		{
+			unsigned int get() { return m_count; }
+		}
+
+		virtual bool IndexOf(DWriteFontFace^ value, unsigned int* index)
+		{
+			*index = 0;
+			for (unsigned int i = 0; i < m_count; i++)
+			{
+				if (m_table->TryGetCreatedFace(RowAt(i)) == value && value != nullptr)
+				{
+					*index = i;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		virtual unsigned int GetMany(unsigned int startIndex, WriteOnlyArray<DWriteFontFace^>^ items)
+		{
+			unsigned int i = 0;
+			for (; startIndex + i < m_count && i < items->Length; i++)
+				items[i] = m_table->GetFace(RowAt(startIndex + i));
+
+			return i;
+		}
+
+		virtual IIterator<DWriteFontFace^>^ First()
+		{
+			return ref new FontFaceViewIterator(this);
+		}
+
+	internal:
+		FontFaceView(std::shared_ptr<FontFaceTable> table, uint32_t first, uint32_t count)
+			: m_table(table), m_first(first), m_count(count) { }
+
+		FontFaceView(std::shared_ptr<FontFaceTable> table, std::vector<uint32_t>&& rows)
+			: m_table(table), m_rows(std::move(rows))
+		{
+			m_count = static_cast<uint32_t>(m_rows.size());
+		}
+
+	private:
+		uint32_t RowAt(uint32_t index) const
+		{
+			return m_rows.empty() ? m_first + index : m_rows[index];
+		}
+
+		std::shared_ptr<FontFaceTable> m_table;
+		std::vector<uint32_t> m_rows;
+		uint32_t m_first = 0;
+		uint32_t m_count = 0;
+	};
+}
@@ -0,0 +1,313 @@
+#pragma once
+
+#include "SfntData.h"
+
+/*
+	Checks that a font file is one the app can use, straight from its bytes,
+	without creating a DirectWrite collection for it.
+
+	A file passes if it's an sfnt (TrueType or OpenType) font whose table
+	directory fits inside the file, which has the tables every font needs
+	plus some source of glyphs, and whose name table has a readable family
+	name, or a TrueType collection with at least one such font. XAML can't
+	render a font without a family name, even if DirectWrite can load it, so
+	that's checked too.
+
+	WOFF and WOFF2 files are recognised and have their headers checked, but
+	are reported as needing to be unpacked, as DirectWrite can't load them
+	directly.
+*/
+
+namespace CharacterMapCX
+{
+	enum class FontFileStatus
+	{
+		Valid,
+
+		/// <summary>
+		/// A WOFF or WOFF2 file with a sane header. It must be converted to
+		/// an sfnt font before it can be used.
+		/// </summary>
+		NeedsUnpacking,
+
+		/// <summary>
+		/// Not a font format the app knows.
+		/// </summary>
+		UnknownFormat,
+
+		/// <summary>
+		/// A header, table directory or table runs outside the file.
+		/// </summary>
+		Truncated,
+
+		/// <summary>
+		/// A required table, or any table holding glyphs, is missing.
+		/// </summary>
+		MissingTable,
+
+		/// <summary>
+		/// A table is present but its contents don't make sense.
+		/// </summary>
+		BadTable,
+
+		/// <summary>
+		/// The name table has no readable family name.
+		/// </summary>
+		MissingFamilyName,
+	};
+
+	class FontFileValidator
+	{
+	public:
+		static constexpr uint32_t TrueTypeVersion = 0x00010000;
+		static constexpr uint32_t AppleTrueTypeTag = MakeSfntTag('t', 'r', 'u', 'e');
+		static constexpr uint32_t CffTag = MakeSfntTag('O', 'T', 'T', 'O');
+		static constexpr uint32_t CollectionTag = MakeSfntTag('t', 't', 'c', 'f');
+		static constexpr uint32_t WoffTag = MakeSfntTag('w', 'O', 'F', 'F');
+		static constexpr uint32_t Woff2Tag = MakeSfntTag('w', 'O', 'F', '2');
+
+		/// <summary>
+		/// Limits how much of a malformed collection is looked at.
+		/// </summary>
+		static constexpr uint32_t MaxCollectionFonts = 1024;
+
+		static FontFileStatus Validate(ByteSpan file)
+		{
+			if (!file.Contains(0, 12))
+				return FontFileStatus::Truncated;
+
+			uint32_t tag = file.UInt32(0);
+			if (tag == CollectionTag)
+				return ValidateCollection(file);
+
+			if (tag == WoffTag)
+				return ValidateWoff(file);
+
+			if (tag == Woff2Tag)
+				return ValidateWoff2(file);
+
+			return ValidateFont(file, 0);
+		}
+
+		/// <summary>
+		/// Validates the font whose offset table starts at offset. Table
+		/// offsets are from the start of the file, as in a collection.
+		/// </summary>
+		static FontFileStatus ValidateFont(ByteSpan file, uint32_t offset)
+		{
+			if (!file.Contains(offset, 12))
+				return FontFileStatus::Truncated;
+
+			uint32_t version = file.UInt32(offset);
+			if (version != TrueTypeVersion && version != AppleTrueTypeTag && version != CffTag)
+				return FontFileStatus::UnknownFormat;
+
+			uint16_t numTables = file.UInt16(offset + 4);
+			if (numTables == 0 || !file.Contains(offset + 12, numTables * 16u))
+				return FontFileStatus::Truncated;
+
+			FontTables tables;
+			for (uint32_t i = 0; i < numTables; i++)
+			{
+				uint32_t record = offset + 12 + i * 16;
+				uint32_t tableOffset = file.UInt32(record + 8);
+				uint32_t length = file.UInt32(record + 12);
+				if (!file.Contains(tableOffset, length))
+					return FontFileStatus::Truncated;
+
+				tables.Set(file.UInt32(record), file.Slice(tableOffset, length));
+			}
+
+			return ValidateTables(tables);
+		}
+
+	private:
+		struct FontTables
+		{
+			ByteSpan Head;
+			ByteSpan Name;
+			ByteSpan Maxp;
+			ByteSpan Cmap;
+			ByteSpan Hhea;
+			ByteSpan Hmtx;
+			bool HasGlyphs = false;
+
+			void Set(uint32_t tag, ByteSpan data)
+			{
+				switch (tag)
+				{
+				case MakeSfntTag('h', 'e', 'a', 'd'): Head = data; break;
+				case MakeSfntTag('n', 'a', 'm', 'e'): Name = data; break;
+				case MakeSfntTag('m', 'a', 'x', 'p'): Maxp = data; break;
+				case MakeSfntTag('c', 'm', 'a', 'p'): Cmap = data; break;
+				case MakeSfntTag('h', 'h', 'e', 'a'): Hhea = data; break;
+				case MakeSfntTag('h', 'm', 't', 'x'): Hmtx = data; break;
+				case MakeSfntTag('g', 'l', 'y', 'f'):
+				case MakeSfntTag('C', 'F', 'F', ' '):
+				case MakeSfntTag('C', 'F', 'F', '2'):
+				case MakeSfntTag('C', 'B', 'D', 'T'):
+				case MakeSfntTag('E', 'B', 'D', 'T'):
+				case MakeSfntTag('s', 'b', 'i', 'x'):
+					HasGlyphs = true;
+					break;
+				}
+			}
+		};
+
+		static FontFileStatus ValidateTables(const FontTables& tables)
+		{
+			if (tables.Head.IsEmpty() || tables.Name.IsEmpty() || tables.Maxp.IsEmpty()
+				|| tables.Cmap.IsEmpty() || tables.Hhea.IsEmpty() || tables.Hmtx.IsEmpty()
+				|| !tables.HasGlyphs)
+				return FontFileStatus::MissingTable;
+
+			// head is 54 bytes, with a fixed magic number at 12
+			if (tables.Head.Size < 54 || tables.Head.UInt32(12) != 0x5F0F3CF5)
+				return FontFileStatus::BadTable;
+
+			if (tables.Maxp.Size < 6 || tables.Maxp.UInt16(4) == 0)
+				return FontFileStatus::BadTable;
+
+			return HasFamilyName(tables.Name)
+				? FontFileStatus::Valid
+				: FontFileStatus::MissingFamilyName;
+		}
+
+		/// <summary>
+		/// Looks for a non-empty family name (name ID 1) in UTF-16, which
+		/// is what DirectWrite reads the Win32 family name from, or failing
+		/// that a Macintosh one, which DirectWrite falls back to.
+		/// </summary>
+		static bool HasFamilyName(ByteSpan name)
+		{
+			uint16_t count = name.UInt16(2);
+			uint16_t storageOffset = name.UInt16(4);
+			if (!name.Contains(6, count * 12u))
+				return false;
+
+			ByteSpan storage = name.Slice(storageOffset);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				uint32_t record = 6 + i * 12;
+				uint16_t platformId = name.UInt16(record);
+				uint16_t encodingId = name.UInt16(record + 2);
+				uint16_t nameId = name.UInt16(record + 6);
+				uint16_t length = name.UInt16(record + 8);
+				uint16_t offset = name.UInt16(record + 10);
+
+				if (nameId != 1 || length == 0 || !storage.Contains(offset, length))
+					continue;
+
+				// Macintosh names use single or multi-byte encodings, where
+				// any byte other than a space or null is part of a name
+				if (platformId == 1)
+				{
+					for (uint32_t c = 0; c < length; c++)
+					{
+						uint8_t ch = storage.UInt8(offset + c);
+						if (ch != 0 && ch != ' ')
+							return true;
+					}
+
+					continue;
+				}
+
+				// Unicode, or Windows Symbol, BMP or full repertoire
+				bool isUtf16 = platformId == 0
+					|| (platformId == 3 && (encodingId == 0 || encodingId == 1 || encodingId == 10));
+				if (!isUtf16)
+					continue;
+
+				for (uint32_t c = 0; c + 1 < length; c += 2)
+				{
+					uint16_t ch = storage.UInt16(offset + c);
+					if (ch != 0 && ch != ' ')
+						return true;
+				}
+			}
+
+			return false;
+		}
+
+		/// <summary>
+		/// A collection passes if any font in it does, as DirectWrite will
+		/// still load the rest. Otherwise the first font's problem is
+		/// reported.
+		/// </summary>
+		static FontFileStatus ValidateCollection(ByteSpan file)
+		{
+			uint32_t numFonts = file.UInt32(8);
+			if (numFonts == 0 || numFonts > MaxCollectionFonts)
+				return FontFileStatus::BadTable;
+
+			if (!file.Contains(12, numFonts * 4))
+				return FontFileStatus::Truncated;
+
+			FontFileStatus first = FontFileStatus::Valid;
+			for (uint32_t i = 0; i < numFonts; i++)
+			{
+				FontFileStatus status = ValidateFont(file, file.UInt32(12 + i * 4));
+				if (status == FontFileStatus::Valid)
+					return status;
+
+				if (i == 0)
+					first = status;
+			}
+
+			return first;
+		}
+
+		/// <summary>
+		/// Checks the WOFF header and that its table directory and every
+		/// table's compressed data lie inside the file.
+		/// </summary>
+		static FontFileStatus ValidateWoff(ByteSpan file)
+		{
+			const uint32_t headerSize = 44;
+			if (file.Size < headerSize)
+				return FontFileStatus::Truncated;
+
+			if (file.UInt32(8) > file.Size)
+				return FontFileStatus::Truncated;
+
+			uint16_t numTables = file.UInt16(12);
+			if (numTables == 0 || !file.Contains(headerSize, numTables * 20u))
+				return FontFileStatus::Truncated;
+
+			bool hasName = false;
+			for (uint32_t i = 0; i < numTables; i++)
+			{
+				uint32_t record = headerSize + i * 20;
+				uint32_t offset = file.UInt32(record + 4);
+				uint32_t compLength = file.UInt32(record + 8);
+				uint32_t origLength = file.UInt32(record + 12);
+				if (!file.Contains(offset, compLength) || compLength > origLength)
+					return FontFileStatus::Truncated;
+
+				hasName |= file.UInt32(record) == MakeSfntTag('n', 'a', 'm', 'e');
+			}
+
+			return hasName ? FontFileStatus::NeedsUnpacking : FontFileStatus::MissingTable;
+		}
+
+		/// <summary>
+		/// WOFF2 tables are compressed as one stream, so only the header
+		/// can be checked without decompressing it.
+		/// </summary>
+		static FontFileStatus ValidateWoff2(ByteSpan file)
+		{
+			const uint32_t headerSize = 48;
+			if (file.Size < headerSize)
+				return FontFileStatus::Truncated;
+
+			if (file.UInt32(8) > file.Size || file.UInt16(12) == 0)
+				return FontFileStatus::Truncated;
+
+			// totalCompressedSize must fit after the header
+			if (!file.Contains(headerSize, file.UInt32(20)))
+				return FontFileStatus::Truncated;
+
+			return FontFileStatus::NeedsUnpacking;
+		}
+	};
+}
@@ -0,0 +1,440 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "SfntData.h"
+
+/*
+	On-disk cache of per-face font metadata, so launches after the first
+	don't have to ask DirectWrite (or the font files) for it again.
+
+	The file is designed to be memory-mapped and used in place: a fixed
+	header, fixed-size records sorted by key hash for binary search, then a
+	pool of UTF-16 strings. Like the font tables it sits alongside, every
+	number is big-endian, so it reads the same on any platform. Nothing is
+	validated up front beyond the header; each record is bounds-checked
+	when it's looked up, and is only used if the file it describes still
+	has the same size and last write time.
+
+	Header (32 bytes)
+		0	'CMFM'
+		4	uint16 version, uint16 record size
+		8	uint32 record count
+		12	uint32 records offset
+		16	uint32 strings offset
+		20	uint32 strings length, in UTF-16 code units
+		24	uint32 locale offset, uint32 locale length (into strings)
+
+	Record (96 bytes)
+		0	uint64 key hash
+		8	uint64 file size
+		16	uint64 last write time
+		24	uint32 path offset, uint32 path length
+		32	uint32 face index
+		36	uint16 simulations, uint16 weight
+		40	uint8 style, uint8 stretch, uint16 glyph count
+		44	uint32 flags
+		48	uint32 tables
+		52	uint32 family name offset, uint32 family name length
+		60	uint32 face name offset, uint32 face name length
+		68	uint8[10] panose
+		78	uint16 fsType
+		80	uint32[4] OS/2 Unicode range bits
+*/
+
+namespace CharacterMapCX
+{
+	enum FontMetadataFlags : uint32_t
+	{
+		FontMetadataColor = 1,
+		FontMetadataSymbol = 2,
+		FontMetadataMonospaced = 4,
+		FontMetadataVariations = 8,
+	};
+
+	/// <summary>
+	/// Identifies one face of a font file as it was when its metadata was read.
+	/// </summary>
+	struct FontMetadataKey
+	{
+		std::u16string Path;
+		uint64_t FileSize = 0;
+		uint64_t LastWriteTime = 0;
+		uint32_t FaceIndex = 0;
+		uint16_t Simulations = 0;
+
+		/// <summary>
+		/// FNV-1a hash of everything that identifies the face, but not the
+		/// file's size or time, so a changed file is found and rejected
+		/// rather than missed.
+		/// </summary>
+		uint64_t Hash() const
+		{
+			uint64_t hash = 14695981039346656037ull;
+			auto add = [&hash](uint32_t value, int bytes)
+			{
+				for (int i = 0; i < bytes; i++)
+				{
+					hash ^= (value >> (i * 8)) & 0xFF;
+					hash *= 1099511628211ull;
+				}
+			};
+
+			for (char16_t c : Path)
+				add(c, 2);
+			add(FaceIndex, 4);
+			add(Simulations, 2);
+			return hash;
+		}
+	};
+
+	struct FontMetadata
+	{
+		std::u16string FamilyName;
+		std::u16string FaceName;
+		uint16_t Weight = 400;
+		uint8_t Style = 0;
+		uint8_t Stretch = 5;
+		uint16_t GlyphCount = 0;
+		uint16_t FsType = 0;
+		uint32_t Flags = 0;
+
+		/// <summary>
+		/// One bit per entry of TableTags the font contains.
+		/// </summary>
+		uint32_t Tables = 0;
+
+		uint8_t Panose[10] = {};
+
+		/// <summary>
+		/// ulUnicodeRange1 to 4 from OS/2, a summary of the blocks the font
+		/// claims to cover.
+		/// </summary>
+		uint32_t UnicodeRanges[4] = {};
+
+		bool HasFlag(FontMetadataFlags flag) const { return (Flags & flag) != 0; }
+
+		/// <summary>
+		/// Tables whose presence is recorded, in bit order.
+		/// </summary>
+		static const uint32_t* TableTags(uint32_t& count)
+		{
+			static const uint32_t Tags[] =
+			{
+				MakeSfntTag('g', 'l', 'y', 'f'),
+				MakeSfntTag('C', 'F', 'F', ' '),
+				MakeSfntTag('C', 'F', 'F', '2'),
+				MakeSfntTag('C', 'O', 'L', 'R'),
+				MakeSfntTag('C', 'P', 'A', 'L'),
+				MakeSfntTag('S', 'V', 'G', ' '),
+				MakeSfntTag('s', 'b', 'i', 'x'),
+				MakeSfntTag('C', 'B', 'D', 'T'),
+				MakeSfntTag('E', 'B', 'D', 'T'),
+				MakeSfntTag('f', 'v', 'a', 'r'),
+				MakeSfntTag('g', 'v', 'a', 'r'),
+				MakeSfntTag('G', 'S', 'U', 'B'),
+				MakeSfntTag('G', 'P', 'O', 'S'),
+				MakeSfntTag('k', 'e', 'r', 'n'),
+				MakeSfntTag('M', 'A', 'T', 'H'),
+				MakeSfntTag('m', 'e', 't', 'a'),
+			};
+
+			count = sizeof(Tags) / sizeof(Tags[0]);
+			return Tags;
+		}
+
+		/// <summary>
+		/// Fills in the fields that come from the OS/2 table. Returns false,
+		/// leaving them unchanged, if the table is too short.
+		/// </summary>
+		bool ReadOS2(ByteSpan os2)
+		{
+			// Every version has the fields up to ulUnicodeRange4
+			if (!os2.Contains(0, 58))
+				return false;
+
+			FsType = os2.UInt16(8);
+			for (uint32_t i = 0; i < 10; i++)
+				Panose[i] = os2.UInt8(32 + i);
+			for (uint32_t i = 0; i < 4; i++)
+				UnicodeRanges[i] = os2.UInt32(42 + i * 4);
+
+			return true;
+		}
+	};
+
+	class FontMetadataCacheReader
+	{
+	public:
+		static const uint32_t Magic = 0x434D464D; // 'CMFM'
+		static const uint16_t Version = 1;
+		static const uint32_t HeaderSize = 32;
+		static const uint32_t RecordSize = 96;
+
+		/// <summary>
+		/// Checks the header and that the record and string areas lie
+		/// within the data, which must stay valid while the reader is used.
+		/// </summary>
+		bool Load(ByteSpan data)
+		{
+			m_count = 0;
+			if (!data.Contains(0, HeaderSize)
+				|| data.UInt32(0) != Magic
+				|| data.UInt16(4) != Version
+				|| data.UInt16(6) != RecordSize)
+				return false;
+
+			uint32_t count = data.UInt32(8);
+			uint32_t recordsOffset = data.UInt32(12);
+			uint32_t stringsOffset = data.UInt32(16);
+			uint32_t stringsLength = data.UInt32(20);
+
+			if (count > data.Size / RecordSize
+				|| !data.Contains(recordsOffset, count * RecordSize)
+				|| stringsLength > data.Size / 2
+				|| !data.Contains(stringsOffset, stringsLength * 2))
+				return false;
+
+			m_records = data.Slice(recordsOffset, count * RecordSize);
+			m_strings = data.Slice(stringsOffset, stringsLength * 2);
+			m_count = count;
+
+			if (!ReadString(data.UInt32(24), data.UInt32(28), m_locale))
+				m_locale.clear();
+
+			return true;
+		}
+
+		uint32_t Count() const { return m_count; }
+
+		/// <summary>
+		/// The user locale names were read in when the cache was written.
+		/// </summary>
+		const std::u16string& Locale() const { return m_locale; }
+
+		/// <summary>
+		/// Finds the metadata for a face. Returns false if the face isn't
+		/// in the cache, or its file has changed since it was added.
+		/// </summary>
+		bool TryGet(const FontMetadataKey& key, FontMetadata& metadata) const
+		{
+			uint64_t hash = key.Hash();
+
+			uint32_t low = 0;
+			uint32_t high = m_count;
+			while (low < high)
+			{
+				uint32_t mid = low + (high - low) / 2;
+				if (HashAt(mid) < hash)
+					low = mid + 1;
+				else
+					high = mid;
+			}
+
+			std::u16string path;
+			for (uint32_t i = low; i < m_count && HashAt(i) == hash; i++)
+			{
+				uint32_t r = i * RecordSize;
+				if (m_records.UInt32(r + 32) != key.FaceIndex
+					|| m_records.UInt16(r + 36) != key.Simulations
+					|| !ReadString(m_records.UInt32(r + 24), m_records.UInt32(r + 28), path)
+					|| path != key.Path)
+					continue;
+
+				if (UInt64(r + 8) != key.FileSize || UInt64(r + 16) != key.LastWriteTime)
+					return false;
+
+				return Read(r, metadata);
+			}
+
+			return false;
+		}
+
+	private:
+		ByteSpan m_records;
+		ByteSpan m_strings;
+		uint32_t m_count = 0;
+		std::u16string m_locale;
+
+		uint64_t UInt64(uint32_t offset) const
+		{
+			return (static_cast<uint64_t>(m_records.UInt32(offset)) << 32) | m_records.UInt32(offset + 4);
+		}
+
+		uint64_t HashAt(uint32_t index) const { return UInt64(index * RecordSize); }
+
+		bool ReadString(uint32_t offset, uint32_t length, std::u16string& value) const
+		{
+			if (offset > m_strings.Size / 2 || length > m_strings.Size / 2 - offset)
+				return false;
+
+			value.resize(length);
+			for (uint32_t i = 0; i < length; i++)
+				value[i] = static_cast<char16_t>(m_strings.UInt16((offset + i) * 2));
+
+			return true;
+		}
+
+		bool Read(uint32_t r, FontMetadata& m) const
+		{
+			if (!ReadString(m_records.UInt32(r + 52), m_records.UInt32(r + 56), m.FamilyName)
+				|| !ReadString(m_records.UInt32(r + 60), m_records.UInt32(r + 64), m.FaceName))
+				return false;
+
+			m.Weight = m_records.UInt16(r + 38);
+			m.Style = m_records.UInt8(r + 40);
+			m.Stretch = m_records.UInt8(r + 41);
+			m.GlyphCount = m_records.UInt16(r + 42);
+			m.Flags = m_records.UInt32(r + 44);
+			m.Tables = m_records.UInt32(r + 48);
+			for (uint32_t i = 0; i < 10; i++)
+				m.Panose[i] = m_records.UInt8(r + 68 + i);
+			m.FsType = m_records.UInt16(r + 78);
+			for (uint32_t i = 0; i < 4; i++)
+				m.UnicodeRanges[i] = m_records.UInt32(r + 80 + i * 4);
+
+			return true;
+		}
+	};
+
+	class FontMetadataCacheWriter
+	{
+	public:
+		void Add(const FontMetadataKey& key, const FontMetadata& metadata)
+		{
+			m_entries.push_back({ key.Hash(), key, metadata });
+		}
+
+		size_t Count() const { return m_entries.size(); }
+
+		/// <summary>
+		/// Writes every entry added so far, sorted for lookup. Faces added
+		/// more than once keep their last entry.
+		/// </summary>
+		void Write(const std::u16string& locale, std::vector<uint8_t>& out)
+		{
+			std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b)
+				{
+					return a.Hash < b.Hash;
+				});
+
+			std::vector<const Entry*> entries;
+			entries.reserve(m_entries.size());
+			for (size_t i = 0; i < m_entries.size(); i++)
+			{
+				const Entry& e = m_entries[i];
+
+				// Later duplicates replace earlier ones within the same hash
+				bool replaced = false;
+				for (size_t j = i + 1; j < m_entries.size() && m_entries[j].Hash == e.Hash; j++)
+				{
+					if (SameFace(m_entries[j].Key, e.Key))
+						replaced = true;
+				}
+
+				if (!replaced)
+					entries.push_back(&e);
+			}
+
+			m_strings.clear();
+			m_out = &out;
+			out.assign(FontMetadataCacheReader::HeaderSize + entries.size() * FontMetadataCacheReader::RecordSize, 0);
+
+			uint32_t localeOffset = AddString(locale);
+			for (size_t i = 0; i < entries.size(); i++)
+				WriteRecord(FontMetadataCacheReader::HeaderSize + static_cast<uint32_t>(i) * FontMetadataCacheReader::RecordSize, *entries[i]);
+
+			uint32_t stringsOffset = static_cast<uint32_t>(out.size());
+			for (char16_t c : m_strings)
+			{
+				out.push_back(static_cast<uint8_t>(c >> 8));
+				out.push_back(static_cast<uint8_t>(c));
+			}
+
+			PutUInt32(0, FontMetadataCacheReader::Magic);
+			PutUInt16(4, FontMetadataCacheReader::Version);
+			PutUInt16(6, FontMetadataCacheReader::RecordSize);
+			PutUInt32(8, static_cast<uint32_t>(entries.size()));
+			PutUInt32(12, FontMetadataCacheReader::HeaderSize);
+			PutUInt32(16, stringsOffset);
+			PutUInt32(20, static_cast<uint32_t>(m_strings.size()));
+			PutUInt32(24, localeOffset);
+			PutUInt32(28, static_cast<uint32_t>(locale.size()));
+
+			m_out = nullptr;
+		}
+
+	private:
+		struct Entry
+		{
+			uint64_t Hash;
+			FontMetadataKey Key;
+			FontMetadata Metadata;
+		};
+
+		std::vector<Entry> m_entries;
+		std::u16string m_strings;
+		std::vector<uint8_t>* m_out = nullptr;
+
+		static bool SameFace(const FontMetadataKey& a, const FontMetadataKey& b)
+		{
+			return a.FaceIndex == b.FaceIndex && a.Simulations == b.Simulations && a.Path == b.Path;
+		}
+
+		uint32_t AddString(const std::u16string& value)
+		{
+			uint32_t offset = static_cast<uint32_t>(m_strings.size());
+			m_strings += value;
+			return offset;
+		}
+
+		void WriteRecord(uint32_t r, const Entry& e)
+		{
+			const FontMetadataKey& k = e.Key;
+			const FontMetadata& m = e.Metadata;
+
+			PutUInt64(r, e.Hash);
+			PutUInt64(r + 8, k.FileSize);
+			PutUInt64(r + 16, k.LastWriteTime);
+			PutUInt32(r + 24, AddString(k.Path));
+			PutUInt32(r + 28, static_cast<uint32_t>(k.Path.size()));
+			PutUInt32(r + 32, k.FaceIndex);
+			PutUInt16(r + 36, k.Simulations);
+			PutUInt16(r + 38, m.Weight);
+			(*m_out)[r + 40] = m.Style;
+			(*m_out)[r + 41] = m.Stretch;
+			PutUInt16(r + 42, m.GlyphCount);
+			PutUInt32(r + 44, m.Flags);
+			PutUInt32(r + 48, m.Tables);
+			PutUInt32(r + 52, AddString(m.FamilyName));
+			PutUInt32(r + 56, static_cast<uint32_t>(m.FamilyName.size()));
+			PutUInt32(r + 60, AddString(m.FaceName));
+			PutUInt32(r + 64, static_cast<uint32_t>(m.FaceName.size()));
+			std::memcpy(m_out->data() + r + 68, m.Panose, 10);
+			PutUInt16(r + 78, m.FsType);
+			for (uint32_t i = 0; i < 4; i++)
+				PutUInt32(r + 80 + i * 4, m.UnicodeRanges[i]);
+		}
+
+		void PutUInt16(uint32_t offset, uint16_t value)
+		{
+			(*m_out)[offset] = static_cast<uint8_t>(value >> 8);
+			(*m_out)[offset + 1] = static_cast<uint8_t>(value);
+		}
+
+		void PutUInt32(uint32_t offset, uint32_t value)
+		{
+			PutUInt16(offset, static_cast<uint16_t>(value >> 16));
+			PutUInt16(offset + 2, static_cast<uint16_t>(value));
+		}
+
+		void PutUInt64(uint32_t offset, uint64_t value)
+		{
+			PutUInt32(offset, static_cast<uint32_t>(value >> 32));
+			PutUInt32(offset + 4, static_cast<uint32_t>(value));
+		}
+	};
+}
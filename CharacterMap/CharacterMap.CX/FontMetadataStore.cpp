@@ -0,0 +1,221 @@
+#pragma once
+#include "pch.h"
+#include "FontMetadataStore.h"
+#include <fileapifromapp.h>
+#include <ppl.h>
+
+using namespace Platform;
+using namespace CharacterMapCX;
+using namespace concurrency;
+
+FontMetadataStore::FontMetadataStore(String^ path, const wchar_t* localeName)
+{
+	m_path = path;
+	m_locale = reinterpret_cast<const char16_t*>(localeName);
+
+	m_file = CreateFile2(path->Data(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0 || size.QuadPart > UINT32_MAX)
+	{
+		Unmap();
+		return;
+	}
+
+	m_mapping = CreateFileMappingFromApp(m_file, nullptr, PAGE_READONLY, 0, nullptr);
+	if (m_mapping != nullptr)
+		m_view = MapViewOfFileFromApp(m_mapping, FILE_MAP_READ, 0, 0);
+
+	if (m_view == nullptr
+		|| !m_reader.Load(ByteSpan(m_view, static_cast<uint32_t>(size.QuadPart)))
+		|| m_reader.Locale() != m_locale)
+	{
+		// Names are cached in the user's locale, so a cache written for
+		// another one is rebuilt rather than used
+		m_reader = FontMetadataCacheReader();
+		Unmap();
+	}
+}
+
+FontMetadataStore::~FontMetadataStore()
+{
+	Unmap();
+}
+
+void FontMetadataStore::Unmap()
+{
+	if (m_view != nullptr)
+		UnmapViewOfFile(m_view);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_view = nullptr;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+bool FontMetadataStore::TryGetKey(IDWriteFont3* font, FontMetadataKey& key, const FontMetadataKey* last)
+{
+	ComPtr<IDWriteFontFaceReference> ref;
+	ComPtr<IDWriteFontFile> file;
+	ComPtr<IDWriteFontFileLoader> loader;
+	ComPtr<IDWriteLocalFontFileLoader> localLoader;
+	const void* refKey = nullptr;
+	UINT32 refKeySize = 0;
+	UINT32 length = 0;
+
+	if (FAILED(font->GetFontFaceReference(&ref))
+		|| FAILED(ref->GetFontFile(&file))
+		|| FAILED(file->GetLoader(&loader))
+		|| FAILED(loader.As(&localLoader))
+		|| FAILED(file->GetReferenceKey(&refKey, &refKeySize))
+		|| FAILED(localLoader->GetFilePathLengthFromKey(refKey, refKeySize, &length)))
+		return false;
+
+	key.Path.resize(length + 1);
+	if (FAILED(localLoader->GetFilePathFromKey(refKey, refKeySize, reinterpret_cast<wchar_t*>(&key.Path[0]), length + 1)))
+		return false;
+	key.Path.resize(length);
+
+	key.FaceIndex = ref->GetFontFaceIndex();
+	key.Simulations = static_cast<uint16_t>(font->GetSimulations());
+
+	if (last != nullptr && last->Path == key.Path)
+	{
+		key.FileSize = last->FileSize;
+		key.LastWriteTime = last->LastWriteTime;
+		return true;
+	}
+
+	WIN32_FILE_ATTRIBUTE_DATA data{};
+	if (!GetFileAttributesExFromAppW(reinterpret_cast<const wchar_t*>(key.Path.c_str()), GetFileExInfoStandard, &data))
+		return false;
+
+	key.FileSize = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+	key.LastWriteTime = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
+bool FontMetadataStore::TryGet(const FontMetadataKey& key, FontMetadata& metadata)
+{
+	if (m_reader.Count() == 0 || !m_reader.TryGet(key, metadata))
+		return false;
+
+	m_hits++;
+
+	Lock lock(m_mutex);
+	m_entries.push_back({ key, metadata, nullptr });
+	return true;
+}
+
+void FontMetadataStore::AddMiss(const FontMetadataKey& key, ComPtr<IDWriteFont3> font, const std::u16string& familyName, const std::u16string& faceName)
+{
+	Entry entry{ key, FontMetadata(), font };
+	entry.Metadata.FamilyName = familyName;
+	entry.Metadata.FaceName = faceName;
+
+	m_misses++;
+
+	Lock lock(m_mutex);
+	m_entries.push_back(std::move(entry));
+}
+
+void FontMetadataStore::Read(Entry& entry)
+{
+	IDWriteFont3* font = entry.Font.Get();
+	FontMetadata& m = entry.Metadata;
+
+	m.Weight = static_cast<uint16_t>(font->GetWeight());
+	m.Style = static_cast<uint8_t>(font->GetStyle());
+	m.Stretch = static_cast<uint8_t>(font->GetStretch());
+
+	if (font->IsColorFont())
+		m.Flags |= FontMetadataColor;
+	if (font->IsSymbolFont())
+		m.Flags |= FontMetadataSymbol;
+	if (font->IsMonospacedFont())
+		m.Flags |= FontMetadataMonospaced;
+
+	ComPtr<IDWriteFontFace3> face;
+	if (FAILED(font->CreateFontFace(&face)))
+		return;
+
+	m.GlyphCount = face->GetGlyphCount();
+
+	ComPtr<IDWriteFontFace5> face5;
+	if (SUCCEEDED(face.As(&face5)) && face5->HasVariations())
+		m.Flags |= FontMetadataVariations;
+
+	const void* data = nullptr;
+	UINT32 size = 0;
+	void* context = nullptr;
+	BOOL exists = FALSE;
+
+	// The tags are built the same way as DWRITE_MAKE_OPENTYPE_TAG's, but
+	// in the opposite byte order
+	uint32_t tagCount = 0;
+	const uint32_t* tags = FontMetadata::TableTags(tagCount);
+	for (uint32_t i = 0; i < tagCount; i++)
+	{
+		uint32_t tag = _byteswap_ulong(tags[i]);
+		if (SUCCEEDED(face->TryGetFontTable(tag, &data, &size, &context, &exists)) && exists)
+		{
+			m.Tables |= 1u << i;
+			face->ReleaseFontTable(context);
+		}
+	}
+
+	if (SUCCEEDED(face->TryGetFontTable(DWRITE_MAKE_OPENTYPE_TAG('O', 'S', '/', '2'), &data, &size, &context, &exists)) && exists)
+	{
+		m.ReadOS2(ByteSpan(data, size));
+		face->ReleaseFontTable(context);
+	}
+}
+
+void FontMetadataStore::Save()
+{
+	// Nothing new was found and nothing was removed
+	if (m_misses == 0 && m_hits == m_reader.Count())
+		return;
+
+	std::vector<Entry*> misses;
+	for (auto& entry : m_entries)
+	{
+		if (entry.Font != nullptr)
+			misses.push_back(&entry);
+	}
+
+	parallel_for(size_t(0), misses.size(), [&](size_t i)
+		{
+			Read(*misses[i]);
+		});
+
+	FontMetadataCacheWriter writer;
+	for (auto& entry : m_entries)
+		writer.Add(entry.Key, entry.Metadata);
+
+	std::vector<uint8_t> data;
+	writer.Write(m_locale, data);
+
+	// Written beside the cache then moved over it, so a cache that's
+	// being read is never left half written
+	String^ temp = m_path + ".tmp";
+	HANDLE file = CreateFile2(temp->Data(), GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	DWORD written = 0;
+	bool ok = WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr)
+		&& written == data.size();
+	CloseHandle(file);
+
+	Unmap();
+	m_reader = FontMetadataCacheReader();
+
+	if (!ok || !MoveFileExW(temp->Data(), m_path->Data(), MOVEFILE_REPLACE_EXISTING))
+		DeleteFileW(temp->Data());
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "pch.h"
+#include "FontMetadataCache.h"
+#include <atomic>
+#include <mutex>
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Maps the font metadata cache from the app's local cache folder while
+	/// the system font set is inflated, and writes an updated cache
+	/// afterwards with any faces that weren't in it.
+	/// </summary>
+	class FontMetadataStore
+	{
+	public:
+		/// <summary>
+		/// Maps the cache at path. A missing or unreadable file, or one written
+		/// for another locale, leaves the store empty so every face misses.
+		/// </summary>
+		FontMetadataStore(Platform::String^ path, const wchar_t* localeName);
+		~FontMetadataStore();
+
+		FontMetadataStore(const FontMetadataStore&) = delete;
+		FontMetadataStore& operator=(const FontMetadataStore&) = delete;
+
+		/// <summary>
+		/// Builds the key for a font from a local file. Fonts from other
+		/// loaders, such as remote or in-memory ones, aren't cached. last
+		/// is the key built before it on the same thread, which saves
+		/// checking the file again for each face of a collection.
+		/// </summary>
+		bool TryGetKey(IDWriteFont3* font, FontMetadataKey& key, const FontMetadataKey* last);
+
+		/// <summary>
+		/// Looks up a face and records the result for Save. Safe to call
+		/// from any thread.
+		/// </summary>
+		bool TryGet(const FontMetadataKey& key, FontMetadata& metadata);
+
+		/// <summary>
+		/// Records a face that wasn't in the cache, to be read by Save.
+		/// Safe to call from any thread.
+		/// </summary>
+		void AddMiss(const FontMetadataKey& key, ComPtr<IDWriteFont3> font, const std::u16string& familyName, const std::u16string& faceName);
+
+		/// <summary>
+		/// Reads the metadata of every missed face and replaces the cache
+		/// file, unless every face was found and none were removed. Call
+		/// once, after all lookups have finished.
+		/// </summary>
+		void Save();
+
+	private:
+		struct Entry
+		{
+			FontMetadataKey Key;
+			FontMetadata Metadata;
+			ComPtr<IDWriteFont3> Font;
+		};
+
+		static void Read(Entry& entry);
+
+		Platform::String^ m_path;
+		std::u16string m_locale;
+
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+		const void* m_view = nullptr;
+		FontMetadataCacheReader m_reader;
+
+		std::mutex m_mutex;
+		std::vector<Entry> m_entries;
+		std::atomic<uint32_t> m_hits = 0;
+		std::atomic<uint32_t> m_misses = 0;
+
+		void Unmap();
+	};
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/*
+	Interns family and face names so each unique name is stored once, and
+	faces refer to names by a 32-bit ID that compares as an integer.
+
+	Names are copied into an arena of large character blocks and never
+	move or get freed, so a name returned by Get stays valid for the life of
+	the table without a lock. Lookups are an open-addressing probe over a
+	power-of-two slot array, taken under a shared lock so any number of
+	threads can look names up at once. Adding a new name takes the lock
+	exclusively. Most faces share a name that's already been seen, so
+	that's rare after the first few families.
+*/
+
+namespace CharacterMapCX
+{
+	struct FontName
+	{
+		/// <summary>
+		/// Null-terminated characters, owned by the table.
+		/// </summary>
+		const char16_t* Data = nullptr;
+		uint32_t Length = 0;
+
+		std::u16string ToString() const { return std::u16string(Data, Length); }
+	};
+
+	class FontNameTable
+	{
+	public:
+		static const uint32_t NotFound = UINT32_MAX;
+
+		FontNameTable()
+		{
+			m_slots.assign(1024, 0);
+		}
+
+		FontNameTable(const FontNameTable&) = delete;
+		FontNameTable& operator=(const FontNameTable&) = delete;
+
+		/// <summary>
+		/// The table shared by every font set in the process.
+		/// </summary>
+		static FontNameTable& Shared()
+		{
+			static FontNameTable table;
+			return table;
+		}
+
+		/// <summary>
+		/// Returns the ID of a name, adding it if it's new. Safe to call
+		/// from any thread.
+		/// </summary>
+		uint32_t Intern(const char16_t* chars, uint32_t length)
+		{
+			uint32_t hash = Hash(chars, length);
+
+			{
+				std::shared_lock<std::shared_mutex> lock(m_mutex);
+				uint32_t id = Find(chars, length, hash);
+				if (id != NotFound)
+					return id;
+			}
+
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+			// Another thread may have added it between the two locks
+			uint32_t id = Find(chars, length, hash);
+			if (id != NotFound)
+				return id;
+
+			id = m_count.load(std::memory_order_relaxed);
+			if (id / BlockSize >= MaxBlocks)
+				return NotFound;
+
+			if ((id + 1) * 2 > m_slots.size())
+				Grow();
+
+			std::unique_ptr<Entry[]>& block = m_blocks[id / BlockSize];
+			if (block == nullptr)
+				block.reset(new Entry[BlockSize]);
+
+			Entry& entry = block[id % BlockSize];
+			entry.Name.Data = Copy(chars, length);
+			entry.Name.Length = length;
+			entry.Hash = hash;
+
+			Insert(id, hash);
+			m_count.store(id + 1, std::memory_order_release);
+			return id;
+		}
+
+		uint32_t Intern(const std::u16string& name)
+		{
+			return Intern(name.data(), static_cast<uint32_t>(name.size()));
+		}
+
+		/// <summary>
+		/// Returns false if the name has never been interned.
+		/// </summary>
+		bool TryFind(const char16_t* chars, uint32_t length, uint32_t& id) const
+		{
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			id = Find(chars, length, Hash(chars, length));
+			return id != NotFound;
+		}
+
+		bool TryFind(const std::u16string& name, uint32_t& id) const
+		{
+			return TryFind(name.data(), static_cast<uint32_t>(name.size()), id);
+		}
+
+		/// <summary>
+		/// Gets an interned name, or an empty one for an unknown ID. Needs
+		/// no lock, as names never move.
+		/// </summary>
+		FontName Get(uint32_t id) const
+		{
+			if (id >= Count())
+				return FontName();
+
+			return m_blocks[id / BlockSize][id % BlockSize].Name;
+		}
+
+		uint32_t Count() const { return m_count.load(std::memory_order_acquire); }
+
+	private:
+		static const uint32_t BlockSize = 1024;
+		static const uint32_t MaxBlocks = 4096;
+		static const uint32_t ArenaSize = 16384;
+
+		struct Entry
+		{
+			FontName Name;
+			uint32_t Hash = 0;
+		};
+
+		mutable std::shared_mutex m_mutex;
+
+		// Each slot holds an ID plus one, or 0 if it's empty
+		std::vector<uint32_t> m_slots;
+		std::unique_ptr<Entry[]> m_blocks[MaxBlocks];
+		std::atomic<uint32_t> m_count{ 0 };
+
+		std::vector<std::unique_ptr<char16_t[]>> m_arena;
+		uint32_t m_arenaUsed = ArenaSize;
+
+		static uint32_t Hash(const char16_t* chars, uint32_t length)
+		{
+			uint32_t hash = 2166136261u;
+			for (uint32_t i = 0; i < length; i++)
+			{
+				hash ^= chars[i] & 0xFF;
+				hash *= 16777619u;
+				hash ^= chars[i] >> 8;
+				hash *= 16777619u;
+			}
+
+			return hash;
+		}
+
+		const Entry& EntryAt(uint32_t id) const
+		{
+			return m_blocks[id / BlockSize][id % BlockSize];
+		}
+
+		uint32_t Find(const char16_t* chars, uint32_t length, uint32_t hash) const
+		{
+			size_t mask = m_slots.size() - 1;
+			for (size_t i = hash & mask; ; i = (i + 1) & mask)
+			{
+				uint32_t slot = m_slots[i];
+				if (slot == 0)
+					return NotFound;
+
+				const Entry& entry = EntryAt(slot - 1);
+				if (entry.Hash == hash
+					&& entry.Name.Length == length
+					&& std::memcmp(entry.Name.Data, chars, length * sizeof(char16_t)) == 0)
+					return slot - 1;
+			}
+		}
+
+		void Insert(uint32_t id, uint32_t hash)
+		{
+			size_t mask = m_slots.size() - 1;
+			size_t i = hash & mask;
+			while (m_slots[i] != 0)
+				i = (i + 1) & mask;
+
+			m_slots[i] = id + 1;
+		}
+
+		/// <summary>
+		/// Doubles the slot array, keeping the load factor under a half.
+		/// </summary>
+		void Grow()
+		{
+			std::vector<uint32_t> slots(m_slots.size() * 2, 0);
+			m_slots.swap(slots);
+
+			for (uint32_t slot : slots)
+			{
+				if (slot != 0)
+					Insert(slot - 1, EntryAt(slot - 1).Hash);
+			}
+		}
+
+		const char16_t* Copy(const char16_t* chars, uint32_t length)
+		{
+			uint32_t size = length + 1;
+			if (size > ArenaSize)
+			{
+				// Too long to share a block
+				m_arena.emplace_back(new char16_t[size]);
+				char16_t* data = m_arena.back().get();
+				std::memcpy(data, chars, length * sizeof(char16_t));
+				data[length] = 0;
+
+				// Keep filling the previous block, which is now second to last
+				if (m_arena.size() > 1 && m_arenaUsed < ArenaSize)
+					std::swap(m_arena[m_arena.size() - 1], m_arena[m_arena.size() - 2]);
+				return data;
+			}
+
+			if (m_arenaUsed + size > ArenaSize)
+			{
+				m_arena.emplace_back(new char16_t[ArenaSize]);
+				m_arenaUsed = 0;
+			}
+
+			char16_t* data = m_arena.back().get() + m_arenaUsed;
+			std::memcpy(data, chars, length * sizeof(char16_t));
+			data[length] = 0;
+			m_arenaUsed += size;
+			return data;
+		}
+	};
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <dwrite_3.h>
+#include <wrl.h>
+#include <utility>
+#include "SfntData.h"
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Holds a font table open via IDWriteFontFace::TryGetFontTable and
+	/// releases it when it goes out of scope.
+	/// </summary>
+	class FontTable
+	{
+	public:
+		FontTable() { }
+
+		FontTable(Microsoft::WRL::ComPtr<IDWriteFontFace> face, UINT32 tag)
+		{
+			const void* data = nullptr;
+			UINT32 size = 0;
+			BOOL exists = FALSE;
+
+			if (SUCCEEDED(face->TryGetFontTable(tag, &data, &size, &m_context, &exists)))
+			{
+				m_face = face;
+				if (exists)
+					m_data = ByteSpan(data, size);
+			}
+		}
+
+		FontTable(const FontTable&) = delete;
+		FontTable& operator=(const FontTable&) = delete;
+
+		FontTable(FontTable&& other)
+		{
+			*this = std::move(other);
+		}
+
+		FontTable& operator=(FontTable&& other)
+		{
+			if (this != &other)
+			{
+				Release();
+				m_face = std::move(other.m_face);
+				m_context = other.m_context;
+				m_data = other.m_data;
+				other.m_context = nullptr;
+				other.m_data = ByteSpan();
+			}
+
+			return *this;
+		}
+
+		~FontTable()
+		{
+			Release();
+		}
+
+		bool Exists() const { return !m_data.IsEmpty(); }
+
+		ByteSpan Data() const { return m_data; }
+
+	private:
+		Microsoft::WRL::ComPtr<IDWriteFontFace> m_face;
+		void* m_context = nullptr;
+		ByteSpan m_data;
+
+		void Release()
+		{
+			if (m_face != nullptr)
+			{
+				m_face->ReleaseFontTable(m_context);
+				m_face = nullptr;
+			}
+
+			m_context = nullptr;
+			m_data = ByteSpan();
+		}
+	};
+}
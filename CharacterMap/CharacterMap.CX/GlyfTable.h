@@ -0,0 +1,636 @@
+#pragma once
+
+#include <vector>
+#include "SfntData.h"
+#include "GlyphPath.h"
+#include "GvarTable.h"
+
+/*
+	Native TrueType outline decoder.
+	glyf Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/glyf
+	loca Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/loca
+
+	Glyphs are first flattened into a list of points and contour end
+	indices, expanding composite glyphs recursively, and then converted to
+	path commands. Scratch buffers are kept between calls so decoding a
+	whole font doesn't allocate per glyph. An instance must therefore not
+	be used from more than one thread at a time.
+*/
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// A single outline point in font units.
+	/// </summary>
+	struct GlyfPoint
+	{
+		float X;
+		float Y;
+		bool OnCurve;
+	};
+
+	class GlyfTable
+	{
+	public:
+		/// <summary>
+		/// Prepares the decoder. The tables must stay alive for as long as
+		/// this instance is used.
+		/// </summary>
+		bool Load(ByteSpan head, ByteSpan loca, ByteSpan glyf, uint16_t numGlyphs)
+		{
+			m_loca = loca;
+			m_glyf = glyf;
+			m_numGlyphs = 0;
+
+			if (!head.Contains(0, 54) || glyf.IsEmpty() || loca.IsEmpty())
+				return false;
+
+			UnitsPerEm = head.UInt16(18);
+			m_longOffsets = head.Int16(50) != 0;
+
+			// Trust loca over maxp if it is too short for every glyph
+			uint32_t entries = loca.Size / (m_longOffsets ? 4 : 2);
+			if (entries == 0)
+				return false;
+
+			m_numGlyphs = static_cast<uint16_t>(std::min<uint32_t>(numGlyphs, entries - 1));
+			return UnitsPerEm > 0;
+		}
+
+		uint16_t UnitsPerEm = 0;
+
+		uint16_t GlyphCount() const { return m_numGlyphs; }
+
+		/// <summary>
+		/// Applies glyph variations to every glyph decoded from now on.
+		/// Passing null goes back to the default outlines. The table is not
+		/// owned and must outlive its use here.
+		/// </summary>
+		void SetVariations(GvarTable* variations) { m_variations = variations; }
+
+		/// <summary>
+		/// Decodes a glyph outline into path commands, scaled by the given
+		/// factor and with the y-axis flipped to match Direct2D's orientation.
+		/// Returns false if the glyph data is malformed. Empty glyphs succeed
+		/// with an empty path.
+		/// </summary>
+		bool Decode(uint16_t glyphId, GlyphPath& path, float scale)
+		{
+			path.Clear();
+			m_points.clear();
+			m_endPoints.clear();
+
+			if (!AppendGlyph(glyphId, 0))
+				return false;
+
+			Emit(path, scale);
+			return true;
+		}
+
+		/// <summary>
+		/// Gets the box around a glyph's outline points, off-curve points
+		/// included, scaled and flipped like Decode. Default outlines read it
+		/// straight from the glyph header; varied outlines have to be decoded
+		/// first. Empty glyphs succeed with empty bounds.
+		/// </summary>
+		bool GetControlBounds(uint16_t glyphId, PathBounds& bounds, float scale)
+		{
+			bounds = PathBounds::Empty();
+
+			if (glyphId >= m_numGlyphs)
+				return false;
+
+			if (!HasVariations())
+			{
+				ByteSpan data = GetGlyphData(glyphId);
+				if (data.IsEmpty() || data.Int16(0) == 0)
+					return true;
+
+				if (!data.Contains(0, 10))
+					return false;
+
+				bounds.Left = data.Int16(2) * scale;
+				bounds.Top = -data.Int16(8) * scale;
+				bounds.Right = data.Int16(6) * scale;
+				bounds.Bottom = -data.Int16(4) * scale;
+				return true;
+			}
+
+			m_points.clear();
+			m_endPoints.clear();
+			if (!AppendGlyph(glyphId, 0))
+				return false;
+
+			for (const GlyfPoint& p : m_points)
+				GlyphPath::Include(bounds, p.X * scale, -p.Y * scale);
+
+			return true;
+		}
+
+		/// <summary>
+		/// Decodes a glyph into its flattened outline points in font units.
+		/// </summary>
+		bool DecodePoints(uint16_t glyphId, std::vector<GlyfPoint>& points, std::vector<uint32_t>& endPoints)
+		{
+			m_points.clear();
+			m_endPoints.clear();
+
+			bool result = AppendGlyph(glyphId, 0);
+			points = m_points;
+			endPoints = m_endPoints;
+			return result;
+		}
+
+		/// <summary>
+		/// Returns the glyph's data inside glyf, or an empty span for empty glyphs.
+		/// </summary>
+		ByteSpan GetGlyphData(uint16_t glyphId) const
+		{
+			if (glyphId >= m_numGlyphs)
+				return ByteSpan();
+
+			uint32_t start, end;
+			if (m_longOffsets)
+			{
+				start = m_loca.UInt32(glyphId * 4u);
+				end = m_loca.UInt32((glyphId + 1u) * 4u);
+			}
+			else
+			{
+				start = m_loca.UInt16(glyphId * 2u) * 2u;
+				end = m_loca.UInt16((glyphId + 1u) * 2u) * 2u;
+			}
+
+			if (end <= start)
+				return ByteSpan();
+
+			return m_glyf.Slice(start, end - start);
+		}
+
+	private:
+		// Simple glyph flags
+		static constexpr uint8_t OnCurvePoint = 0x01;
+		static constexpr uint8_t XShortVector = 0x02;
+		static constexpr uint8_t YShortVector = 0x04;
+		static constexpr uint8_t RepeatFlag = 0x08;
+		static constexpr uint8_t XIsSameOrPositive = 0x10;
+		static constexpr uint8_t YIsSameOrPositive = 0x20;
+
+		// Composite glyph flags
+		static constexpr uint16_t ArgsAreWords = 0x0001;
+		static constexpr uint16_t ArgsAreXYValues = 0x0002;
+		static constexpr uint16_t HasScale = 0x0008;
+		static constexpr uint16_t MoreComponents = 0x0020;
+		static constexpr uint16_t HasXYScale = 0x0040;
+		static constexpr uint16_t HasTwoByTwo = 0x0080;
+		static constexpr uint16_t ScaledComponentOffset = 0x0800;
+		static constexpr uint16_t UnscaledComponentOffset = 0x1000;
+
+		// Limits to stop malformed fonts running away with us
+		static constexpr int MaxDepth = 16;
+		static constexpr uint32_t MaxPoints = 0x40000;
+
+		ByteSpan m_loca;
+		ByteSpan m_glyf;
+		uint16_t m_numGlyphs = 0;
+		bool m_longOffsets = false;
+
+		std::vector<GlyfPoint> m_points;
+		std::vector<uint32_t> m_endPoints;
+		std::vector<uint8_t> m_flags;
+		std::vector<uint32_t> m_contourEnds;
+		GvarTable* m_variations = nullptr;
+
+		bool HasVariations() const
+		{
+			return m_variations != nullptr && !m_variations->IsDefault();
+		}
+
+		bool AppendGlyph(uint16_t glyphId, int depth)
+		{
+			if (depth > MaxDepth || glyphId >= m_numGlyphs)
+				return false;
+
+			ByteSpan data = GetGlyphData(glyphId);
+			if (data.IsEmpty())
+				return true;
+
+			if (!data.Contains(0, 10))
+				return false;
+
+			int16_t contours = data.Int16(0);
+			if (contours >= 0)
+				return AppendSimple(glyphId, data, static_cast<uint16_t>(contours));
+
+			return AppendComposite(glyphId, data, depth);
+		}
+
+		bool AppendSimple(uint16_t glyphId, ByteSpan data, uint16_t contourCount)
+		{
+			if (contourCount == 0)
+				return true;
+
+			uint32_t offset = 10;
+			if (!data.Contains(offset, contourCount * 2u + 2))
+				return false;
+
+			uint32_t base = static_cast<uint32_t>(m_points.size());
+			uint32_t pointCount = 0;
+			size_t firstContour = m_endPoints.size();
+
+			for (uint16_t c = 0; c < contourCount; c++)
+			{
+				uint32_t end = data.UInt16(offset + c * 2u);
+				if (c > 0 && end < pointCount)
+					return false;
+
+				pointCount = end + 1;
+			}
+
+			if (base + pointCount > MaxPoints)
+				return false;
+
+			for (uint16_t c = 0; c < contourCount; c++)
+				m_endPoints.push_back(base + data.UInt16(offset + c * 2u));
+
+			offset += contourCount * 2u;
+			uint32_t instructionLength = data.UInt16(offset);
+			offset += 2 + instructionLength;
+
+			// Flags
+			m_flags.resize(pointCount);
+			for (uint32_t i = 0; i < pointCount;)
+			{
+				if (offset >= data.Size)
+					return Fail(base, firstContour);
+
+				uint8_t flag = data.Data[offset++];
+				m_flags[i++] = flag;
+
+				if (flag & RepeatFlag)
+				{
+					if (offset >= data.Size)
+						return Fail(base, firstContour);
+
+					uint32_t repeat = data.Data[offset++];
+					for (; repeat > 0 && i < pointCount; repeat--)
+						m_flags[i++] = flag;
+				}
+			}
+
+			m_points.resize(base + pointCount);
+
+			// X coordinates
+			int32_t value = 0;
+			for (uint32_t i = 0; i < pointCount; i++)
+			{
+				uint8_t flag = m_flags[i];
+				if (flag & XShortVector)
+				{
+					if (offset >= data.Size)
+						return Fail(base, firstContour);
+
+					int32_t dx = data.Data[offset++];
+					value += (flag & XIsSameOrPositive) ? dx : -dx;
+				}
+				else if (!(flag & XIsSameOrPositive))
+				{
+					if (!data.Contains(offset, 2))
+						return Fail(base, firstContour);
+
+					value += data.Int16(offset);
+					offset += 2;
+				}
+
+				GlyfPoint& p = m_points[base + i];
+				p.X = static_cast<float>(value);
+				p.OnCurve = (flag & OnCurvePoint) != 0;
+			}
+
+			// Y coordinates
+			value = 0;
+			for (uint32_t i = 0; i < pointCount; i++)
+			{
+				uint8_t flag = m_flags[i];
+				if (flag & YShortVector)
+				{
+					if (offset >= data.Size)
+						return Fail(base, firstContour);
+
+					int32_t dy = data.Data[offset++];
+					value += (flag & YIsSameOrPositive) ? dy : -dy;
+				}
+				else if (!(flag & YIsSameOrPositive))
+				{
+					if (!data.Contains(offset, 2))
+						return Fail(base, firstContour);
+
+					value += data.Int16(offset);
+					offset += 2;
+				}
+
+				m_points[base + i].Y = static_cast<float>(value);
+			}
+
+			if (HasVariations())
+			{
+				m_contourEnds.resize(contourCount);
+				for (uint16_t c = 0; c < contourCount; c++)
+					m_contourEnds[c] = m_endPoints[firstContour + c] - base;
+
+				if (!m_variations->ApplyDeltas(glyphId, &m_points[base], pointCount, m_contourEnds.data(), contourCount))
+					return Fail(base, firstContour);
+			}
+
+			return true;
+		}
+
+		bool AppendComposite(uint16_t glyphId, ByteSpan data, int depth)
+		{
+			// gvar treats each component's offset as a point of the
+			// composite, so their deltas are worked out before the
+			// components themselves are decoded and varied.
+			std::vector<GlyfPoint> offsetDeltas;
+			if (HasVariations())
+			{
+				offsetDeltas.resize(CountComponents(data));
+				if (!m_variations->ApplyDeltas(glyphId, offsetDeltas.data(), static_cast<uint32_t>(offsetDeltas.size()), nullptr, 0))
+					return false;
+			}
+
+			// Matched points are numbered from this composite's first point,
+			// which is only 0 when it isn't nested inside another composite
+			uint32_t compositeBase = static_cast<uint32_t>(m_points.size());
+			uint32_t offset = 10;
+			uint32_t component = 0;
+			uint16_t flags = MoreComponents;
+
+			while (flags & MoreComponents)
+			{
+				if (!data.Contains(offset, 4))
+					return false;
+
+				flags = data.UInt16(offset);
+				uint16_t glyphIndex = data.UInt16(offset + 2);
+				offset += 4;
+
+				int32_t arg1, arg2;
+				if (flags & ArgsAreWords)
+				{
+					if (!data.Contains(offset, 4))
+						return false;
+
+					if (flags & ArgsAreXYValues)
+					{
+						arg1 = data.Int16(offset);
+						arg2 = data.Int16(offset + 2);
+					}
+					else
+					{
+						arg1 = data.UInt16(offset);
+						arg2 = data.UInt16(offset + 2);
+					}
+					offset += 4;
+				}
+				else
+				{
+					if (!data.Contains(offset, 2))
+						return false;
+
+					if (flags & ArgsAreXYValues)
+					{
+						arg1 = static_cast<int8_t>(data.UInt8(offset));
+						arg2 = static_cast<int8_t>(data.UInt8(offset + 1));
+					}
+					else
+					{
+						arg1 = data.UInt8(offset);
+						arg2 = data.UInt8(offset + 1);
+					}
+					offset += 2;
+				}
+
+				// 2x2 transform: x' = a*x + c*y, y' = b*x + d*y
+				float a = 1, b = 0, c = 0, d = 1;
+				if (flags & HasScale)
+				{
+					if (!data.Contains(offset, 2))
+						return false;
+
+					a = d = F2Dot14(data, offset);
+					offset += 2;
+				}
+				else if (flags & HasXYScale)
+				{
+					if (!data.Contains(offset, 4))
+						return false;
+
+					a = F2Dot14(data, offset);
+					d = F2Dot14(data, offset + 2);
+					offset += 4;
+				}
+				else if (flags & HasTwoByTwo)
+				{
+					if (!data.Contains(offset, 8))
+						return false;
+
+					a = F2Dot14(data, offset);
+					b = F2Dot14(data, offset + 2);
+					c = F2Dot14(data, offset + 4);
+					d = F2Dot14(data, offset + 6);
+					offset += 8;
+				}
+
+				uint32_t start = static_cast<uint32_t>(m_points.size());
+				if (!AppendGlyph(glyphIndex, depth + 1))
+					return false;
+
+				uint32_t end = static_cast<uint32_t>(m_points.size());
+
+				for (uint32_t i = start; i < end; i++)
+				{
+					GlyfPoint& p = m_points[i];
+					float x = p.X, y = p.Y;
+					p.X = a * x + c * y;
+					p.Y = b * x + d * y;
+				}
+
+				float dx, dy;
+				if (flags & ArgsAreXYValues)
+				{
+					dx = static_cast<float>(arg1);
+					dy = static_cast<float>(arg2);
+
+					if (component < offsetDeltas.size())
+					{
+						dx += offsetDeltas[component].X;
+						dy += offsetDeltas[component].Y;
+					}
+
+					// Offsets are unscaled unless the font explicitly asks
+					if ((flags & ScaledComponentOffset) && !(flags & UnscaledComponentOffset))
+					{
+						float x = dx;
+						dx = a * x + c * dy;
+						dy = b * x + d * dy;
+					}
+				}
+				else
+				{
+					// Point matching: arg1 is a point of this composite placed
+					// by an earlier component, arg2 a point in the new one.
+					uint32_t parent = compositeBase + static_cast<uint32_t>(arg1);
+					uint32_t child = start + static_cast<uint32_t>(arg2);
+					if (parent >= start || child >= end)
+						return false;
+
+					dx = m_points[parent].X - m_points[child].X;
+					dy = m_points[parent].Y - m_points[child].Y;
+				}
+
+				if (dx != 0 || dy != 0)
+				{
+					for (uint32_t i = start; i < end; i++)
+					{
+						m_points[i].X += dx;
+						m_points[i].Y += dy;
+					}
+				}
+
+				component++;
+			}
+
+			return true;
+		}
+
+		static uint32_t CountComponents(ByteSpan data)
+		{
+			uint32_t count = 0;
+			uint32_t offset = 10;
+			uint16_t flags = MoreComponents;
+
+			while ((flags & MoreComponents) && data.Contains(offset, 4))
+			{
+				flags = data.UInt16(offset);
+				offset += (flags & ArgsAreWords) ? 8 : 6;
+
+				if (flags & HasScale)
+					offset += 2;
+				else if (flags & HasXYScale)
+					offset += 4;
+				else if (flags & HasTwoByTwo)
+					offset += 8;
+
+				count++;
+			}
+
+			return count;
+		}
+
+		/// <summary>
+		/// Removes a partially added simple glyph and reports failure.
+		/// </summary>
+		bool Fail(uint32_t pointBase, size_t contourBase)
+		{
+			m_points.resize(pointBase);
+			m_endPoints.resize(contourBase);
+			return false;
+		}
+
+		static float F2Dot14(ByteSpan data, uint32_t offset)
+		{
+			return data.Int16(offset) / 16384.0f;
+		}
+
+		/// <summary>
+		/// Converts the flattened points into path commands. Consecutive
+		/// off-curve points imply an on-curve point halfway between them.
+		/// </summary>
+		void Emit(GlyphPath& path, float scale)
+		{
+			uint32_t start = 0;
+			for (uint32_t endPoint : m_endPoints)
+			{
+				uint32_t end = endPoint;
+				if (end < start || end >= m_points.size())
+					break;
+
+				EmitContour(path, start, end, scale);
+				start = end + 1;
+			}
+		}
+
+		void EmitContour(GlyphPath& path, uint32_t first, uint32_t last, float scale)
+		{
+			const GlyfPoint* pts = m_points.data();
+			uint32_t count = last - first + 1;
+
+			// Contours need at least two points to draw anything
+			if (count < 2)
+				return;
+
+			auto px = [&](float x) { return x * scale; };
+			auto py = [&](float y) { return -y * scale; };
+
+			// Choose a starting on-curve point, synthesising one between
+			// the first and last points if neither is on the curve.
+			float startX, startY;
+			uint32_t index;
+			const GlyfPoint& f = pts[first];
+			const GlyfPoint& l = pts[last];
+
+			if (f.OnCurve)
+			{
+				startX = f.X; startY = f.Y;
+				index = 1;
+			}
+			else if (l.OnCurve)
+			{
+				startX = l.X; startY = l.Y;
+				index = 0;
+				count--;
+			}
+			else
+			{
+				startX = (f.X + l.X) / 2; startY = (f.Y + l.Y) / 2;
+				index = 0;
+			}
+
+			path.MoveTo(px(startX), py(startY));
+
+			bool pending = false;
+			float cx = 0, cy = 0;
+
+			for (; index < count; index++)
+			{
+				const GlyfPoint& p = pts[first + index];
+				if (p.OnCurve)
+				{
+					if (pending)
+						path.QuadTo(px(cx), py(cy), px(p.X), py(p.Y));
+					else
+						path.LineTo(px(p.X), py(p.Y));
+
+					pending = false;
+				}
+				else
+				{
+					if (pending)
+					{
+						float mx = (cx + p.X) / 2, my = (cy + p.Y) / 2;
+						path.QuadTo(px(cx), py(cy), px(mx), py(my));
+					}
+
+					cx = p.X; cy = p.Y;
+					pending = true;
+				}
+			}
+
+			// Close back to the start point
+			if (pending)
+				path.QuadTo(px(cx), py(cy), px(startX), py(startY));
+
+			path.Close();
+		}
+	};
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include "SbixTable.h"
+#include "CbdtTable.h"
+#include "CffTable.h"
+
+/*
+	Classifies the image formats of every glyph in a font in a single pass
+	over its tables, rather than asking DirectWrite glyph by glyph or laying
+	out each character to see what comes back.
+
+	The result is one GlyphFormatBits mask per glyph id. Every value fits in
+	a byte, which keeps the map for a 65k glyph font at 64KB.
+*/
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// The raw tables used to classify glyphs. Any table may be left empty
+	/// if the font doesn't contain it.
+	/// </summary>
+	struct GlyphFormatTables
+	{
+		uint16_t NumGlyphs = 0;
+
+		ByteSpan Head;
+		ByteSpan Loca;
+		ByteSpan Glyf;
+		ByteSpan Cff;
+		ByteSpan Cff2;
+		ByteSpan Colr;
+		ByteSpan Svg;
+		ByteSpan Sbix;
+		ByteSpan Cblc;
+		ByteSpan Cbdt;
+	};
+
+	class GlyphFormatClassifier
+	{
+	public:
+		static std::vector<uint8_t> Classify(const GlyphFormatTables& tables)
+		{
+			std::vector<uint8_t> formats(tables.NumGlyphs, static_cast<uint8_t>(GlyphFormat_None));
+			if (formats.empty())
+				return formats;
+
+			AddTrueType(tables, formats);
+			AddCff(tables.Cff, false, formats);
+			AddCff(tables.Cff2, true, formats);
+			AddColr(tables.Colr, formats);
+			AddSvg(tables.Svg, formats);
+			AddSbix(tables.Sbix, formats);
+			AddCbdt(tables.Cblc, tables.Cbdt, formats);
+
+			return formats;
+		}
+
+	private:
+		static void Mark(std::vector<uint8_t>& formats, uint32_t glyph, uint32_t format)
+		{
+			if (glyph < formats.size())
+				formats[glyph] |= static_cast<uint8_t>(format);
+		}
+
+		/// <summary>
+		/// Glyphs with a non-empty loca entry have TrueType outlines.
+		/// </summary>
+		static void AddTrueType(const GlyphFormatTables& tables, std::vector<uint8_t>& formats)
+		{
+			if (tables.Glyf.IsEmpty() || tables.Loca.IsEmpty() || !tables.Head.Contains(50, 2))
+				return;
+
+			bool longOffsets = tables.Head.Int16(50) != 0;
+			uint32_t entrySize = longOffsets ? 4 : 2;
+			uint32_t count = static_cast<uint32_t>(formats.size());
+
+			for (uint32_t g = 0; g < count; g++)
+			{
+				if (!tables.Loca.Contains((g + 1) * entrySize, entrySize))
+					break;
+
+				uint32_t start = longOffsets ? tables.Loca.UInt32(g * 4) : tables.Loca.UInt16(g * 2) * 2u;
+				uint32_t end = longOffsets ? tables.Loca.UInt32((g + 1) * 4) : tables.Loca.UInt16((g + 1) * 2) * 2u;
+
+				if (end > start && tables.Glyf.Contains(start, end - start))
+					formats[g] |= GlyphFormat_TrueType;
+			}
+		}
+
+		/// <summary>
+		/// Every glyph in CharStrings has CFF outlines. Blank glyphs still
+		/// carry a CharString, so unlike glyf there is no cheap way to tell
+		/// an empty glyph apart without running it.
+		/// </summary>
+		static void AddCff(ByteSpan table, bool cff2, std::vector<uint8_t>& formats)
+		{
+			CffTable cff;
+			if (table.IsEmpty() || !cff.Load(table, cff2))
+				return;
+
+			uint32_t count = cff.CharStrings.Count;
+			for (uint32_t g = 0; g < count && g < formats.size(); g++)
+				formats[g] |= GlyphFormat_Cff;
+		}
+
+		static void AddColr(ByteSpan colr, std::vector<uint8_t>& formats)
+		{
+			if (!colr.Contains(0, 14))
+				return;
+
+			// Version 0 base glyph records
+			uint32_t baseCount = colr.UInt16(2);
+			ByteSpan records = colr.Slice(colr.UInt32(4));
+			for (uint32_t i = 0; i < baseCount && records.Contains(i * 6, 6); i++)
+				if (records.UInt16(i * 6 + 4) > 0)
+					Mark(formats, records.UInt16(i * 6), GlyphFormat_Colr);
+
+			// Version 1 paint records
+			if (colr.UInt16(0) >= 1 && colr.Contains(14, 4))
+			{
+				uint32_t listOffset = colr.UInt32(14);
+				if (listOffset == 0)
+					return;
+
+				ByteSpan list = colr.Slice(listOffset);
+				uint32_t paintCount = list.UInt32(0);
+				for (uint32_t i = 0; i < paintCount && list.Contains(4 + i * 6, 6); i++)
+					Mark(formats, list.UInt16(4 + i * 6), GlyphFormat_Colr);
+			}
+		}
+
+		static void AddSvg(ByteSpan svg, std::vector<uint8_t>& formats)
+		{
+			if (!svg.Contains(0, 6))
+				return;
+
+			ByteSpan list = svg.Slice(svg.UInt32(2));
+			uint32_t entries = list.UInt16(0);
+			for (uint32_t i = 0; i < entries && list.Contains(2 + i * 12, 12); i++)
+			{
+				uint32_t record = 2 + i * 12;
+				uint32_t first = list.UInt16(record);
+				uint32_t last = list.UInt16(record + 2);
+				if (list.UInt32(record + 8) == 0)
+					continue;
+
+				for (uint32_t g = first; g <= last && g < formats.size(); g++)
+					formats[g] |= GlyphFormat_Svg;
+			}
+		}
+
+		static void AddSbix(ByteSpan table, std::vector<uint8_t>& formats)
+		{
+			SbixTable sbix;
+			if (table.IsEmpty() || !sbix.Load(table, static_cast<uint16_t>(formats.size())))
+				return;
+
+			int strikes = static_cast<int>(sbix.GetStrikes().size());
+			BitmapGlyph glyph;
+			for (uint32_t g = 0; g < formats.size(); g++)
+				for (int s = 0; s < strikes; s++)
+					if (sbix.TryGetGlyphFromStrike(s, static_cast<uint16_t>(g), glyph))
+						formats[g] |= static_cast<uint8_t>(glyph.Format);
+		}
+
+		static void AddCbdt(ByteSpan cblc, ByteSpan cbdt, std::vector<uint8_t>& formats)
+		{
+			CbdtTable table;
+			if (cblc.IsEmpty() || cbdt.IsEmpty() || !table.Load(cblc, cbdt))
+				return;
+
+			for (uint32_t g = 0; g < formats.size(); g++)
+				if (table.HasGlyph(static_cast<uint16_t>(g)))
+					formats[g] |= GlyphFormat_Png;
+		}
+	};
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include "GlyphImageFormat.h"
+#include "SfntData.h"
+
+using namespace Platform;
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// The image formats available for every glyph in a font, built in a single
+	/// pass over the font's tables. Lookups are a simple array index, so this can
+	/// be queried for thousands of glyphs without creating any text layouts.
+	/// </summary>
+	public ref class GlyphFormatMap sealed
+	{
+	public:
+
+		/// <summary>
+		/// Number of glyphs in the font.
+		/// </summary>
+		property UINT32 GlyphCount { UINT32 get() { return static_cast<UINT32>(m_formats.size()); } }
+
+		/// <summary>
+		/// Every format used by at least one glyph in the font.
+		/// </summary>
+		property GlyphImageFormat Formats { GlyphImageFormat get() { return static_cast<GlyphImageFormat>(m_all); } }
+
+		/// <summary>
+		/// True if any glyph in the font has COLR, SVG or bitmap data.
+		/// </summary>
+		property bool HasColorGlyphs { bool get() { return (m_all & GlyphFormat_ColorMask) != 0; } }
+
+		GlyphImageFormat GetFormat(UINT16 glyphIndex)
+		{
+			if (glyphIndex >= m_formats.size())
+				return GlyphImageFormat::None;
+
+			return static_cast<GlyphImageFormat>(m_formats[glyphIndex]);
+		}
+
+		bool IsColorGlyph(UINT16 glyphIndex)
+		{
+			return glyphIndex < m_formats.size() && (m_formats[glyphIndex] & GlyphFormat_ColorMask) != 0;
+		}
+
+	internal:
+		GlyphFormatMap(std::vector<uint8_t>&& formats) : m_formats(std::move(formats))
+		{
+			for (uint8_t f : m_formats)
+				m_all |= f;
+		}
+
+	private:
+		std::vector<uint8_t> m_formats;
+		uint32_t m_all = 0;
+	};
+}
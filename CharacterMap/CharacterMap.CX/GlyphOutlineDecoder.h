@@ -0,0 +1,227 @@
+#pragma once
+
+#include <dwrite_3.h>
+#include <wrl.h>
+#include <vector>
+#include "FontTable.h"
+#include "CffTable.h"
+#include "GlyfTable.h"
+#include "GvarTable.h"
+#include "VariationAxes.h"
+#include "VariationInstanceCache.h"
+#include "GlyphPath.h"
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Decodes glyph outlines for a DirectWrite font face straight from its
+	/// tables when possible, so callers can skip creating a Direct2D path
+	/// geometry per glyph. TryDecode returns false when the face needs
+	/// DirectWrite to produce the outline, and the caller should fall back
+	/// to IDWriteFontFace::GetGlyphRunOutline. Variable faces are decoded
+	/// at their own axis values, using gvar or CFF2 blends. Given a cache and
+	/// the face's cache key, the normalized coordinates and gvar's shared
+	/// tuple scalars are worked out once per instance and shared by every
+	/// decoder for it.
+	/// </summary>
+	class GlyphOutlineDecoder
+	{
+	public:
+		GlyphOutlineDecoder(
+			Microsoft::WRL::ComPtr<IDWriteFontFace3> face,
+			VariationInstanceCache* instances = nullptr,
+			const std::string& faceKey = std::string())
+		{
+			// Simulations change the outline DirectWrite produces, which
+			// the raw tables know nothing about.
+			if (face->GetSimulations() != DWRITE_FONT_SIMULATIONS_NONE)
+				return;
+
+			Microsoft::WRL::ComPtr<IDWriteFontFace> f;
+			face.As(&f);
+
+			std::vector<float> coords;
+			bool varies = false;
+
+			Microsoft::WRL::ComPtr<IDWriteFontFace5> face5;
+			bool variable = SUCCEEDED(face.As(&face5)) && face5->HasVariations();
+			bool shared = variable && instances != nullptr && !faceKey.empty();
+
+			std::shared_ptr<const VariationInstance> instance;
+			if (shared)
+				instance = instances->TryGet(faceKey);
+
+			if (instance != nullptr)
+			{
+				coords = instance->Coords;
+				varies = instance->Varies;
+			}
+			else if (variable)
+			{
+				if (!GetCoordinates(f, face5, coords, varies))
+					return;
+			}
+
+			std::shared_ptr<const std::vector<float>> gvarScalars;
+
+			m_head = FontTable(f, DWRITE_MAKE_OPENTYPE_TAG('h', 'e', 'a', 'd'));
+			m_loca = FontTable(f, DWRITE_MAKE_OPENTYPE_TAG('l', 'o', 'c', 'a'));
+			m_glyf = FontTable(f, DWRITE_MAKE_OPENTYPE_TAG('g', 'l', 'y', 'f'));
+
+			m_hasGlyf = m_glyf.Exists()
+				&& m_glyfTable.Load(m_head.Data(), m_loca.Data(), m_glyf.Data(), face->GetGlyphCount());
+
+			if (m_hasGlyf && varies)
+			{
+				// Without gvar the outlines simply don't vary
+				m_gvar = FontTable(f, DWRITE_MAKE_OPENTYPE_TAG('g', 'v', 'a', 'r'));
+				if (m_gvar.Exists())
+				{
+					if (!m_gvarTable.Load(m_gvar.Data(), static_cast<uint32_t>(coords.size())))
+					{
+						m_hasGlyf = false;
+						return;
+					}
+
+					m_gvarTable.SetCoordinates(coords, instance != nullptr ? instance->GvarScalars : nullptr);
+					m_glyfTable.SetVariations(&m_gvarTable);
+					gvarScalars = m_gvarTable.GetSharedScalars();
+				}
+			}
+
+			if (shared && instance == nullptr)
+			{
+				auto added = std::make_shared<VariationInstance>();
+				added->Coords = coords;
+				added->Varies = varies;
+				added->GvarScalars = gvarScalars;
+				instances->Add(faceKey, std::move(added));
+			}
+
+			if (m_hasGlyf)
+				return;
+
+			m_cff = FontTable(f, DWRITE_MAKE_OPENTYPE_TAG('C', 'F', 'F', ' '));
+			bool cff2 = !m_cff.Exists();
+			if (cff2)
+				m_cff = FontTable(f, DWRITE_MAKE_OPENTYPE_TAG('C', 'F', 'F', '2'));
+
+			DWRITE_FONT_METRICS metrics{};
+			face->GetMetrics(&metrics);
+			m_unitsPerEm = metrics.designUnitsPerEm;
+
+			m_hasCff = m_cff.Exists()
+				&& m_unitsPerEm > 0
+				&& m_cffTable.Load(m_cff.Data(), cff2);
+
+			if (m_hasCff && varies)
+				m_cffTable.SetVariationCoordinates(coords.data(), static_cast<uint32_t>(coords.size()));
+		}
+
+		bool CanDecode() const { return m_hasGlyf || m_hasCff; }
+
+		/// <summary>
+		/// Decodes a glyph at the given em size, in the same coordinate space
+		/// GetGlyphRunOutline uses.
+		/// </summary>
+		bool TryDecode(UINT16 glyphIndex, float emSize, GlyphPath& path)
+		{
+			if (m_hasGlyf)
+				return m_glyfTable.Decode(glyphIndex, path, emSize / m_glyfTable.UnitsPerEm);
+
+			if (m_hasCff)
+				return m_cffTable.Decode(glyphIndex, path, emSize / m_unitsPerEm);
+
+			return false;
+		}
+
+		/// <summary>
+		/// Measures a glyph at the given em size without building its path
+		/// where the font allows. Tight bounds follow the extrema of curves;
+		/// otherwise the box around every control point is returned, which
+		/// for TrueType outlines is read from the glyph header.
+		/// </summary>
+		bool TryGetBounds(UINT16 glyphIndex, float emSize, bool tight, PathBounds& bounds)
+		{
+			if (m_hasGlyf)
+			{
+				float scale = emSize / m_glyfTable.UnitsPerEm;
+				if (!tight)
+					return m_glyfTable.GetControlBounds(glyphIndex, bounds, scale);
+
+				if (!m_glyfTable.Decode(glyphIndex, m_path, scale))
+					return false;
+
+				bounds = m_path.GetBounds();
+				return true;
+			}
+
+			if (m_hasCff)
+				return m_cffTable.GetBounds(glyphIndex, bounds, emSize / m_unitsPerEm, tight);
+
+			return false;
+		}
+
+	private:
+		FontTable m_head;
+		FontTable m_loca;
+		FontTable m_glyf;
+		GlyfTable m_glyfTable;
+		bool m_hasGlyf = false;
+
+		FontTable m_gvar;
+		GvarTable m_gvarTable;
+
+		FontTable m_cff;
+		CffTable m_cffTable;
+		UINT16 m_unitsPerEm = 0;
+		bool m_hasCff = false;
+
+		GlyphPath m_path;
+
+		/// <summary>
+		/// Normalizes the face's axis values through fvar and avar. Axes the
+		/// face doesn't give a value for stay at their default.
+		/// </summary>
+		static bool GetCoordinates(
+			Microsoft::WRL::ComPtr<IDWriteFontFace> f,
+			Microsoft::WRL::ComPtr<IDWriteFontFace5> face5,
+			std::vector<float>& coords,
+			bool& varies)
+		{
+			FontTable fvar(f, DWRITE_MAKE_OPENTYPE_TAG('f', 'v', 'a', 'r'));
+			FontTable avar(f, DWRITE_MAKE_OPENTYPE_TAG('a', 'v', 'a', 'r'));
+
+			VariationAxes axes;
+			if (!axes.Load(fvar.Data(), avar.Data()))
+				return false;
+
+			std::vector<DWRITE_FONT_AXIS_VALUE> values(face5->GetFontAxisValueCount());
+			if (FAILED(face5->GetFontAxisValues(values.data(), static_cast<UINT32>(values.size()))))
+				return false;
+
+			std::vector<float> user(axes.AxisCount());
+			for (uint32_t i = 0; i < axes.AxisCount(); i++)
+			{
+				const VariationAxis& axis = axes.GetAxis(i);
+				user[i] = axis.Default;
+
+				// fvar tags are big-endian, DirectWrite's are in byte order
+				for (auto& value : values)
+				{
+					if (ToSfntTag(value.axisTag) == axis.Tag)
+						user[i] = value.value;
+				}
+			}
+
+			varies = axes.Normalize(user.data(), coords);
+			return true;
+		}
+
+		static uint32_t ToSfntTag(DWRITE_FONT_AXIS_TAG tag)
+		{
+			uint32_t t = static_cast<uint32_t>(tag);
+			return (t & 0xFF) << 24 | (t & 0xFF00) << 8 | (t >> 8 & 0xFF00) | t >> 24;
+		}
+	};
+}
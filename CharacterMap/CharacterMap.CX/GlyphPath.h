@@ -0,0 +1,570 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include "SvgPathBuilder.h"
+
+/*
+	Portable path command buffer filled by the native outline decoders.
+
+	Verbs and coordinates are stored in two flat arrays so a single
+	GlyphPath can be cleared and reused for every glyph in a font without
+	reallocating once it has grown to fit the largest outline.
+*/
+
+namespace CharacterMapCX
+{
+	enum class PathVerb : uint8_t
+	{
+		Move,	// 1 point
+		Line,	// 1 point
+		Quad,	// 2 points: control, end
+		Cubic,	// 3 points: control 1, control 2, end
+		Close,	// 0 points
+	};
+
+	struct PathBounds
+	{
+		float Left = 0;
+		float Top = 0;
+		float Right = 0;
+		float Bottom = 0;
+
+		bool IsEmpty() const { return Right < Left || Bottom < Top; }
+
+		/// <summary>
+		/// Bounds that any included point will replace.
+		/// </summary>
+		static PathBounds Empty()
+		{
+			PathBounds b;
+			b.Left = b.Top = INFINITY;
+			b.Right = b.Bottom = -INFINITY;
+			return b;
+		}
+	};
+
+	/// <summary>
+	/// Controls the syntax used by GlyphPath::WriteSvg. The defaults match
+	/// SVGGeometrySink.
+	/// </summary>
+	struct SvgWriteOptions
+	{
+		/// <summary>
+		/// XAML fill rule prefix, or negative for none.
+		/// </summary>
+		int FillMode = 1;
+
+		/// <summary>
+		/// Write lowercase commands with coordinates relative to the
+		/// previous point.
+		/// </summary>
+		bool Relative = false;
+
+		/// <summary>
+		/// Leave out a command letter when it repeats the previous one.
+		/// </summary>
+		bool ElideCommands = false;
+
+		/// <summary>
+		/// Write quadratic curves as the equivalent cubics, as Direct2D does,
+		/// for consumers that only accept cubic segments.
+		/// </summary>
+		bool RaiseQuadratics = false;
+	};
+
+	class GlyphPath
+	{
+	public:
+		std::vector<PathVerb> Verbs;
+
+		/// <summary>
+		/// Interleaved x, y coordinates for every point of every verb.
+		/// </summary>
+		std::vector<float> Points;
+
+		void Clear()
+		{
+			Verbs.clear();
+			Points.clear();
+		}
+
+		bool IsEmpty() const { return Verbs.empty(); }
+
+		/// <summary>
+		/// True if the path contains any drawing segments, rather than just
+		/// empty figures.
+		/// </summary>
+		bool HasSegments() const
+		{
+			for (PathVerb v : Verbs)
+				if (v != PathVerb::Move && v != PathVerb::Close)
+					return true;
+
+			return false;
+		}
+
+		void MoveTo(float x, float y)
+		{
+			Verbs.push_back(PathVerb::Move);
+			Add(x, y);
+		}
+
+		void LineTo(float x, float y)
+		{
+			Verbs.push_back(PathVerb::Line);
+			Add(x, y);
+		}
+
+		void QuadTo(float cx, float cy, float x, float y)
+		{
+			Verbs.push_back(PathVerb::Quad);
+			Add(cx, cy);
+			Add(x, y);
+		}
+
+		void CubicTo(float c1x, float c1y, float c2x, float c2y, float x, float y)
+		{
+			Verbs.push_back(PathVerb::Cubic);
+			Add(c1x, c1y);
+			Add(c2x, c2y);
+			Add(x, y);
+		}
+
+		void Close()
+		{
+			Verbs.push_back(PathVerb::Close);
+		}
+
+		static uint32_t PointCount(PathVerb verb)
+		{
+			switch (verb)
+			{
+			case PathVerb::Move:
+			case PathVerb::Line: return 1;
+			case PathVerb::Quad: return 2;
+			case PathVerb::Cubic: return 3;
+			default: return 0;
+			}
+		}
+
+		/// <summary>
+		/// Applies an affine transform to every point in the path.
+		/// </summary>
+		void Transform(float m11, float m12, float m21, float m22, float dx, float dy)
+		{
+			for (size_t i = 0; i + 1 < Points.size(); i += 2)
+			{
+				float x = Points[i];
+				float y = Points[i + 1];
+				Points[i] = x * m11 + y * m21 + dx;
+				Points[i + 1] = x * m12 + y * m22 + dy;
+			}
+		}
+
+		/// <summary>
+		/// Calculates the exact bounds of the path, including the extrema of
+		/// any curves rather than their control points.
+		/// </summary>
+		PathBounds GetBounds() const
+		{
+			PathBounds b = PathBounds::Empty();
+
+			const float* p = Points.data();
+			float cx = 0, cy = 0;
+
+			for (PathVerb verb : Verbs)
+			{
+				switch (verb)
+				{
+				case PathVerb::Move:
+				case PathVerb::Line:
+					cx = p[0]; cy = p[1];
+					Include(b, cx, cy);
+					p += 2;
+					break;
+
+				case PathVerb::Quad:
+					Include(b, p[2], p[3]);
+					QuadExtrema(b, cx, cy, p[0], p[1], p[2], p[3]);
+					cx = p[2]; cy = p[3];
+					p += 4;
+					break;
+
+				case PathVerb::Cubic:
+					Include(b, p[4], p[5]);
+					CubicExtrema(b, cx, cy, p[0], p[1], p[2], p[3], p[4], p[5]);
+					cx = p[4]; cy = p[5];
+					p += 6;
+					break;
+
+				default:
+					break;
+				}
+			}
+
+			return b;
+		}
+
+		/// <summary>
+		/// Appends the path in the same SVG path syntax produced by
+		/// SVGGeometrySink. Quadratic curves, as used by TrueType, are written
+		/// as Q commands, or T where the control point is the reflection of the
+		/// previous one once both are rounded, so the path reads back exactly.
+		/// A negative fill mode omits the XAML fill rule prefix, for use in
+		/// SVG documents.
+		/// </summary>
+		void WriteSvg(SvgPathBuilder& b, int fillMode = 1) const
+		{
+			SvgWriteOptions options;
+			options.FillMode = fillMode;
+			WriteSvg(b, options);
+		}
+
+		void WriteSvg(SvgPathBuilder& b, const SvgWriteOptions& options) const
+		{
+			if (options.FillMode >= 0)
+				b.FillMode(options.FillMode);
+
+			const float* p = Points.data();
+			float cx = 0, cy = 0;
+			float sx = 0, sy = 0;
+
+			// In relative mode each delta is taken from the previous point as
+			// it was written, after rounding, so errors don't accumulate along
+			// a figure.
+			double ox = 0, oy = 0;
+			double fx = 0, fy = 0;
+			char last = 0;
+
+			// The previous quadratic control point as written, which a T
+			// command reflects about the current point.
+			bool smooth = false;
+			double qx = 0, qy = 0;
+
+			auto command = [&](char c)
+			{
+				if (options.Relative)
+					c = static_cast<char>(c - 'A' + 'a');
+
+				// A repeated moveto would be read as a lineto, and closepath
+				// takes no arguments, so only drawing commands are elided.
+				if (!options.ElideCommands || c != last || c == 'm' || c == 'M' || c == 'z' || c == 'Z')
+					b.Command(c);
+
+				last = c;
+			};
+
+			auto point = [&](float x, float y)
+			{
+				if (options.Relative)
+				{
+					// Deltas stay in double so they add back up exactly
+					b.Number(b.Round(x) - ox);
+					b.Number(b.Round(y) - oy);
+				}
+				else
+					b.Point(x, y);
+			};
+
+			auto moveTo = [&](float x, float y)
+			{
+				cx = x; cy = y;
+				if (options.Relative)
+				{
+					ox = b.Round(x);
+					oy = b.Round(y);
+				}
+			};
+
+			for (PathVerb verb : Verbs)
+			{
+				bool afterQuad = smooth;
+				smooth = false;
+
+				switch (verb)
+				{
+				case PathVerb::Move:
+					command('M');
+					point(p[0], p[1]);
+					moveTo(p[0], p[1]);
+					sx = cx; sy = cy;
+					fx = ox; fy = oy;
+					p += 2;
+					break;
+
+				case PathVerb::Line:
+					command('L');
+					point(p[0], p[1]);
+					moveTo(p[0], p[1]);
+					p += 2;
+					break;
+
+				case PathVerb::Quad:
+					if (options.RaiseQuadratics)
+					{
+						command('C');
+						point(cx + 2.0f / 3.0f * (p[0] - cx), cy + 2.0f / 3.0f * (p[1] - cy));
+						point(p[2] + 2.0f / 3.0f * (p[0] - p[2]), p[3] + 2.0f / 3.0f * (p[1] - p[3]));
+					}
+					else
+					{
+						// TrueType's implied on-curve points sit midway between
+						// two control points, so most curves after the first in
+						// a run can be written as T.
+						double rx = b.Round(p[0]);
+						double ry = b.Round(p[1]);
+						if (afterQuad
+							&& b.Round(2 * b.Round(cx) - qx) == rx
+							&& b.Round(2 * b.Round(cy) - qy) == ry)
+						{
+							command('T');
+						}
+						else
+						{
+							command('Q');
+							point(p[0], p[1]);
+						}
+
+						qx = rx; qy = ry;
+						smooth = true;
+					}
+
+					point(p[2], p[3]);
+					moveTo(p[2], p[3]);
+					p += 4;
+					break;
+
+				case PathVerb::Cubic:
+					command('C');
+					point(p[0], p[1]);
+					point(p[2], p[3]);
+					point(p[4], p[5]);
+					moveTo(p[4], p[5]);
+					p += 6;
+					break;
+
+				case PathVerb::Close:
+					command('Z');
+
+					// Closing a figure returns to its start point
+					cx = sx; cy = sy;
+					ox = fx; oy = fy;
+					break;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Removes points from runs of straight lines that stay within the
+		/// given distance of the simplified line, using Douglas-Peucker.
+		/// Curves and the ends of each run are kept, so the figure's shape
+		/// and closure are unchanged. A tiny tolerance just removes
+		/// duplicate and collinear points.
+		/// </summary>
+		void SimplifyLines(float tolerance)
+		{
+			if (tolerance < 0)
+				return;
+
+			std::vector<PathVerb> verbs;
+			std::vector<float> points;
+			verbs.reserve(Verbs.size());
+			points.reserve(Points.size());
+
+			std::vector<uint8_t> keep;
+			const float* p = Points.data();
+			size_t i = 0;
+
+			while (i < Verbs.size())
+			{
+				PathVerb verb = Verbs[i];
+				if (verb != PathVerb::Line || verbs.empty() || verbs.back() == PathVerb::Close)
+				{
+					uint32_t count = PointCount(verb) * 2;
+					verbs.push_back(verb);
+					points.insert(points.end(), p, p + count);
+					p += count;
+					i++;
+					continue;
+				}
+
+				// A run of lines, starting from the last point written
+				size_t run = 0;
+				while (i + run < Verbs.size() && Verbs[i + run] == PathVerb::Line)
+					run++;
+
+				size_t start = points.size() - 2;
+				points.insert(points.end(), p, p + run * 2);
+				p += run * 2;
+				i += run;
+
+				size_t total = run + 1;
+				keep.assign(total, 0);
+				keep[0] = keep[total - 1] = 1;
+				MarkDouglasPeucker(points.data() + start, 0, total - 1, tolerance * tolerance, keep);
+
+				size_t write = start + 2;
+				for (size_t k = 1; k < total; k++)
+				{
+					if (!keep[k])
+						continue;
+
+					points[write] = points[start + k * 2];
+					points[write + 1] = points[start + k * 2 + 1];
+					write += 2;
+					verbs.push_back(PathVerb::Line);
+				}
+
+				points.resize(write);
+			}
+
+			Verbs.swap(verbs);
+			Points.swap(points);
+		}
+
+		/// <summary>
+		/// Grows the bounds to include a point.
+		/// </summary>
+		static void Include(PathBounds& b, float x, float y)
+		{
+			b.Left = std::min(b.Left, x);
+			b.Right = std::max(b.Right, x);
+			b.Top = std::min(b.Top, y);
+			b.Bottom = std::max(b.Bottom, y);
+		}
+
+		/// <summary>
+		/// Grows the bounds to include the turning points of a curve. The
+		/// caller includes its end points.
+		/// </summary>
+		static void QuadExtrema(PathBounds& b, float x0, float y0, float x1, float y1, float x2, float y2)
+		{
+			// Derivative is linear, so each axis has at most one turning point
+			float dx = x0 - 2 * x1 + x2;
+			if (dx != 0)
+			{
+				float t = (x0 - x1) / dx;
+				if (t > 0 && t < 1)
+					Include(b, QuadAt(x0, x1, x2, t), QuadAt(y0, y1, y2, t));
+			}
+
+			float dy = y0 - 2 * y1 + y2;
+			if (dy != 0)
+			{
+				float t = (y0 - y1) / dy;
+				if (t > 0 && t < 1)
+					Include(b, QuadAt(x0, x1, x2, t), QuadAt(y0, y1, y2, t));
+			}
+		}
+
+		static void CubicExtrema(PathBounds& b, float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3)
+		{
+			float roots[4];
+			int count = CubicRoots(x0, x1, x2, x3, roots);
+			count += CubicRoots(y0, y1, y2, y3, roots + count);
+
+			for (int i = 0; i < count; i++)
+				Include(b, CubicAt(x0, x1, x2, x3, roots[i]), CubicAt(y0, y1, y2, y3, roots[i]));
+		}
+
+	private:
+		void Add(float x, float y)
+		{
+			Points.push_back(x);
+			Points.push_back(y);
+		}
+
+		static float SegmentDistanceSquared(const float* a, const float* b, const float* p)
+		{
+			float dx = b[0] - a[0], dy = b[1] - a[1];
+			float length = dx * dx + dy * dy;
+			float t = length > 0 ? ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / length : 0;
+			t = std::max(0.0f, std::min(1.0f, t));
+
+			float ex = a[0] + t * dx - p[0];
+			float ey = a[1] + t * dy - p[1];
+			return ex * ex + ey * ey;
+		}
+
+		static void MarkDouglasPeucker(const float* points, size_t first, size_t last, float toleranceSquared, std::vector<uint8_t>& keep)
+		{
+			// Iterative, so long runs from malformed outlines can't overflow the stack
+			std::vector<std::pair<size_t, size_t>> ranges{ { first, last } };
+			while (!ranges.empty())
+			{
+				auto range = ranges.back();
+				ranges.pop_back();
+
+				float furthest = -1;
+				size_t index = 0;
+				for (size_t k = range.first + 1; k < range.second; k++)
+				{
+					float d = SegmentDistanceSquared(points + range.first * 2, points + range.second * 2, points + k * 2);
+					if (d > furthest)
+					{
+						furthest = d;
+						index = k;
+					}
+				}
+
+				if (furthest > toleranceSquared)
+				{
+					keep[index] = 1;
+					ranges.push_back({ range.first, index });
+					ranges.push_back({ index, range.second });
+				}
+			}
+		}
+
+		static float QuadAt(float p0, float p1, float p2, float t)
+		{
+			float mt = 1 - t;
+			return mt * mt * p0 + 2 * mt * t * p1 + t * t * p2;
+		}
+
+		static float CubicAt(float p0, float p1, float p2, float p3, float t)
+		{
+			float mt = 1 - t;
+			return mt * mt * mt * p0 + 3 * mt * mt * t * p1 + 3 * mt * t * t * p2 + t * t * t * p3;
+		}
+
+		/// <summary>
+		/// Finds the values of t in (0, 1) where the derivative of a single
+		/// cubic axis is zero. Writes at most two roots.
+		/// </summary>
+		static int CubicRoots(float p0, float p1, float p2, float p3, float* roots)
+		{
+			// B'(t) / 3 = a t^2 + b t + c
+			double a = -p0 + 3.0 * p1 - 3.0 * p2 + p3;
+			double b = 2.0 * (p0 - 2.0 * p1 + p2);
+			double c = p1 - p0;
+			int count = 0;
+
+			auto add = [&](double t)
+			{
+				if (t > 0 && t < 1)
+					roots[count++] = static_cast<float>(t);
+			};
+
+			if (std::fabs(a) < 1e-12)
+			{
+				if (std::fabs(b) > 1e-12)
+					add(-c / b);
+				return count;
+			}
+
+			double disc = b * b - 4 * a * c;
+			if (disc < 0)
+				return count;
+
+			double s = std::sqrt(disc);
+			add((-b + s) / (2 * a));
+			add((-b - s) / (2 * a));
+			return count;
+		}
+	};
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "GlyphPath.h"
+#include "PathEncoding.h"
+
+/*
+	Bounded, thread-safe LRU cache of decoded glyph outlines.
+
+	Entries are keyed by an opaque byte string describing the font face
+	(file identity, face index, simulations and axis values), followed by
+	the glyph and em size. Outlines are stored before any output transform
+	or formatting, so one entry serves every precision, fill rule and
+	transform a caller asks for.
+
+	Each outline is held as a PathEncoding stream rather than as floats,
+	which fits two to three times as many glyphs in the same budget.
+	Coordinates are rounded to 1/65536 of the em, so callers should round
+	an outline they add through the same encoding before using it, for a
+	hit to match the miss that added it.
+*/
+
+namespace CharacterMapCX
+{
+	class GlyphPathCache
+	{
+	public:
+		static constexpr size_t DefaultBudget = 16 * 1024 * 1024;
+
+		/// <summary>
+		/// Appends the glyph and em size to a face key to make an entry key.
+		/// </summary>
+		static void MakeKey(const std::string& faceKey, uint16_t glyph, float emSize, std::string& key)
+		{
+			key.assign(faceKey);
+			key.append(reinterpret_cast<const char*>(&glyph), sizeof(glyph));
+			key.append(reinterpret_cast<const char*>(&emSize), sizeof(emSize));
+		}
+
+		/// <summary>
+		/// Fraction bits that round coordinates to about 1/65536 of the em,
+		/// such as 1/256 DIP at 256 DIPs, while leaving room for outlines
+		/// many ems across.
+		/// </summary>
+		static uint8_t FractionBits(float emSize)
+		{
+			int exponent = 0;
+			std::frexp(emSize, &exponent);
+			int bits = 17 - exponent;
+			return static_cast<uint8_t>(bits < 0 ? 0 : bits > 16 ? 16 : bits);
+		}
+
+		/// <summary>
+		/// Sets the approximate maximum memory used by cached outlines. A
+		/// budget of zero disables caching.
+		/// </summary>
+		void SetBudget(size_t bytes)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_budget = bytes;
+			Trim();
+		}
+
+		size_t GetBudget()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_budget;
+		}
+
+		size_t GetSize()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_size;
+		}
+
+		void Clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_map.clear();
+			m_entries.clear();
+			m_size = 0;
+		}
+
+		/// <summary>
+		/// Decodes a cached outline into path and marks it most recently used.
+		/// </summary>
+		bool TryGet(const std::string& key, GlyphPath& path)
+		{
+			std::shared_ptr<const std::vector<uint8_t>> encoded;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto it = m_map.find(key);
+				if (it == m_map.end())
+					return false;
+
+				m_entries.splice(m_entries.begin(), m_entries, it->second);
+				encoded = it->second->Encoded;
+			}
+
+			// Decoded outside the lock, as the stream is never changed
+			return PathEncoding::Decode(ByteSpan(encoded->data(), static_cast<uint32_t>(encoded->size())), path);
+		}
+
+		/// <summary>
+		/// Adds an outline encoded by PathEncoding with FractionBits.
+		/// </summary>
+		void Add(const std::string& key, std::vector<uint8_t>&& encoded)
+		{
+			size_t cost = EntryOverhead + key.size() * 2 + encoded.size();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (cost > m_budget)
+				return;
+
+			// Another thread may have decoded the same glyph
+			auto it = m_map.find(key);
+			if (it != m_map.end())
+			{
+				m_entries.splice(m_entries.begin(), m_entries, it->second);
+				return;
+			}
+
+			m_entries.emplace_front();
+			Entry& entry = m_entries.front();
+			entry.Key = key;
+			entry.Encoded = std::make_shared<const std::vector<uint8_t>>(std::move(encoded));
+			entry.Cost = cost;
+
+			m_map.emplace(entry.Key, m_entries.begin());
+			m_size += cost;
+			Trim();
+		}
+
+	private:
+		struct Entry
+		{
+			std::string Key;
+			std::shared_ptr<const std::vector<uint8_t>> Encoded;
+			size_t Cost = 0;
+		};
+
+		// Rough per-entry overhead of the list node, map node and vectors
+		static constexpr size_t EntryOverhead = 128;
+
+		std::mutex m_mutex;
+		std::list<Entry> m_entries;
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_map;
+		size_t m_size = 0;
+		size_t m_budget = DefaultBudget;
+
+		void Trim()
+		{
+			while (m_size > m_budget && !m_entries.empty())
+			{
+				Entry& last = m_entries.back();
+				m_size -= last.Cost;
+				m_map.erase(last.Key);
+				m_entries.pop_back();
+			}
+		}
+	};
+}
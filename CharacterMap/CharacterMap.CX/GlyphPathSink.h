@@ -0,0 +1,70 @@
+#pragma once
+
+#include <dwrite_3.h>
+#include "GlyphPath.h"
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Records an outline from IDWriteFontFace::GetGlyphRunOutline into a
+	/// GlyphPath, so glyphs the native decoders can't handle still avoid
+	/// creating a Direct2D path geometry. The sink lives on the stack of its
+	/// caller and is never handed out, so reference counting is a no-op.
+	/// </summary>
+	class GlyphPathSink : public IDWriteGeometrySink
+	{
+	public:
+		GlyphPathSink(GlyphPath& path) : m_path(path) { }
+
+		IFACEMETHODIMP_(void) SetFillMode(D2D1_FILL_MODE fillMode) { }
+
+		IFACEMETHODIMP_(void) SetSegmentFlags(D2D1_PATH_SEGMENT vertexFlags) { }
+
+		IFACEMETHODIMP_(void) BeginFigure(D2D1_POINT_2F startPoint, D2D1_FIGURE_BEGIN figureBegin)
+		{
+			m_path.MoveTo(startPoint.x, startPoint.y);
+		}
+
+		IFACEMETHODIMP_(void) AddLines(const D2D1_POINT_2F* points, UINT32 pointsCount)
+		{
+			for (UINT32 i = 0; i < pointsCount; i++)
+				m_path.LineTo(points[i].x, points[i].y);
+		}
+
+		IFACEMETHODIMP_(void) AddBeziers(const D2D1_BEZIER_SEGMENT* beziers, UINT32 beziersCount)
+		{
+			for (UINT32 i = 0; i < beziersCount; i++)
+			{
+				auto& z = beziers[i];
+				m_path.CubicTo(z.point1.x, z.point1.y, z.point2.x, z.point2.y, z.point3.x, z.point3.y);
+			}
+		}
+
+		IFACEMETHODIMP_(void) EndFigure(D2D1_FIGURE_END figureEnd)
+		{
+			if (figureEnd == D2D1_FIGURE_END_CLOSED)
+				m_path.Close();
+		}
+
+		IFACEMETHODIMP Close() { return S_OK; }
+
+		IFACEMETHODIMP_(unsigned long) AddRef() { return 1; }
+
+		IFACEMETHODIMP_(unsigned long) Release() { return 1; }
+
+		IFACEMETHODIMP QueryInterface(IID const& riid, void** ppvObject)
+		{
+			if (__uuidof(IDWriteGeometrySink) == riid || __uuidof(IUnknown) == riid)
+			{
+				*ppvObject = this;
+				return S_OK;
+			}
+
+			*ppvObject = nullptr;
+			return E_NOINTERFACE;
+		}
+
+	private:
+		GlyphPath& m_path;
+	};
+}
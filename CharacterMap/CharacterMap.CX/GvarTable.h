@@ -0,0 +1,581 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "SfntData.h"
+#include "VariationAxes.h"
+
+/*
+	TrueType glyph variations.
+	gvar Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/gvar
+	Tuple data: https://docs.microsoft.com/en-us/typography/opentype/spec/otvarcommonformats
+
+	Each glyph carries a set of tuples, each with a region of the design
+	space and deltas for some or all of its points. The deltas of every
+	tuple whose region contains the instance are scaled and added to the
+	default outline, with deltas for points a tuple leaves out inferred
+	from their neighbours (IUP).
+
+	Scalars for the shared tuples depend only on the instance, so they are
+	worked out once in SetCoordinates and reused for every glyph. They are
+	immutable once made, so GetSharedScalars lets another GvarTable for the
+	same instance reuse them. Like GlyfTable, an instance keeps scratch
+	buffers and must not be used from more than one thread at a time.
+*/
+
+namespace CharacterMapCX
+{
+	class GvarTable
+	{
+	public:
+		/// <summary>
+		/// Prepares the table. It must stay alive for as long as this
+		/// instance is used.
+		/// </summary>
+		bool Load(ByteSpan gvar, uint32_t axisCount)
+		{
+			m_gvar = gvar;
+			m_glyphCount = 0;
+			m_isDefault = true;
+			m_coords.clear();
+			m_sharedScalars.reset();
+
+			if (!gvar.Contains(0, 20) || gvar.UInt16(0) != 1 || gvar.UInt16(4) != axisCount)
+				return false;
+
+			m_axisCount = axisCount;
+			m_sharedTupleCount = gvar.UInt16(6);
+			m_sharedTuplesOffset = gvar.UInt32(8);
+			m_longOffsets = (gvar.UInt16(14) & 1) != 0;
+			m_dataOffset = gvar.UInt32(16);
+
+			uint32_t glyphCount = gvar.UInt16(12);
+			if (!gvar.Contains(20, (glyphCount + 1) * (m_longOffsets ? 4 : 2))
+				|| !gvar.Contains(m_sharedTuplesOffset, m_sharedTupleCount * axisCount * 2))
+				return false;
+
+			m_glyphCount = glyphCount;
+			return true;
+		}
+
+		/// <summary>
+		/// Sets the instance, as normalized coordinates in fvar axis order.
+		/// Shared tuple scalars from GetSharedScalars for the same font and
+		/// coordinates can be passed in rather than worked out again.
+		/// </summary>
+		void SetCoordinates(const std::vector<float>& coords, std::shared_ptr<const std::vector<float>> sharedScalars = nullptr)
+		{
+			m_coords = coords;
+			m_coords.resize(m_axisCount);
+
+			m_isDefault = true;
+			for (float c : m_coords)
+				if (c != 0)
+					m_isDefault = false;
+
+			if (sharedScalars != nullptr && sharedScalars->size() == m_sharedTupleCount)
+			{
+				m_sharedScalars = std::move(sharedScalars);
+				return;
+			}
+
+			auto scalars = std::make_shared<std::vector<float>>(m_sharedTupleCount, 0.0f);
+			if (!m_isDefault)
+			{
+				for (uint32_t t = 0; t < m_sharedTupleCount; t++)
+				{
+					uint32_t tuple = m_sharedTuplesOffset + t * m_axisCount * 2;
+					(*scalars)[t] = PeakScalar(m_gvar, tuple);
+				}
+			}
+
+			m_sharedScalars = std::move(scalars);
+		}
+
+		/// <summary>
+		/// The scalar of each shared tuple at the current coordinates.
+		/// </summary>
+		std::shared_ptr<const std::vector<float>> GetSharedScalars() const { return m_sharedScalars; }
+
+		/// <summary>
+		/// True when the instance is the default, so outlines are unchanged.
+		/// </summary>
+		bool IsDefault() const { return m_isDefault; }
+
+		/// <summary>
+		/// Adds the glyph's variation deltas to its points, which must still
+		/// be in their default positions. endPoints holds the last point of
+		/// each contour and is used to infer deltas for points a tuple
+		/// leaves out; composite glyphs pass no contours, and their points
+		/// are the component offsets. Returns false if the data is malformed.
+		/// </summary>
+		template <typename TPoint>
+		bool ApplyDeltas(uint16_t glyphId, TPoint* points, uint32_t pointCount, const uint32_t* endPoints, uint32_t contourCount)
+		{
+			if (m_isDefault || glyphId >= m_glyphCount || pointCount == 0)
+				return true;
+
+			ByteSpan data = GetGlyphData(glyphId);
+			if (data.IsEmpty())
+				return true;
+
+			if (!data.Contains(0, 4))
+				return false;
+
+			uint16_t tupleCount = data.UInt16(0);
+			uint32_t serialized = data.UInt16(2);
+			uint32_t header = 4;
+
+			// Every point a tuple can address, including the four phantom
+			// points that only move the metrics.
+			uint32_t totalPoints = pointCount + 4;
+
+			bool sharedAll = false;
+			if (tupleCount & SharedPointNumbers)
+			{
+				if (!ReadPoints(data, serialized, m_sharedPoints, sharedAll))
+					return false;
+			}
+
+			m_totalX.assign(pointCount, 0.0f);
+			m_totalY.assign(pointCount, 0.0f);
+
+			for (uint32_t t = 0; t < (tupleCount & TupleCountMask); t++)
+			{
+				if (!data.Contains(header, 4))
+					return false;
+
+				uint32_t size = data.UInt16(header);
+				uint16_t index = data.UInt16(header + 2);
+				header += 4;
+
+				float scalar;
+				if (index & EmbeddedPeakTuple)
+				{
+					if (!data.Contains(header, m_axisCount * 2))
+						return false;
+
+					if (index & IntermediateRegion)
+					{
+						if (!data.Contains(header, m_axisCount * 6))
+							return false;
+
+						scalar = RegionScalar(data, header, data, header + m_axisCount * 2);
+					}
+					else
+						scalar = PeakScalar(data, header);
+
+					header += m_axisCount * 2;
+				}
+				else
+				{
+					uint32_t shared = index & TupleIndexMask;
+					if (shared >= m_sharedTupleCount)
+						return false;
+
+					if (index & IntermediateRegion)
+					{
+						if (!data.Contains(header, m_axisCount * 4))
+							return false;
+
+						scalar = RegionScalar(m_gvar, m_sharedTuplesOffset + shared * m_axisCount * 2, data, header);
+					}
+					else
+						scalar = (*m_sharedScalars)[shared];
+				}
+
+				if (index & IntermediateRegion)
+					header += m_axisCount * 4;
+
+				uint32_t offset = serialized;
+				serialized += size;
+
+				if (scalar == 0)
+					continue;
+
+				if (!data.Contains(offset, size))
+					return false;
+
+				ByteSpan tuple = data.Slice(offset, size);
+				offset = 0;
+
+				const std::vector<uint16_t>* indices = &m_sharedPoints;
+				bool all = sharedAll;
+				if (index & PrivatePointNumbers)
+				{
+					if (!ReadPoints(tuple, offset, m_privatePoints, all))
+						return false;
+
+					indices = &m_privatePoints;
+				}
+				else if (!(tupleCount & SharedPointNumbers))
+					all = true;
+
+				uint32_t count = all ? totalPoints : static_cast<uint32_t>(indices->size());
+				if (!ReadDeltas(tuple, offset, count, m_deltaX) || !ReadDeltas(tuple, offset, count, m_deltaY))
+					return false;
+
+				if (all)
+				{
+					for (uint32_t i = 0; i < pointCount; i++)
+					{
+						m_totalX[i] += m_deltaX[i] * scalar;
+						m_totalY[i] += m_deltaY[i] * scalar;
+					}
+				}
+				else
+				{
+					AddSparseDeltas(points, pointCount, *indices, endPoints, contourCount, scalar);
+				}
+			}
+
+			for (uint32_t i = 0; i < pointCount; i++)
+			{
+				points[i].X += m_totalX[i];
+				points[i].Y += m_totalY[i];
+			}
+
+			return true;
+		}
+
+	private:
+		// Tuple variation count flags
+		static constexpr uint16_t SharedPointNumbers = 0x8000;
+		static constexpr uint16_t TupleCountMask = 0x0FFF;
+
+		// Tuple index flags
+		static constexpr uint16_t EmbeddedPeakTuple = 0x8000;
+		static constexpr uint16_t IntermediateRegion = 0x4000;
+		static constexpr uint16_t PrivatePointNumbers = 0x2000;
+		static constexpr uint16_t TupleIndexMask = 0x0FFF;
+
+		// Packed data flags
+		static constexpr uint8_t PointsAreWords = 0x80;
+		static constexpr uint8_t PointRunCountMask = 0x7F;
+		static constexpr uint8_t DeltasAreZero = 0x80;
+		static constexpr uint8_t DeltasAreWords = 0x40;
+		static constexpr uint8_t DeltaRunCountMask = 0x3F;
+
+		ByteSpan m_gvar;
+		uint32_t m_axisCount = 0;
+		uint32_t m_glyphCount = 0;
+		uint32_t m_sharedTupleCount = 0;
+		uint32_t m_sharedTuplesOffset = 0;
+		uint32_t m_dataOffset = 0;
+		bool m_longOffsets = false;
+		bool m_isDefault = true;
+
+		std::vector<float> m_coords;
+		std::shared_ptr<const std::vector<float>> m_sharedScalars;
+
+		std::vector<uint16_t> m_sharedPoints;
+		std::vector<uint16_t> m_privatePoints;
+		std::vector<float> m_deltaX;
+		std::vector<float> m_deltaY;
+		std::vector<float> m_totalX;
+		std::vector<float> m_totalY;
+		std::vector<float> m_tupleX;
+		std::vector<float> m_tupleY;
+		std::vector<uint8_t> m_touched;
+
+		ByteSpan GetGlyphData(uint16_t glyphId) const
+		{
+			uint32_t start, end;
+			if (m_longOffsets)
+			{
+				start = m_gvar.UInt32(20 + glyphId * 4u);
+				end = m_gvar.UInt32(20 + (glyphId + 1u) * 4u);
+			}
+			else
+			{
+				start = m_gvar.UInt16(20 + glyphId * 2u) * 2u;
+				end = m_gvar.UInt16(20 + (glyphId + 1u) * 2u) * 2u;
+			}
+
+			if (end <= start)
+				return ByteSpan();
+
+			return m_gvar.Slice(m_dataOffset).Slice(start, end - start);
+		}
+
+		static float F2Dot14(ByteSpan data, uint32_t offset)
+		{
+			return data.Int16(offset) / 16384.0f;
+		}
+
+		/// <summary>
+		/// Scalar for a tuple with only a peak, whose region runs from zero.
+		/// </summary>
+		float PeakScalar(ByteSpan data, uint32_t peaks) const
+		{
+			float scalar = 1;
+			for (uint32_t a = 0; a < m_axisCount && scalar != 0; a++)
+			{
+				float peak = F2Dot14(data, peaks + a * 2);
+				float start = peak < 0 ? peak : 0;
+				float end = peak > 0 ? peak : 0;
+				scalar *= VariationAxes::AxisScalar(m_coords[a], start, peak, end);
+			}
+
+			return scalar;
+		}
+
+		/// <summary>
+		/// Scalar for a tuple with an intermediate region, which holds the
+		/// start tuple followed by the end tuple.
+		/// </summary>
+		float RegionScalar(ByteSpan peakData, uint32_t peaks, ByteSpan regionData, uint32_t region) const
+		{
+			float scalar = 1;
+			for (uint32_t a = 0; a < m_axisCount && scalar != 0; a++)
+			{
+				float peak = F2Dot14(peakData, peaks + a * 2);
+				float start = F2Dot14(regionData, region + a * 2);
+				float end = F2Dot14(regionData, region + (m_axisCount + a) * 2);
+				scalar *= VariationAxes::AxisScalar(m_coords[a], start, peak, end);
+			}
+
+			return scalar;
+		}
+
+		/// <summary>
+		/// Reads packed point numbers. A count of zero means every point.
+		/// </summary>
+		static bool ReadPoints(ByteSpan data, uint32_t& offset, std::vector<uint16_t>& points, bool& all)
+		{
+			points.clear();
+			all = false;
+
+			if (offset >= data.Size)
+				return false;
+
+			uint32_t count = data.Data[offset++];
+			if (count == 0)
+			{
+				all = true;
+				return true;
+			}
+
+			if (count & PointsAreWords)
+			{
+				if (offset >= data.Size)
+					return false;
+
+				count = ((count & PointRunCountMask) << 8) | data.Data[offset++];
+			}
+
+			points.reserve(count);
+			uint16_t point = 0;
+
+			while (points.size() < count)
+			{
+				if (offset >= data.Size)
+					return false;
+
+				uint8_t control = data.Data[offset++];
+				uint32_t run = (control & PointRunCountMask) + 1u;
+				bool words = (control & PointsAreWords) != 0;
+				if (!data.Contains(offset, run * (words ? 2 : 1)))
+					return false;
+
+				for (uint32_t i = 0; i < run && points.size() < count; i++)
+				{
+					point += words ? data.UInt16(offset + i * 2) : data.Data[offset + i];
+					points.push_back(point);
+				}
+
+				offset += run * (words ? 2 : 1);
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Reads count packed deltas.
+		/// </summary>
+		static bool ReadDeltas(ByteSpan data, uint32_t& offset, uint32_t count, std::vector<float>& deltas)
+		{
+			deltas.resize(count);
+			uint32_t i = 0;
+
+			while (i < count)
+			{
+				if (offset >= data.Size)
+					return false;
+
+				uint8_t control = data.Data[offset++];
+				uint32_t run = (control & DeltaRunCountMask) + 1u;
+				uint32_t end = std::min(count, i + run);
+
+				if ((control & (DeltasAreZero | DeltasAreWords)) == (DeltasAreZero | DeltasAreWords))
+				{
+					// 32-bit deltas
+					if (!data.Contains(offset, run * 4))
+						return false;
+
+					for (uint32_t k = 0; i < end; i++, k++)
+						deltas[i] = static_cast<float>(static_cast<int32_t>(data.UInt32(offset + k * 4)));
+
+					offset += run * 4;
+				}
+				else if (control & DeltasAreZero)
+				{
+					for (; i < end; i++)
+						deltas[i] = 0;
+				}
+				else if (control & DeltasAreWords)
+				{
+					if (!data.Contains(offset, run * 2))
+						return false;
+
+					for (uint32_t k = 0; i < end; i++, k++)
+						deltas[i] = data.Int16(offset + k * 2);
+
+					offset += run * 2;
+				}
+				else
+				{
+					if (!data.Contains(offset, run))
+						return false;
+
+					for (uint32_t k = 0; i < end; i++, k++)
+						deltas[i] = static_cast<int8_t>(data.Data[offset + k]);
+
+					offset += run;
+				}
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Adds the deltas of a tuple that lists its points, inferring deltas
+		/// for the untouched points of each contour that has any touched.
+		/// </summary>
+		template <typename TPoint>
+		void AddSparseDeltas(
+			const TPoint* points,
+			uint32_t pointCount,
+			const std::vector<uint16_t>& indices,
+			const uint32_t* endPoints,
+			uint32_t contourCount,
+			float scalar)
+		{
+			m_tupleX.assign(pointCount, 0.0f);
+			m_tupleY.assign(pointCount, 0.0f);
+			m_touched.assign(pointCount, 0);
+
+			bool any = false;
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				uint16_t p = indices[i];
+				if (p >= pointCount)
+					continue;
+
+				// Later entries for the same point replace earlier ones
+				m_tupleX[p] = m_deltaX[i];
+				m_tupleY[p] = m_deltaY[i];
+				m_touched[p] = 1;
+				any = true;
+			}
+
+			if (!any)
+				return;
+
+			uint32_t start = 0;
+			for (uint32_t c = 0; c < contourCount; c++)
+			{
+				uint32_t end = endPoints[c];
+				if (end < start || end >= pointCount)
+					break;
+
+				InferContour(points, start, end);
+				start = end + 1;
+			}
+
+			for (uint32_t i = 0; i < pointCount; i++)
+			{
+				m_totalX[i] += m_tupleX[i] * scalar;
+				m_totalY[i] += m_tupleY[i] * scalar;
+			}
+		}
+
+		/// <summary>
+		/// Interpolates deltas for untouched points from the nearest touched
+		/// points before and after them on the same contour.
+		/// </summary>
+		template <typename TPoint>
+		void InferContour(const TPoint* points, uint32_t first, uint32_t last)
+		{
+			uint32_t firstTouched = UINT32_MAX;
+			for (uint32_t i = first; i <= last; i++)
+			{
+				if (m_touched[i])
+				{
+					firstTouched = i;
+					break;
+				}
+			}
+
+			if (firstTouched == UINT32_MAX)
+				return;
+
+			uint32_t previous = firstTouched;
+			uint32_t i = firstTouched;
+
+			do
+			{
+				i = i == last ? first : i + 1;
+				if (!m_touched[i])
+					continue;
+
+				if (!IsNext(previous, i, first, last))
+					InferSegment(points, previous, i, first, last);
+
+				previous = i;
+			} while (i != firstTouched);
+		}
+
+		static bool IsNext(uint32_t a, uint32_t b, uint32_t first, uint32_t last)
+		{
+			return (a == last ? first : a + 1) == b;
+		}
+
+		/// <summary>
+		/// Fills in the untouched points after a and before b, wrapping round
+		/// the contour. When a and b are the same point, every other point
+		/// on the contour takes its delta.
+		/// </summary>
+		template <typename TPoint>
+		void InferSegment(const TPoint* points, uint32_t a, uint32_t b, uint32_t first, uint32_t last)
+		{
+			for (uint32_t i = a == last ? first : a + 1; i != b; i = i == last ? first : i + 1)
+			{
+				m_tupleX[i] = Interpolate(points[a].X, points[b].X, m_tupleX[a], m_tupleX[b], points[i].X);
+				m_tupleY[i] = Interpolate(points[a].Y, points[b].Y, m_tupleY[a], m_tupleY[b], points[i].Y);
+			}
+		}
+
+		static float Interpolate(float x1, float x2, float d1, float d2, float x)
+		{
+			if (x1 == x2)
+				return d1 == d2 ? d1 : 0;
+
+			if (x1 > x2)
+			{
+				std::swap(x1, x2);
+				std::swap(d1, d2);
+			}
+
+			if (x <= x1)
+				return d1;
+			if (x >= x2)
+				return d2;
+
+			return d1 + (x - x1) * (d2 - d1) / (x2 - x1);
+		}
+	};
+}
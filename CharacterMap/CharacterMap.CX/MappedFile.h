@@ -0,0 +1,62 @@
+#pragma once
+
+#include "pch.h"
+#include "SfntData.h"
+#include <fileapifromapp.h>
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Maps a whole file read-only for as long as it's in scope. The file
+	/// is opened with delete sharing, so it never stops the caller from
+	/// deleting the file straight afterwards.
+	/// </summary>
+	class MappedFile
+	{
+	public:
+		MappedFile(Platform::String^ path)
+		{
+			m_file = CreateFile2FromAppW(path->Data(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, OPEN_EXISTING, nullptr);
+			if (m_file == INVALID_HANDLE_VALUE)
+				return;
+
+			LARGE_INTEGER size{};
+			if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0 || size.QuadPart > UINT32_MAX)
+				return;
+
+			m_mapping = CreateFileMappingFromApp(m_file, nullptr, PAGE_READONLY, 0, nullptr);
+			if (m_mapping == nullptr)
+				return;
+
+			m_view = MapViewOfFileFromApp(m_mapping, FILE_MAP_READ, 0, 0);
+			if (m_view != nullptr)
+				m_data = ByteSpan(m_view, static_cast<uint32_t>(size.QuadPart));
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile()
+		{
+			if (m_view != nullptr)
+				UnmapViewOfFile(m_view);
+			if (m_mapping != nullptr)
+				CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE)
+				CloseHandle(m_file);
+		}
+
+		bool IsOpen() const { return !m_data.IsEmpty(); }
+
+		/// <summary>
+		/// The contents of the file, valid while this is in scope.
+		/// </summary>
+		ByteSpan Data() const { return m_data; }
+
+	private:
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+		void* m_view = nullptr;
+		ByteSpan m_data;
+	};
+}
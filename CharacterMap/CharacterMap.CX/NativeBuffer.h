@@ -0,0 +1,86 @@
+#pragma once
+
+#include <wrl.h>
+#include <robuffer.h>
+#include <windows.storage.streams.h>
+#include <functional>
+#include "SfntData.h"
+#include "ErrorHandling.h"
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// A read-only IBuffer that points at memory owned by someone else, such as
+	/// a DirectWrite font table or file fragment. The owner is notified through
+	/// the release callback once WinRT has finished with the buffer, letting us
+	/// hand native data to callers without copying it.
+	/// </summary>
+	class NativeBuffer : public Microsoft::WRL::RuntimeClass<
+		Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::WinRtClassicComMix>,
+		ABI::Windows::Storage::Streams::IBuffer,
+		Windows::Storage::Streams::IBufferByteAccess>
+	{
+		InspectableClass(L"CharacterMapCX.NativeBuffer", BaseTrust)
+
+	public:
+		HRESULT RuntimeClassInitialize(ByteSpan data, std::function<void()> release)
+		{
+			m_data = data;
+			m_length = data.Size;
+			m_release = std::move(release);
+			return S_OK;
+		}
+
+		virtual ~NativeBuffer()
+		{
+			if (m_release)
+				m_release();
+		}
+
+		IFACEMETHODIMP Buffer(byte** value) override
+		{
+			*value = const_cast<byte*>(m_data.Data);
+			return S_OK;
+		}
+
+		IFACEMETHODIMP get_Capacity(UINT32* value) override
+		{
+			*value = m_data.Size;
+			return S_OK;
+		}
+
+		IFACEMETHODIMP get_Length(UINT32* value) override
+		{
+			*value = m_length;
+			return S_OK;
+		}
+
+		IFACEMETHODIMP put_Length(UINT32 value) override
+		{
+			if (value > m_data.Size)
+				return E_INVALIDARG;
+
+			m_length = value;
+			return S_OK;
+		}
+
+		/// <summary>
+		/// Wraps existing memory in an IBuffer. The release callback runs when
+		/// the last reference to the buffer goes away.
+		/// </summary>
+		static Windows::Storage::Streams::IBuffer^ Create(ByteSpan data, std::function<void()> release)
+		{
+			Microsoft::WRL::ComPtr<NativeBuffer> buffer;
+			ThrowIfFailed(Microsoft::WRL::MakeAndInitialize<NativeBuffer>(&buffer, data, std::move(release)));
+
+			auto inspectable = reinterpret_cast<IInspectable*>(
+				static_cast<ABI::Windows::Storage::Streams::IBuffer*>(buffer.Get()));
+			return reinterpret_cast<Windows::Storage::Streams::IBuffer^>(inspectable);
+		}
+
+	private:
+		ByteSpan m_data;
+		UINT32 m_length = 0;
+		std::function<void()> m_release;
+	};
+}
@@ -6,8 +6,20 @@
 #include <string>
 #include "SVGGeometrySink.h"
 #include "PathData.h"
+#include "GlyphOutlineDecoder.h"
+#include "GlyphPathCache.h"
+#include "VariationInstanceCache.h"
+#include "PathEncoding.h"
+#include "GlyphPathSink.h"
+#include "NativeBuffer.h"
+#include "SvgDocumentWriter.h"
+#include "FontMetadataStore.h"
+#include "WoffDecoder.h"
 #include "Windows.h"
 #include <concurrent_vector.h>
+#include <ppl.h>
+#include <thread>
+#include <unordered_map>
 #include <robuffer.h>
 
 using namespace Microsoft::WRL;
@@ -40,7 +52,12 @@ NativeInterop::NativeInterop(CanvasDevice^ device)
 		D2D1_DEVICE_CONTEXT_OPTIONS_ENABLE_MULTITHREADED_OPTIMIZATIONS,
 		&m_d2dContext);
 
-	m_fontManager = new CustomFontManager(m_dwriteFactory);
+	// Shared with DirectWrite's static helpers, so imported font
+	// collections are cached once for the whole app
+	m_fontManager = std::make_shared<CustomFontManager>(m_dwriteFactory);
+	CustomFontManager::SetInstance(m_fontManager);
+	m_pathCache = std::make_shared<GlyphPathCache>();
+	m_variationCache = std::make_shared<VariationInstanceCache>();
 	_Current = this;
 }
 
@@ -69,30 +86,50 @@ IVectorView<DWriteFontSet^>^ NativeInterop::GetFonts(IVectorView<Uri^>^ uris)
 	return DirectWrite::GetFonts(uris, m_dwriteFactory);
 }
 
-DWriteFontSet^ NativeInterop::GetSystemFonts()
+ComPtr<IDWriteFontCollection3> NativeInterop::LoadSystemFontCollection()
 {
-	if (m_isFontSetStale)
-	{
-		m_systemFontSet = nullptr;
-		m_appFontSet = nullptr;
-	}
+	ComPtr<IDWriteFontSet1> fontSet;
+	ComPtr<IDWriteFontCollection3> fontCollection;
 
-	if (m_systemFontSet == nullptr || m_appFontSet == nullptr)
-	{
-		ComPtr<IDWriteFontSet1> fontSet;
-		ComPtr<IDWriteFontCollection3> fontCollection;
+	ThrowIfFailed(m_dwriteFactory->GetSystemFontCollection(true, DWRITE_FONT_FAMILY_MODEL_WEIGHT_STRETCH_STYLE, &fontCollection));
+	ThrowIfFailed(fontCollection->GetFontSet(&fontSet));
+	m_fontCollection = fontCollection;
+
+	ComPtr<IDWriteFontSet3> fontSet3;
+	ThrowIfFailed(fontSet.As(&fontSet3));
+	m_systemFontSet = fontSet3;
 
-		ThrowIfFailed(m_dwriteFactory->GetSystemFontCollection(true, DWRITE_FONT_FAMILY_MODEL_WEIGHT_STRETCH_STYLE, &fontCollection));
-		ThrowIfFailed(fontCollection->GetFontSet(&fontSet));
-		m_fontCollection = fontCollection;
+	return fontCollection;
+}
 
-		ComPtr<IDWriteFontSet3> fontSet3;
-		ThrowIfFailed(fontSet.As(&fontSet3));
-		m_systemFontSet = fontSet3;
+DWriteFontSet^ NativeInterop::GetSystemFonts()
+{
+	Lock lock(m_fontSetMutex);
 
-        m_appFontSet = DirectWrite::GetFonts(fontCollection);
+	if (m_appFontSet != nullptr && m_isFontSetStale)
+	{
+		PatchSystemFonts();
+	}
+	else if (m_appFontSet == nullptr)
+	{
+		auto fontCollection = LoadSystemFontCollection();
+
+		// Faces are created natively for every family at once, rather than
+		// a managed call per family. Faces whose files haven't changed since
+		// the last launch are created from the metadata cache instead of
+		// reading their names and files.
+		wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
+		GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH);
+		auto store = std::make_shared<FontMetadataStore>(
+			ApplicationData::Current->LocalCacheFolder->Path + "\\FontMetadata.cache", localeName);
+
+		m_appFontSet = DirectWrite::GetFonts(fontCollection)->InflateFromStore(store.get());
 		m_isFontSetStale = false;
 
+		// Faces that missed are read and the cache rewritten in the
+		// background, so a cold start is no slower than before.
+		create_task([store] { store->Save(); });
+
 		// We listen for the expiration event on a background thread
 		// with an infinite thread block, so don't await this.
 		ListenForFontSetExpirationAsync();
@@ -101,6 +138,26 @@ DWriteFontSet^ NativeInterop::GetSystemFonts()
 	return m_appFontSet;
 }
 
+DWriteFontSetDiff^ NativeInterop::UpdateSystemFonts()
+{
+	Lock lock(m_fontSetMutex);
+
+	if (m_appFontSet == nullptr || !m_isFontSetStale)
+		return ref new DWriteFontSetDiff();
+
+	return PatchSystemFonts();
+}
+
+DWriteFontSetDiff^ NativeInterop::PatchSystemFonts()
+{
+	auto fontCollection = LoadSystemFontCollection();
+	auto diff = m_appFontSet->Patch(DirectWrite::GetFonts(fontCollection)->Families);
+	m_isFontSetStale = false;
+
+	ListenForFontSetExpirationAsync();
+	return diff;
+}
+
 IVectorView<DWriteFontSet^>^ NativeInterop::GetFonts(IVectorView<StorageFile^>^ files)
 {
 	Vector<DWriteFontSet^>^ fontSets = ref new Vector<DWriteFontSet^>();
@@ -113,6 +170,19 @@ IVectorView<DWriteFontSet^>^ NativeInterop::GetFonts(IVectorView<StorageFile^>^
 	return fontSets->GetView();
 }
 
+DWriteFontSet^ NativeInterop::GetMergedFonts(IVectorView<StorageFile^>^ files)
+{
+	std::vector<std::wstring> paths;
+	paths.reserve(files->Size);
+	for (StorageFile^ file : files)
+		paths.emplace_back(file->Path->Data(), file->Path->Length());
+
+	auto collection = m_fontManager->GetFontCollection(paths);
+	DWriteFontSet^ set = DirectWrite::GetFonts(collection)->Inflate();
+	set->SetSourceFiles(paths);
+	return set;
+}
+
 DWriteFontSet^ NativeInterop::GetFonts(StorageFile^ file)
 {
 	auto collection = m_fontManager->GetFontCollection(file->Path);
@@ -131,97 +201,698 @@ DWriteFallbackFont^ NativeInterop::CreateEmptyFallback()
 	return ref new DWriteFallbackFont(fallback);
 }
 
-Platform::String^ NativeInterop::GetPathData(DWriteFontFace^ fontFace, UINT16 glyphIndicie)
+/// <summary>
+/// Converts a natively decoded outline into the same syntax produced
+/// by streaming a Direct2D geometry through SVGGeometrySink, keeping any
+/// quadratic curves. The builder is reused between glyphs so its buffer
+/// only grows once.
+/// </summary>
+static String^ ToPathString(const GlyphPath& path, SvgPathBuilder& builder, const SvgWriteOptions& options = SvgWriteOptions())
+{
+	if (!path.HasSegments())
+		return ref new String();
+
+	builder.Clear();
+	path.WriteSvg(builder, options);
+	return SVGGeometrySink::CreateString(builder);
+}
+
+/// <summary>
+/// Builds the part of a path cache key that identifies a font face: the
+/// reference key, size and last write time of each file, the face index,
+/// simulations and the axis values of variable fonts. Nothing in the key
+/// depends on an object's address, which could be reused by another font
+/// once freed. Returns an empty key for faces that shouldn't be cached.
+/// </summary>
+static std::string GetFaceCacheKey(ComPtr<IDWriteFontFace3> face)
+{
+	std::string key;
+	auto append = [&key](const void* data, size_t size)
+	{
+		key.append(static_cast<const char*>(data), size);
+	};
+
+	UINT32 fileCount = 0;
+	face->GetFiles(&fileCount, nullptr);
+	std::vector<ComPtr<IDWriteFontFile>> files(fileCount);
+	face->GetFiles(&fileCount, reinterpret_cast<IDWriteFontFile**>(files.data()));
+
+	for (auto& file : files)
+	{
+		ComPtr<IDWriteFontFileLoader> loader;
+		ComPtr<IDWriteFontFileStream> stream;
+		const void* referenceKey = nullptr;
+		UINT32 referenceKeySize = 0;
+		if (FAILED(file->GetLoader(&loader))
+			|| FAILED(file->GetReferenceKey(&referenceKey, &referenceKeySize)))
+			return std::string();
+
+		// In-memory font keys are just an index into the loader, which
+		// could be reused for a different font after the loader is freed.
+		ComPtr<IDWriteInMemoryFontFileLoader> memoryLoader;
+		if (SUCCEEDED(loader.As(&memoryLoader)))
+			return std::string();
+
+		// Keys from different kinds of loader aren't comparable
+		ComPtr<IDWriteLocalFontFileLoader> localLoader;
+		ComPtr<IDWriteRemoteFontFileLoader> remoteLoader;
+		uint8_t kind = SUCCEEDED(loader.As(&localLoader)) ? 1 : SUCCEEDED(loader.As(&remoteLoader)) ? 2 : 0;
+
+		UINT64 fileSize = 0;
+		UINT64 lastWriteTime = 0;
+		if (FAILED(loader->CreateStreamFromKey(referenceKey, referenceKeySize, &stream))
+			|| FAILED(stream->GetFileSize(&fileSize)))
+			return std::string();
+
+		stream->GetLastWriteTime(&lastWriteTime);
+
+		append(&kind, sizeof(kind));
+		append(&fileSize, sizeof(fileSize));
+		append(&lastWriteTime, sizeof(lastWriteTime));
+		append(&referenceKeySize, sizeof(referenceKeySize));
+		append(referenceKey, referenceKeySize);
+	}
+
+	UINT32 index = face->GetIndex();
+	DWRITE_FONT_SIMULATIONS simulations = face->GetSimulations();
+	append(&index, sizeof(index));
+	append(&simulations, sizeof(simulations));
+
+	ComPtr<IDWriteFontFace5> face5;
+	if (SUCCEEDED(face.As(&face5)) && face5->HasVariations())
+	{
+		std::vector<DWRITE_FONT_AXIS_VALUE> values(face5->GetFontAxisValueCount());
+		face5->GetFontAxisValues(values.data(), static_cast<UINT32>(values.size()));
+		append(values.data(), values.size() * sizeof(DWRITE_FONT_AXIS_VALUE));
+	}
+
+	return key;
+}
+
+/// <summary>
+/// Creates a face for the same variable font resource at the given axis
+/// values. Returns the face unchanged if it has no variations.
+/// </summary>
+static ComPtr<IDWriteFontFace3> CreateFaceInstance(ComPtr<IDWriteFontFace3> face, IVectorView<DWriteFontAxis^>^ axis)
+{
+	ComPtr<IDWriteFontFace5> face5;
+	if (FAILED(face.As(&face5)) || !face5->HasVariations())
+		return face;
+
+	ComPtr<IDWriteFontResource> resource;
+	ThrowIfFailed(face5->GetFontResource(&resource));
+
+	std::vector<DWRITE_FONT_AXIS_VALUE> values;
+	values.reserve(axis->Size);
+	for (unsigned int i = 0; i < axis->Size; ++i)
+		values.push_back(axis->GetAt(i)->GetDWriteValue());
+
+	ComPtr<IDWriteFontFace5> instance;
+	ThrowIfFailed(resource->CreateFontFace(face->GetSimulations(), values.data(), static_cast<UINT32>(values.size()), &instance));
+
+	ComPtr<IDWriteFontFace3> result;
+	ThrowIfFailed(instance.As(&result));
+	return result;
+}
+
+/// <summary>
+/// Gets the face and em size outlines should be created at for a set of
+/// path options.
+/// </summary>
+static ComPtr<IDWriteFontFace3> GetOutlineFace(DWriteFontFace^ fontFace, PathOptions^ options, float& size)
 {
 	ComPtr<IDWriteFontFace3> face = fontFace->GetFontFace();
 
-	uint16 indicies[1];
-	indicies[0] = glyphIndicie;
+	// The instance's axis values become part of the path cache key
+	if (options->Axis != nullptr && options->Axis->Size > 0)
+		face = CreateFaceInstance(face, options->Axis);
 
-	ComPtr<ID2D1PathGeometry> geom;
-	m_d2dFactory->CreatePathGeometry(&geom);
+	size = options->Size;
+	if (options->UseFontUnits)
+	{
+		DWRITE_FONT_METRICS metrics{};
+		face->GetMetrics(&metrics);
+		size = metrics.designUnitsPerEm;
+	}
 
-	ComPtr<ID2D1GeometrySink> geometrySink;
-	geom->Open(&geometrySink);
-	
-	face->GetGlyphRunOutline(
-		64,
-		indicies,
-		nullptr,
-		nullptr,
-		ARRAYSIZE(indicies),
-		false,
-		false,
-		geometrySink.Get());
-
-	geometrySink->Close();
+	return face;
+}
 
-	ComPtr<SVGGeometrySink> sink = new (std::nothrow) SVGGeometrySink();
-	geom->Stream(sink.Get());
-	sink->Close();
+/// <summary>
+/// Gets a glyph outline from the path cache, decoding it and adding it to the
+/// cache on a miss. The decoder is only created once it's needed, sharing
+/// the face's variation instance with every other decoder for it. A missed
+/// outline is rounded through the cache's encoding before it's returned, so
+/// a glyph comes out the same on a hit as on the miss that added it. Faces
+/// that can't be cached, or a disabled cache, skip the encoding entirely.
+/// </summary>
+static void GetGlyphOutline(
+	GlyphPathCache& cache,
+	VariationInstanceCache& instances,
+	const std::string& faceKey,
+	ComPtr<IDWriteFontFace3>& face,
+	std::unique_ptr<GlyphOutlineDecoder>& decoder,
+	UINT16 glyph,
+	float size,
+	GlyphPath& path,
+	std::string& key)
+{
+	bool useCache = !faceKey.empty() && cache.GetBudget() > 0;
+	if (useCache)
+	{
+		GlyphPathCache::MakeKey(faceKey, glyph, size, key);
+		if (cache.TryGet(key, path))
+			return;
+	}
+
+	if (decoder == nullptr)
+		decoder = std::make_unique<GlyphOutlineDecoder>(face, &instances, faceKey);
 
-	//delete[] indicies;
-	return sink->GetPathData();
+	// TrueType and CFF outlines are decoded straight from the font
+	// tables. Anything else is recorded from DirectWrite into the
+	// same buffer, without a Direct2D path geometry.
+	if (!decoder->TryDecode(glyph, size, path))
+	{
+		path.Clear();
+		GlyphPathSink sink(path);
+		face->GetGlyphRunOutline(size, &glyph, nullptr, nullptr, 1, false, false, &sink);
+	}
+
+	if (!useCache)
+		return;
+
+	std::vector<uint8_t> encoded;
+	PathEncoding::Encode(path, encoded, GlyphPathCache::FractionBits(size));
+	PathEncoding::Decode(ByteSpan(encoded.data(), static_cast<uint32_t>(encoded.size())), path);
+	cache.Add(key, std::move(encoded));
 }
 
-IVectorView<PathData^>^ NativeInterop::GetPathDatas(DWriteFontFace^ fontFace, const Platform::Array<UINT16>^ glyphIndicies)
+/// <summary>
+/// The parts of PathOptions applied to an outline once it has been created,
+/// read up front so they can be used from any thread.
+/// </summary>
+struct OutlineSettings
+{
+	float3x2 Matrix;
+	bool HasTransform;
+	float SimplifyTolerance;
+	bool RemoveCollinearPoints;
+	int Precision;
+	SvgWriteOptions WriteOptions;
+
+	OutlineSettings(PathOptions^ options)
+	{
+		Precision = options->Precision;
+		Matrix = options->Transform;
+		HasTransform = !is_identity(Matrix);
+
+		WriteOptions.FillMode = static_cast<int>(options->FillMode);
+		WriteOptions.Relative = options->UseRelativeCommands;
+		WriteOptions.ElideCommands = options->ElideRepeatedCommands;
+		WriteOptions.RaiseQuadratics = options->UseCubicCurves;
+
+		// Without a tolerance, only points lying exactly on the line between
+		// their neighbours are removed. Anything looser could change how the
+		// remaining points round, and so the written path.
+		SimplifyTolerance = options->SimplifyTolerance;
+		RemoveCollinearPoints = options->RemoveCollinearPoints;
+	}
+
+	void Apply(GlyphPath& path) const
+	{
+		if (HasTransform)
+			path.Transform(Matrix.m11, Matrix.m12, Matrix.m21, Matrix.m22, Matrix.m31, Matrix.m32);
+
+		if (SimplifyTolerance > 0)
+			path.SimplifyLines(SimplifyTolerance);
+		else if (RemoveCollinearPoints)
+			path.SimplifyLines(0);
+	}
+};
+
+/// <summary>
+/// Glyphs are split into chunks that PPL's work-stealing scheduler spreads
+/// across cores. Small enough chunks to balance uneven glyph complexity,
+/// large enough that setting up a decoder is a tiny part of the work.
+/// </summary>
+static UINT32 GetChunkSize(UINT32 count)
+{
+	return std::max(16u, std::min(256u, count / (std::thread::hardware_concurrency() * 8 + 1)));
+}
+
+Platform::String^ NativeInterop::GetPathData(DWriteFontFace^ fontFace, UINT16 glyphIndicie)
 {
 	ComPtr<IDWriteFontFace3> face = fontFace->GetFontFace();
-	Vector<PathData^>^ paths = ref new Vector<PathData^>();
+	std::unique_ptr<GlyphOutlineDecoder> decoder;
+	GlyphPath path;
+	SvgPathBuilder builder;
+	std::string key;
+
+	GetGlyphOutline(*m_pathCache, *m_variationCache, GetFaceCacheKey(face), face, decoder, glyphIndicie, 64, path, key);
+	return ToPathString(path, builder);
+}
+
+PathData^ NativeInterop::GetPathData(DWriteFontFace^ fontFace, UINT16 glyphIndicie, PathOptions^ options)
+{
+	UINT16 glyphs[1] = { glyphIndicie };
+	return GetPathDatas(fontFace, Platform::ArrayReference<UINT16>(glyphs, 1), options)->GetAt(0);
+}
+
+IVectorView<PathData^>^ NativeInterop::GetPathDatas(DWriteFontFace^ fontFace, const Platform::Array<UINT16>^ glyphIndicies)
+{
+	// This overload has always skipped the .notdef glyph
+	std::vector<UINT16> glyphs;
+	glyphs.reserve(glyphIndicies->Length);
+	for (auto ind : glyphIndicies)
+	{
+		if (ind != 0)
+			glyphs.push_back(ind);
+	}
+
+	if (glyphs.empty())
+		return (ref new Vector<PathData^>())->GetView();
 
-	for (int i = 0; i < glyphIndicies->Length; i++)
+	return GetPathDatas(
+		fontFace,
+		Platform::ArrayReference<UINT16>(glyphs.data(), static_cast<unsigned int>(glyphs.size())),
+		ref new PathOptions());
+}
+
+IVectorView<PathData^>^ NativeInterop::GetPathDatas(DWriteFontFace^ fontFace, const Platform::Array<UINT16>^ glyphIndicies, PathOptions^ options)
+{
+	float size;
+	ComPtr<IDWriteFontFace3> face = GetOutlineFace(fontFace, options, size);
+
+	const UINT16* glyphs = glyphIndicies->Data;
+	UINT32 count = glyphIndicies->Length;
+	std::vector<PathData^> results(count);
+
+	CanvasFilledRegionDetermination fillRule = options->FillMode;
+	OutlineSettings settings(options);
+
+	// Each chunk gets its own decoder and buffers; the only shared state is
+	// the font face, which DirectWrite allows, and the locked path cache.
+	UINT32 chunkSize = GetChunkSize(count);
+	UINT32 chunks = (count + chunkSize - 1) / chunkSize;
+
+	std::string faceKey = GetFaceCacheKey(face);
+	GlyphPathCache& cache = *m_pathCache;
+	VariationInstanceCache& instances = *m_variationCache;
+
+	parallel_for(0u, chunks, [&](UINT32 chunk)
+		{
+			std::unique_ptr<GlyphOutlineDecoder> decoder;
+			GlyphPath path;
+			SvgPathBuilder builder;
+			builder.SetPrecision(settings.Precision);
+			std::string key;
+
+			UINT32 end = std::min(count, (chunk + 1) * chunkSize);
+			for (UINT32 i = chunk * chunkSize; i < end; i++)
+			{
+				GetGlyphOutline(cache, instances, faceKey, face, decoder, glyphs[i], size, path, key);
+				settings.Apply(path);
+
+				PathBounds b = path.GetBounds();
+				if (!path.HasSegments() || b.IsEmpty())
+				{
+					results[i] = ref new PathData(ref new String(), Rect::Empty);
+					continue;
+				}
+
+				std::vector<uint8_t> encoded;
+				PathEncoding::Encode(path, encoded);
+
+				results[i] = ref new PathData(
+					ToPathString(path, builder, settings.WriteOptions),
+					Rect(b.Left, b.Top, b.Right - b.Left, b.Bottom - b.Top),
+					std::move(encoded),
+					fillRule);
+			}
+		});
+
+	return (ref new Vector<PathData^>(std::move(results)))->GetView();
+}
+
+IVectorView<Rect>^ NativeInterop::GetGlyphBounds(DWriteFontFace^ fontFace, const Platform::Array<UINT16>^ glyphIndicies, PathOptions^ options, bool tight)
+{
+	float size;
+	ComPtr<IDWriteFontFace3> face = GetOutlineFace(fontFace, options, size);
+
+	const UINT16* glyphs = glyphIndicies->Data;
+	UINT32 count = glyphIndicies->Length;
+	std::vector<Rect> results(count, Rect::Empty);
+
+	float3x2 matrix = options->Transform;
+	bool hasTransform = !is_identity(matrix);
+
+	// Same chunking as GetPathDatas. Reading glyf headers is cheap enough
+	// that most of the benefit is for tight bounds and CFF fonts.
+	UINT32 chunkSize = GetChunkSize(count);
+	UINT32 chunks = (count + chunkSize - 1) / chunkSize;
+
+	std::string faceKey = GetFaceCacheKey(face);
+	VariationInstanceCache& instances = *m_variationCache;
+
+	parallel_for(0u, chunks, [&](UINT32 chunk)
+		{
+			GlyphOutlineDecoder decoder(face, &instances, faceKey);
+			GlyphPath path;
+
+			UINT32 end = std::min(count, (chunk + 1) * chunkSize);
+			for (UINT32 i = chunk * chunkSize; i < end; i++)
+			{
+				PathBounds b;
+				if (!decoder.TryGetBounds(glyphs[i], size, tight, b))
+				{
+					path.Clear();
+					GlyphPathSink sink(path);
+					face->GetGlyphRunOutline(size, &glyphs[i], nullptr, nullptr, 1, false, false, &sink);
+					b = path.GetBounds();
+				}
+
+				if (b.IsEmpty())
+					continue;
+
+				// Transforming the corners keeps rotated and skewed boxes
+				// around the outline, though no longer tight.
+				if (hasTransform)
+				{
+					PathBounds t = PathBounds::Empty();
+					for (float2 corner : { float2(b.Left, b.Top), float2(b.Right, b.Top), float2(b.Left, b.Bottom), float2(b.Right, b.Bottom) })
+					{
+						float2 p = transform(corner, matrix);
+						GlyphPath::Include(t, p.x, p.y);
+					}
+					b = t;
+				}
+
+				results[i] = Rect(b.Left, b.Top, b.Right - b.Left, b.Bottom - b.Top);
+			}
+		});
+
+	return (ref new Vector<Rect>(std::move(results)))->GetView();
+}
+
+/// <summary>
+/// Converts a WinRT string to UTF-8 for writing into SVG markup.
+/// </summary>
+static std::string ToUtf8(String^ value)
+{
+	std::string result;
+	if (value == nullptr || value->Length() == 0)
+		return result;
+
+	int length = WideCharToMultiByte(CP_UTF8, 0, value->Data(), value->Length(), nullptr, 0, nullptr, nullptr);
+	result.resize(length);
+	WideCharToMultiByte(CP_UTF8, 0, value->Data(), value->Length(), &result[0], length, nullptr, nullptr);
+	return result;
+}
+
+/// <summary>
+/// Hands the text in a builder to WinRT without copying it. The builder is
+/// kept alive until the buffer is released.
+/// </summary>
+static IBuffer^ CreateBuffer(std::shared_ptr<SvgPathBuilder> builder)
+{
+	return NativeBuffer::Create(
+		ByteSpan(builder->Data(), builder->Size()),
+		[builder] {});
+}
+
+/// <summary>
+/// State shared by every batch of an SVG export. Format creates the text for
+/// one glyph, and Write is given each finished batch in glyph order. The
+/// counts are only changed by Write, which never runs for two batches at once.
+/// </summary>
+struct SvgExportJob
+{
+	SvgExportJob(PathOptions^ options) : Settings(options) { }
+
+	std::shared_ptr<GlyphPathCache> Cache;
+	std::shared_ptr<VariationInstanceCache> Instances;
+	ComPtr<IDWriteFontFace3> Face;
+	std::string FaceKey;
+	float Size = 0;
+	OutlineSettings Settings;
+	std::vector<UINT16> Glyphs;
+	std::vector<String^> Names;
+	progress_reporter<UINT32> Reporter;
+	cancellation_token Token = cancellation_token::none();
+
+	std::function<void(UINT32, const GlyphPath&, SvgPathBuilder&)> Format;
+	std::function<task<void>(UINT32, const std::vector<std::shared_ptr<SvgPathBuilder>>&, const std::vector<uint8_t>&)> Write;
+
+	UINT32 Exported = 0;
+	UINT32 Skipped = 0;
+	UINT32 Failed = 0;
+
+	SvgExportResult^ GetResult() const
 	{
-		auto ind = glyphIndicies[i];
-		if (ind == 0)
-			continue;
-
-		uint16 indicies[1];
-		indicies[0] = ind;
-
-		ComPtr<ID2D1PathGeometry> geom;
-		m_d2dFactory->CreatePathGeometry(&geom);
-
-		ComPtr<ID2D1GeometrySink> geometrySink;
-		geom->Open(&geometrySink);
-
-		face->GetGlyphRunOutline(
-			256,
-			indicies,
-			nullptr,
-			nullptr,
-			ARRAYSIZE(indicies),
-			false,
-			false,
-			geometrySink.Get());
-
-		geometrySink->Close();
-
-		ComPtr<SVGGeometrySink> sink = new (std::nothrow) SVGGeometrySink();
-		geom->Stream(sink.Get());
-
-		D2D1_RECT_F bounds;
-		geom->GetBounds(D2D1_MATRIX_3X2_F { 1, 0, 0, 1, 0, 0 }, &bounds);
-		
-		if (isinf(bounds.left) || isinf(bounds.top))
+		return ref new SvgExportResult(Exported, Skipped, Failed);
+	}
+};
+
+/// <summary>
+/// Creates the SVG text for a glyph selection one batch at a time, starting
+/// at first. Each batch is decoded and formatted in parallel, one builder per
+/// glyph, and the next batch is chained on once it has been written. Only a
+/// single batch of text is ever held, so memory stays the same however many
+/// glyphs are exported. Cancelling stops between batches, leaving the counts
+/// for everything written so far.
+/// </summary>
+static task<void> ExportSvgBatchesAsync(std::shared_ptr<SvgExportJob> job, UINT32 first)
+{
+	const UINT32 BatchSize = 256;
+
+	UINT32 count = static_cast<UINT32>(job->Glyphs.size());
+	if (first >= count || job->Token.is_canceled())
+		return task_from_result();
+
+	UINT32 batchCount = std::min(BatchSize, count - first);
+	std::vector<std::shared_ptr<SvgPathBuilder>> batch(batchCount);
+	std::vector<uint8_t> empty(batchCount);
+
+	UINT32 chunkSize = GetChunkSize(batchCount);
+	UINT32 chunks = (batchCount + chunkSize - 1) / chunkSize;
+
+	parallel_for(0u, chunks, [&](UINT32 chunk)
 		{
-			paths->Append(
-				ref new PathData(ref new String(), Rect::Empty));
-		}
-		else
+			std::unique_ptr<GlyphOutlineDecoder> decoder;
+			GlyphPath path;
+			std::string key;
+
+			UINT32 end = std::min(batchCount, (chunk + 1) * chunkSize);
+			for (UINT32 i = chunk * chunkSize; i < end; i++)
+			{
+				GetGlyphOutline(*job->Cache, *job->Instances, job->FaceKey, job->Face, decoder, job->Glyphs[first + i], job->Size, path, key);
+				job->Settings.Apply(path);
+
+				auto builder = std::make_shared<SvgPathBuilder>();
+				builder->SetPrecision(job->Settings.Precision);
+				empty[i] = !path.HasSegments() || path.GetBounds().IsEmpty();
+				job->Format(first + i, path, *builder);
+				batch[i] = builder;
+			}
+		});
+
+	return job->Write(first, batch, empty).then([job, first, batchCount]
+		{
+			job->Reporter.report(first + batchCount);
+			return ExportSvgBatchesAsync(job, first + batchCount);
+		}, task_continuation_context::use_arbitrary());
+}
+
+/// <summary>
+/// Runs an export's batches from a worker thread, so the caller's thread
+/// isn't held while the first batch is formatted.
+/// </summary>
+static task<SvgExportResult^> RunSvgExportAsync(std::shared_ptr<SvgExportJob> job)
+{
+	return create_task([job]
+		{
+			job->FaceKey = GetFaceCacheKey(job->Face);
+			return ExportSvgBatchesAsync(job, 0);
+		}).then([job]
 		{
-			paths->Append(
-				ref new PathData(sink->GetPathData(), Rect(bounds.left, bounds.top, bounds.right - bounds.left, bounds.bottom - bounds.top)));
+			return job->GetResult();
+		}, task_continuation_context::use_arbitrary());
+}
+
+IAsyncOperationWithProgress<SvgExportResult^, UINT32>^ NativeInterop::ExportSvgSpriteAsync(
+	DWriteFontFace^ fontFace,
+	const Platform::Array<UINT16>^ glyphIndicies,
+	const Platform::Array<String^>^ ids,
+	IOutputStream^ stream,
+	PathOptions^ options)
+{
+	if (ids->Length != glyphIndicies->Length)
+		throw ref new InvalidArgumentException();
+
+	// Everything the export needs is copied before leaving the calling thread
+	auto job = std::make_shared<SvgExportJob>(options);
+	job->Face = GetOutlineFace(fontFace, options, job->Size);
+	job->Glyphs.assign(begin(glyphIndicies), end(glyphIndicies));
+	job->Names.assign(begin(ids), end(ids));
+	job->Cache = m_pathCache;
+	job->Instances = m_variationCache;
+
+	job->Format = [state = job.get()](UINT32 i, const GlyphPath& path, SvgPathBuilder& b)
+	{
+		std::string id = ToUtf8(state->Names[i]);
+		SvgDocumentWriter::WriteSymbol(b, id.data(), id.size(), path, state->Settings.WriteOptions);
+	};
+
+	job->Write = [state = job.get(), stream](
+		UINT32 first, const std::vector<std::shared_ptr<SvgPathBuilder>>& batch, const std::vector<uint8_t>& empty)
+	{
+		// Each batch is written to the stream as one chunk
+		auto chunk = std::make_shared<SvgPathBuilder>();
+		for (size_t i = 0; i < batch.size(); i++)
+		{
+			if (empty[i])
+			{
+				state->Skipped++;
+				continue;
+			}
+
+			chunk->Text(batch[i]->Data(), batch[i]->Size());
+			state->Exported++;
 		}
 
-		sink->Close();
+		if (chunk->IsEmpty())
+			return task_from_result();
+
+		return create_task(stream->WriteAsync(CreateBuffer(chunk))).then([](unsigned int) {});
+	};
+
+	return create_async([job, stream](progress_reporter<UINT32> reporter, cancellation_token token)
+		{
+			job->Reporter = reporter;
+			job->Token = token;
+
+			auto header = std::make_shared<SvgPathBuilder>();
+			SvgDocumentWriter::WriteHeader(*header);
+			SvgDocumentWriter::BeginSprite(*header);
+
+			return create_task(stream->WriteAsync(CreateBuffer(header))).then([job](unsigned int)
+				{
+					return RunSvgExportAsync(job);
+				}, task_continuation_context::use_arbitrary()).then([stream](SvgExportResult^ result)
+				{
+					// A cancelled sprite is still closed so what was written is valid
+					auto footer = std::make_shared<SvgPathBuilder>();
+					SvgDocumentWriter::EndSprite(*footer);
+					return create_task(stream->WriteAsync(CreateBuffer(footer))).then([stream](unsigned int)
+						{
+							return stream->FlushAsync();
+						}).then([result](bool)
+						{
+							return result;
+						});
+				}, task_continuation_context::use_arbitrary());
+		});
+}
 
-		//delete[] indicies;
-		sink = nullptr;
-		geometrySink = nullptr;
-		geom = nullptr;
+IAsyncOperationWithProgress<SvgExportResult^, UINT32>^ NativeInterop::ExportSvgFilesAsync(
+	DWriteFontFace^ fontFace,
+	const Platform::Array<UINT16>^ glyphIndicies,
+	const Platform::Array<String^>^ fileNames,
+	StorageFolder^ folder,
+	PathOptions^ options,
+	Windows::UI::Color color,
+	bool skipEmpty)
+{
+	if (fileNames->Length != glyphIndicies->Length)
+		throw ref new InvalidArgumentException();
+
+	auto job = std::make_shared<SvgExportJob>(options);
+	job->Face = GetOutlineFace(fontFace, options, job->Size);
+	job->Glyphs.assign(begin(glyphIndicies), end(glyphIndicies));
+	job->Names.assign(begin(fileNames), end(fileNames));
+	job->Cache = m_pathCache;
+	job->Instances = m_variationCache;
+	uint32_t argb = (color.A << 24) | (color.R << 16) | (color.G << 8) | color.B;
+
+	// Only the first glyph given each file name is written, and the rest are
+	// counted as skipped. Otherwise glyphs sharing a name would race to
+	// replace the same file. Names are compared ignoring case, as the file
+	// system does.
+	auto duplicate = std::make_shared<std::vector<uint8_t>>(job->Names.size());
+	std::unordered_map<std::wstring, UINT32> firstIndex;
+	for (UINT32 i = 0; i < job->Names.size(); i++)
+	{
+		std::wstring name(job->Names[i]->Data(), job->Names[i]->Length());
+		if (!name.empty())
+			CharUpperBuffW(&name[0], static_cast<DWORD>(name.size()));
+
+		(*duplicate)[i] = !firstIndex.emplace(std::move(name), i).second;
 	}
 
-	return paths->GetView();
+	job->Format = [argb, state = job.get()](UINT32 i, const GlyphPath& path, SvgPathBuilder& b)
+	{
+		SvgDocumentWriter::WriteHeader(b);
+		SvgDocumentWriter::WriteDocument(b, path, state->Settings.WriteOptions, argb);
+	};
+
+	job->Write = [state = job.get(), folder, skipEmpty, duplicate](
+		UINT32 first, const std::vector<std::shared_ptr<SvgPathBuilder>>& batch, const std::vector<uint8_t>& empty)
+	{
+		// Every file in the batch is created and written at once,
+		// as the storage APIs spend most of their time waiting.
+		std::vector<task<bool>> writes;
+		writes.reserve(batch.size());
+
+		for (size_t i = 0; i < batch.size(); i++)
+		{
+			if ((skipEmpty && empty[i]) || (*duplicate)[first + i])
+			{
+				state->Skipped++;
+				continue;
+			}
+
+			IBuffer^ buffer = CreateBuffer(batch[i]);
+			writes.push_back(
+				create_task(folder->CreateFileAsync(state->Names[first + i], CreationCollisionOption::ReplaceExisting))
+				.then([buffer](StorageFile^ file)
+					{
+						return FileIO::WriteBufferAsync(file, buffer);
+					})
+				.then([](task<void> t)
+					{
+						try
+						{
+							t.get();
+							return true;
+						}
+						catch (Platform::Exception^)
+						{
+							return false;
+						}
+					}));
+		}
+
+		if (writes.empty())
+			return task_from_result();
+
+		return when_all(writes.begin(), writes.end()).then([state](std::vector<bool> results)
+			{
+				for (bool succeeded : results)
+				{
+					if (succeeded)
+						state->Exported++;
+					else
+						state->Failed++;
+				}
+			}, task_continuation_context::use_arbitrary());
+	};
+
+	return create_async([job](progress_reporter<UINT32> reporter, cancellation_token token)
+		{
+			job->Reporter = reporter;
+			job->Token = token;
+			return RunSvgExportAsync(job);
+		});
 }
 
 PathData^ NativeInterop::GetPathData(CanvasGeometry^ geometry)
@@ -287,19 +958,51 @@ byte* GetPointerToPixelData(IBuffer^ pixelBuffer, unsigned int* length)
 	return pixels;
 }
 
-IAsyncOperation<bool>^ NativeInterop::UnpackWOFF2Async(IBuffer^ buffer, IOutputStream^ stream)
+IAsyncOperationWithProgress<bool, UINT64>^ NativeInterop::UnpackWOFF2Async(IBuffer^ buffer, IOutputStream^ stream)
 {
-	// 1. Unpack the WOFF2 data
+	// 1. Unpack the WOFF2 data. DirectWrite decodes it into a stream of its
+	//    own, so the input buffer is only read while this call runs.
 	unsigned int length;
 	auto bytes = GetPointerToPixelData(buffer, &length);
 	ComPtr<IDWriteFactory7> factory = m_fontManager->GetIsolatedFactory();
 	ComPtr<IDWriteFontFileStream> fileStream;
-	auto result = factory->UnpackFontFile(DWRITE_CONTAINER_TYPE_WOFF2, bytes, length, &fileStream);
+	if (factory->UnpackFontFile(DWRITE_CONTAINER_TYPE_WOFF2, bytes, length, &fileStream) != S_OK)
+		fileStream = nullptr;
 
-	if (result != S_OK)
-		return create_async([] { return task_from_result(false); });
-	else
-		return DirectWrite::SaveFontStreamAsync(fileStream, stream);
+	// 2. Write it out a fragment at a time, without copying it again
+	return DirectWrite::SaveFontStreamAsync(fileStream, stream);
+}
+
+IAsyncOperation<bool>^ NativeInterop::UnpackWOFFAsync(IBuffer^ buffer, IOutputStream^ stream)
+{
+	return create_async([buffer, stream]
+		{
+			// 1. Decode every table straight into its place in the output,
+			//    in parallel. The buffer is captured, so its bytes stay alive.
+			unsigned int length;
+			auto bytes = GetPointerToPixelData(buffer, &length);
+			auto output = std::make_shared<std::vector<uint8_t>>();
+
+			WoffDecoder decoder;
+			auto status = decoder.Decode(ByteSpan(bytes, length), *output, [](uint32_t count, auto body)
+				{
+					parallel_for(0u, count, body);
+				});
+
+			if (status != WoffStatus::OK)
+				return task_from_result(false);
+
+			// 2. Write the decoded font to the stream without copying it again
+			uint32_t size = static_cast<uint32_t>(output->size());
+			auto data = NativeBuffer::Create(ByteSpan(output->data(), size), [output] {});
+			return create_task(stream->WriteAsync(data)).then([stream, size](unsigned int written)
+				{
+					if (written != size)
+						return task_from_result(false);
+
+					return create_task(stream->FlushAsync());
+				}, task_continuation_context::use_arbitrary());
+		});
 }
 
 CanvasTextFormat^ CharacterMapCX::NativeInterop::CreateTextFormat(DWriteFontFace^ fontFace, FontWeight weight, FontStyle style, FontStretch stretch, float fontSize)
@@ -12,6 +12,10 @@
 #include "DWriteFontAxis.h"
 #include "DWriteFontAxisAttribute.h"
 #include "PathData.h"
+#include "PathOptions.h"
+#include "SvgExportResult.h"
+#include "GlyphPathCache.h"
+#include "VariationInstanceCache.h"
 #include "GlyphImageFormat.h"
 #include "DWriteFallbackFont.h"
 
@@ -41,22 +45,120 @@ namespace CharacterMapCX
 
 		IVectorView<PathData^>^ GetPathDatas(DWriteFontFace^ fontFace, const Platform::Array<UINT16>^ glyphIndicies);
 
+		/// <summary>
+		/// Creates path data for a batch of glyphs in parallel. Returns one
+		/// PathData for every glyph index passed in, in the same order.
+		/// </summary>
+		IVectorView<PathData^>^ GetPathDatas(DWriteFontFace^ fontFace, const Platform::Array<UINT16>^ glyphIndicies, PathOptions^ options);
+
 		Platform::String^ GetPathData(DWriteFontFace^ fontFace, UINT16 glyphIndicie);
 
+		/// <summary>
+		/// Gets the bounds of a batch of glyphs in the same space as
+		/// GetPathDatas, without building their outlines where the font allows.
+		/// Tight bounds follow the extrema of curves; otherwise the box around
+		/// every control point is returned, which for TrueType glyphs is read
+		/// straight from the glyph header. Empty glyphs get Rect::Empty.
+		/// </summary>
+		IVectorView<Rect>^ GetGlyphBounds(DWriteFontFace^ fontFace, const Platform::Array<UINT16>^ glyphIndicies, PathOptions^ options, bool tight);
+
+		/// <summary>
+		/// Writes an SVG sprite sheet to a stream, with a symbol for each glyph
+		/// that has an outline using the matching id. Outlines come straight
+		/// from the font and are written a batch at a time, so memory use
+		/// doesn't grow with the number of glyphs. Progress is the number of
+		/// glyphs handled so far. Cancelling stops after the current batch,
+		/// closes the sprite, and completes with the counts so far.
+		/// </summary>
+		IAsyncOperationWithProgress<SvgExportResult^, UINT32>^ ExportSvgSpriteAsync(
+			DWriteFontFace^ fontFace,
+			const Platform::Array<UINT16>^ glyphIndicies,
+			const Platform::Array<String^>^ ids,
+			IOutputStream^ stream,
+			PathOptions^ options);
+
+		/// <summary>
+		/// Writes each glyph to its own SVG file in a folder, replacing any
+		/// existing file of the same name, in the same form as a single glyph
+		/// SVG export. Glyphs are processed in batches like ExportSvgSpriteAsync.
+		/// When several glyphs share a file name only the first is written,
+		/// and the others are counted as skipped.
+		/// </summary>
+		IAsyncOperationWithProgress<SvgExportResult^, UINT32>^ ExportSvgFilesAsync(
+			DWriteFontFace^ fontFace,
+			const Platform::Array<UINT16>^ glyphIndicies,
+			const Platform::Array<String^>^ fileNames,
+			StorageFolder^ folder,
+			PathOptions^ options,
+			Windows::UI::Color color,
+			bool skipEmpty);
+
+		/// <summary>
+		/// Creates path data for a single glyph using the given output options.
+		/// </summary>
+		PathData^ GetPathData(DWriteFontFace^ fontFace, UINT16 glyphIndicie, PathOptions^ options);
+
+		/// <summary>
+		/// Approximate memory, in bytes, used to cache glyph outlines between
+		/// calls to GetPathData and GetPathDatas. Zero disables the cache.
+		/// </summary>
+		property UINT64 PathCacheBudget
+		{
+			UINT64 get() { return m_pathCache->GetBudget(); }
+			void set(UINT64 value) { m_pathCache->SetBudget(static_cast<size_t>(value)); }
+		}
+
+		void ClearPathCache()
+		{
+			m_pathCache->Clear();
+			m_variationCache->Clear();
+		}
+
 		/// <summary>
 		/// Returns an SVG-Path syntax compatible representation of the Canvas Text Geometry.
 		/// </summary>
 		PathData^ GetPathData(CanvasGeometry^ geometry);
 
+		/// <summary>
+		/// Gets the system font collection with every family inflated. The
+		/// set is cached, and patched in place once the system font set
+		/// changes. Face metadata is also cached on disk between launches.
+		/// </summary>
 		DWriteFontSet^ GetSystemFonts();
 
+		/// <summary>
+		/// After FontSetInvalidated, patches the set returned by
+		/// GetSystemFonts in place to match the new system font set, and
+		/// returns the faces that were added, removed or changed. Faces that
+		/// are still installed keep their existing objects.
+		/// </summary>
+		DWriteFontSetDiff^ UpdateSystemFonts();
+
 		DWriteFallbackFont^ CreateEmptyFallback();
 
 		__inline DWriteFontSet^ GetFonts(StorageFile^ files);
 
 		IVectorView<DWriteFontSet^>^ GetFonts(IVectorView<StorageFile^>^ files);
 
-		IAsyncOperation<bool>^ UnpackWOFF2Async(IBuffer^ buffer, IOutputStream^ stream);
+		/// <summary>
+		/// Loads every file into one merged font set through a single custom
+		/// collection. Use DWriteFontSet.GetFontsFromFile with a file's index
+		/// to get the faces that came from it.
+		/// </summary>
+		DWriteFontSet^ GetMergedFonts(IVectorView<StorageFile^>^ files);
+
+		/// <summary>
+		/// Unpacks a WOFF2 file and writes the font it holds to the stream
+		/// in chunks. Progress is the number of bytes written so far.
+		/// </summary>
+		IAsyncOperationWithProgress<bool, UINT64>^ UnpackWOFF2Async(IBuffer^ buffer, IOutputStream^ stream);
+
+		/// <summary>
+		/// Converts a WOFF 1.0 file to the TrueType or OpenType font it
+		/// wraps, decompressing its tables in parallel. Returns false without
+		/// writing anything if the file can't be decoded.
+		/// </summary>
+		IAsyncOperation<bool>^ UnpackWOFFAsync(IBuffer^ buffer, IOutputStream^ stream);
 
 		DWriteFontSet^ GetFonts(Uri^ uri);
 
@@ -88,7 +190,12 @@ namespace CharacterMapCX
 		ComPtr<ID2D1DeviceContext1> m_d2dContext;
 		DWriteFontSet^ m_appFontSet;
 		IAsyncAction^ ListenForFontSetExpirationAsync();
+		ComPtr<IDWriteFontCollection3> LoadSystemFontCollection();
+		DWriteFontSetDiff^ PatchSystemFonts();
+		std::mutex m_fontSetMutex;
 		bool m_isFontSetStale = true;
-		CustomFontManager* m_fontManager;
+		std::shared_ptr<CustomFontManager> m_fontManager;
+		std::shared_ptr<GlyphPathCache> m_pathCache;
+		std::shared_ptr<VariationInstanceCache> m_variationCache;
     };
 }
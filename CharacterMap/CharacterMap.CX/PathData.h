@@ -5,9 +5,15 @@
 #include <d2d1_3.h>
 #include <dwrite_3.h>
 #include <WindowsNumerics.h>
+#include <vector>
+#include "GlyphPath.h"
+#include "PathEncoding.h"
+#include "SVGGeometrySink.h"
 
 using namespace Windows::Foundation;
 using namespace Windows::Foundation::Numerics;
+using namespace Microsoft::Graphics::Canvas;
+using namespace Microsoft::Graphics::Canvas::Geometry;
 using namespace Platform;
 
 namespace CharacterMapCX
@@ -31,6 +37,97 @@ namespace CharacterMapCX
 			Rect get() { return m_bounds; }
 		}
 
+		/// <summary>
+		/// The path in a compact binary form (see PathEncoding.h), typically
+		/// 5x smaller than Path, with coordinates rounded to 1/256 DIP.
+		/// Null for paths created from a CanvasGeometry.
+		/// </summary>
+		property Array<uint8>^ EncodedPath
+		{
+			Array<uint8>^ get()
+			{
+				if (m_encoded.empty())
+					return nullptr;
+
+				return ref new Array<uint8>(m_encoded.data(), static_cast<unsigned int>(m_encoded.size()));
+			}
+		}
+
+		/// <summary>
+		/// Converts the encoded path to SVG path syntax, without the fill
+		/// rule prefix XAML uses.
+		/// </summary>
+		String^ ToSvgPath()
+		{
+			return WritePath(-1);
+		}
+
+		/// <summary>
+		/// Converts the encoded path to the XAML path mini-language.
+		/// </summary>
+		String^ ToXamlPath()
+		{
+			return WritePath(static_cast<int>(m_fillMode));
+		}
+
+		/// <summary>
+		/// Creates a Win2D geometry from the encoded path, without parsing
+		/// any text. Returns null if there is no encoded path.
+		/// </summary>
+		CanvasGeometry^ CreateGeometry(ICanvasResourceCreator^ resourceCreator)
+		{
+			GlyphPath path;
+			if (!PathEncoding::Decode(ByteSpan(m_encoded.data(), static_cast<uint32_t>(m_encoded.size())), path))
+				return nullptr;
+
+			auto builder = ref new CanvasPathBuilder(resourceCreator);
+			builder->SetFilledRegionDetermination(m_fillMode);
+
+			const float* p = path.Points.data();
+			bool open = false;
+
+			for (PathVerb verb : path.Verbs)
+			{
+				switch (verb)
+				{
+				case PathVerb::Move:
+					if (open)
+						builder->EndFigure(CanvasFigureLoop::Open);
+					builder->BeginFigure(p[0], p[1]);
+					open = true;
+					break;
+
+				case PathVerb::Line:
+					if (open)
+						builder->AddLine(p[0], p[1]);
+					break;
+
+				case PathVerb::Quad:
+					if (open)
+						builder->AddQuadraticBezier(float2(p[0], p[1]), float2(p[2], p[3]));
+					break;
+
+				case PathVerb::Cubic:
+					if (open)
+						builder->AddCubicBezier(float2(p[0], p[1]), float2(p[2], p[3]), float2(p[4], p[5]));
+					break;
+
+				case PathVerb::Close:
+					if (open)
+						builder->EndFigure(CanvasFigureLoop::Closed);
+					open = false;
+					break;
+				}
+
+				p += GlyphPath::PointCount(verb) * 2;
+			}
+
+			if (open)
+				builder->EndFigure(CanvasFigureLoop::Open);
+
+			return CanvasGeometry::CreatePath(builder);
+		}
+
 	internal:
 		PathData(String^ path, D2D1::Matrix3x2F* matrix)
 		{
@@ -44,11 +141,32 @@ namespace CharacterMapCX
 			m_bounds = bounds;
 		}
 
+		PathData(String^ path, Rect bounds, std::vector<uint8_t>&& encoded, CanvasFilledRegionDetermination fillMode)
+			: m_encoded(std::move(encoded)), m_fillMode(fillMode)
+		{
+			m_path = path;
+			m_bounds = bounds;
+		}
+
 	private:
 		inline PathData() { }
 
+		String^ WritePath(int fillMode)
+		{
+			GlyphPath path;
+			if (!PathEncoding::Decode(ByteSpan(m_encoded.data(), static_cast<uint32_t>(m_encoded.size())), path)
+				|| !path.HasSegments())
+				return ref new String();
+
+			SvgPathBuilder builder;
+			path.WriteSvg(builder, fillMode);
+			return SVGGeometrySink::CreateString(builder);
+		}
+
 		Rect m_bounds = Rect::Empty;
 		float3x2 m_matrix;
 		String^ m_path = nullptr;
+		std::vector<uint8_t> m_encoded;
+		CanvasFilledRegionDetermination m_fillMode = CanvasFilledRegionDetermination::Winding;
 	};
-}
\ No newline at end of file
+}
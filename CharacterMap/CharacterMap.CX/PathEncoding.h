@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "GlyphPath.h"
+#include "SfntData.h"
+
+/*
+	Compact binary encoding of a GlyphPath.
+
+	byte 0		Format version, currently 1
+	byte 1		Number of fraction bits used for fixed point coordinates
+
+	The rest of the stream is a sequence of commands. Each command byte holds
+	a PathVerb in its low 3 bits and a repeat count minus one in its high 5
+	bits, so runs of up to 32 lines or curves share one byte. The points of
+	every repeated verb follow, each as a pair of zigzag encoded LEB128
+	varints holding the x and y delta from the previous point.
+
+	Glyph outlines are dominated by small steps between neighbouring points,
+	so most deltas take one or two bytes instead of the ten or more each
+	coordinate takes as SVG text.
+
+	The encoding is lossy: every coordinate is rounded to the nearest
+	multiple of 1 / 2^fractionBits, so a decoded point can be up to half
+	that step from the original. Outlines whose points already lie on that
+	grid, such as TrueType glyphs at a size that's a whole multiple of
+	their units per em, come back exactly.
+*/
+
+namespace CharacterMapCX
+{
+	class PathEncoding
+	{
+	public:
+		static constexpr uint8_t Version = 1;
+
+		/// <summary>
+		/// Default number of fraction bits, giving 1/256 DIP precision.
+		/// </summary>
+		static constexpr uint8_t DefaultFractionBits = 8;
+
+		static void Encode(const GlyphPath& path, std::vector<uint8_t>& output, uint8_t fractionBits = DefaultFractionBits)
+		{
+			if (fractionBits > 16)
+				fractionBits = 16;
+
+			output.clear();
+			output.reserve(2 + path.Verbs.size() + path.Points.size() * 2);
+			output.push_back(Version);
+			output.push_back(fractionBits);
+
+			float scale = static_cast<float>(1 << fractionBits);
+			const float* p = path.Points.data();
+			int32_t lastX = 0, lastY = 0;
+
+			size_t i = 0;
+			while (i < path.Verbs.size())
+			{
+				PathVerb verb = path.Verbs[i];
+				size_t run = 1;
+				while (run < MaxRun && i + run < path.Verbs.size() && path.Verbs[i + run] == verb)
+					run++;
+
+				output.push_back(static_cast<uint8_t>((run - 1) << 3 | static_cast<uint8_t>(verb)));
+
+				uint32_t points = static_cast<uint32_t>(run) * GlyphPath::PointCount(verb);
+				for (uint32_t k = 0; k < points; k++, p += 2)
+				{
+					int32_t x = Quantize(p[0], scale);
+					int32_t y = Quantize(p[1], scale);
+					WriteVarint(output, ZigZag(x - lastX));
+					WriteVarint(output, ZigZag(y - lastY));
+					lastX = x;
+					lastY = y;
+				}
+
+				i += run;
+			}
+		}
+
+		/// <summary>
+		/// Decodes an encoded path. Returns false if the data is truncated or
+		/// malformed.
+		/// </summary>
+		static bool Decode(ByteSpan data, GlyphPath& path)
+		{
+			path.Clear();
+
+			if (data.Size < 2 || data.Data[0] != Version || data.Data[1] > 16)
+				return false;
+
+			float scale = 1.0f / static_cast<float>(1 << data.Data[1]);
+			int32_t x = 0, y = 0;
+			uint32_t offset = 2;
+
+			while (offset < data.Size)
+			{
+				uint8_t command = data.Data[offset++];
+				uint8_t verb = command & 0x7;
+				uint32_t run = (command >> 3) + 1;
+				if (verb > static_cast<uint8_t>(PathVerb::Close))
+					return false;
+
+				uint32_t count = GlyphPath::PointCount(static_cast<PathVerb>(verb));
+				for (uint32_t r = 0; r < run; r++)
+				{
+					path.Verbs.push_back(static_cast<PathVerb>(verb));
+					for (uint32_t k = 0; k < count; k++)
+					{
+						uint32_t dx, dy;
+						if (!ReadVarint(data, offset, dx) || !ReadVarint(data, offset, dy))
+							return false;
+
+						// Wrap rather than overflow on malformed data
+						x = static_cast<int32_t>(static_cast<uint32_t>(x) + static_cast<uint32_t>(UnZigZag(dx)));
+						y = static_cast<int32_t>(static_cast<uint32_t>(y) + static_cast<uint32_t>(UnZigZag(dy)));
+						path.Points.push_back(x * scale);
+						path.Points.push_back(y * scale);
+					}
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		static constexpr size_t MaxRun = 32;
+
+		// Keeps deltas between any two points inside int32 range
+		static constexpr float MaxFixed = 536870912.0f;
+
+		static int32_t Quantize(float value, float scale)
+		{
+			float v = std::round(value * scale);
+			if (!(v > -MaxFixed))
+				return static_cast<int32_t>(-MaxFixed);
+			if (v > MaxFixed)
+				return static_cast<int32_t>(MaxFixed);
+			return static_cast<int32_t>(v);
+		}
+
+		static uint32_t ZigZag(int32_t value)
+		{
+			return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+		}
+
+		static int32_t UnZigZag(uint32_t value)
+		{
+			return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+		}
+
+		static void WriteVarint(std::vector<uint8_t>& output, uint32_t value)
+		{
+			while (value >= 0x80)
+			{
+				output.push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+
+			output.push_back(static_cast<uint8_t>(value));
+		}
+
+		static bool ReadVarint(ByteSpan data, uint32_t& offset, uint32_t& value)
+		{
+			value = 0;
+			for (uint32_t shift = 0; shift < 35; shift += 7)
+			{
+				if (offset >= data.Size)
+					return false;
+
+				uint8_t b = data.Data[offset++];
+				value |= static_cast<uint32_t>(b & 0x7F) << shift;
+				if ((b & 0x80) == 0)
+					return true;
+			}
+
+			return false;
+		}
+	};
+}
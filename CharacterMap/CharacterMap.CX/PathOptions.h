@@ -0,0 +1,145 @@
+#pragma once
+
+#include <WindowsNumerics.h>
+#include "DWriteFontAxis.h"
+
+using namespace Windows::Foundation::Numerics;
+using namespace Windows::Foundation::Collections;
+using namespace Microsoft::Graphics::Canvas::Geometry;
+using namespace Platform;
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Controls how glyph outlines are converted to path data by
+	/// NativeInterop::GetPathDatas.
+	/// </summary>
+	public ref class PathOptions sealed
+	{
+	public:
+		PathOptions() { }
+
+		/// <summary>
+		/// The em size, in DIPs, to create outlines at. Defaults to 256.
+		/// Ignored when UseFontUnits is set.
+		/// </summary>
+		property float Size
+		{
+			float get() { return m_size; }
+			void set(float value) { m_size = value; }
+		}
+
+		/// <summary>
+		/// Create outlines in the font's design units rather than at Size.
+		/// </summary>
+		property bool UseFontUnits
+		{
+			bool get() { return m_useFontUnits; }
+			void set(bool value) { m_useFontUnits = value; }
+		}
+
+		/// <summary>
+		/// Maximum number of decimal places written for each coordinate,
+		/// from 0 to 9. Defaults to 6.
+		/// </summary>
+		property int Precision
+		{
+			int get() { return m_precision; }
+			void set(int value) { m_precision = value < 0 ? 0 : value > 9 ? 9 : value; }
+		}
+
+		/// <summary>
+		/// Transform applied to every outline before its path data and
+		/// bounds are calculated. Defaults to identity.
+		/// </summary>
+		property float3x2 Transform
+		{
+			float3x2 get() { return m_transform; }
+			void set(float3x2 value) { m_transform = value; }
+		}
+
+		/// <summary>
+		/// The fill rule written at the start of the path data. Glyph
+		/// outlines are designed for non-zero winding, the default.
+		/// </summary>
+		property CanvasFilledRegionDetermination FillMode
+		{
+			CanvasFilledRegionDetermination get() { return m_fillMode; }
+			void set(CanvasFilledRegionDetermination value) { m_fillMode = value; }
+		}
+
+		/// <summary>
+		/// Write relative (lowercase) commands, which need fewer digits.
+		/// </summary>
+		property bool UseRelativeCommands
+		{
+			bool get() { return m_relative; }
+			void set(bool value) { m_relative = value; }
+		}
+
+		/// <summary>
+		/// Leave out command letters that repeat the previous command.
+		/// </summary>
+		property bool ElideRepeatedCommands
+		{
+			bool get() { return m_elide; }
+			void set(bool value) { m_elide = value; }
+		}
+
+		/// <summary>
+		/// Remove duplicate points, and points lying exactly on the straight
+		/// line between their neighbours. SimplifyTolerance, when set,
+		/// removes these too.
+		/// </summary>
+		property bool RemoveCollinearPoints
+		{
+			bool get() { return m_removeCollinear; }
+			void set(bool value) { m_removeCollinear = value; }
+		}
+
+		/// <summary>
+		/// If greater than zero, straight line runs are simplified with
+		/// Douglas-Peucker so no removed point is further than this from the
+		/// result, in output units. Curves are never changed.
+		/// </summary>
+		property float SimplifyTolerance
+		{
+			float get() { return m_simplifyTolerance; }
+			void set(float value) { m_simplifyTolerance = value; }
+		}
+
+		/// <summary>
+		/// Write TrueType quadratic curves as cubics, for consumers that only
+		/// accept cubic segments. Paths are larger but otherwise the same.
+		/// </summary>
+		property bool UseCubicCurves
+		{
+			bool get() { return m_cubic; }
+			void set(bool value) { m_cubic = value; }
+		}
+
+		/// <summary>
+		/// Axis values to create outlines of a variable font at. Axes that
+		/// aren't listed keep their default value. When null, outlines use
+		/// the face's own axis values.
+		/// </summary>
+		property IVectorView<DWriteFontAxis^>^ Axis
+		{
+			IVectorView<DWriteFontAxis^>^ get() { return m_axis; }
+			void set(IVectorView<DWriteFontAxis^>^ value) { m_axis = value; }
+		}
+
+	private:
+		float m_size = 256;
+		bool m_useFontUnits = false;
+		bool m_relative = false;
+		bool m_elide = false;
+		bool m_removeCollinear = false;
+		bool m_cubic = false;
+		float m_simplifyTolerance = 0;
+		int m_precision = 6;
+		float3x2 m_transform = float3x2::identity();
+		CanvasFilledRegionDetermination m_fillMode = CanvasFilledRegionDetermination::Winding;
+		IVectorView<DWriteFontAxis^>^ m_axis = nullptr;
+	};
+}
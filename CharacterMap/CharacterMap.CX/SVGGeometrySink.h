@@ -9,7 +9,8 @@
 #include "GlyphImageFormat.h"
 #include <vector>
 #include <string>
-#include <iostream>
+#include "ErrorHandling.h"
+#include "SvgPathBuilder.h"
 
 using namespace Microsoft::Graphics::Canvas;
 using namespace Microsoft::Graphics::Canvas::Text;
@@ -31,52 +32,61 @@ namespace CharacterMapCX
             m_offsetY = y;
         }
 
-        virtual string ts(float value)
-        {
-            auto str = to_string(value);
-            str.erase(str.find_last_not_of('0') + 1, string::npos); 
-            str.erase(str.find_last_not_of('.') + 1, string::npos);
-            return str;
-        }
-
-        virtual std::string ts(D2D1_POINT_2F p)
-        {
-            return ts(p.x + m_offsetX) + " " + ts(p.y + m_offsetY);
-        }
-
         virtual void STDMETHODCALLTYPE SetFillMode(D2D1_FILL_MODE fillMode)
         {
-            b = b + "F" + to_string(fillMode) + " ";
+            b.FillMode(fillMode);
         }
 
         virtual void STDMETHODCALLTYPE BeginFigure(D2D1_POINT_2F startPoint, D2D1_FIGURE_BEGIN figureBegin)
         {
-            b = b + "M " + ts(startPoint) + " ";
+            b.Command('M');
+            Point(startPoint);
         }
 
         virtual void STDMETHODCALLTYPE AddLines(const D2D1_POINT_2F* points, UINT pointsCount)
         {
             m_hasData = true;
-            for (int i = 0; i < pointsCount; i = i + 1)
+            for (UINT i = 0; i < pointsCount; i++)
             {
-                b = b + "L " + ts(points[i]) + " ";
+                b.Command('L');
+                Point(points[i]);
             }
         }
 
         virtual void STDMETHODCALLTYPE AddBeziers(const D2D1_BEZIER_SEGMENT* beziers, UINT beziersCount)
         {
             m_hasData = true;
-            for (int i = 0; i < beziersCount; i = i + 1)
+            for (UINT i = 0; i < beziersCount; i++)
+            {
+                auto& z = beziers[i];
+                b.Command('C');
+                Point(z.point1);
+                Point(z.point2);
+                Point(z.point3);
+            }
+        }
+
+        virtual void STDMETHODCALLTYPE AddQuadraticBeziers(const D2D1_QUADRATIC_BEZIER_SEGMENT* beziers, UINT32 beziersCount)
+        {
+            m_hasData = true;
+            for (UINT i = 0; i < beziersCount; i++)
             {
-                auto z = beziers[i];
-                b = b + "C " + ts(z.point1) + " " + ts(z.point2) + " " + ts(z.point3) + " ";
+                auto& z = beziers[i];
+                b.Command('Q');
+                Point(z.point1);
+                Point(z.point2);
             }
         }
 
+        virtual void STDMETHODCALLTYPE AddQuadraticBezier(const D2D1_QUADRATIC_BEZIER_SEGMENT* bezier)
+        {
+            AddQuadraticBeziers(bezier, 1);
+        }
+
         virtual void STDMETHODCALLTYPE EndFigure(D2D1_FIGURE_END figureEnd)
         {
             if (figureEnd == D2D1_FIGURE_END::D2D1_FIGURE_END_CLOSED)
-                b = b + "Z ";
+                b.Command('Z');
         }
 
         virtual void STDMETHODCALLTYPE SetSegmentFlags(D2D1_PATH_SEGMENT vertexFlags)
@@ -133,40 +143,57 @@ namespace CharacterMapCX
         String^ GetPathData()
         {
             if (m_hasData)
-            {
-                std::wstring wsTmp(b.begin(), b.end());
-                auto ws = wsTmp;
-
-                String^ s = ref new String(ws.c_str());
-                return s;
-            }
+                return CreateString(b);
             else
                 return ref new String();
         }
 
+        /// <summary>
+        /// Creates a String from path data, widening it straight into the
+        /// HSTRING's own buffer.
+        /// </summary>
+        static String^ CreateString(const SvgPathBuilder& builder)
+        {
+            if (builder.IsEmpty())
+                return ref new String();
+
+            wchar_t* chars = nullptr;
+            HSTRING_BUFFER buffer = nullptr;
+            ThrowIfFailed(WindowsPreallocateStringBuffer(builder.Size(), &chars, &buffer));
+            builder.CopyTo(chars);
+
+            HSTRING hstring = nullptr;
+            HRESULT hr = WindowsPromoteStringBuffer(buffer, &hstring);
+            if (FAILED(hr))
+            {
+                WindowsDeleteStringBuffer(buffer);
+                ThrowIfFailed(hr);
+            }
+
+            // The String takes ownership of the HSTRING
+            return reinterpret_cast<String^>(hstring);
+        }
+
 	private:
 
-        string b = "";
+        SvgPathBuilder b;
         bool m_hasData = false;
         unsigned long m_refCount;
 
         float m_offsetX = 0;
         float m_offsetY = 0;
 
-        // Inherited via ID2D1GeometrySink - Not required for text.
-        void __stdcall AddLine(D2D1_POINT_2F point)
+        void Point(D2D1_POINT_2F p)
         {
+            b.Point(p.x + m_offsetX, p.y + m_offsetY);
         }
 
-        void __stdcall AddBezier(const D2D1_BEZIER_SEGMENT* bezier)
-        {
-        }
-
-        void __stdcall AddQuadraticBezier(const D2D1_QUADRATIC_BEZIER_SEGMENT* bezier)
+        // Inherited via ID2D1GeometrySink - Not required for text.
+        void __stdcall AddLine(D2D1_POINT_2F point)
         {
         }
 
-        void __stdcall AddQuadraticBeziers(const D2D1_QUADRATIC_BEZIER_SEGMENT* beziers, UINT32 beziersCount)
+        void __stdcall AddBezier(const D2D1_BEZIER_SEGMENT* bezier)
         {
         }
 
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "BitmapGlyph.h"
+
+/*
+	Native sbix reader.
+	Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/sbix
+
+	All image data returned is a view onto the table passed to Load, so
+	the table must stay alive for as long as any BitmapGlyph is in use.
+*/
+
+namespace CharacterMapCX
+{
+	struct SbixStrike
+	{
+		uint16_t Ppem = 0;
+		uint16_t Ppi = 0;
+		ByteSpan Data;
+	};
+
+	class SbixTable
+	{
+	public:
+		static constexpr uint32_t PngTag = MakeSfntTag('p', 'n', 'g', ' ');
+		static constexpr uint32_t JpgTag = MakeSfntTag('j', 'p', 'g', ' ');
+		static constexpr uint32_t TiffTag = MakeSfntTag('t', 'i', 'f', 'f');
+		static constexpr uint32_t DupeTag = MakeSfntTag('d', 'u', 'p', 'e');
+
+		/// <summary>
+		/// Indexes every strike in the table. numGlyphs must be the glyph
+		/// count from maxp, as the strike offset arrays are sized by it.
+		/// </summary>
+		bool Load(ByteSpan table, uint16_t numGlyphs)
+		{
+			m_strikes.clear();
+			m_table = table;
+			m_numGlyphs = numGlyphs;
+
+			if (!table.Contains(0, 8))
+				return false;
+
+			uint32_t strikeCount = table.UInt32(4);
+			if (strikeCount > (table.Size - 8) / 4)
+				return false;
+
+			// Each strike header is 4 bytes plus (numGlyphs + 1) offsets
+			uint32_t strikeHeaderSize = 4 + (static_cast<uint32_t>(numGlyphs) + 1) * 4;
+
+			m_strikes.reserve(strikeCount);
+			for (uint32_t i = 0; i < strikeCount; i++)
+			{
+				uint32_t offset = table.UInt32(8 + i * 4);
+				if (!table.Contains(offset, strikeHeaderSize))
+					continue;
+
+				SbixStrike strike;
+				strike.Ppem = table.UInt16(offset);
+				strike.Ppi = table.UInt16(offset + 2);
+				strike.Data = table.Slice(offset);
+				m_strikes.push_back(strike);
+			}
+
+			// Keep strikes ordered by size so we can search them
+			std::stable_sort(m_strikes.begin(), m_strikes.end(),
+				[](const SbixStrike& a, const SbixStrike& b) { return a.Ppem < b.Ppem; });
+
+			return !m_strikes.empty();
+		}
+
+		const std::vector<SbixStrike>& GetStrikes() const { return m_strikes; }
+
+		/// <summary>
+		/// Returns the index of the best strike to use when rendering at the
+		/// target ppem: the smallest strike at least as large as the target,
+		/// otherwise the largest strike available. Returns -1 if there are none.
+		/// </summary>
+		int SelectStrike(uint16_t targetPpem) const
+		{
+			if (m_strikes.empty())
+				return -1;
+
+			auto it = std::lower_bound(m_strikes.begin(), m_strikes.end(), targetPpem,
+				[](const SbixStrike& s, uint16_t ppem) { return s.Ppem < ppem; });
+
+			if (it == m_strikes.end())
+				return static_cast<int>(m_strikes.size()) - 1;
+
+			return static_cast<int>(it - m_strikes.begin());
+		}
+
+		/// <summary>
+		/// Finds the image for a glyph, preferring the best strike for the target
+		/// ppem and falling back to larger then smaller strikes if the preferred
+		/// strike has no image for this glyph. 'dupe' records are resolved.
+		/// </summary>
+		bool TryGetGlyph(uint16_t glyphId, uint16_t targetPpem, BitmapGlyph& result) const
+		{
+			int best = SelectStrike(targetPpem);
+			if (best < 0)
+				return false;
+
+			int count = static_cast<int>(m_strikes.size());
+			for (int i = best; i < count; i++)
+				if (TryGetGlyphFromStrike(i, glyphId, result))
+					return true;
+
+			for (int i = best - 1; i >= 0; i--)
+				if (TryGetGlyphFromStrike(i, glyphId, result))
+					return true;
+
+			return false;
+		}
+
+		/// <summary>
+		/// Reads the image for a glyph from a single strike, without fallback.
+		/// </summary>
+		bool TryGetGlyphFromStrike(int strikeIndex, uint16_t glyphId, BitmapGlyph& result) const
+		{
+			if (strikeIndex < 0 || strikeIndex >= static_cast<int>(m_strikes.size()))
+				return false;
+
+			const SbixStrike& strike = m_strikes[strikeIndex];
+
+			// Fonts can chain dupes, but never legitimately in a cycle.
+			// Limit the depth so malformed fonts can't spin us forever.
+			for (int depth = 0; depth < 8; depth++)
+			{
+				if (glyphId >= m_numGlyphs)
+					return false;
+
+				uint32_t start = strike.Data.UInt32(4 + glyphId * 4);
+				uint32_t end = strike.Data.UInt32(4 + (glyphId + 1) * 4);
+
+				// Empty records mean the strike has no image for this glyph
+				if (end <= start || end - start <= 8 || !strike.Data.Contains(start, end - start))
+					return false;
+
+				ByteSpan record = strike.Data.Slice(start, end - start);
+				uint32_t type = record.UInt32(4);
+				ByteSpan data = record.Slice(8);
+
+				if (type == DupeTag)
+				{
+					if (data.Size < 2)
+						return false;
+
+					glyphId = data.UInt16(0);
+					continue;
+				}
+
+				uint32_t format = GetFormat(type);
+				if (format == GlyphFormat_None)
+					return false;
+
+				result.Data = data;
+				result.Format = format;
+				result.GlyphId = glyphId;
+				result.Ppem = strike.Ppem;
+				result.Ppi = strike.Ppi;
+				result.OriginX = record.Int16(0);
+				result.OriginY = record.Int16(2);
+				return true;
+			}
+
+			return false;
+		}
+
+		static uint32_t GetFormat(uint32_t graphicType)
+		{
+			switch (graphicType)
+			{
+			case PngTag: return GlyphFormat_Png;
+			case JpgTag: return GlyphFormat_Jpeg;
+			case TiffTag: return GlyphFormat_Tiff;
+			default: return GlyphFormat_None;
+			}
+		}
+
+	private:
+		ByteSpan m_table;
+		uint16_t m_numGlyphs = 0;
+		std::vector<SbixStrike> m_strikes;
+	};
+}
@@ -31,7 +31,7 @@ namespace CharacterMapCX
 
 		property uint16 Version;
 		property uint16 Flags;
-		property uint16 NumberOfStrikes;
+		property uint32 NumberOfStrikes;
 
 	internal:
 		SbixTableReader(
@@ -42,7 +42,7 @@ namespace CharacterMapCX
 			Flags = GetUInt16();
 			NumberOfStrikes = GetUInt32();
 
-			// We don't read offset of strikes
+			// Strikes are indexed natively by SbixTable
 		};
 
 		
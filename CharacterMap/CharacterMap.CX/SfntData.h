@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+	Portable helpers for reading raw OpenType table data.
+
+	Unlike TableReader, nothing in here copies the table or depends on
+	WinRT, so parsers built on top of it can hand out views directly
+	into the font data and can be compiled on any platform.
+*/
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Non-owning view over a range of bytes, usually inside a font table.
+	/// The underlying table must outlive the span.
+	/// </summary>
+	struct ByteSpan
+	{
+		const uint8_t* Data = nullptr;
+		uint32_t Size = 0;
+
+		ByteSpan() { }
+
+		ByteSpan(const void* data, uint32_t size)
+			: Data(static_cast<const uint8_t*>(data)), Size(data == nullptr ? 0 : size) { }
+
+		bool IsEmpty() const { return Data == nullptr || Size == 0; }
+
+		bool Contains(uint32_t offset, uint32_t length) const
+		{
+			return offset <= Size && length <= Size - offset;
+		}
+
+		/// <summary>
+		/// Returns a sub-range of this span, or an empty span if the
+		/// requested range falls outside of it.
+		/// </summary>
+		ByteSpan Slice(uint32_t offset, uint32_t length) const
+		{
+			if (!Contains(offset, length))
+				return ByteSpan();
+
+			return ByteSpan(Data + offset, length);
+		}
+
+		ByteSpan Slice(uint32_t offset) const
+		{
+			if (offset > Size)
+				return ByteSpan();
+
+			return ByteSpan(Data + offset, Size - offset);
+		}
+
+		uint8_t UInt8(uint32_t offset) const
+		{
+			return offset < Size ? Data[offset] : 0;
+		}
+
+		uint16_t UInt16(uint32_t offset) const
+		{
+			if (!Contains(offset, 2))
+				return 0;
+
+			const uint8_t* p = Data + offset;
+			return static_cast<uint16_t>((p[0] << 8) | p[1]);
+		}
+
+		int16_t Int16(uint32_t offset) const
+		{
+			return static_cast<int16_t>(UInt16(offset));
+		}
+
+		uint32_t UInt24(uint32_t offset) const
+		{
+			if (!Contains(offset, 3))
+				return 0;
+
+			const uint8_t* p = Data + offset;
+			return (static_cast<uint32_t>(p[0]) << 16) | (p[1] << 8) | p[2];
+		}
+
+		uint32_t UInt32(uint32_t offset) const
+		{
+			if (!Contains(offset, 4))
+				return 0;
+
+			const uint8_t* p = Data + offset;
+			return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+		}
+
+		int32_t Int32(uint32_t offset) const
+		{
+			return static_cast<int32_t>(UInt32(offset));
+		}
+
+		/// <summary>
+		/// Reads a variable sized big-endian unsigned integer of 1 to 4 bytes.
+		/// </summary>
+		uint32_t UIntN(uint32_t offset, uint32_t size) const
+		{
+			switch (size)
+			{
+			case 1: return UInt8(offset);
+			case 2: return UInt16(offset);
+			case 3: return UInt24(offset);
+			case 4: return UInt32(offset);
+			default: return 0;
+			}
+		}
+	};
+
+	/// <summary>
+	/// Native mirror of GlyphImageFormat / DWRITE_GLYPH_IMAGE_FORMATS for
+	/// portable code that cannot see the WinRT enum. Values must match.
+	/// </summary>
+	enum GlyphFormatBits : uint32_t
+	{
+		GlyphFormat_None = 0x00,
+		GlyphFormat_TrueType = 0x01,
+		GlyphFormat_Cff = 0x02,
+		GlyphFormat_Colr = 0x04,
+		GlyphFormat_Svg = 0x08,
+		GlyphFormat_Png = 0x10,
+		GlyphFormat_Jpeg = 0x20,
+		GlyphFormat_Tiff = 0x40,
+		GlyphFormat_PremultipliedB8G8R8A8 = 0x80,
+	};
+
+	/// <summary>
+	/// Formats that render in colour rather than as a plain outline.
+	/// </summary>
+	constexpr uint32_t GlyphFormat_ColorMask =
+		GlyphFormat_Colr | GlyphFormat_Svg | GlyphFormat_Png
+		| GlyphFormat_Jpeg | GlyphFormat_Tiff | GlyphFormat_PremultipliedB8G8R8A8;
+
+	/// <summary>
+	/// Equivalent of DWRITE_MAKE_OPENTYPE_TAG for big-endian tags as they
+	/// are stored inside the font data.
+	/// </summary>
+	constexpr uint32_t MakeSfntTag(char a, char b, char c, char d)
+	{
+		return (static_cast<uint32_t>(static_cast<uint8_t>(a)) << 24)
+			| (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 16)
+			| (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 8)
+			| static_cast<uint32_t>(static_cast<uint8_t>(d));
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "GlyphPath.h"
+#include "SvgPathBuilder.h"
+
+/*
+	Writes complete SVG documents around glyph outlines, either one document
+	per glyph (matching the app's single glyph export) or a sprite sheet with
+	a <symbol> per glyph. Everything is appended to an SvgPathBuilder so the
+	caller decides when the text is flushed to its destination.
+*/
+
+namespace CharacterMapCX
+{
+	class SvgDocumentWriter
+	{
+	public:
+		/// <summary>
+		/// Writes the comment every exported file starts with.
+		/// </summary>
+		static void WriteHeader(SvgPathBuilder& b)
+		{
+			b.Text("<!-- Exported by Character Map UWP -->\r\n");
+		}
+
+		/// <summary>
+		/// Writes a standalone document for one glyph, filled with an ARGB
+		/// colour. Glyphs without any segments produce an empty document.
+		/// </summary>
+		static void WriteDocument(SvgPathBuilder& b, const GlyphPath& path, const SvgWriteOptions& options, uint32_t argb)
+		{
+			PathBounds bounds = path.GetBounds();
+			if (!path.HasSegments() || bounds.IsEmpty())
+			{
+				b.Text("<svg width=\"100%\" height=\"100%\" xmlns=\"http://www.w3.org/2000/svg\"></svg>");
+				return;
+			}
+
+			b.Text("<svg width=\"100%\" height=\"100%\" viewBox=\"");
+			WriteViewBox(b, bounds);
+			b.Text("\" xmlns=\"http://www.w3.org/2000/svg\"><path d=\"");
+			WritePath(b, path, options);
+			b.Text("\" style=\"fill: ");
+			WriteColor(b, argb);
+			b.Text("; fill-opacity: ");
+			b.Value(((argb >> 24) & 0xFF) / 255.0f, 6);
+			b.Text("\" /></svg>");
+		}
+
+		static void BeginSprite(SvgPathBuilder& b)
+		{
+			b.Text("<svg xmlns=\"http://www.w3.org/2000/svg\">\r\n");
+		}
+
+		/// <summary>
+		/// Writes one glyph of a sprite sheet. The path has no fill so it
+		/// can be styled, or take currentColor, wherever the symbol is used.
+		/// The id is UTF-8 and is escaped here.
+		/// </summary>
+		static void WriteSymbol(SvgPathBuilder& b, const char* id, size_t idLength, const GlyphPath& path, const SvgWriteOptions& options)
+		{
+			b.Text("<symbol id=\"");
+			b.EscapedText(id, idLength);
+
+			PathBounds bounds = path.GetBounds();
+			if (!path.HasSegments() || bounds.IsEmpty())
+			{
+				b.Text("\" />\r\n");
+				return;
+			}
+
+			b.Text("\" viewBox=\"");
+			WriteViewBox(b, bounds);
+			b.Text("\"><path d=\"");
+			WritePath(b, path, options);
+			b.Text("\" /></symbol>\r\n");
+		}
+
+		static void EndSprite(SvgPathBuilder& b)
+		{
+			b.Text("</svg>\r\n");
+		}
+
+	private:
+		/// <summary>
+		/// Writes the bounds expanded out to whole units, so the outline is
+		/// never clipped by rounding.
+		/// </summary>
+		static void WriteViewBox(SvgPathBuilder& b, const PathBounds& bounds)
+		{
+			float left = std::floor(bounds.Left);
+			float top = std::floor(bounds.Top);
+			b.Number(left);
+			b.Number(top);
+			b.Number(std::ceil(bounds.Right) - left);
+			b.Value(std::ceil(bounds.Bottom) - top);
+		}
+
+		/// <summary>
+		/// Writes the path data without a fill rule prefix or the trailing
+		/// separator.
+		/// </summary>
+		static void WritePath(SvgPathBuilder& b, const GlyphPath& path, const SvgWriteOptions& options)
+		{
+			SvgWriteOptions o = options;
+			o.FillMode = -1;
+			path.WriteSvg(b, o);
+			b.TrimEnd();
+		}
+
+		static void WriteColor(SvgPathBuilder& b, uint32_t argb)
+		{
+			static const char Digits[] = "0123456789abcdef";
+			char chars[7];
+			chars[0] = '#';
+			for (int i = 0; i < 6; i++)
+				chars[i + 1] = Digits[(argb >> (20 - i * 4)) & 0xF];
+
+			b.Text(chars, sizeof(chars));
+		}
+	};
+}
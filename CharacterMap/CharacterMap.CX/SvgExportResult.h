@@ -0,0 +1,43 @@
+#pragma once
+
+namespace CharacterMapCX
+{
+	/// <summary>
+	/// Counts of the glyphs handled by an SVG export from NativeInterop.
+	/// A cancelled export returns the counts for the glyphs it reached.
+	/// </summary>
+	public ref class SvgExportResult sealed
+	{
+	public:
+		property UINT32 Exported
+		{
+			UINT32 get() { return m_exported; }
+		}
+
+		/// <summary>
+		/// Glyphs left out because they had no outline, or shared a file
+		/// name with an earlier glyph.
+		/// </summary>
+		property UINT32 Skipped
+		{
+			UINT32 get() { return m_skipped; }
+		}
+
+		/// <summary>
+		/// Glyphs whose file couldn't be created or written.
+		/// </summary>
+		property UINT32 Failed
+		{
+			UINT32 get() { return m_failed; }
+		}
+
+	internal:
+		SvgExportResult(UINT32 exported, UINT32 skipped, UINT32 failed)
+			: m_exported(exported), m_skipped(skipped), m_failed(failed) { }
+
+	private:
+		UINT32 m_exported;
+		UINT32 m_skipped;
+		UINT32 m_failed;
+	};
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <charconv>
+#include <cmath>
+
+/*
+	Appends SVG path data into a single growable character buffer.
+
+	Numbers use the same format path export has always used (fixed with six
+	decimal places by default, then trailing zeros and the decimal point trimmed), but
+	are written with std::to_chars straight into the buffer rather than
+	through temporary strings.
+*/
+
+namespace CharacterMapCX
+{
+	class SvgPathBuilder
+	{
+	public:
+		SvgPathBuilder()
+		{
+			m_buffer.reserve(1024);
+		}
+
+		/// <summary>
+		/// Empties the builder, keeping its capacity for the next path.
+		/// </summary>
+		void Clear() { m_buffer.clear(); }
+
+		bool IsEmpty() const { return m_buffer.empty(); }
+
+		/// <summary>
+		/// Removes a trailing separator left by the last number or command.
+		/// </summary>
+		void TrimEnd()
+		{
+			if (!m_buffer.empty() && m_buffer.back() == ' ')
+				m_buffer.pop_back();
+		}
+
+		/// <summary>
+		/// Sets the number of decimal places written for each number, from 0 to 9.
+		/// </summary>
+		void SetPrecision(int precision)
+		{
+			m_precision = precision < 0 ? 0 : precision > 9 ? 9 : precision;
+		}
+
+		const char* Data() const { return m_buffer.data(); }
+
+		uint32_t Size() const { return static_cast<uint32_t>(m_buffer.size()); }
+
+		/// <summary>
+		/// Rounds a value to the precision numbers are written with. Ties go
+		/// to even, as they do in std::to_chars, so the result matches the
+		/// digits Number writes for the same value.
+		/// </summary>
+		double Round(double value) const
+		{
+			static const double Scales[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+			double scale = Scales[m_precision];
+			return std::nearbyint(value * scale) / scale;
+		}
+
+		/// <summary>
+		/// Writes a command letter followed by a space.
+		/// </summary>
+		void Command(char command)
+		{
+			m_buffer.push_back(command);
+			m_buffer.push_back(' ');
+		}
+
+		/// <summary>
+		/// Writes "x y ".
+		/// </summary>
+		void Point(float x, float y)
+		{
+			Number(x);
+			Number(y);
+		}
+
+		/// <summary>
+		/// Writes a number followed by a space.
+		/// </summary>
+		void Number(double value)
+		{
+			Value(value);
+			m_buffer.push_back(' ');
+		}
+
+		/// <summary>
+		/// Writes a number in the same format as Number, without a separator.
+		/// </summary>
+		void Value(double value)
+		{
+			Value(value, m_precision);
+		}
+
+		void Value(double value, int precision)
+		{
+			// Large enough for DBL_MAX in fixed notation with nine decimals
+			char chars[384];
+			auto result = std::to_chars(chars, chars + sizeof(chars), value, std::chars_format::fixed, precision);
+			char* end = result.ptr;
+
+			if (result.ec == std::errc())
+			{
+				char* dot = chars;
+				while (dot < end && *dot != '.')
+					dot++;
+
+				if (dot < end)
+				{
+					while (end[-1] == '0')
+						end--;
+					if (end[-1] == '.')
+						end--;
+				}
+			}
+			else
+			{
+				chars[0] = '0';
+				end = chars + 1;
+			}
+
+			m_buffer.insert(m_buffer.end(), chars, end);
+		}
+
+		/// <summary>
+		/// Writes the fill mode prefix, e.g. "F1 " for non-zero winding.
+		/// </summary>
+		void FillMode(int mode)
+		{
+			char chars[16];
+			chars[0] = 'F';
+			auto result = std::to_chars(chars + 1, chars + sizeof(chars), mode);
+			m_buffer.insert(m_buffer.end(), chars, result.ptr);
+			m_buffer.push_back(' ');
+		}
+
+		/// <summary>
+		/// Writes markup around the path data as it is.
+		/// </summary>
+		void Text(const char* text, size_t length)
+		{
+			m_buffer.insert(m_buffer.end(), text, text + length);
+		}
+
+		template <size_t N>
+		void Text(const char(&text)[N])
+		{
+			Text(text, N - 1);
+		}
+
+		/// <summary>
+		/// Writes UTF-8 text for use inside an XML attribute or element,
+		/// escaping the characters XML reserves.
+		/// </summary>
+		void EscapedText(const char* text, size_t length)
+		{
+			for (size_t i = 0; i < length; i++)
+			{
+				switch (text[i])
+				{
+				case '&': Text("&amp;"); break;
+				case '<': Text("&lt;"); break;
+				case '>': Text("&gt;"); break;
+				case '"': Text("&quot;"); break;
+				case '\'': Text("&apos;"); break;
+				default: m_buffer.push_back(text[i]); break;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Widens the path to UTF-16. Path data is always ASCII, so each
+		/// character maps directly. The destination must hold Size() characters.
+		/// </summary>
+		void CopyTo(wchar_t* destination) const
+		{
+			for (char c : m_buffer)
+				*destination++ = static_cast<wchar_t>(c);
+		}
+
+	private:
+		std::vector<char> m_buffer;
+		int m_precision = 6;
+	};
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include "SfntData.h"
+
+/*
+	Variation axis normalization for OpenType variable fonts.
+	fvar Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/fvar
+	avar Spec: https://docs.microsoft.com/en-us/typography/opentype/spec/avar
+
+	User axis values (such as a weight of 650) are mapped to normalized
+	coordinates from -1 to 1, with 0 at the axis default, and then through
+	the avar segment maps. Both gvar and CFF2 blend against these.
+*/
+
+namespace CharacterMapCX
+{
+	struct VariationAxis
+	{
+		uint32_t Tag;
+		float Minimum;
+		float Default;
+		float Maximum;
+	};
+
+	class VariationAxes
+	{
+	public:
+		/// <summary>
+		/// Reads the axes from fvar and, if present, the avar segment maps.
+		/// The tables are only used during the call.
+		/// </summary>
+		bool Load(ByteSpan fvar, ByteSpan avar)
+		{
+			m_axes.clear();
+			m_maps.clear();
+
+			if (!fvar.Contains(0, 16))
+				return false;
+
+			uint32_t axesOffset = fvar.UInt16(4);
+			uint32_t axisCount = fvar.UInt16(8);
+			uint32_t axisSize = fvar.UInt16(10);
+			if (axisSize < 20 || !fvar.Contains(axesOffset, axisCount * axisSize))
+				return false;
+
+			m_axes.resize(axisCount);
+			for (uint32_t i = 0; i < axisCount; i++)
+			{
+				uint32_t record = axesOffset + i * axisSize;
+				VariationAxis& axis = m_axes[i];
+				axis.Tag = fvar.UInt32(record);
+				axis.Minimum = Fixed(fvar, record + 4);
+				axis.Default = Fixed(fvar, record + 8);
+				axis.Maximum = Fixed(fvar, record + 12);
+			}
+
+			LoadAvar(avar);
+			return true;
+		}
+
+		uint32_t AxisCount() const { return static_cast<uint32_t>(m_axes.size()); }
+
+		const VariationAxis& GetAxis(uint32_t index) const { return m_axes[index]; }
+
+		/// <summary>
+		/// Converts user axis values, one per axis in fvar order, to
+		/// normalized coordinates. Returns false if every coordinate is at
+		/// the default, in which case nothing needs to vary.
+		/// </summary>
+		bool Normalize(const float* values, std::vector<float>& coords) const
+		{
+			bool varies = false;
+			coords.resize(m_axes.size());
+
+			for (size_t i = 0; i < m_axes.size(); i++)
+			{
+				const VariationAxis& axis = m_axes[i];
+				float v = values[i];
+				if (!(v >= axis.Minimum)) v = axis.Minimum;
+				if (v > axis.Maximum) v = axis.Maximum;
+
+				float n = 0;
+				if (v < axis.Default && axis.Default > axis.Minimum)
+					n = (v - axis.Default) / (axis.Default - axis.Minimum);
+				else if (v > axis.Default && axis.Maximum > axis.Default)
+					n = (v - axis.Default) / (axis.Maximum - axis.Default);
+
+				n = ToF2Dot14(n);
+				if (i < m_maps.size())
+					n = ToF2Dot14(Map(m_maps[i], n));
+
+				coords[i] = n;
+				varies |= n != 0;
+			}
+
+			return varies;
+		}
+
+		/// <summary>
+		/// Returns how much a region applies at a normalized coordinate on
+		/// one axis, following the spec's rules for ignoring invalid regions.
+		/// </summary>
+		static float AxisScalar(float coord, float start, float peak, float end)
+		{
+			if (peak == 0 || start > peak || peak > end || (start < 0 && end > 0))
+				return 1;
+			if (coord < start || coord > end)
+				return 0;
+			if (coord == peak)
+				return 1;
+			if (coord < peak)
+				return (coord - start) / (peak - start);
+			return (end - coord) / (end - peak);
+		}
+
+	private:
+		struct AxisValueMap
+		{
+			float From;
+			float To;
+		};
+
+		std::vector<VariationAxis> m_axes;
+		std::vector<std::vector<AxisValueMap>> m_maps;
+
+		static float Fixed(ByteSpan data, uint32_t offset)
+		{
+			return static_cast<int32_t>(data.UInt32(offset)) / 65536.0f;
+		}
+
+		static float ToF2Dot14(float value)
+		{
+			return std::round(value * 16384.0f) / 16384.0f;
+		}
+
+		void LoadAvar(ByteSpan avar)
+		{
+			if (!avar.Contains(0, 8) || avar.UInt16(6) != m_axes.size())
+				return;
+
+			std::vector<std::vector<AxisValueMap>> maps(m_axes.size());
+			uint32_t offset = 8;
+
+			for (auto& map : maps)
+			{
+				if (!avar.Contains(offset, 2))
+					return;
+
+				uint32_t count = avar.UInt16(offset);
+				offset += 2;
+				if (!avar.Contains(offset, count * 4))
+					return;
+
+				map.resize(count);
+				for (uint32_t i = 0; i < count; i++, offset += 4)
+				{
+					map[i].From = avar.Int16(offset) / 16384.0f;
+					map[i].To = avar.Int16(offset + 2) / 16384.0f;
+				}
+			}
+
+			m_maps = std::move(maps);
+		}
+
+		/// <summary>
+		/// Applies a piecewise linear segment map. Values outside the map
+		/// are shifted by the nearest end's offset.
+		/// </summary>
+		static float Map(const std::vector<AxisValueMap>& map, float value)
+		{
+			if (map.empty())
+				return value;
+
+			if (value <= map.front().From)
+				return value + map.front().To - map.front().From;
+
+			if (value >= map.back().From)
+				return value + map.back().To - map.back().From;
+
+			for (size_t i = 1; i < map.size(); i++)
+			{
+				const AxisValueMap& a = map[i - 1];
+				const AxisValueMap& b = map[i];
+				if (value == b.From)
+					return b.To;
+
+				if (value < b.From)
+				{
+					if (b.From == a.From)
+						return a.To;
+
+					return a.To + (b.To - a.To) * (value - a.From) / (b.From - a.From);
+				}
+			}
+
+			return value;
+		}
+	};
+}
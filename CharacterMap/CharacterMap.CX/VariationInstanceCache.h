@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Per-instance variation state for variable fonts, shared between the
+	decoders of every thread.
+
+	Normalizing a face's axis values through fvar and avar, and scaling
+	each of gvar's shared tuples for them, depends only on the font and
+	its axis values. Entries are keyed by the same face key as the glyph
+	path cache, which already includes the axis values, so each instance
+	is worked out once rather than once per decoder.
+*/
+
+namespace CharacterMapCX
+{
+	struct VariationInstance
+	{
+		/// <summary>
+		/// Normalized coordinates in fvar axis order.
+		/// </summary>
+		std::vector<float> Coords;
+
+		/// <summary>
+		/// False when every coordinate is at the default.
+		/// </summary>
+		bool Varies = false;
+
+		/// <summary>
+		/// The scalar of each of gvar's shared tuples, or null if the font
+		/// has no gvar outlines to vary.
+		/// </summary>
+		std::shared_ptr<const std::vector<float>> GvarScalars;
+	};
+
+	class VariationInstanceCache
+	{
+	public:
+		static constexpr size_t DefaultCapacity = 64;
+
+		/// <summary>
+		/// Gets an instance and marks it most recently used, or returns null.
+		/// </summary>
+		std::shared_ptr<const VariationInstance> TryGet(const std::string& faceKey)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto it = m_map.find(faceKey);
+			if (it == m_map.end())
+				return nullptr;
+
+			m_entries.splice(m_entries.begin(), m_entries, it->second);
+			return it->second->Instance;
+		}
+
+		/// <summary>
+		/// Adds an instance, dropping the least recently used once more than
+		/// the capacity are held. Returns the instance now stored for the
+		/// key, which is an earlier one if another thread added it first.
+		/// </summary>
+		std::shared_ptr<const VariationInstance> Add(const std::string& faceKey, std::shared_ptr<const VariationInstance> instance)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto it = m_map.find(faceKey);
+			if (it != m_map.end())
+			{
+				m_entries.splice(m_entries.begin(), m_entries, it->second);
+				return it->second->Instance;
+			}
+
+			m_entries.push_front({ faceKey, std::move(instance) });
+			m_map.emplace(faceKey, m_entries.begin());
+
+			// Taken before trimming, as a capacity of zero drops it again
+			std::shared_ptr<const VariationInstance> result = m_entries.front().Instance;
+			Trim();
+			return result;
+		}
+
+		void SetCapacity(size_t count)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_capacity = count;
+			Trim();
+		}
+
+		size_t GetCount()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_entries.size();
+		}
+
+		void Clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_map.clear();
+			m_entries.clear();
+		}
+
+	private:
+		struct Entry
+		{
+			std::string Key;
+			std::shared_ptr<const VariationInstance> Instance;
+		};
+
+		std::mutex m_mutex;
+		std::list<Entry> m_entries;
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_map;
+		size_t m_capacity = DefaultCapacity;
+
+		void Trim()
+		{
+			while (m_entries.size() > m_capacity)
+			{
+				m_map.erase(m_entries.back().Key);
+				m_entries.pop_back();
+			}
+		}
+	};
+}
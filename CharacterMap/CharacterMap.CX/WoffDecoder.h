@@ -0,0 +1,317 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "DeflateDecoder.h"
+
+/*
+	Converts a WOFF 1.0 file back into the sfnt (TrueType or OpenType) font
+	it wraps.
+
+	The table directory is read once and gives every table its place in
+	the output up front, so the output can be allocated in one go and each
+	table decoded straight into its own slice of it. Tables don't depend on
+	each other, so the caller can decode them on as many threads as it
+	likes. Finish then fills in the table records, with checksums
+	recalculated from the decoded data, and head.checkSumAdjustment.
+
+	As before, DSIG is dropped as converting invalidates it, and a font
+	with an empty Windows family name gets its PostScript name in its
+	place, as XAML can't render a font without one.
+*/
+
+namespace CharacterMapCX
+{
+	enum class WoffStatus
+	{
+		OK,
+
+		/// <summary>
+		/// Not a WOFF file.
+		/// </summary>
+		UnrecognisedFile,
+
+		/// <summary>
+		/// A WOFF2 file, which this doesn't decode.
+		/// </summary>
+		UnsupportedWoff2,
+
+		/// <summary>
+		/// The header or table directory doesn't fit the file.
+		/// </summary>
+		Malformed,
+
+		/// <summary>
+		/// A table didn't decompress to its original length.
+		/// </summary>
+		TableLengthMismatch,
+	};
+
+	class WoffDecoder
+	{
+	public:
+		static constexpr uint32_t WoffTag = MakeSfntTag('w', 'O', 'F', 'F');
+		static constexpr uint32_t Woff2Tag = MakeSfntTag('w', 'O', 'F', '2');
+
+		/// <summary>
+		/// The largest font that will be decoded.
+		/// </summary>
+		static constexpr uint32_t MaxOutputSize = 512 * 1024 * 1024;
+
+		struct Table
+		{
+			uint32_t Tag = 0;
+			uint32_t Offset = 0;
+			uint32_t CompLength = 0;
+			uint32_t OrigLength = 0;
+			uint32_t OutputOffset = 0;
+			uint32_t Checksum = 0;
+		};
+
+		/// <summary>
+		/// Reads the header and table directory of a WOFF file, which must
+		/// stay alive until decoding has finished.
+		/// </summary>
+		WoffStatus ReadDirectory(ByteSpan file)
+		{
+			m_file = file;
+			m_tables.clear();
+			m_outputSize = 0;
+
+			uint32_t signature = file.UInt32(0);
+			if (signature == Woff2Tag)
+				return WoffStatus::UnsupportedWoff2;
+			if (signature != WoffTag)
+				return WoffStatus::UnrecognisedFile;
+
+			const uint32_t headerSize = 44;
+			uint16_t numTables = file.UInt16(12);
+			if (numTables == 0 || !file.Contains(headerSize, numTables * 20u))
+				return WoffStatus::Malformed;
+
+			m_flavor = file.UInt32(4);
+			m_tables.reserve(numTables);
+			for (uint32_t i = 0; i < numTables; i++)
+			{
+				uint32_t record = headerSize + i * 20;
+
+				Table table;
+				table.Tag = file.UInt32(record);
+				table.Offset = file.UInt32(record + 4);
+				table.CompLength = file.UInt32(record + 8);
+				table.OrigLength = file.UInt32(record + 12);
+
+				// Converting invalidates the signature
+				if (table.Tag == MakeSfntTag('D', 'S', 'I', 'G'))
+					continue;
+
+				// Also rules out lengths no DEFLATE stream could decode to,
+				// so a tiny file can't ask for a huge allocation
+				if (!file.Contains(table.Offset, table.CompLength)
+					|| table.CompLength > table.OrigLength
+					|| table.OrigLength / 1032 > table.CompLength)
+					return WoffStatus::Malformed;
+
+				m_tables.push_back(table);
+			}
+
+			// sfnt table records are sorted by tag
+			std::sort(m_tables.begin(), m_tables.end(), [](const Table& a, const Table& b) { return a.Tag < b.Tag; });
+
+			uint64_t offset = 12 + m_tables.size() * 16;
+			for (auto& table : m_tables)
+			{
+				table.OutputOffset = static_cast<uint32_t>(offset);
+				offset += (table.OrigLength + 3ull) & ~3ull;
+				if (offset > MaxOutputSize)
+					return WoffStatus::Malformed;
+			}
+
+			m_outputSize = static_cast<uint32_t>(offset);
+			return WoffStatus::OK;
+		}
+
+		/// <summary>
+		/// Size of the decoded font, including table padding.
+		/// </summary>
+		uint32_t OutputSize() const { return m_outputSize; }
+
+		uint32_t TableCount() const { return static_cast<uint32_t>(m_tables.size()); }
+
+		/// <summary>
+		/// Decodes one table into its place in output, which must be
+		/// OutputSize bytes and zeroed. Different tables can be decoded on
+		/// different threads at once.
+		/// </summary>
+		bool DecodeTable(uint32_t index, uint8_t* output)
+		{
+			Table& table = m_tables[index];
+			uint8_t* data = output + table.OutputOffset;
+			ByteSpan source = m_file.Slice(table.Offset, table.CompLength);
+
+			if (table.CompLength == table.OrigLength)
+				memcpy(data, source.Data, table.OrigLength);
+			else if (!DeflateDecoder::InflateZlib(source, data, table.OrigLength))
+				return false;
+
+			if (table.Tag == MakeSfntTag('n', 'a', 'm', 'e'))
+				FixNameTable(data, table.OrigLength);
+
+			// head's checksum is taken with checkSumAdjustment zeroed, and
+			// it's set once the whole font's checksum is known
+			if (table.Tag == MakeSfntTag('h', 'e', 'a', 'd') && table.OrigLength >= 12)
+				memset(data + 8, 0, 4);
+
+			table.Checksum = Checksum(data, (table.OrigLength + 3) & ~3u);
+			return true;
+		}
+
+		/// <summary>
+		/// Writes the sfnt header and table records once every table has
+		/// been decoded, then sets head.checkSumAdjustment.
+		/// </summary>
+		void Finish(uint8_t* output) const
+		{
+			uint16_t numTables = static_cast<uint16_t>(m_tables.size());
+			uint16_t entrySelector = 0;
+			while ((2u << entrySelector) <= numTables)
+				entrySelector++;
+
+			uint16_t searchRange = static_cast<uint16_t>((1u << entrySelector) * 16);
+
+			WriteUInt32(output, m_flavor);
+			WriteUInt16(output + 4, numTables);
+			WriteUInt16(output + 6, searchRange);
+			WriteUInt16(output + 8, entrySelector);
+			WriteUInt16(output + 10, static_cast<uint16_t>(numTables * 16 - searchRange));
+
+			const Table* head = nullptr;
+			for (uint32_t i = 0; i < numTables; i++)
+			{
+				const Table& table = m_tables[i];
+				uint8_t* record = output + 12 + i * 16;
+				WriteUInt32(record, table.Tag);
+				WriteUInt32(record + 4, table.Checksum);
+				WriteUInt32(record + 8, table.OutputOffset);
+				WriteUInt32(record + 12, table.OrigLength);
+
+				if (table.Tag == MakeSfntTag('h', 'e', 'a', 'd') && table.OrigLength >= 12)
+					head = &table;
+			}
+
+			if (head != nullptr)
+			{
+				// Tables are summed already, so only the header needs adding
+				uint32_t sum = Checksum(output, 12 + numTables * 16);
+				for (const auto& table : m_tables)
+					sum += table.Checksum;
+
+				WriteUInt32(output + head->OutputOffset + 8, 0xB1B0AFBA - sum);
+			}
+		}
+
+		/// <summary>
+		/// Decodes a whole file. forEach(count, body) must call body(i)
+		/// once for each i below count, in any order and on any threads.
+		/// </summary>
+		template <typename ForEach>
+		WoffStatus Decode(ByteSpan file, std::vector<uint8_t>& output, ForEach forEach)
+		{
+			WoffStatus status = ReadDirectory(file);
+			if (status != WoffStatus::OK)
+				return status;
+
+			output.assign(m_outputSize, 0);
+			std::unique_ptr<bool[]> decoded(new bool[m_tables.size()]());
+			uint8_t* data = output.data();
+			forEach(TableCount(), [&](uint32_t i)
+				{
+					decoded[i] = DecodeTable(i, data);
+				});
+
+			for (uint32_t i = 0; i < TableCount(); i++)
+			{
+				if (!decoded[i])
+					return WoffStatus::TableLengthMismatch;
+			}
+
+			Finish(data);
+			return WoffStatus::OK;
+		}
+
+		WoffStatus Decode(ByteSpan file, std::vector<uint8_t>& output)
+		{
+			return Decode(file, output, [](uint32_t count, auto body)
+				{
+					for (uint32_t i = 0; i < count; i++)
+						body(i);
+				});
+		}
+
+		/// <summary>
+		/// Sums a 4-byte aligned range of big-endian 32-bit words.
+		/// </summary>
+		static uint32_t Checksum(const uint8_t* data, uint32_t size)
+		{
+			ByteSpan span(data, size);
+			uint32_t sum = 0;
+			for (uint32_t i = 0; i < size; i += 4)
+				sum += span.UInt32(i);
+
+			return sum;
+		}
+
+	private:
+		ByteSpan m_file;
+		uint32_t m_flavor = 0;
+		uint32_t m_outputSize = 0;
+		std::vector<Table> m_tables;
+
+		static void WriteUInt16(uint8_t* p, uint16_t value)
+		{
+			p[0] = static_cast<uint8_t>(value >> 8);
+			p[1] = static_cast<uint8_t>(value);
+		}
+
+		static void WriteUInt32(uint8_t* p, uint32_t value)
+		{
+			p[0] = static_cast<uint8_t>(value >> 24);
+			p[1] = static_cast<uint8_t>(value >> 16);
+			p[2] = static_cast<uint8_t>(value >> 8);
+			p[3] = static_cast<uint8_t>(value);
+		}
+
+		/// <summary>
+		/// Points an empty Windows family name record at the PostScript
+		/// name's string. Web fonts may leave the family name blank, but
+		/// XAML needs it to render the font.
+		/// </summary>
+		static void FixNameTable(uint8_t* data, uint32_t size)
+		{
+			ByteSpan name(data, size);
+			uint16_t count = name.UInt16(2);
+			if (name.UInt16(0) != 0 || !name.Contains(6, count * 12u))
+				return;
+
+			uint32_t family = UINT32_MAX;
+			uint32_t postScript = UINT32_MAX;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				uint32_t record = 6 + i * 12;
+				uint16_t nameId = name.UInt16(record + 6);
+				if (family == UINT32_MAX && nameId == 1 && name.UInt16(record) == 3)
+					family = record;
+				else if (postScript == UINT32_MAX && nameId == 6)
+					postScript = record;
+			}
+
+			if (family == UINT32_MAX || postScript == UINT32_MAX
+				|| name.UInt16(family + 8) != 0 || name.UInt16(postScript + 8) == 0)
+				return;
+
+			// Length and offset are the last two fields of a record
+			memcpy(data + family + 8, data + postScript + 8, 4);
+		}
+	};
+}
@@ -152,6 +152,15 @@ public partial class CMFontFace : IDisposable
 
     public int GetGlyphIndex(Character c) => Face.GetGlyphIndice(c.UnicodeIndex);
 
+    /// <summary>
+    /// False only when the font's glyph format map shows the glyph for a character
+    /// is a plain outline, with no COLR, SVG or bitmap data. Fonts without a map
+    /// are treated as if every glyph could be colour.
+    /// </summary>
+    public bool HasColorGlyph(Character c)
+        => GetAnalysisInternal().GlyphFormats is not GlyphFormatMap formats
+            || formats.IsColorGlyph((ushort)GetGlyphIndex(c));
+
     public uint[] GetGlyphUnicodeIndexes() => GetCharacters().Select(c => c.UnicodeIndex).ToArray();
 
     public FontAnalysis GetAnalysis() => _analysis ??= TypographyAnalyzer.Analyze(this);
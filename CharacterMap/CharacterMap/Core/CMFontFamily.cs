@@ -96,6 +96,27 @@ public class CMFontFamily : IComparable, IEquatable<CMFontFamily>
         };
     }
 
+    /// <summary>
+    /// Creates a copy of the family, including simulated faces, without
+    /// any of the given faces. Returns null if no faces are left.
+    /// </summary>
+    public CMFontFamily Without(ISet<DWriteFontFace> faces)
+    {
+        CMFontFamily family = new(this.Name)
+        {
+            _variants = _variants.Where(v => faces.Contains(v.Face) is false).ToList(),
+            _simulatedVariants = _simulatedVariants?.Where(v => faces.Contains(v.Face) is false).ToList()
+        };
+
+        family.HasImportedFiles = family._variants.Any(v => v.IsImported)
+            || (family._simulatedVariants?.Any(v => v.IsImported) ?? false);
+
+        if (family._variants.Count == 0 && (family._simulatedVariants?.Count ?? 0) == 0)
+            return null;
+
+        return family;
+    }
+
     public static CMFontFamily CreateDefault(DWriteFontFace face)
     {
         CMFontFamily font = new ("Segoe UI");
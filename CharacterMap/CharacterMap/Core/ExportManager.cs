@@ -102,14 +102,24 @@ public static partial class ExportManager
             && !options.Analysis.GlyphFormats.Contains(GlyphImageFormat.Svg))
         {
             NativeInterop interop = Utils.GetInterop();
+            PathOptions pathOptions = new() { Axis = options.Axis };
+
+            // Every layer is created in one batch, and its bounds come from
+            // the native outline without building any geometry.
+            ushort[] layers = options.Analysis.Indicies
+                .Select(i => i.FirstOrDefault(g => g != 0))
+                .Where(g => g != 0)
+                .ToArray();
+
             List<string> paths = new();
             Rect bounds = Rect.Empty;
 
             // Try to find the bounding box of all glyph layers combined
-            foreach (var thing in options.Analysis.Indicies)
+            foreach (var path in interop.GetPathDatas(options.Variant.Face, layers, pathOptions))
             {
-                var path = interop.GetPathDatas(options.Variant.Face, thing.ToArray()).First();
-                paths.Add(path.Path);
+                // SVG syntax straight from the encoded outline, rather than
+                // the XAML text with its fill rule prefix
+                paths.Add(path.ToSvgPath());
 
                 if (!path.Bounds.IsEmpty)
                 {
@@ -473,6 +483,20 @@ public static partial class ExportManager
          * Drop into C++/CX for color / multi-variant glyphs.
          */
 
+        if (GetCachedOutline(selectedChar, options, options.FontSize, Matrix3x2.Identity) is PathData outline)
+        {
+            if (string.IsNullOrWhiteSpace(outline.Path))
+                return (outline.Path, outline.Bounds);
+
+            // The outline is relative to the glyph origin. Bounds are returned
+            // negated for GenerateSvgDocument, and snapped out to whole units
+            // here so the viewBox still covers the glyph after it rounds them.
+            var b = outline.Bounds;
+            double left = Math.Floor(b.Left);
+            double top = Math.Floor(b.Top);
+            return (outline.Path, new Rect(-left, -top, b.Right - left, b.Bottom - top));
+        }
+
         using CanvasGeometry geom = CreateGeometry(selectedChar, options);
         var bounds = geom.ComputeBounds();
         var data = Utils.GetInterop().GetPathData(geom);
@@ -485,6 +509,43 @@ public static partial class ExportManager
         return (data.Path, bounds);
     }
 
+    /// <summary>
+    /// Gets the outline of the glyph a character maps to through the native
+    /// glyph path cache, without laying out text. Returns null when a text
+    /// layout could draw a different glyph: a typography feature may substitute
+    /// one, and a character the font doesn't map falls back to another font.
+    /// </summary>
+    internal static PathData GetCachedOutline(
+        Character c,
+        CharacterRenderingOptions options,
+        float size,
+        Matrix3x2 transform)
+    {
+        if (options.Variant is null || options.DefaultTypography is not null)
+            return null;
+
+        int glyph = options.Variant.GetGlyphIndex(c);
+        if (glyph <= 0)
+            return null;
+
+        return Utils.GetInterop().GetPathData(
+            options.Variant.Face,
+            (ushort)glyph,
+            new PathOptions { Size = size, Axis = options.Axis, Transform = transform });
+    }
+
+    /// <summary>
+    /// Gets where a layout from CreateGeometry places the glyph origin, so a
+    /// cached outline can be drawn in the same place.
+    /// </summary>
+    internal static Vector2 GetGlyphOrigin(
+        Character selectedChar,
+        CharacterRenderingOptions options)
+    {
+        using var layout = CreateLayout(options, selectedChar, ExportStyle.ColorGlyph, options.FontSize);
+        return new Vector2(layout.GetCaretPosition(0, false).X, layout.LineMetrics[0].Baseline);
+    }
+
     public static CanvasGeometry CreateGeometry(
        Character selectedChar,
        CharacterRenderingOptions options)
@@ -524,6 +585,25 @@ public static partial class ExportManager
             List<ExportResult> skips = new();
             NativeInterop interop = Utils.GetInterop();
 
+            // Only glyphs the font's format map shows as colour need to be laid
+            // out and analysed; every other glyph exports as a plain outline.
+            // Typography features can swap in a different glyph, so with one
+            // applied any glyph of a font with colour glyphs is analysed.
+            bool hasColorGlyphs = e.Options.Variant.GetAnalysis().GlyphFormats?.HasColorGlyphs ?? true;
+            bool typography = e.Options.DefaultTypography is not null;
+            bool[] analyse = characters
+                .Select(c => hasColorGlyphs && (typography || e.Options.Variant.HasColorGlyph(c)))
+                .ToArray();
+            CanvasTextLayoutAnalysis outlineAnalysis = new();
+
+            // Without colour glyphs or typography features every SVG comes
+            // straight from the font outlines, which can be written natively
+            // in batches without a layout or SVG document per glyph.
+            if (!typography
+                && !analyse.Contains(true)
+                && e.PreferredFormat == ExportFormat.Svg)
+                return await ExportSvgFilesAsync(characters, e, folder, callback, token);
+
             // TODO: Parallelise this to improve export speed
             // TODO: Requires UI thread because SVG geometry parsing
             //       uses XAML geometry. See if we can find a faster path.
@@ -533,16 +613,23 @@ public static partial class ExportManager
                 if (token.IsCancellationRequested)
                     break;
 
+                // We need to create a new analysis for each individual colour glyph
+                // to properly support export non-outline glyphs
+                if (analyse[i])
+                {
+                    using var layout = CreateLayout(e.Options, c, e.PreferredStyle, 1024f);
+                    e = e with { 
+                        Options = e.Options with { Analysis = interop.AnalyzeCharacterLayout(layout) } 
+                    };
+                }
+                else
+                {
+                    e = e with { Options = e.Options with { Analysis = outlineAnalysis } };
+                }
+
                 i++;
                 callback?.Invoke(i, characters.Count);
 
-                // We need to create a new analysis for each individual glyph to properly
-                // support export non-outline glyphs
-                using var layout = CreateLayout(e.Options, c, e.PreferredStyle, 1024f);
-                e = e with { 
-                    Options = e.Options with { Analysis = interop.AnalyzeCharacterLayout(layout) } 
-                };
-
                 // Export the glyph
                 ExportResult result = await ExportGlyphAsync(e, c);
                 if (result is not null)
@@ -560,4 +647,42 @@ public static partial class ExportManager
 
         return null;
     }
+
+    private static async Task<ExportGlyphsResult> ExportSvgFilesAsync(
+        IReadOnlyList<Character> characters,
+        ExportOptions e,
+        StorageFolder folder,
+        Action<int, int> callback,
+        CancellationToken token)
+    {
+        DWriteFontFace face = e.Options.Variant.Face;
+        ushort[] glyphs = face.GetGlyphIndices(characters.Select(c => c.UnicodeIndex).ToArray())
+            .Select(g => (ushort)g)
+            .ToArray();
+        string[] names = characters.Select(c => e.GetFileName(c, "svg")).ToArray();
+
+        // Geometry is prepared at 1024px to match single glyph export
+        PathOptions options = new() { Size = 1024, Axis = e.Options.Axis };
+
+        var operation = Utils.GetInterop().ExportSvgFilesAsync(
+            face, glyphs, names, folder, options, e.PreferredColor, e.SkipEmptyGlyphs);
+
+        try
+        {
+            // Cancelling completes the export early with the counts of the
+            // files written so far, rather than throwing
+            SvgExportResult result = await operation.AsTask(token, new Progress<uint>(p =>
+            {
+                callback?.Invoke((int)p, characters.Count);
+            }));
+
+            return new ExportGlyphsResult(
+                true, (int)result.Exported, folder, (int)result.Failed, (int)result.Skipped);
+        }
+        catch (OperationCanceledException)
+        {
+            // Only reached if the export was cancelled before it started
+            return new ExportGlyphsResult(true, 0, folder, 0, 0);
+        }
+    }
 }
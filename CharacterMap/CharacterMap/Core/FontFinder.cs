@@ -37,23 +37,16 @@ public class FontFinder
         await _initSemaphore.WaitAsync().ConfigureAwait(false);
 
         NativeInterop interop = Utils.GetInterop();
-        DWriteFontSet systemFonts = interop.GetSystemFonts();
 
-        Parallel.ForEach(systemFonts.Families, new ParallelOptions { MaxDegreeOfParallelism = 50 }, l =>
-        {
-            l.Inflate();
-        });
-        systemFonts.Update();
+        // Returned with every family already inflated
+        DWriteFontSet systemFonts = interop.GetSystemFonts();
 
         try
         {
             if (DefaultFont == null)
             {
-                DWriteFontFace segoe = systemFonts.Fonts.FirstOrDefault(
-                       f => f.Properties.FamilyName == "Segoe UI"
-                            && f.Properties.Weight.Weight == FontWeights.Normal.Weight
-                            && f.Properties.Stretch == FontStretch.Normal
-                            && f.Properties.Style == FontStyle.Normal);
+                DWriteFontFace segoe = systemFonts.FindFace(
+                    "Segoe UI", FontWeights.Normal, FontStretch.Normal, FontStyle.Normal);
 
                 if (segoe != null)
                     DefaultFont = CMFontFamily.CreateDefault(segoe);
@@ -93,12 +86,13 @@ public class FontFinder
 
             // Load SystemFonts and imported fonts in parallel
             // 1.1. Load imported fonts
-            IReadOnlyList<StorageFile> files = null;
-            Task<List<DWriteFontSet>> setsTask = Task.Run(async () =>
+            List<StorageFile> files = null;
+            Task<DWriteFontSet> setsTask = Task.Run(async () =>
             {
-                files = await FontImporter.ImportFolder.GetFilesAsync();
-                var sets = interop.GetFonts(files).ToList();
-                return sets;
+                files = (await FontImporter.ImportFolder.GetFilesAsync())
+                    .Where(f => FontImporter.IgnoredFonts.Contains(f.Name) is false)
+                    .ToList();
+                return interop.GetMergedFonts(files);
             });
 
             // 1.2. Perform cleanup
@@ -117,24 +111,12 @@ public class FontFinder
             UpdateMeta(systemFonts);
 
             /* Add imported fonts */
-            IReadOnlyList<DWriteFontSet> sets = setsTask.Result;
-            ImportedFamilyCount = ImportedFaceCount = 0;
+            DWriteFontSet importedFonts = setsTask.Result;
+            UpdateMeta(importedFonts);
+            ImportedFaceCount = importedFonts.FaceCount;
+            ImportedFamilyCount = importedFonts.Families.Count;
             for (int i = 0; i < files.Count; i++)
-            {
-                var file = files[i];
-                if (FontImporter.IgnoredFonts.Contains(file.Name))
-                    continue;
-
-                DWriteFontSet importedFonts = sets[i];
-                UpdateMeta(importedFonts);
-                ImportedFaceCount += importedFonts.FaceCount;
-                ImportedFamilyCount += importedFonts.Families.Count;
-
-                foreach (DWriteFontFace font in importedFonts.Fonts)
-                {
-                    AddFont(resultList, font, file);
-                }
-            }
+                AddImportedFonts(resultList, importedFonts, i, files[i]);
 
             var imports = resultList.ToDictionary(d => d.Key, v => v.Value.Clone());
 
@@ -142,7 +124,8 @@ public class FontFinder
             SystemFamilyCount = systemFonts.Families.Count;
             SystemFaceCount = systemFonts.FaceCount;
 
-            foreach (var font in systemFonts.Fonts)
+            // Hidden simulated faces are filtered natively, so they're never created
+            foreach (var font in systemFonts.GetFonts(ResourceHelper.AppSettings.HideSimulatedFontFaces is false))
                 AddFont(resultList, font);
 
             /* Order everything appropriately */
@@ -164,6 +147,75 @@ public class FontFinder
         });
     }
 
+    /// <summary>
+    /// Applies a change to the installed fonts by patching the existing font
+    /// list, rather than reloading every font. Only families with faces
+    /// that were added, removed or changed are copied. Returns false if
+    /// the installed fonts are unchanged.
+    /// </summary>
+    public static Task<bool> UpdateSystemFontsAsync()
+    {
+        return Task.Run(async () =>
+        {
+            await _loadSemaphore.WaitAsync().ConfigureAwait(false);
+
+            try
+            {
+                if (FontDictionary is null)
+                    return false;
+
+                NativeInterop interop = Utils.GetInterop();
+                DWriteFontSetDiff diff = interop.UpdateSystemFonts();
+                if (diff.IsEmpty)
+                    return false;
+
+                Dictionary<string, CMFontFamily> fonts = new(FontDictionary);
+                HashSet<DWriteFontFace> gone = new(diff.Removed.Concat(diff.Previous));
+                HashSet<string> copied = new();
+
+                // 1. Copy each affected family, without the faces that are gone
+                void Copy(DWriteFontFace face, HashSet<DWriteFontFace> without)
+                {
+                    string name = face.Properties.FamilyName;
+                    if (string.IsNullOrEmpty(name)
+                        || copied.Add(name) is false
+                        || fonts.TryGetValue(name, out CMFontFamily family) is false)
+                        return;
+
+                    if (family.Without(without) is CMFontFamily copy)
+                        fonts[name] = copy;
+                    else
+                        fonts.Remove(name);
+                }
+
+                foreach (DWriteFontFace face in gone)
+                    Copy(face, gone);
+
+                // 2. Add the new faces to the copies
+                IEnumerable<DWriteFontFace> added = diff.Added.Concat(diff.Changed);
+                foreach (DWriteFontFace face in added)
+                    Copy(face, gone);
+
+                foreach (DWriteFontFace face in added)
+                    AddFont(fonts, face);
+
+                DWriteFontSet systemFonts = interop.GetSystemFonts();
+                SystemFamilyCount = systemFonts.Families.Count;
+                SystemFaceCount = systemFonts.FaceCount;
+
+                Fonts = CreateFontList(fonts);
+                FontDictionary = fonts;
+            }
+            finally
+            {
+                _loadSemaphore.Release();
+            }
+
+            WeakReferenceMessenger.Default.Send(new FontListCreatedMessage());
+            return true;
+        });
+    }
+
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
     public static List<CMFontFamily> CreateFontList(Dictionary<string, CMFontFamily> fonts)
     {
@@ -185,7 +237,7 @@ public class FontFinder
 
         HasRemoteFonts = HasRemoteFonts || set.CloudFontCount > 0;
         HasAppxFonts = HasAppxFonts || set.AppxFontCount > 0;
-        HasVariableFonts = true;
+        HasVariableFonts = HasVariableFonts || set.VariableFontCount > 0;
     }
 
     internal static List<CMFontFace> GetImportedVariants(bool includeSimulations = false)
@@ -237,6 +289,34 @@ public class FontFinder
         }
     }
 
+    /// <summary>
+    /// Adds the faces of one file of a merged set. A file whose faces were
+    /// all merged away into identical faces from another file is loaded on
+    /// its own instead, so every imported file keeps its faces.
+    /// </summary>
+    internal static void AddImportedFonts(
+        IDictionary<string, CMFontFamily> fontList,
+        DWriteFontSet set,
+        int fileIndex,
+        StorageFile file)
+    {
+        IReadOnlyList<DWriteFontFace> fonts = set.GetFontsFromFile(fileIndex);
+        if (fonts.Count == 0)
+        {
+            try
+            {
+                fonts = Utils.GetInterop().GetFonts(file).Fonts;
+            }
+            catch
+            {
+                return;
+            }
+        }
+
+        foreach (DWriteFontFace font in fonts)
+            AddFont(fontList, font, file);
+    }
+
     [MethodImpl(MethodImplOptions.AggressiveInlining)]
     internal static string GetAppPath(StorageFile file)
     {
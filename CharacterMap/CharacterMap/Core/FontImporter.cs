@@ -162,6 +162,7 @@ public static class FontImporter
                 if (await FontImporter.ImportFolder.TryGetItemAsync(variant.FileName)
                                     is StorageFile file)
                 {
+                    DirectWrite.ReleaseFontCollection(file.Path);
                     await file.DeleteAsync(StorageDeleteOption.PermanentDelete);
                 }
             }
@@ -363,19 +364,18 @@ public static class FontImporter
             if (options.IsCancelled)
                 return contents;
 
-            // 3. Create font sets
+            // 3. Create font sets. Each file is loaded on its own, as only the
+            //    latest merged collection is cached, and a merged set of just
+            //    these files would evict the imported fonts' collection.
             var interop = Utils.GetInterop();
             var results = tasks.Where(t => t.Result is not null).SelectMany(t => t.Result).ToList();
-            var dwSets = interop.GetFonts(results).ToList();
+            IReadOnlyList<DWriteFontSet> sets = interop.GetFonts(results);
 
             // 4. Create InstalledFonts list
-            for (int i = 0; i < dwSets.Count; i++)
+            for (int i = 0; i < results.Count; i++)
             {
-                StorageFile file = results[i];
-                DWriteFontSet set = dwSets[i];
-
-                foreach (DWriteFontFace font in set.Inflate().Fonts)
-                    FontFinder.AddFont(contents.FontCache, font, file);
+                foreach (DWriteFontFace font in sets[i].Fonts)
+                    FontFinder.AddFont(contents.FontCache, font, results[i]);
             }
 
             return contents;
@@ -47,17 +47,14 @@ public static class FontConverter
     {
         try
         {
-            IBuffer buffer = null;
-            using (var stream = await file.OpenReadAsync())
-            using (DataReader reader = new(stream))
-            {
-                await reader.LoadAsync((uint)stream.Size);
-                buffer = reader.ReadBuffer(reader.UnconsumedBufferLength);
-            }
+            // Read straight into one buffer, rather than through a DataReader
+            // that would hold a second copy of the file
+            IBuffer buffer = await FileIO.ReadBufferAsync(file);
 
             using (var os = await newFile.OpenAsync(FileAccessMode.ReadWrite))
             {
-                await Utils.GetInterop().UnpackWOFF2Async(buffer, os);
+                if (!await Utils.GetInterop().UnpackWOFF2Async(buffer, os))
+                    return ConversionStatus.UnspecifiedError;
             }
 
             return ConversionStatus.OK;
@@ -78,8 +75,27 @@ public static class FontConverter
     {
         return Task.Run(async () =>
         {
+            // The native decoder is used first, and the managed converter is
+            // kept for any file it rejects, as it reports why it failed.
+            IBuffer buffer = await FileIO.ReadBufferAsync(inputFile).AsTask().ConfigureAwait(false);
+            try
+            {
+                using var os = await outputFile.OpenAsync(FileAccessMode.ReadWrite).AsTask().ConfigureAwait(false);
+                if (await Utils.GetInterop().UnpackWOFFAsync(buffer, os).AsTask().ConfigureAwait(false))
+                    return ConversionStatus.OK;
+            }
+            catch (Exception ex)
+            {
+                // The decoder reports bad input by returning false, so this
+                // is a failure to write the output, which the managed
+                // converter would hit too
+                Debug.WriteLine(ex);
+                return ConversionStatus.UnspecifiedError;
+            }
+
             using var input = await inputFile.OpenStreamForReadAsync().ConfigureAwait(false);
             using var output = await outputFile.OpenStreamForWriteAsync().ConfigureAwait(false);
+            output.SetLength(0);
             var result = Converter.Convert(input, output);
             return result;
         });
@@ -40,10 +40,10 @@ public partial class DevProviderBase
        CharacterRenderingOptions o)
     {
         /* 
-         * We use a cache because creating geometry is currently a little bit more expensive than it needs to be 
-         * (we're not actually reading the data from the font, but using D2D to "Draw" the geometry to a custom sink)
-         * and we might be creating it multiple times for a single glyph depending on how our dev providers are
-         * configured, so a small cache will help performance
+         * We use a cache because we might be creating the path multiple times for a single glyph depending on
+         * how our dev providers are configured. Outlines come from the native glyph path cache where possible;
+         * only glyphs a layout could change (typography features, font fallback) are "drawn" by D2D to a
+         * custom sink.
          */
 
         if (_geometryCache.FirstOrDefault(p => p.Key is GeometryCacheEntry e && e.Options == o && e.Character == c) is { } pair
@@ -56,9 +56,17 @@ public partial class DevProviderBase
         {
             // We use a font size of 20 as this metrically maps to the size of SegoeMDL2 icons used
             // in FontIcon / SymbolIcon controls.
-            using var geom = ExportManager.CreateGeometry(c, o with { FontSize = 20 });
-            using var typo = o.CreateCanvasTypography();
-            pathIconData = Utils.GetInterop().GetPathData(geom).Path;
+            var options = o with { FontSize = 20 };
+            if (ExportManager.GetCachedOutline(c, options, 20, Matrix3x2.CreateTranslation(ExportManager.GetGlyphOrigin(c, options))) is PathData outline)
+            {
+                pathIconData = outline.Path;
+            }
+            else
+            {
+                using var geom = ExportManager.CreateGeometry(c, options);
+                pathIconData = Utils.GetInterop().GetPathData(geom).Path;
+            }
+
             _geometryCache.Add(KeyValuePair.Create(new GeometryCacheEntry(c, o), pathIconData));
 
             // Keep the cache to a certain size
@@ -424,6 +424,13 @@ public partial class FontMapViewModel : ViewModelBase
 
     internal CanvasTextLayoutAnalysis GetCharAnalysis(Character c)
     {
+        // The font's glyph format map already shows which glyphs are plain
+        // outlines, which need no layout to analyse. A typography feature can
+        // swap in a different glyph, so those are always laid out.
+        if (!SelectedVariant.HasColorGlyph(c)
+            && (SelectedTypography is null || SelectedTypography.Feature == CanvasTypographyFeatureName.None))
+            return new();
+
         using CanvasTextLayout layout = new(Utils.CanvasDevice, $"{c.Char}", new()
         {
             FontSize = (float)Core.Converters.GetFontSize(Settings.GridSize),
@@ -232,10 +232,19 @@ public partial class MainViewModel : ViewModelBase
         IsLoadingFonts = false;
     }
 
-    private void FontSetInvalidated(NativeInterop sender, object args)
+    private async void FontSetInvalidated(NativeInterop sender, object args)
     {
+        // Only the fonts that were installed, removed or updated are
+        // patched into the font list
+        if (await FontFinder.UpdateSystemFontsAsync() is false)
+            return;
+
         _ = MainPage.MainDispatcher.RunAsync(Windows.UI.Core.CoreDispatcherPriority.Normal, () =>
         {
+            RefreshFontList(SelectedCollection);
+
+            // XAML may still render from its own font cache until the
+            // app is restarted (see ReloadFontSet)
             IsFontSetExpired = true;
         });
     }